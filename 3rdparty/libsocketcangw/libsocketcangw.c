@@ -55,6 +55,40 @@ static int addattr_l(struct nlmsghdr *n, size_t maxlen, int type, const void *da
 	return 0;
 }
 
+/* Shared netlink session attached by cangw_attach_session. -1 if not attached. */
+static int g_session_fd = -1;
+/* Sequence number allocator of shared session. It's owned by the caller. */
+static unsigned int *g_session_seq = NULL;
+
+/**
+ * @ingroup extern
+ * cangw_attach_session - use caller owned netlink socket for set requests
+ * @param sock_fd bound NETLINK_ROUTE socket. Negative value detaches the session.
+ * @param seq pointer to last sequence number of the session. The library allocates
+ *            sequence number from it, the caller shall use same allocator for own requests.
+ *
+ * The socket and sequence number are owned by the caller. The library does not close it.
+ * Receive timeout of the socket (SO_RCVTIMEO) bounds the wait for acknowledgement.
+ *
+ * @return 0 if success
+ * @return -1 if argument is invalid
+ */
+int cangw_attach_session(int sock_fd, unsigned int *seq)
+{
+	if (sock_fd < 0) {
+		g_session_fd = -1;
+		g_session_seq = NULL;
+	} else {
+		if (seq == NULL) {
+			return -1;
+		}
+		g_session_fd = sock_fd;
+		g_session_seq = seq;
+	}
+
+	return 0;
+}
+
 /**
  * @ingroup intern
  * send_cangw_set_request - send request to add gw rule into kernel
@@ -69,17 +103,26 @@ static int send_cangw_set_request(struct s_request_data *req)
 {
 	int result = 0;
 	int sock_fd = -1;
+	int is_shared = 0;
 	ssize_t ret = -1;
 	struct nlmsghdr *nlh = NULL;
 	struct nlmsgerr *rte = NULL;
 	struct sockaddr_nl nladdr;
 	unsigned char rxbuf[8192];
 
-	// Open netlink socket interface
-	sock_fd = socket(PF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
-	if (sock_fd < 0) {
-		result = -1;
-		goto do_return;
+	if (g_session_fd >= 0) {
+		// Use shared session
+		sock_fd = g_session_fd;
+		is_shared = 1;
+		(*g_session_seq)++;
+		req->nh.nlmsg_seq = *g_session_seq;
+	} else {
+		// Open netlink socket interface
+		sock_fd = socket(PF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+		if (sock_fd < 0) {
+			result = -1;
+			goto do_return;
+		}
 	}
 
 	memset(&nladdr, 0, sizeof(nladdr));
@@ -93,14 +136,33 @@ static int send_cangw_set_request(struct s_request_data *req)
 		goto do_return;
 	}
 
-	memset(rxbuf, 0, sizeof(rxbuf));
-	ret = recv(sock_fd, &rxbuf, sizeof(rxbuf), 0);
-	if (ret < 0) {
+	do {
+		struct nlmsghdr *msg = NULL;
+		int len = 0;
+
+		memset(rxbuf, 0, sizeof(rxbuf));
+		ret = recv(sock_fd, &rxbuf, sizeof(rxbuf), 0);
+		if (ret < 0) {
+			result = -1;
+			goto do_return;
+		}
+
+		nlh = NULL;
+		len = (int) ret;
+		// Shared session may have stale response in same datagram, find response of this request.
+		for (msg = (struct nlmsghdr *) rxbuf; NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+			if ((is_shared == 0) || (msg->nlmsg_seq == req->nh.nlmsg_seq)) {
+				nlh = msg;
+				break;
+			}
+		}
+	} while ((is_shared == 1) && (nlh == NULL));
+
+	if (nlh == NULL) {
 		result = -1;
 		goto do_return;
 	}
 
-	nlh = (struct nlmsghdr *) rxbuf;
 	if (nlh->nlmsg_type != NLMSG_ERROR) {
 		result = -2;
 		goto do_return;
@@ -112,7 +174,7 @@ static int send_cangw_set_request(struct s_request_data *req)
 	}
 
 do_return:
-	if (sock_fd >= 0) {
+	if ((sock_fd >= 0) && (is_shared == 0)) {
 		close(sock_fd);
 	}
 
@@ -253,6 +315,12 @@ static int parse_listing_data(socketcan_gw_rules_t *gw_rules, unsigned char *rxb
 			case CGW_DST_IF:
 				rule->dst_ifindex = (*(unsigned int *) RTA_DATA(rta));
 				break;
+			case CGW_HANDLED:
+				rule->handled = (*(unsigned int *) RTA_DATA(rta));
+				break;
+			case CGW_DROPPED:
+				rule->dropped = (*(unsigned int *) RTA_DATA(rta));
+				break;
 			default:
 				break;
 			}
@@ -281,6 +349,14 @@ static int parse_listing_data(socketcan_gw_rules_t *gw_rules, unsigned char *rxb
 				rule->filter.can_mask = filter->can_mask;
 				break;
 			}
+			case CGW_MOD_SET: {
+				struct cgw_frame_mod *mod = (struct cgw_frame_mod *) RTA_DATA(rta);
+				if ((mod->modtype & CGW_MOD_ID) == CGW_MOD_ID) {
+					rule->options |= SOCKETCAN_GW_RULE_MOD_ID;
+					rule->mod_id = mod->cf.can_id;
+				}
+				break;
+			}
 
 			default:
 				break;
@@ -350,6 +426,15 @@ static void operate_rule_options(struct s_request_data *req, socketcan_gw_rule_t
 			&rule->filter,
 			sizeof(struct can_filter));
 	}
+
+	if ((rule->options & SOCKETCAN_GW_RULE_MOD_ID) == SOCKETCAN_GW_RULE_MOD_ID) {
+		struct cgw_frame_mod mod;
+
+		memset(&mod, 0, sizeof(mod));
+		mod.cf.can_id = rule->mod_id;
+		mod.modtype = CGW_MOD_ID;
+		addattr_l(&req->nh, sizeof(struct s_request_data), CGW_MOD_SET, &mod, CGW_MODATTR_LEN);
+	}
 }
 
 /**
@@ -18,6 +18,7 @@ extern "C" {
 
 #define SOCKETCAN_GW_RULE_ECHO (0x00000001U)
 #define SOCKETCAN_GW_RULE_FILTER (0x00000002U)
+#define SOCKETCAN_GW_RULE_MOD_ID (0x00000004U)
 
 struct s_socketcan_gw_rule {
 	unsigned int src_ifindex;
@@ -27,6 +28,11 @@ struct s_socketcan_gw_rule {
 
 	unsigned int echo;
 	struct can_filter filter;
+	canid_t mod_id;
+
+	// statistics, set by cangw_get_rules only
+	unsigned int handled;
+	unsigned int dropped;
 };
 typedef struct s_socketcan_gw_rule socketcan_gw_rule_t;
 
@@ -43,6 +49,7 @@ int cangw_delete_rule(socketcan_gw_rule_t *rule);
 int cangw_clean_rule(void);
 int cangw_get_rules(socketcan_gw_rules_t **gw_rules);
 int cangw_release_rules(socketcan_gw_rules_t *gw_rules);
+int cangw_attach_session(int sock_fd, unsigned int *seq);
 
 #ifdef __cplusplus
 }
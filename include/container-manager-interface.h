@@ -18,6 +18,9 @@
 
 #define CONTAINER_EXTIF_STR_LEN_MAX (128u)
 #define CONTAINER_EXTIF_GUESTS_MAX (8*2) //Ref. to container.h GUEST_CONTAINER_LIMIT
+#define CONTAINER_EXTIF_CANIF_MAX (32)
+#define CONTAINER_EXTIF_NETCLASS_MAX (32)
+#define CONTAINER_EXTIF_IFNAME_LEN_MAX (16u)
 //-----------------------------------------------------------------------------
 // Client -> Container manager
 typedef struct s_container_extif_command_header {
@@ -29,6 +32,18 @@ typedef struct s_container_extif_command_get {
 	container_extif_command_header_t header;
 } container_extif_command_get_t;
 
+#define CONTAINER_EXTIF_COMMAND_GETCANSTATS     (0x1001u)
+// Use container_extif_command_get_t
+
+#define CONTAINER_EXTIF_COMMAND_GETNETSTATS     (0x1002u)
+// Use container_extif_command_get_t
+
+#define CONTAINER_EXTIF_COMMAND_GETRECOVERYSTATS    (0x1003u)
+// Use container_extif_command_get_t
+
+#define CONTAINER_EXTIF_COMMAND_GETFSERRORS     (0x1004u)
+// Use container_extif_command_get_t
+
 
 #define CONTAINER_EXTIF_COMMAND_LIFECYCLE_GUEST_NAME  (0x2000u)
 #define CONTAINER_EXTIF_COMMAND_LIFECYCLE_GUEST_ROLE  (0x2001u)
@@ -72,6 +87,81 @@ typedef struct s_container_extif_command_get_response {
     int32_t num_of_guests;
 } container_extif_command_get_response_t;
 
+#define CONTAINER_EXTIF_COMMAND_RESPONSE_GETCANSTATS    (0xa1001u)
+typedef struct s_container_extif_canif_stat {
+    char guest_name[CONTAINER_EXTIF_STR_LEN_MAX];
+    char ifname[CONTAINER_EXTIF_IFNAME_LEN_MAX];
+    uint64_t rx_handled;
+    uint64_t rx_dropped;
+    uint64_t tx_handled;
+    uint64_t tx_dropped;
+    uint32_t rx_rate;   // frames per second from previous request
+    uint32_t tx_rate;   // frames per second from previous request
+} container_extif_canif_stat_t;
+
+typedef struct s_container_extif_command_getcanstats_response {
+	container_extif_command_response_header_t header;
+    container_extif_canif_stat_t canifs[CONTAINER_EXTIF_CANIF_MAX];
+    int32_t num_of_canifs;
+} container_extif_command_getcanstats_response_t;
+
+#define CONTAINER_EXTIF_COMMAND_RESPONSE_GETNETSTATS    (0xa1002u)
+#define CONTAINER_EXTIF_NETCLASS_FROM_GUEST (0xffff0000u)  // classid of from guest policing
+typedef struct s_container_extif_netclass_stat {
+    char guest_name[CONTAINER_EXTIF_STR_LEN_MAX];
+    char ifname[CONTAINER_EXTIF_IFNAME_LEN_MAX];
+    uint32_t classid;   // tc class id (major << 16 | minor) at host side peer
+    uint64_t bytes;
+    uint64_t packets;
+    uint64_t drops;
+} container_extif_netclass_stat_t;
+
+typedef struct s_container_extif_command_getnetstats_response {
+	container_extif_command_response_header_t header;
+    container_extif_netclass_stat_t classes[CONTAINER_EXTIF_NETCLASS_MAX];
+    int32_t num_of_classes;
+} container_extif_command_getnetstats_response_t;
+
+#define CONTAINER_EXTIF_COMMAND_RESPONSE_GETRECOVERYSTATS    (0xa1003u)
+#define CONTAINER_EXTIF_RECOVERY_TIER_JOURNAL   (0) // journal replay
+#define CONTAINER_EXTIF_RECOVERY_TIER_CHECK     (1) // file system check
+#define CONTAINER_EXTIF_RECOVERY_TIER_RECREATE  (2) // mkfs, clone or erase
+#define CONTAINER_EXTIF_RECOVERY_TIER_MAX       (3)
+#define CONTAINER_EXTIF_RECOVERY_TIER_NONE      (-1)
+typedef struct s_container_extif_recovery_stat {
+    char guest_name[CONTAINER_EXTIF_STR_LEN_MAX];
+    uint32_t count[CONTAINER_EXTIF_RECOVERY_TIER_MAX];          // succeeded recovery at each tier
+    uint64_t total_time_ms[CONTAINER_EXTIF_RECOVERY_TIER_MAX];
+    uint64_t max_time_ms[CONTAINER_EXTIF_RECOVERY_TIER_MAX];
+    uint32_t failed;        // failed at all tier
+    int32_t last_tier;      // CONTAINER_EXTIF_RECOVERY_TIER_XXX
+    uint64_t last_time_ms;
+    int32_t running_phase;  // phase of running recovery job (CM_WORKER_PHASE_XXX), CONTAINER_EXTIF_RECOVERY_PHASE_NONE is not running
+    int32_t running_percent;    // progress of running phase, -1 is not reported
+} container_extif_recovery_stat_t;
+#define CONTAINER_EXTIF_RECOVERY_PHASE_NONE     (-1)
+
+typedef struct s_container_extif_command_getrecoverystats_response {
+	container_extif_command_response_header_t header;
+    container_extif_recovery_stat_t guests[CONTAINER_EXTIF_GUESTS_MAX];
+    int32_t num_of_guests;
+} container_extif_command_getrecoverystats_response_t;
+
+#define CONTAINER_EXTIF_COMMAND_RESPONSE_GETFSERRORS    (0xa1004u)
+typedef struct s_container_extif_fserror_stat {
+    char guest_name[CONTAINER_EXTIF_STR_LEN_MAX];
+    uint32_t count;         // reported file system errors
+    int32_t last_error;     // errno of last error
+    uint64_t last_time_ms;
+    char last_path[CONTAINER_EXTIF_STR_LEN_MAX];
+} container_extif_fserror_stat_t;
+
+typedef struct s_container_extif_command_getfserrors_response {
+	container_extif_command_response_header_t header;
+    container_extif_fserror_stat_t guests[CONTAINER_EXTIF_GUESTS_MAX];
+    int32_t num_of_guests;
+} container_extif_command_getfserrors_response_t;
+
 #define CONTAINER_EXTIF_GUEST_STATUS_DISABLE		(0)
 #define CONTAINER_EXTIF_GUEST_STATUS_NOT_STARTED	(1)
 #define CONTAINER_EXTIF_GUEST_STATUS_STARTED		(2)
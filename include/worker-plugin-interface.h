@@ -60,6 +60,123 @@ struct s_cm_worker_instance {
 };
 typedef struct s_cm_worker_instance cm_worker_instance_t;	/**< typedef for struct s_cm_worker_instance. */
 
+/**
+ * @def	CM_WORKER_API_VERSION_1
+ * @brief	Worker plugin API version 1.  Blocking exec and flag based cancel only.  Plugin that is not export cm_worker_api_version is version 1.
+ */
+#define CM_WORKER_API_VERSION_1	(1)
+/**
+ * @def	CM_WORKER_API_VERSION_2
+ * @brief	Worker plugin API version 2.  Add progress reporting and pollable fd based async execution.
+ */
+#define CM_WORKER_API_VERSION_2	(2)
+
+/**
+ * @def	CM_WORKER_PHASE_PREPARE
+ * @brief	Worker phase is preparing, such as waiting for unmount.
+ */
+#define CM_WORKER_PHASE_PREPARE	(0)
+/**
+ * @def	CM_WORKER_PHASE_CHECK
+ * @brief	Worker phase is file system check.
+ */
+#define CM_WORKER_PHASE_CHECK	(1)
+/**
+ * @def	CM_WORKER_PHASE_ERASE
+ * @brief	Worker phase is disk erase.
+ */
+#define CM_WORKER_PHASE_ERASE	(2)
+/**
+ * @def	CM_WORKER_PHASE_FORMAT
+ * @brief	Worker phase is file system format.
+ */
+#define CM_WORKER_PHASE_FORMAT	(3)
+/**
+ * @def	CM_WORKER_PHASE_JOURNAL
+ * @brief	Worker phase is journal replay.  It's fast path of file system check.
+ */
+#define CM_WORKER_PHASE_JOURNAL	(4)
+
+/**
+ * @brief Function pointer for progress report from container workqueue worker.
+ *
+ * @param [in]	userdata	The user data that was set by cm_worker_set_progress_t.
+ * @param [in]	phase		Current phase of worker. CM_WORKER_PHASE_XXX.
+ * @param [in]	percent		Progress of current phase (0-100).
+ * @return void
+ */
+typedef void (*cm_worker_progress_cb_t)(void *userdata, int phase, int percent);
+
+/**
+ * @brief Function pointer for set progress callback to container workqueue worker. (v2)
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [in]	callback	Progress callback. NULL is disable.
+ * @param [in]	userdata	The user data for callback.
+ * @return Description for return value
+ * @retval 0	Success to set.
+ * @retval -1	Fail to set.
+ */
+typedef int (*cm_worker_set_progress_t)(cm_worker_handle_t handle, cm_worker_progress_cb_t callback, void *userdata);
+
+/**
+ * @brief Function pointer for async start to container workqueue worker. (v2)
+ * This function shall not block.  After start, host poll to fd that is got by cm_worker_get_fd_t and call cm_worker_dispatch_t when fd is readable.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval 0	Success to start worker.
+ * @retval -1	Fail to start worker.
+ */
+typedef int (*cm_worker_start_t)(cm_worker_handle_t handle);
+
+/**
+ * @brief Function pointer for get pollable fd of container workqueue worker. (v2)
+ * The fd become readable when worker need to dispatch, such as child exit, progress and cancel request.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval >=0	Pollable fd.
+ * @retval -1	Fail to get fd.
+ */
+typedef int (*cm_worker_get_fd_t)(cm_worker_handle_t handle);
+
+/**
+ * @brief Function pointer for dispatch of container workqueue worker. (v2)
+ * This function shall not block.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [out]	result		Result of worker when completed. 1: cancel, 0: success, -1: fail.
+ * @return Description for return value
+ * @retval 1	Worker is completed.
+ * @retval 0	Worker is running.
+ * @retval -1	Fail to dispatch.
+ */
+typedef int (*cm_worker_dispatch_t)(cm_worker_handle_t handle, int *result);
+
+/**
+ * @struct	s_cm_worker_instance_v2
+ * @brief	The data structure for container manager workqueue worker instance version 2.  The first member is compatible with cm_worker_instance_t.
+ */
+struct s_cm_worker_instance_v2 {
+    cm_worker_instance_t base;              /**< Version 1 compatible part. base.exec execute worker by blocking. */
+    cm_worker_set_progress_t set_progress;  /**< A function pointer for cm_worker_set_progress_t. */
+    cm_worker_start_t start;                /**< A function pointer for cm_worker_start_t. */
+    cm_worker_get_fd_t get_fd;              /**< A function pointer for cm_worker_get_fd_t. */
+    cm_worker_dispatch_t dispatch;          /**< A function pointer for cm_worker_dispatch_t. */
+};
+typedef struct s_cm_worker_instance_v2 cm_worker_instance_v2_t;	/**< typedef for struct s_cm_worker_instance_v2. */
+
+/**
+ * @brief Get API version of the container workqueue worker plugin.
+ * When plugin return CM_WORKER_API_VERSION_2, instance that is got by cm_worker_new is cm_worker_instance_v2_t.
+ *
+ * @return Description for return value
+ * @retval CM_WORKER_API_VERSION_2	Plugin support API version 2.
+ */
+int __attribute__((visibility ("default"))) cm_worker_api_version(void);
+typedef int (*cm_worker_api_version_t)(void);
+
 /**
  * @brief Entry point for the container workqueue worker plugin.
  *
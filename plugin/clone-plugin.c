@@ -0,0 +1,918 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	clone-plugin.c
+ * @brief	This file include implementation of template image clone plugin.
+ */
+
+#include "worker-plugin-interface.h"
+#include "libs/cm-worker-utils.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#define CLONE_STATE_IDLE			(0)	/**< Worker is not started. */
+#define CLONE_STATE_WAIT_UNMOUNT	(1)	/**< Worker is waiting for unmount. */
+#define CLONE_STATE_COPY			(2)	/**< Worker is copying template image. */
+#define CLONE_STATE_UUID			(3)	/**< Worker is assigning new file system UUID. */
+#define CLONE_STATE_RESIZE			(4)	/**< Worker is growing file system. */
+#define CLONE_STATE_DONE			(5)	/**< Worker is completed. */
+
+#define CLONE_FS_UNKNOWN	(0)	/**< Template image is not supported file system. */
+#define CLONE_FS_EXT4		(1)	/**< Template image is ext2/3/4. */
+#define CLONE_FS_F2FS		(2)	/**< Template image is f2fs. */
+
+/**
+ * @def	CLONE_UNMOUNT_WAIT_INTERVAL
+ * @brief	Interval of unmount test (ms).
+ */
+#define CLONE_UNMOUNT_WAIT_INTERVAL	(100)
+/**
+ * @def	CLONE_BUFFER_SIZE
+ * @brief	Size of copy buffer.  It's allocated before fork, child process can't use malloc.
+ */
+#define CLONE_BUFFER_SIZE	(4u*1024u*1024u)	// 4MByte buffer
+/**
+ * @def	CLONE_RESIZE_PROGRESS
+ * @brief	Progress (percent) at start of resize.  Template copy use 0 to this value.
+ */
+#define CLONE_RESIZE_PROGRESS	(90)
+
+/**
+ * @struct	s_clone_plugin
+ * @brief	The data structure for container manager workqueue worker instance.
+ */
+struct s_clone_plugin {
+	char *blkdev_path;					/**< Target block device. */
+	char *template_path;				/**< Template file system image. */
+	int fs_type;						/**< File system type of template. CLONE_FS_XXX. */
+	int cancel_request;
+	int state;							/**< Worker state. CLONE_STATE_XXX. */
+	int retry_count;					/**< Remaining retry count of unmount wait. */
+	int result;							/**< Result of worker. 1: cancel, 0: success, -1: fail. */
+	int budget_expired;					/**< Time budget of clone is expired. */
+	int64_t budget;						/**< Time budget of template copy and resize (ms).  Set by "budget=" option, 0 is no limit. */
+	char *buffer;						/**< Copy buffer. CLONE_BUFFER_SIZE. */
+	libcmplug_child_t child;			/**< Async child process control. */
+	cm_worker_progress_cb_t progress_cb;	/**< Progress callback. */
+	void *progress_userdata;			/**< The user data for progress callback. */
+};
+typedef struct s_clone_plugin clone_plugin_t;	/**< typedef for struct s_clone_plugin. */
+
+/**
+ * @var		cstr_option_device
+ * @brief	Option key for target block device.
+ */
+static const char *cstr_option_device = "device=";
+/**
+ * @var		cstr_option_template
+ * @brief	Option key for template image.
+ */
+static const char *cstr_option_template = "template=";
+/**
+ * @brief Function for argument set to clone plugin.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [in]	arg_str		Pointer to the argument string.
+ * @param [in]	arg_length	Length for the argument string.
+ * @return Description for return value
+ * @retval 0	Success to set argument.
+ * @retval -1	Fail to set argument.
+ */
+static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, size_t arg_length)
+{
+	clone_plugin_t *pclone = NULL;
+	char device[PATH_MAX];
+	char template[PATH_MAX];
+	int ret = -1;
+
+	if ((handle == NULL) || (arg_str == NULL) || (arg_length >= 1024u)) {
+		return -1;
+	}
+
+	pclone = (clone_plugin_t*)handle;
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"clone-plugin: cm_worker_set_args %s (%zu)\n", arg_str, arg_length);
+	#endif
+
+	ret = libcmplug_arg_get_value(arg_str, cstr_option_device, device, sizeof(device));
+	if (ret < 0) {
+		return -1;
+	}
+
+	ret = libcmplug_arg_get_value(arg_str, cstr_option_template, template, sizeof(template));
+	if (ret < 0) {
+		return -1;
+	}
+
+	pclone->budget = libcmplug_arg_get_budget(arg_str);
+
+	(void) free(pclone->blkdev_path);
+	pclone->blkdev_path = strdup(device);
+	(void) free(pclone->template_path);
+	pclone->template_path = strdup(template);
+	if ((pclone->blkdev_path == NULL) || (pclone->template_path == NULL)) {
+		return -1;
+	}
+
+	// New job, clear cancel request of previous job.
+	(void) libcmplug_child_clear_cancel(&pclone->child);
+	(void) libcmplug_cgroup_procs_path(arg_str, pclone->child.cgroup_procs, sizeof(pclone->child.cgroup_procs));
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"clone-plugin: cm_worker_set_args set device = %s, template = %s\n", pclone->blkdev_path, pclone->template_path);
+	#endif
+
+	return 0;
+}
+
+static const char *cstr_block_device_test_base = "/sys/fs/ext4/";
+/**
+ * @brief Function for unmount test.
+ *
+ * @param [in]	pclone		Initialized clone_plugin_t.
+ * @return Description for return value
+ * @retval 1	Unmounted.
+ * @retval 0	Still mounted.
+ * @retval -1	Fail to test.
+ */
+static int cm_worker_test_unmount(clone_plugin_t *pclone)
+{
+	int ret = -1;
+	ssize_t slen = 0, buflen = 0;
+	char test_path[PATH_MAX];
+	const char *devname = NULL;
+
+	// test to /sys/fs/ext4/block-device-name
+	devname = libcmplug_trimmed_devname(pclone->blkdev_path);
+	if (devname == NULL) {
+		// pclone->blkdev_path is not device name.
+		return -1;
+	}
+
+	test_path[0] = '\0';
+	buflen = (ssize_t)sizeof(test_path) - 1;
+
+	slen = (ssize_t)snprintf(test_path, buflen, "%s%s", cstr_block_device_test_base, devname);
+	if (slen >= buflen) {
+		//May not cause this error.
+		return -1;
+	}
+
+	ret = libcmplug_node_check(test_path);
+	if (ret == -1) {
+		// Already unmounted
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout, "clone-plugin: cm_worker_test_unmount unmounted at %s\n",test_path);
+		#endif
+		return 1;
+	}
+
+	return 0;
+}
+/**
+ * @brief Function for file system type detection of template image.
+ * Only file system that can grow offline is supported.
+ *
+ * @param [in]	path		Path to template image.
+ * @return Description for return value
+ * @retval CLONE_FS_EXT4	Template is ext2/3/4.
+ * @retval CLONE_FS_F2FS	Template is f2fs.
+ * @retval CLONE_FS_UNKNOWN	Not supported or fail to read.
+ */
+static int cm_worker_detect_fs(const char *path)
+{
+	unsigned char sb[2048];
+	ssize_t sret = -1;
+	int fd = -1;
+
+	fd = open(path, (O_RDONLY | O_CLOEXEC));
+	if (fd < 0) {
+		return CLONE_FS_UNKNOWN;
+	}
+
+	sret = pread(fd, sb, sizeof(sb), 0);
+	(void) close(fd);
+	if (sret != (ssize_t)sizeof(sb)) {
+		return CLONE_FS_UNKNOWN;
+	}
+
+	// ext superblock is at 1024, s_magic (0xEF53 le16) is at offset 56.
+	if ((sb[1024 + 56] == 0x53u) && (sb[1024 + 57] == 0xEFu)) {
+		return CLONE_FS_EXT4;
+	}
+
+	// f2fs superblock is at 1024, magic is 0xF2F52010 le32.
+	if ((sb[1024] == 0x10u) && (sb[1025] == 0x20u) && (sb[1026] == 0xF5u) && (sb[1027] == 0xF2u)) {
+		return CLONE_FS_F2FS;
+	}
+
+	return CLONE_FS_UNKNOWN;
+}
+/**
+ * @brief Function for progress report.
+ *
+ * @param [in]	pclone		Initialized clone_plugin_t.
+ * @param [in]	phase		Current phase. CM_WORKER_PHASE_XXX.
+ * @param [in]	percent		Progress of current phase.
+ * @return void
+ */
+static void cm_worker_report_progress(clone_plugin_t *pclone, int phase, int percent)
+{
+	if (pclone->progress_cb != NULL) {
+		pclone->progress_cb(pclone->progress_userdata, phase, percent);
+	}
+}
+/**
+ * @brief Line callback for copy progress from child process.
+ *
+ * @param [in]	userdata	Pointer to clone_plugin_t.
+ * @param [in]	line		One line of progress. It's percent of copy.
+ * @return void
+ */
+static void cm_worker_copy_progress(void *userdata, const char *line)
+{
+	clone_plugin_t *pclone = (clone_plugin_t*)userdata;
+	long percent = 0;
+
+	percent = strtol(line, NULL, 10);
+	if ((percent < 0) || (percent > 100)) {
+		return;
+	}
+
+	cm_worker_report_progress(pclone, CM_WORKER_PHASE_FORMAT, (int)((percent * CLONE_RESIZE_PROGRESS) / 100));
+}
+/**
+ * @brief Function for write all data.
+ *
+ * @param [in]	fd		File descriptor to write.
+ * @param [in]	buf		Data to write.
+ * @param [in]	size	Size of data.
+ * @param [in]	offset	Offset of file to write.
+ * @return Description for return value
+ * @retval 0	Success.
+ * @retval -1	Fail to write.
+ */
+static int cm_worker_pwrite_all(int fd, const char *buf, size_t size, off_t offset)
+{
+	size_t done = 0;
+	ssize_t sret = -1;
+
+	while (done < size) {
+		sret = pwrite(fd, &buf[done], size - done, offset + (off_t)done);
+		if (sret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		done += (size_t)sret;
+	}
+
+	return 0;
+}
+/**
+ * @brief Function for template copy.  This function is run in child process.
+ * Only allocated extents of sparse template image are copied.  Previous data in device is discarded before copy.
+ *
+ * @param [in]	arg		Pointer to clone_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to copy.
+ * @retval 1	Fail to copy.
+ */
+static int cm_worker_copy_child(void *arg)
+{
+	clone_plugin_t *pclone = (clone_plugin_t*)arg;
+	struct stat sb;
+	uint64_t devsize = 0, range[2];
+	off_t offset = 0, data = 0, hole = 0;
+	ssize_t sret = -1;
+	int img_fd = -1, dev_fd = -1;
+	int percent = -1, ret = -1;
+	char line[16];
+
+	img_fd = open(pclone->template_path, (O_RDONLY | O_CLOEXEC));
+	if (img_fd < 0) {
+		goto err_ret;
+	}
+
+	// O_EXCL to block device fail when device is mounted.
+	dev_fd = open(pclone->blkdev_path, (O_WRONLY | O_EXCL | O_CLOEXEC));
+	if (dev_fd < 0) {
+		goto err_ret;
+	}
+
+	ret = fstat(img_fd, &sb);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	ret = ioctl(dev_fd, BLKGETSIZE64, &devsize);
+	if ((ret < 0) || ((uint64_t)sb.st_size > devsize) || (sb.st_size <= 0)) {
+		goto err_ret;
+	}
+
+	// Discard old data, not supported device keep old data.  Unallocated area of template is not refered by file system.
+	range[0] = 0;
+	range[1] = devsize;
+	(void) ioctl(dev_fd, BLKDISCARD, range);
+
+	offset = 0;
+	while (offset < sb.st_size) {
+		data = lseek(img_fd, offset, SEEK_DATA);
+		if (data < 0) {
+			if (errno == ENXIO) {
+				// No more data.
+				break;
+			}
+			goto err_ret;
+		}
+
+		hole = lseek(img_fd, data, SEEK_HOLE);
+		if (hole < 0) {
+			goto err_ret;
+		}
+
+		while (data < hole) {
+			size_t len = CLONE_BUFFER_SIZE;
+
+			if ((off_t)len > (hole - data)) {
+				len = (size_t)(hole - data);
+			}
+
+			sret = pread(img_fd, pclone->buffer, len, data);
+			if (sret < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				goto err_ret;
+			} else if (sret == 0) {
+				// Unexpected EOF.
+				goto err_ret;
+			}
+
+			ret = cm_worker_pwrite_all(dev_fd, pclone->buffer, (size_t)sret, data);
+			if (ret < 0) {
+				goto err_ret;
+			}
+			data += (off_t)sret;
+
+			if ((int)((data * 100) / sb.st_size) != percent) {
+				int len_line = 0;
+
+				percent = (int)((data * 100) / sb.st_size);
+				len_line = snprintf(line, sizeof(line), "%d\n", percent);
+				(void) write(LIBCMPLUG_CHILD_PROGRESS_FD, line, (size_t)len_line);
+			}
+		}
+
+		offset = hole;
+	}
+
+	ret = fsync(dev_fd);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	(void) close(dev_fd);
+	(void) close(img_fd);
+
+	return 0;
+
+err_ret:
+	if (dev_fd >= 0) {
+		(void) close(dev_fd);
+	}
+	if (img_fd >= 0) {
+		(void) close(img_fd);
+	}
+
+	return 1;
+}
+/**
+ * @brief Function for template copy start.
+ *
+ * @param [in]	pclone		Initialized clone_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to start copy.
+ * @retval -1	Fail to start copy.
+ */
+static int cm_worker_start_copy(clone_plugin_t *pclone)
+{
+	int ret = -1;
+
+	ret = libcmplug_child_fork(&pclone->child, cm_worker_copy_child, pclone, cm_worker_copy_progress, pclone);
+	if (ret < 0) {
+		return -1;
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "clone-plugin: fork template copy pid=%d\n",(int)pclone->child.child_pid);
+	#endif
+
+	// Budget covers copy and resize.
+	pclone->budget_expired = 0;
+	(void) libcmplug_child_set_timer(&pclone->child, pclone->budget);
+	pclone->state = CLONE_STATE_COPY;
+	cm_worker_report_progress(pclone, CM_WORKER_PHASE_FORMAT, 0);
+
+	return 0;
+}
+/**
+ * @brief Function for file system resize start.
+ * New block groups of ext4 are created with uninitialized inode table, resize time does not depend on partition size.
+ *
+ * @param [in]	pclone		Initialized clone_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to start resize.
+ * @retval -1	Fail to start resize.
+ */
+static int cm_worker_start_resize(clone_plugin_t *pclone)
+{
+	int ret = -1;
+	// Template is trusted build artifact, skip last check time test of resize2fs.
+	char *argv_ext4[] = {"/sbin/resize2fs", "-f", pclone->blkdev_path, NULL};
+	char *argv_f2fs[] = {"/sbin/resize.f2fs", pclone->blkdev_path, NULL};
+
+	if (pclone->fs_type == CLONE_FS_F2FS) {
+		ret = libcmplug_child_spawn(&pclone->child, argv_f2fs, NULL, NULL);
+	} else {
+		ret = libcmplug_child_spawn(&pclone->child, argv_ext4, NULL, NULL);
+	}
+	if (ret < 0) {
+		return -1;
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "clone-plugin: fork and exec resize pid=%d\n",(int)pclone->child.child_pid);
+	#endif
+
+	pclone->state = CLONE_STATE_RESIZE;
+	cm_worker_report_progress(pclone, CM_WORKER_PHASE_FORMAT, CLONE_RESIZE_PROGRESS);
+
+	return 0;
+}
+/**
+ * @brief Function for new file system UUID assignment start.
+ * All clones of one template have same UUID, it's changed to random UUID before resize.
+ * With metadata_csum, tune2fs rewrite checksum of all metadata, it's faster on the template size than after resize.
+ * f2fs-tools does not provide UUID change for existing file system, f2fs clone keeps the template UUID.
+ *
+ * @param [in]	pclone		Initialized clone_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to start.
+ * @retval -1	Fail to start.
+ */
+static int cm_worker_start_uuid(clone_plugin_t *pclone)
+{
+	int ret = -1;
+	char *argv_ext4[] = {"/sbin/tune2fs", "-U", "random", pclone->blkdev_path, NULL};
+
+	if (pclone->fs_type != CLONE_FS_EXT4) {
+		return cm_worker_start_resize(pclone);
+	}
+
+	ret = libcmplug_child_spawn(&pclone->child, argv_ext4, NULL, NULL);
+	if (ret < 0) {
+		return -1;
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "clone-plugin: fork and exec tune2fs pid=%d\n",(int)pclone->child.child_pid);
+	#endif
+
+	pclone->state = CLONE_STATE_UUID;
+	cm_worker_report_progress(pclone, CM_WORKER_PHASE_FORMAT, CLONE_RESIZE_PROGRESS);
+
+	return 0;
+}
+/**
+ * @brief Function for worker completion.
+ *
+ * @param [in]	pclone		Initialized clone_plugin_t.
+ * @param [in]	result		Result of worker.
+ * @return void
+ */
+static void cm_worker_complete(clone_plugin_t *pclone, int result)
+{
+	(void) libcmplug_child_set_timer(&pclone->child, 0);
+	pclone->result = result;
+	pclone->state = CLONE_STATE_DONE;
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "clone-plugin: complete result = %d\n", result);
+	#endif
+}
+/**
+ * @brief Function pointer for async start to container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval 0	Success to start worker.
+ * @retval -1	Fail to start worker.
+ */
+static int cm_worker_start(cm_worker_handle_t handle)
+{
+	clone_plugin_t *pclone = NULL;
+	int ret = -1;
+
+	if (handle == NULL) {
+		return -1;
+	}
+	pclone = (clone_plugin_t*)handle;
+
+	if (((pclone->state != CLONE_STATE_IDLE) && (pclone->state != CLONE_STATE_DONE))
+		|| (pclone->blkdev_path == NULL) || (pclone->template_path == NULL)) {
+		return -1;
+	}
+
+	pclone->fs_type = cm_worker_detect_fs(pclone->template_path);
+	if (pclone->fs_type == CLONE_FS_UNKNOWN) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout, "clone-plugin: not supported template %s\n", pclone->template_path);
+		#endif
+		return -1;
+	}
+
+	pclone->cancel_request = 0;
+	pclone->child.cancel_request = 0;
+	pclone->result = 0;
+	pclone->retry_count = (5000 / CLONE_UNMOUNT_WAIT_INTERVAL);	//5000ms
+	pclone->state = CLONE_STATE_WAIT_UNMOUNT;
+	cm_worker_report_progress(pclone, CM_WORKER_PHASE_PREPARE, 0);
+
+	ret = cm_worker_test_unmount(pclone);
+	if (ret < 0) {
+		pclone->state = CLONE_STATE_IDLE;
+		return -1;
+	} else if (ret == 1) {
+		ret = cm_worker_start_copy(pclone);
+		if (ret < 0) {
+			pclone->state = CLONE_STATE_IDLE;
+			return -1;
+		}
+	} else {
+		// Test again by interval timer.
+		ret = libcmplug_child_set_timer(&pclone->child, CLONE_UNMOUNT_WAIT_INTERVAL);
+		if (ret < 0) {
+			pclone->state = CLONE_STATE_IDLE;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+/**
+ * @brief Function pointer for get pollable fd of container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval >=0	Pollable fd.
+ * @retval -1	Fail to get fd.
+ */
+static int cm_worker_get_fd(cm_worker_handle_t handle)
+{
+	clone_plugin_t *pclone = NULL;
+
+	if (handle == NULL) {
+		return -1;
+	}
+	pclone = (clone_plugin_t*)handle;
+
+	return pclone->child.epoll_fd;
+}
+/**
+ * @brief Function pointer for dispatch of container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [out]	result		Result of worker when completed.
+ * @return Description for return value
+ * @retval 1	Worker is completed.
+ * @retval 0	Worker is running.
+ * @retval -1	Fail to dispatch.
+ */
+static int cm_worker_dispatch(cm_worker_handle_t handle, int *result)
+{
+	clone_plugin_t *pclone = NULL;
+	int events = 0;
+	int ret = -1;
+
+	if ((handle == NULL) || (result == NULL)) {
+		return -1;
+	}
+	pclone = (clone_plugin_t*)handle;
+
+	events = libcmplug_child_dispatch(&pclone->child);
+	if (events < 0) {
+		cm_worker_complete(pclone, -1);
+		goto do_return;
+	}
+
+	if ((events & LIBCMPLUG_CHILD_EVENT_CANCEL) != 0) {
+		pclone->cancel_request = 1;
+	}
+
+	if (pclone->state == CLONE_STATE_WAIT_UNMOUNT) {
+		if (pclone->cancel_request == 1) {
+			// Got cancel request.
+			cm_worker_complete(pclone, 1);
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			ret = cm_worker_test_unmount(pclone);
+			if (ret == 1) {
+				(void) libcmplug_child_set_timer(&pclone->child, 0);
+				ret = cm_worker_start_copy(pclone);
+				if (ret < 0) {
+					cm_worker_complete(pclone, -1);
+				}
+			} else if (ret == 0) {
+				pclone->retry_count--;
+				if (pclone->retry_count <= 0) {
+					// No unmounted
+					#ifdef _PRINTF_DEBUG_
+					(void) fprintf(stdout, "clone-plugin: not unmounted %s\n", pclone->blkdev_path);
+					#endif
+					cm_worker_complete(pclone, -1);
+				}
+			} else {
+				cm_worker_complete(pclone, -1);
+			}
+		} else {
+			;	//nop
+		}
+	} else if (pclone->state == CLONE_STATE_COPY) {
+		if ((events & LIBCMPLUG_CHILD_EVENT_EXITED) != 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout, "clone-plugin: template copy exit = %d\n", pclone->child.exit_code);
+			#endif
+			if (pclone->cancel_request == 1) {
+				cm_worker_complete(pclone, 1);
+			} else if ((pclone->budget_expired == 1) || (pclone->child.exit_code != 0)) {
+				cm_worker_complete(pclone, -1);
+			} else {
+				ret = cm_worker_start_uuid(pclone);
+				if (ret < 0) {
+					cm_worker_complete(pclone, -1);
+				}
+			}
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			// Budget expired, wait exit of terminated process.
+			pclone->budget_expired = 1;
+			(void) libcmplug_child_set_timer(&pclone->child, 0);
+			(void) libcmplug_child_terminate(&pclone->child);
+		} else {
+			;	//nop
+		}
+	} else if (pclone->state == CLONE_STATE_UUID) {
+		if ((events & LIBCMPLUG_CHILD_EVENT_EXITED) != 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout, "clone-plugin: tune2fs exit = %d\n", pclone->child.exit_code);
+			#endif
+			if (pclone->cancel_request == 1) {
+				cm_worker_complete(pclone, 1);
+			} else if ((pclone->budget_expired == 1) || (pclone->child.exit_code != 0)) {
+				// Same UUID as other clone is not allowed.
+				cm_worker_complete(pclone, -1);
+			} else {
+				ret = cm_worker_start_resize(pclone);
+				if (ret < 0) {
+					cm_worker_complete(pclone, -1);
+				}
+			}
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			// Budget expired, wait exit of terminated process.
+			pclone->budget_expired = 1;
+			(void) libcmplug_child_set_timer(&pclone->child, 0);
+			(void) libcmplug_child_terminate(&pclone->child);
+		} else {
+			;	//nop
+		}
+	} else if (pclone->state == CLONE_STATE_RESIZE) {
+		if ((events & LIBCMPLUG_CHILD_EVENT_EXITED) != 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout, "clone-plugin: resize exit = %d\n", pclone->child.exit_code);
+			#endif
+			cm_worker_report_progress(pclone, CM_WORKER_PHASE_FORMAT, 100);
+			if (pclone->cancel_request == 1) {
+				cm_worker_complete(pclone, 1);
+			} else if ((pclone->budget_expired == 1) || (pclone->child.exit_code != 0)) {
+				// Cloned file system is valid, but not grown.
+				cm_worker_complete(pclone, -1);
+			} else {
+				cm_worker_complete(pclone, 0);
+			}
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			// Budget expired, wait exit of terminated process.
+			pclone->budget_expired = 1;
+			(void) libcmplug_child_set_timer(&pclone->child, 0);
+			(void) libcmplug_child_terminate(&pclone->child);
+		} else {
+			;	//nop
+		}
+	} else {
+		;	//nop
+	}
+
+do_return:
+	if (pclone->state == CLONE_STATE_DONE) {
+		(*result) = pclone->result;
+		return 1;
+	}
+
+	return 0;
+}
+/**
+ * @brief Function pointer for container workqueue execution.
+ * This function execute worker by blocking, it's wrapper of async interface.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval 1	Canceled.
+ * @retval 0	Success to execute worker.
+ * @retval -1	Fail to execute worker.
+ */
+static int cm_worker_exec(cm_worker_handle_t handle)
+{
+	struct pollfd waiter[1];
+	int result = -1;
+	int ret = -1;
+
+	ret = cm_worker_start(handle);
+	if (ret < 0) {
+		return -1;
+	}
+
+	(void) memset(waiter, 0, sizeof(struct pollfd)*1u);
+	waiter[0].fd = cm_worker_get_fd(handle);
+	waiter[0].events = POLLIN;
+
+	do {
+		ret = poll(waiter, 1, -1);
+		if ((ret < 0) && (errno != EINTR)) {
+			// Can't wait child process. Child process is killed at cm_worker_delete.
+			result = -1;
+			break;
+		}
+
+		ret = cm_worker_dispatch(handle, &result);
+		if (ret < 0) {
+			result = -1;
+			break;
+		}
+	} while(ret == 0);
+
+	return result;
+}
+/**
+ * @brief Function pointer for set progress callback to container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [in]	callback	Progress callback.
+ * @param [in]	userdata	The user data for callback.
+ * @return Description for return value
+ * @retval 0	Success to set.
+ * @retval -1	Fail to set.
+ */
+static int cm_worker_set_progress(cm_worker_handle_t handle, cm_worker_progress_cb_t callback, void *userdata)
+{
+	clone_plugin_t *pclone = NULL;
+
+	if (handle == NULL) {
+		return -1;
+	}
+	pclone = (clone_plugin_t*)handle;
+
+	pclone->progress_cb = callback;
+	pclone->progress_userdata = userdata;
+
+	return 0;
+}
+/**
+ * @brief Function pointer for cancel to container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval 0	Success to cancel request to worker.
+ * @retval -1	Fail to cancel request to worker.
+ */
+int cm_worker_cancel(cm_worker_handle_t handle)
+{
+	clone_plugin_t *pclone = NULL;
+
+	if (handle == NULL) {
+		return -1;
+	}
+
+	pclone = (clone_plugin_t*)handle;
+
+	return libcmplug_child_cancel(&pclone->child);
+}
+/*
+ *  cm_worker_api_version for clone plugin
+ */
+int cm_worker_api_version(void)
+{
+	return CM_WORKER_API_VERSION_2;
+}
+/*
+ *  cm_worker_new for clone plugin
+ */
+int cm_worker_new(cm_worker_instance_t **instance)
+{
+	cm_worker_instance_v2_t *inst = NULL;
+	clone_plugin_t *plug = NULL;
+	int result = -1;
+	int ret = -1;
+
+	inst = (cm_worker_instance_v2_t*)malloc(sizeof(cm_worker_instance_v2_t));
+	if (inst == NULL) {
+		result = -1;
+		goto err_return;
+	}
+
+	(void)memset(inst,0,sizeof(cm_worker_instance_v2_t));
+
+	plug = (clone_plugin_t*)malloc(sizeof(clone_plugin_t));
+	if (plug == NULL) {
+		result = -1;
+		goto err_return;
+	}
+	(void)memset(plug,0,sizeof(clone_plugin_t));
+
+	plug->buffer = (char*)malloc(CLONE_BUFFER_SIZE);
+	if (plug->buffer == NULL) {
+		result = -1;
+		goto err_return;
+	}
+
+	ret = libcmplug_child_init(&plug->child);
+	if (ret < 0) {
+		result = -1;
+		goto err_return;
+	}
+	plug->state = CLONE_STATE_IDLE;
+
+	inst->base.handle = (cm_worker_handle_t)plug;
+	inst->base.set_args = cm_worker_set_args;
+	inst->base.exec = cm_worker_exec;
+	inst->base.cancel = cm_worker_cancel;
+	inst->set_progress = cm_worker_set_progress;
+	inst->start = cm_worker_start;
+	inst->get_fd = cm_worker_get_fd;
+	inst->dispatch = cm_worker_dispatch;
+
+	(*instance) = &inst->base;
+
+	return 0;
+
+err_return:
+	if (plug != NULL) {
+		(void)free(plug->buffer);
+	}
+	(void)free(plug);
+
+	(void)free(inst);
+
+	return result;
+}
+/*
+ *  cm_worker_delete for clone plugin
+ */
+int cm_worker_delete(cm_worker_instance_t *instance)
+{
+	int result = -1;
+
+	if (instance == NULL) {
+		result = -1;
+		goto err_return;
+	}
+
+	if (instance->handle != NULL) {
+		clone_plugin_t *pclone = NULL;
+		pclone = (clone_plugin_t*)instance->handle;
+		(void)libcmplug_child_deinit(&pclone->child);
+		(void)free(pclone->blkdev_path);
+		(void)free(pclone->template_path);
+		(void)free(pclone->buffer);
+		(void)free(pclone);
+	}
+
+	// The instance is allocated as cm_worker_instance_v2_t, base is first member.
+	(void)free(instance);
+
+	return 0;
+err_return:
+	return result;
+}
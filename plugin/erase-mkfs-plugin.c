@@ -11,6 +11,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <poll.h>
@@ -28,6 +30,10 @@
 struct s_erase_mkfs_plugin {
 	char *blkdev_path;
 	int cancel_request;
+	int erase_method;		/**< Used erase method. ERASE_METHOD_XXX. */
+	uint64_t erase_total;	/**< Total erase size (byte). */
+	uint64_t erase_done;	/**< Erased size (byte). It use for progress. */
+	char cgroup_procs[256];	/**< cgroup.procs path to move mkfs process. Empty is not move. */
 };
 typedef struct s_erase_mkfs_plugin erase_mkfs_plugin_t;	/**< typedef for struct s_cm_worker_instance. */
 
@@ -77,7 +83,11 @@ static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, si
 					char *device = &substr[cstr_option_device_length];
 					size_t len = strlen(device);
 					if (len > 0u) {
+						(void) free(permkfs->blkdev_path);
 						permkfs->blkdev_path = strdup(device);
+						// New job, clear cancel request of previous job.
+						permkfs->cancel_request = 0;
+						(void) libcmplug_cgroup_procs_path(arg_str, permkfs->cgroup_procs, sizeof(permkfs->cgroup_procs));
 						result = 0;
 						#ifdef _PRINTF_DEBUG_
 						(void) fprintf(stdout,"erase-mkfs-plugin: cm_worker_set_args set device = %s\n", permkfs->blkdev_path);
@@ -174,14 +184,161 @@ do_return:
  */
 #define ERASE_BUFFER_SIZE	(8u*1024u*1024u)	// 8MByte buffer
 /**
- * @brief Function for disk erase execution.
+ * @def	ERASE_CHUNK_SIZE
+ * @brief	Range size of one erase ioctl.  Cancel request and progress are checked at each chunk.
+ */
+#define ERASE_CHUNK_SIZE	(8ull*1024ull*1024ull)	// 8MByte
+/**
+ * @def	ERASE_VERIFY_SIZE
+ * @brief	Read back size to verify zero after discard.
+ */
+#define ERASE_VERIFY_SIZE	(4096u)
+
+#define ERASE_METHOD_NONE			(0)	/**< Not erased. */
+#define ERASE_METHOD_SECDISCARD		(1)	/**< Erased by BLKSECDISCARD. */
+#define ERASE_METHOD_DISCARD		(2)	/**< Erased by BLKDISCARD. Read back data is zero. */
+#define ERASE_METHOD_ZEROOUT		(3)	/**< Erased by BLKZEROOUT. */
+#define ERASE_METHOD_WRITE			(4)	/**< Erased by zero write. */
+
+/**
+ * @brief Function for zero verify of discarded range.
+ *
+ * @param [in]	fd		File descriptor of block device.
+ * @param [in]	offset	Offset of verify range.
+ * @param [in]	length	Length of verify range.
+ * @return Description for return value
+ * @retval 0	Read back data is zero.
+ * @retval -1	Read back data is not zero or read error.
+ */
+static int cm_worker_erase_verify_zero(int fd, uint64_t offset, uint64_t length)
+{
+	uint64_t buf[ERASE_VERIFY_SIZE / sizeof(uint64_t)];
+	size_t size = ERASE_VERIFY_SIZE;
+	ssize_t sret = -1;
+
+	if (length < (uint64_t)size) {
+		size = (size_t)length;
+	}
+
+	// Check head of range and tail of range.
+	for (int i = 0; i < 2; i++) {
+		off_t pos = (off_t)offset;
+
+		if (i == 1) {
+			pos = (off_t)(offset + length - (uint64_t)size);
+		}
+
+		(void) memset(buf, 0xff, sizeof(buf));
+		sret = pread(fd, buf, size, pos);
+		if (sret != (ssize_t)size) {
+			return -1;
+		}
+
+		for (size_t j = 0; j < (size / sizeof(uint64_t)); j++) {
+			if (buf[j] != 0) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+/**
+ * @brief Function for disk erase by block device ioctl.
+ * This function try BLKSECDISCARD, BLKDISCARD with zero verify and BLKZEROOUT in order.  Erase operation is executed by chunk.
  *
  * @param [in]	permkfs		Initialized erase_mkfs_plugin_t.
+ * @param [in]	fd			File descriptor of block device.
  * @return Description for return value
- * @retval 0	Success to execute worker.
- * @retval -1	Fail to execute worker.
+ * @retval 1	Canceled.
+ * @retval 0	Success to erase.
+ * @retval -1	Not support ioctl erase, need to fallback.
  */
-static int cm_worker_exec_erase(erase_mkfs_plugin_t *permkfs)
+static int cm_worker_exec_erase_ioctl(erase_mkfs_plugin_t *permkfs, int fd)
+{
+	int ret = -1;
+	int method = ERASE_METHOD_SECDISCARD;
+	uint64_t offset = 0;
+
+	while (offset < permkfs->erase_total) {
+		uint64_t range[2];
+
+		if (permkfs->cancel_request == 1) {
+			// Got cancel request.
+			return 1;
+		}
+
+		range[0] = offset;
+		range[1] = permkfs->erase_total - offset;
+		if (range[1] > ERASE_CHUNK_SIZE) {
+			range[1] = ERASE_CHUNK_SIZE;
+		}
+
+		if (method == ERASE_METHOD_SECDISCARD) {
+			ret = ioctl(fd, BLKSECDISCARD, range);
+		} else if (method == ERASE_METHOD_DISCARD) {
+			ret = ioctl(fd, BLKDISCARD, range);
+			if (ret == 0) {
+				ret = cm_worker_erase_verify_zero(fd, range[0], range[1]);
+				if (ret < 0) {
+					// Discarded range is not read as zero, need to use zero out.
+					#ifdef _PRINTF_DEBUG_
+					(void) fprintf(stdout, "erase-mkfs-plugin: discard is not zeroed at %llu\n", (unsigned long long)offset);
+					#endif
+					errno = EOPNOTSUPP;
+				}
+			}
+		} else {
+			ret = ioctl(fd, BLKZEROOUT, range);
+		}
+
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (method == ERASE_METHOD_ZEROOUT) {
+				// No more ioctl method.
+				return -1;
+			}
+
+			if (method == ERASE_METHOD_SECDISCARD) {
+				if (offset != 0) {
+					// Secure discard is partially done, remaining range erase by zero out to keep same level.
+					method = ERASE_METHOD_ZEROOUT;
+				} else {
+					method = ERASE_METHOD_DISCARD;
+				}
+			} else {
+				method = ERASE_METHOD_ZEROOUT;
+			}
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout, "erase-mkfs-plugin: fallback to erase method %d at %llu\n", method, (unsigned long long)offset);
+			#endif
+			continue;
+		}
+
+		if (permkfs->erase_method < method) {
+			permkfs->erase_method = method;
+		}
+
+		offset += range[1];
+		permkfs->erase_done = offset;
+	}
+
+	return 0;
+}
+/**
+ * @brief Function for disk erase by zero write.
+ * This function is last fallback of disk erase.
+ *
+ * @param [in]	permkfs		Initialized erase_mkfs_plugin_t.
+ * @return Description for return value
+ * @retval 1	Canceled.
+ * @retval 0	Success to erase.
+ * @retval -1	Fail to erase.
+ */
+static int cm_worker_exec_erase_write(erase_mkfs_plugin_t *permkfs)
 {
 	int fd = -1;
 	int result = -1;
@@ -196,11 +353,14 @@ static int cm_worker_exec_erase(erase_mkfs_plugin_t *permkfs)
 
 	fd = open(permkfs->blkdev_path, O_CLOEXEC | O_SYNC | O_WRONLY);
 	#ifdef _PRINTF_DEBUG_
-	(void) fprintf(stdout, "erase-mkfs-plugin: cm_worker_exec_erase fd=%d\n",fd);
+	(void) fprintf(stdout, "erase-mkfs-plugin: cm_worker_exec_erase_write fd=%d\n",fd);
 	#endif
 	if (fd >= 0) {
 		ssize_t sret = -1;
 
+		permkfs->erase_method = ERASE_METHOD_WRITE;
+		permkfs->erase_done = 0;
+
 		do {
 			if (permkfs->cancel_request == 1) {
 				// Got cancel request.
@@ -208,6 +368,9 @@ static int cm_worker_exec_erase(erase_mkfs_plugin_t *permkfs)
 				goto do_return;
 			}
 			sret = write(fd, erase_buff, ERASE_BUFFER_SIZE);
+			if (sret > 0) {
+				permkfs->erase_done += (uint64_t)sret;
+			}
 		} while((sret > 0) && (errno != EINTR));
 
 		// Finally, sret = -1 and errno = 28(ENOSPC).
@@ -226,6 +389,60 @@ do_return:
 
 	return result;
 }
+/**
+ * @brief Function for disk erase execution.
+ * Erase strategy is BLKSECDISCARD, BLKDISCARD with zero verify, BLKZEROOUT and zero write in order.
+ *
+ * @param [in]	permkfs		Initialized erase_mkfs_plugin_t.
+ * @return Description for return value
+ * @retval 1	Canceled.
+ * @retval 0	Success to execute worker.
+ * @retval -1	Fail to execute worker.
+ */
+static int cm_worker_exec_erase(erase_mkfs_plugin_t *permkfs)
+{
+	int fd = -1;
+	int ret = -1;
+	int result = -1;
+	uint64_t size = 0;
+
+	permkfs->erase_method = ERASE_METHOD_NONE;
+	permkfs->erase_total = 0;
+	permkfs->erase_done = 0;
+
+	fd = open(permkfs->blkdev_path, O_CLOEXEC | O_RDWR);
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "erase-mkfs-plugin: cm_worker_exec_erase fd=%d\n",fd);
+	#endif
+	if (fd >= 0) {
+		ret = ioctl(fd, BLKGETSIZE64, &size);
+		if (ret == 0) {
+			permkfs->erase_total = size;
+			ret = cm_worker_exec_erase_ioctl(permkfs, fd);
+		} else {
+			ret = -1;
+		}
+		(void) close(fd);
+
+		if (ret >= 0) {
+			// Success or canceled.
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"erase-mkfs-plugin: erase end for %s method = %d (%llu/%llu)\n"
+							, permkfs->blkdev_path, permkfs->erase_method
+							, (unsigned long long)permkfs->erase_done, (unsigned long long)permkfs->erase_total);
+			#endif
+			result = ret;
+			goto do_return;
+		}
+	}
+
+	// Fallback to zero write.
+	result = cm_worker_exec_erase_write(permkfs);
+
+do_return:
+
+	return result;
+}
 /**
  * @brief Function for disk format execution.
  *
@@ -252,7 +469,10 @@ static int cm_worker_exec_mkfs(erase_mkfs_plugin_t *permkfs)
 	}
 
 	if (child_pid == 0) {
-		// exec /sbin/fsck.ext4 -p
+		if (permkfs->cgroup_procs[0] != '\0') {
+			(void) libcmplug_cgroup_attach_self(permkfs->cgroup_procs);
+		}
+		// exec /sbin/mkfs.ext4
 		(void) execlp("/sbin/mkfs.ext4", "/sbin/mkfs.ext4", "-I", "256", permkfs->blkdev_path, (char*)NULL);
 
 		// Shall not return execlp
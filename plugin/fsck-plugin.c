@@ -21,6 +21,28 @@
 #include <stdlib.h>
 #include <limits.h>
 
+#define FSCK_STATE_IDLE			(0)	/**< Worker is not started. */
+#define FSCK_STATE_WAIT_UNMOUNT	(1)	/**< Worker is waiting for unmount. */
+#define FSCK_STATE_JOURNAL		(2)	/**< Worker is running journal replay. */
+#define FSCK_STATE_CHECK		(3)	/**< Worker is running fsck. */
+#define FSCK_STATE_DONE			(4)	/**< Worker is completed. */
+
+/**
+ * @def	FSCK_UNMOUNT_WAIT_INTERVAL
+ * @brief	Interval of unmount test (ms).
+ */
+#define FSCK_UNMOUNT_WAIT_INTERVAL	(100)
+/**
+ * @def	FSCK_EXIT_UNCORRECTED
+ * @brief	Minimum exit code of e2fsck that means fail to recover.  4: errors left uncorrected, 8: operational error, etc.
+ */
+#define FSCK_EXIT_UNCORRECTED	(4)
+/**
+ * @def	FSCK_JOURNAL_BUDGET
+ * @brief	Time budget of journal replay (ms).  When it's expired, escalate to file system check.
+ */
+#define FSCK_JOURNAL_BUDGET	(10 * 1000)
+
 /**
  * @struct	s_fsck_plugin
  * @brief	The data structure for container manager workqueue worker instance.
@@ -28,6 +50,15 @@
 struct s_fsck_plugin {
 	char *blkdev_path;
 	int cancel_request;
+	int state;							/**< Worker state. FSCK_STATE_XXX. */
+	int retry_count;					/**< Remaining retry count of unmount wait. */
+	int result;							/**< Result of worker. 1: cancel, 0: success, -1: fail. */
+	int skip_journal;					/**< Skip journal replay and force full check. Set by "tier=check" option. */
+	int budget_expired;					/**< Time budget of current tier is expired. */
+	int64_t check_budget;				/**< Time budget of file system check (ms).  Set by "budget=" option, 0 is no limit. */
+	libcmplug_child_t child;			/**< Async child process control. */
+	cm_worker_progress_cb_t progress_cb;	/**< Progress callback. */
+	void *progress_userdata;			/**< The user data for progress callback. */
 };
 typedef struct s_fsck_plugin fsck_plugin_t;	/**< typedef for struct s_cm_worker_instance. */
 
@@ -36,6 +67,11 @@ typedef struct s_fsck_plugin fsck_plugin_t;	/**< typedef for struct s_cm_worker_
  * @brief	default signal to use guest container termination.
  */
 static const char *cstr_option_device = "device=";
+/**
+ * @var		cstr_option_tier
+ * @brief	Option key for first recovery tier. "check" skip journal replay.
+ */
+static const char *cstr_option_tier = "tier=";
 /**
  * @brief Function for argument set to erase and mkfs plugin.
  *
@@ -60,6 +96,17 @@ static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, si
 
 	pfsck = (fsck_plugin_t*)handle;
 
+	// Last tier is not limited unless host set budget.  When it's expired, fsck is failed and following recovery job may run.
+	pfsck->check_budget = libcmplug_arg_get_budget(arg_str);
+
+	// Previous recovery could not fix, host request to skip fast path.
+	pfsck->skip_journal = 0;
+	if (libcmplug_arg_get_value(arg_str, cstr_option_tier, strbuf, sizeof(strbuf)) == 0) {
+		if (strcmp(strbuf, "check") == 0) {
+			pfsck->skip_journal = 1;
+		}
+	}
+
 	strbuf[sizeof(strbuf)-1u] = '\0';
 	// Typically arg_length is set strlen(arg_str). In this case must set +1 byte to length argument at strncpy to add null terminate.
 	(void) strncpy(strbuf, arg_str, sizeof(strbuf) - 1u);
@@ -77,7 +124,11 @@ static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, si
 					char *device = &substr[cstr_option_device_length];
 					size_t len = strlen(device);
 					if (len > 0u) {
+						(void) free(pfsck->blkdev_path);
 						pfsck->blkdev_path = strdup(device);
+						// New job, clear cancel request of previous job.
+						(void) libcmplug_child_clear_cancel(&pfsck->child);
+						(void) libcmplug_cgroup_procs_path(arg_str, pfsck->child.cgroup_procs, sizeof(pfsck->child.cgroup_procs));
 						result = 0;
 						#ifdef _PRINTF_DEBUG_
 						(void) fprintf(stdout,"erase-mkfs-plugin: cm_worker_set_args set device = %s\n", pfsck->blkdev_path);
@@ -97,27 +148,31 @@ static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, si
 }
 static const char *cstr_block_device_test_base = "/sys/fs/ext4/";
 /**
- * @brief Function for unmont wait.
+ * @var		g_fsck_pass_percent
+ * @brief	Progress percent at start of each e2fsck pass.  It's same as e2fsck internal table.
+ */
+static const int g_fsck_pass_percent[] = {0, 70, 90, 92, 95, 100};
+/**
+ * @brief Function for unmount test.
  *
- * @param [in]	permkfs		Initialized erase_mkfs_plugin_t.
+ * @param [in]	pfsck		Initialized fsck_plugin_t.
  * @return Description for return value
- * @retval 0	Success to execute worker.
- * @retval -1	Fail to execute worker.
+ * @retval 1	Unmounted.
+ * @retval 0	Still mounted.
+ * @retval -1	Fail to test.
  */
-static int cm_worker_wait_unmount(fsck_plugin_t *pfsck)
+static int cm_worker_test_unmount(fsck_plugin_t *pfsck)
 {
-	int ret = -1, result = -1;
+	int ret = -1;
 	ssize_t slen = 0, buflen = 0;
 	char test_path[PATH_MAX];
 	const char *devname = NULL;
-	int retry_count = (5000 / 100);	//5000ms
 
 	// test to /sys/fs/ext4/block-device-name
 	devname = libcmplug_trimmed_devname(pfsck->blkdev_path);
 	if (devname == NULL) {
 		// pfsck->blkdev_path is not device name.
-		result = -1;
-		goto do_return;
+		return -1;
 	}
 
 	test_path[0] = '\0';
@@ -126,183 +181,425 @@ static int cm_worker_wait_unmount(fsck_plugin_t *pfsck)
 	slen = (ssize_t)snprintf(test_path, buflen, "%s%s", cstr_block_device_test_base, devname);
 	if (slen >= buflen) {
 		//May not cause this error.
-		result = -1;
-		goto do_return;
+		return -1;
+	}
+
+	ret = libcmplug_node_check(test_path);
+	if (ret == -1) {
+		// Already unmounted
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout, "fsck-plugin: cm_worker_test_unmount unmounted at %s\n",test_path);
+		#endif
+		return 1;
+	}
+
+	return 0;
+}
+/**
+ * @brief Function for progress report.
+ *
+ * @param [in]	pfsck		Initialized fsck_plugin_t.
+ * @param [in]	phase		Current phase. CM_WORKER_PHASE_XXX.
+ * @param [in]	percent		Progress of current phase.
+ * @return void
+ */
+static void cm_worker_report_progress(fsck_plugin_t *pfsck, int phase, int percent)
+{
+	if (pfsck->progress_cb != NULL) {
+		pfsck->progress_cb(pfsck->progress_userdata, phase, percent);
+	}
+}
+/**
+ * @brief Line callback for fsck progress output (-C fd).
+ * The line format is "pass current max device".
+ *
+ * @param [in]	userdata	Pointer to fsck_plugin_t.
+ * @param [in]	line		One line of progress output.
+ * @return void
+ */
+static void cm_worker_fsck_progress(void *userdata, const char *line)
+{
+	fsck_plugin_t *pfsck = (fsck_plugin_t*)userdata;
+	unsigned long current = 0, max = 0;
+	int pass = 0, percent = 0;
+
+	if (sscanf(line, "%d %lu %lu", &pass, &current, &max) != 3) {
+		return;
+	}
+
+	if ((pass < 1) || (pass >= (int)(sizeof(g_fsck_pass_percent)/sizeof(g_fsck_pass_percent[0]))) || (max == 0)) {
+		return;
+	}
+
+	if (current > max) {
+		current = max;
+	}
+
+	percent = g_fsck_pass_percent[pass - 1]
+				+ (int)(((unsigned long)(g_fsck_pass_percent[pass] - g_fsck_pass_percent[pass - 1]) * current) / max);
+
+	cm_worker_report_progress(pfsck, CM_WORKER_PHASE_CHECK, percent);
+}
+/**
+ * @brief Function for journal replay start.  It's first tier of recovery.
+ *
+ * @param [in]	pfsck		Initialized fsck_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to start journal replay.
+ * @retval -1	Fail to start journal replay.
+ */
+static int cm_worker_start_journal(fsck_plugin_t *pfsck)
+{
+	int ret = -1;
+	char *argv[] = {"/sbin/fsck.ext4", "-p", "-E", "journal_only", pfsck->blkdev_path, NULL};
+
+	// exec /sbin/fsck.ext4 -p -E journal_only
+	ret = libcmplug_child_spawn(&pfsck->child, argv, NULL, NULL);
+	if (ret < 0) {
+		return -1;
 	}
 
 	#ifdef _PRINTF_DEBUG_
-	(void) fprintf(stdout, "erase-mkfs-plugin: cm_worker_wait_unmount test to %s\n",test_path);
+	(void) fprintf(stdout, "fsck-plugin: fork and exec fsck.ext4 journal replay pid=%d\n",(int)pfsck->child.child_pid);
 	#endif
 
-	result = -1;
-	do {
-		ret = libcmplug_node_check(test_path);
-		if (ret == -1) {
-			// Already unmounted
-			result = 0;
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "erase-mkfs-plugin: cm_worker_wait_unmount unmounted at %s\n",test_path);
-			#endif
-			break;
-		}
+	pfsck->budget_expired = 0;
+	(void) libcmplug_child_set_timer(&pfsck->child, FSCK_JOURNAL_BUDGET);
+	pfsck->state = FSCK_STATE_JOURNAL;
+	cm_worker_report_progress(pfsck, CM_WORKER_PHASE_JOURNAL, 0);
 
-		libcmplug_sleep_ms_time(100ll);
-		retry_count--;
+	return 0;
+}
+/**
+ * @brief Function for fsck execution start.  It's second tier of recovery.
+ *
+ * @param [in]	pfsck		Initialized fsck_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to start fsck.
+ * @retval -1	Fail to start fsck.
+ */
+static int cm_worker_start_fsck(fsck_plugin_t *pfsck)
+{
+	int ret = -1;
+	char progress_fd[16];
+	char *argv[] = {"/sbin/fsck.ext4", "-p", "-C", progress_fd, pfsck->blkdev_path, NULL};
+	char *argv_force[] = {"/sbin/fsck.ext4", "-p", "-f", "-C", progress_fd, pfsck->blkdev_path, NULL};
 
-		if (pfsck->cancel_request == 1) {
-			// Got cancel request.
-			result = -1;
-			break;
-		}
+	(void) snprintf(progress_fd, sizeof(progress_fd), "%d", LIBCMPLUG_CHILD_PROGRESS_FD);
 
-	} while(retry_count > 0);
+	if (pfsck->skip_journal == 1) {
+		// Previous recovery could not fix, clean flag is not reliable.  exec /sbin/fsck.ext4 -p -f -C 3
+		ret = libcmplug_child_spawn(&pfsck->child, argv_force, cm_worker_fsck_progress, (void*)pfsck);
+	} else {
+		// exec /sbin/fsck.ext4 -p -C 3
+		ret = libcmplug_child_spawn(&pfsck->child, argv, cm_worker_fsck_progress, (void*)pfsck);
+	}
+	if (ret < 0) {
+		return -1;
+	}
 
 	#ifdef _PRINTF_DEBUG_
-	if (result == -1) {
-		(void) fprintf(stdout, "erase-mkfs-plugin: cm_worker_wait_unmount not unmounted at %s\n",test_path);
-	}
+	(void) fprintf(stdout, "fsck-plugin: fork and exec fsck.ext4 pid=%d\n",(int)pfsck->child.child_pid);
 	#endif
 
-do_return:
+	pfsck->budget_expired = 0;
+	(void) libcmplug_child_set_timer(&pfsck->child, pfsck->check_budget);
+	pfsck->state = FSCK_STATE_CHECK;
+	cm_worker_report_progress(pfsck, CM_WORKER_PHASE_CHECK, 0);
 
-	return result;
+	return 0;
 }
 /**
- * @brief Function pointer for container workqueue execution.
+ * @brief Function for recovery start after unmount.
+ *
+ * @param [in]	pfsck		Initialized fsck_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to start.
+ * @retval -1	Fail to start.
+ */
+static int cm_worker_start_recovery(fsck_plugin_t *pfsck)
+{
+	if (pfsck->skip_journal == 1) {
+		return cm_worker_start_fsck(pfsck);
+	}
+
+	return cm_worker_start_journal(pfsck);
+}
+/**
+ * @brief Function for worker completion.
+ *
+ * @param [in]	pfsck		Initialized fsck_plugin_t.
+ * @param [in]	result		Result of worker.
+ * @return void
+ */
+static void cm_worker_complete(fsck_plugin_t *pfsck, int result)
+{
+	(void) libcmplug_child_set_timer(&pfsck->child, 0);
+	pfsck->result = result;
+	pfsck->state = FSCK_STATE_DONE;
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "fsck-plugin: complete result = %d\n", result);
+	#endif
+}
+/**
+ * @brief Function pointer for async start to container workqueue worker.
  *
  * @param [in]	handle		Initialized cm_worker_handle_t.
  * @return Description for return value
- * @retval 0	Success to execute worker.
- * @retval -1	Fail to execute worker.
+ * @retval 0	Success to start worker.
+ * @retval -1	Fail to start worker.
  */
-static int cm_worker_exec(cm_worker_handle_t handle)
+static int cm_worker_start(cm_worker_handle_t handle)
 {
 	fsck_plugin_t *pfsck = NULL;
-	struct pollfd waiter[1];
-	siginfo_t child_info;
-	int result = -1;
 	int ret = -1;
-	int exit_code = -1;
-	int child_fd = -1;
-	pid_t child_pid = -1;
 
 	if (handle == NULL) {
-		result = -1;
-		goto do_return;
+		return -1;
 	}
 	pfsck = (fsck_plugin_t*)handle;
 
-	ret = cm_worker_wait_unmount(pfsck);
-	if (ret < 0) {
-		// No unmounted
-		result = -1;
-		goto do_return;
+	if (((pfsck->state != FSCK_STATE_IDLE) && (pfsck->state != FSCK_STATE_DONE)) || (pfsck->blkdev_path == NULL)) {
+		return -1;
 	}
 
-	child_pid = fork();
-	if (child_pid < 0) {
-		// Fail to fork
-		result = -1;
-		goto do_return;
+	pfsck->cancel_request = 0;
+	pfsck->child.cancel_request = 0;
+	pfsck->result = 0;
+	pfsck->retry_count = (5000 / FSCK_UNMOUNT_WAIT_INTERVAL);	//5000ms
+	pfsck->state = FSCK_STATE_WAIT_UNMOUNT;
+	cm_worker_report_progress(pfsck, CM_WORKER_PHASE_PREPARE, 0);
+
+	ret = cm_worker_test_unmount(pfsck);
+	if (ret < 0) {
+		pfsck->state = FSCK_STATE_IDLE;
+		return -1;
+	} else if (ret == 1) {
+		ret = cm_worker_start_recovery(pfsck);
+		if (ret < 0) {
+			pfsck->state = FSCK_STATE_IDLE;
+			return -1;
+		}
+	} else {
+		// Test again by interval timer.
+		ret = libcmplug_child_set_timer(&pfsck->child, FSCK_UNMOUNT_WAIT_INTERVAL);
+		if (ret < 0) {
+			pfsck->state = FSCK_STATE_IDLE;
+			return -1;
+		}
 	}
 
-	if (child_pid == 0) {
-		// exec /sbin/fsck.ext4 -p
-		(void) execlp("/sbin/fsck.ext4", "/sbin/fsck.ext4", "-p", pfsck->blkdev_path, (char*)NULL);
+	return 0;
+}
+/**
+ * @brief Function pointer for get pollable fd of container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval >=0	Pollable fd.
+ * @retval -1	Fail to get fd.
+ */
+static int cm_worker_get_fd(cm_worker_handle_t handle)
+{
+	fsck_plugin_t *pfsck = NULL;
 
-		// Shall not return execlp
-		(void) _exit(128);
+	if (handle == NULL) {
+		return -1;
 	}
+	pfsck = (fsck_plugin_t*)handle;
 
-	#ifdef _PRINTF_DEBUG_
-	(void) fprintf(stdout, "fsck-plugin: cm_worker_exec fork and exec fsck.ext4 pid=%d\n",(int)child_pid);
-	#endif
+	return pfsck->child.epoll_fd;
+}
+/**
+ * @brief Function pointer for dispatch of container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [out]	result		Result of worker when completed.
+ * @return Description for return value
+ * @retval 1	Worker is completed.
+ * @retval 0	Worker is running.
+ * @retval -1	Fail to dispatch.
+ */
+static int cm_worker_dispatch(cm_worker_handle_t handle, int *result)
+{
+	fsck_plugin_t *pfsck = NULL;
+	int events = 0;
+	int ret = -1;
+
+	if ((handle == NULL) || (result == NULL)) {
+		return -1;
+	}
+	pfsck = (fsck_plugin_t*)handle;
 
-	child_fd = libcmplug_pidfd_open(child_pid);
-	if (child_fd < 0) {
-		// Fail to fork
+	events = libcmplug_child_dispatch(&pfsck->child);
+	if (events < 0) {
+		cm_worker_complete(pfsck, -1);
 		goto do_return;
 	}
 
-	(void) memset(waiter, 0, sizeof(struct pollfd)*1u);
-	waiter[0].fd = child_fd;
-	waiter[0].events = POLLIN;
+	if ((events & LIBCMPLUG_CHILD_EVENT_CANCEL) != 0) {
+		pfsck->cancel_request = 1;
+	}
 
-	do {
-		ret = poll(waiter, 1, 100);	//100ms timeout
-		if (ret > 0) {
-			// Got a event
+	if (pfsck->state == FSCK_STATE_WAIT_UNMOUNT) {
+		if (pfsck->cancel_request == 1) {
+			// Got cancel request.
+			cm_worker_complete(pfsck, 1);
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			ret = cm_worker_test_unmount(pfsck);
+			if (ret == 1) {
+				(void) libcmplug_child_set_timer(&pfsck->child, 0);
+				ret = cm_worker_start_recovery(pfsck);
+				if (ret < 0) {
+					cm_worker_complete(pfsck, -1);
+				}
+			} else if (ret == 0) {
+				pfsck->retry_count--;
+				if (pfsck->retry_count <= 0) {
+					// No unmounted
+					#ifdef _PRINTF_DEBUG_
+					(void) fprintf(stdout, "fsck-plugin: not unmounted %s\n", pfsck->blkdev_path);
+					#endif
+					cm_worker_complete(pfsck, -1);
+				}
+			} else {
+				cm_worker_complete(pfsck, -1);
+			}
+		} else {
+			;	//nop
+		}
+	} else if (pfsck->state == FSCK_STATE_JOURNAL) {
+		if ((events & LIBCMPLUG_CHILD_EVENT_EXITED) != 0) {
 			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "fsck-plugin: cm_worker_exec got a exit fsck.ext4.\n");
+			(void) fprintf(stdout, "fsck-plugin: fsck.ext4 journal replay exit = %d\n", pfsck->child.exit_code);
 			#endif
-			break;
-		} else if (ret == 0) {
-			// Timeout
+			(void) libcmplug_child_set_timer(&pfsck->child, 0);
 			if (pfsck->cancel_request == 1) {
-				// Need to cancel
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout, "fsck-plugin: cm_worker_exec got a cancel request.\n");
-				#endif
-				ret = libcmplug_pidfd_send_signal(child_fd, SIGTERM, NULL, 0);
+				cm_worker_complete(pfsck, 1);
+			} else if ((pfsck->budget_expired == 0) && (pfsck->child.exit_code >= 0)
+						&& (pfsck->child.exit_code < FSCK_EXIT_UNCORRECTED) && (libcmplug_ext4_is_clean(pfsck->blkdev_path) == 1)) {
+				// Journal replay was enough.  Phase is kept to JOURNAL, host use it as recovery tier.
+				cm_worker_report_progress(pfsck, CM_WORKER_PHASE_JOURNAL, 100);
+				cm_worker_complete(pfsck, 0);
+			} else {
+				// Escalate to file system check.
+				ret = cm_worker_start_fsck(pfsck);
 				if (ret < 0) {
-					(void) kill(child_pid, SIGTERM);
+					cm_worker_complete(pfsck, -1);
 				}
-				break;
 			}
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			// Budget expired, wait exit of terminated process.
+			pfsck->budget_expired = 1;
+			(void) libcmplug_child_set_timer(&pfsck->child, 0);
+			(void) libcmplug_child_terminate(&pfsck->child);
 		} else {
-			if (errno != EINTR) {
-				// Can't wait child process.
-				int wait_status = 0;
-
-				(void) kill(child_pid, SIGTERM);
-				(void) waitpid(child_pid, &wait_status, 0);
-				result = -1;
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout, "fsck-plugin: cm_worker_exec fail (%d)\n", (int)errno);
-				#endif
-				goto do_return;
-			}
+			;	//nop
 		}
-	} while(1);
-
-	(void) memset(&child_info, 0, sizeof(child_info));
-
-	ret = waitid(P_PID, (id_t)child_pid, &child_info, WEXITED);
-	if (ret == 0) {
-		if (child_info.si_code == CLD_EXITED) {
-			// Exited
-			exit_code = child_info.si_status;
+	} else if (pfsck->state == FSCK_STATE_CHECK) {
+		if ((events & LIBCMPLUG_CHILD_EVENT_EXITED) != 0) {
 			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "fsck-plugin: cm_worker_exec fsck.ext4 exit = %d\n", exit_code);
+			(void) fprintf(stdout, "fsck-plugin: fsck.ext4 exit = %d\n", pfsck->child.exit_code);
 			#endif
+			cm_worker_report_progress(pfsck, CM_WORKER_PHASE_CHECK, 100);
+			if (pfsck->cancel_request == 1) {
+				cm_worker_complete(pfsck, 1);
+			} else if (pfsck->budget_expired == 1) {
+				// Budget expired.  Following recovery job may run.
+				cm_worker_complete(pfsck, -1);
+			} else if ((pfsck->child.exit_code < 0) || (pfsck->child.exit_code >= FSCK_EXIT_UNCORRECTED)) {
+				// File system errors left uncorrected or operational error.  Following recovery job may run.
+				cm_worker_complete(pfsck, -1);
+			} else {
+				cm_worker_complete(pfsck, 0);
+			}
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			// Budget expired, wait exit of terminated process.
+			pfsck->budget_expired = 1;
+			(void) libcmplug_child_set_timer(&pfsck->child, 0);
+			(void) libcmplug_child_terminate(&pfsck->child);
 		} else {
-			// Canceled
-			exit_code = 0;	// Set success
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "fsck-plugin: cm_worker_exec fsck.ext4 may canceled.\n");
-			#endif
+			;	//nop
 		}
 	} else {
-		result = -1;
-		#ifdef _PRINTF_DEBUG_
-		(void) fprintf(stdout, "fsck-plugin: cm_worker_exec waitid fail (%d)\n", (int)errno);
-		#endif
-		goto do_return;
+		;	//nop
 	}
 
-	if (pfsck->cancel_request == 1) {
-		result = 1;
-	} else {
-		result = 0;
+do_return:
+	if (pfsck->state == FSCK_STATE_DONE) {
+		(*result) = pfsck->result;
+		return 1;
 	}
 
-do_return:
-	if (child_fd >= 0) {
-		(void) close(child_fd);
+	return 0;
+}
+/**
+ * @brief Function pointer for container workqueue execution.
+ * This function execute worker by blocking, it's wrapper of async interface.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval 1	Canceled.
+ * @retval 0	Success to execute worker.
+ * @retval -1	Fail to execute worker.
+ */
+static int cm_worker_exec(cm_worker_handle_t handle)
+{
+	struct pollfd waiter[1];
+	int result = -1;
+	int ret = -1;
+
+	ret = cm_worker_start(handle);
+	if (ret < 0) {
+		return -1;
 	}
 
+	(void) memset(waiter, 0, sizeof(struct pollfd)*1u);
+	waiter[0].fd = cm_worker_get_fd(handle);
+	waiter[0].events = POLLIN;
+
+	do {
+		ret = poll(waiter, 1, -1);
+		if ((ret < 0) && (errno != EINTR)) {
+			// Can't wait child process. Child process is killed at cm_worker_delete.
+			result = -1;
+			break;
+		}
+
+		ret = cm_worker_dispatch(handle, &result);
+		if (ret < 0) {
+			result = -1;
+			break;
+		}
+	} while(ret == 0);
+
 	return result;
 }
+/**
+ * @brief Function pointer for set progress callback to container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [in]	callback	Progress callback.
+ * @param [in]	userdata	The user data for callback.
+ * @return Description for return value
+ * @retval 0	Success to set.
+ * @retval -1	Fail to set.
+ */
+static int cm_worker_set_progress(cm_worker_handle_t handle, cm_worker_progress_cb_t callback, void *userdata)
+{
+	fsck_plugin_t *pfsck = NULL;
+
+	if (handle == NULL) {
+		return -1;
+	}
+	pfsck = (fsck_plugin_t*)handle;
+
+	pfsck->progress_cb = callback;
+	pfsck->progress_userdata = userdata;
+
+	return 0;
+}
 /**
  * @brief Function pointer for cancel to container workqueue worker.
  *
@@ -321,27 +618,32 @@ int cm_worker_cancel(cm_worker_handle_t handle)
 
 	pfsck = (fsck_plugin_t*)handle;
 
-	pfsck->cancel_request = 1;
-
-	return 0;
+	return libcmplug_child_cancel(&pfsck->child);
+}
+/*
+ *  cm_worker_api_version for fsck plugin
+ */
+int cm_worker_api_version(void)
+{
+	return CM_WORKER_API_VERSION_2;
 }
-
 /*
  *  cm_worker_new for fsck plugin
  */
 int cm_worker_new(cm_worker_instance_t **instance)
 {
-	cm_worker_instance_t *inst = NULL;
+	cm_worker_instance_v2_t *inst = NULL;
 	fsck_plugin_t *plug = NULL;
 	int result = -1;
+	int ret = -1;
 
-	inst = (cm_worker_instance_t*)malloc(sizeof(cm_worker_instance_t));
+	inst = (cm_worker_instance_v2_t*)malloc(sizeof(cm_worker_instance_v2_t));
 	if (inst == NULL) {
 		result = -1;
 		goto err_return;
 	}
 
-	(void)memset(inst,0,sizeof(cm_worker_instance_t));
+	(void)memset(inst,0,sizeof(cm_worker_instance_v2_t));
 
 	plug = (fsck_plugin_t*)malloc(sizeof(fsck_plugin_t));
 	if (plug == NULL) {
@@ -350,12 +652,23 @@ int cm_worker_new(cm_worker_instance_t **instance)
 	}
 	(void)memset(plug,0,sizeof(fsck_plugin_t));
 
-	inst->handle = (cm_worker_handle_t)plug;
-	inst->set_args = cm_worker_set_args;
-	inst->exec = cm_worker_exec;
-	inst->cancel = cm_worker_cancel;
+	ret = libcmplug_child_init(&plug->child);
+	if (ret < 0) {
+		result = -1;
+		goto err_return;
+	}
+	plug->state = FSCK_STATE_IDLE;
+
+	inst->base.handle = (cm_worker_handle_t)plug;
+	inst->base.set_args = cm_worker_set_args;
+	inst->base.exec = cm_worker_exec;
+	inst->base.cancel = cm_worker_cancel;
+	inst->set_progress = cm_worker_set_progress;
+	inst->start = cm_worker_start;
+	inst->get_fd = cm_worker_get_fd;
+	inst->dispatch = cm_worker_dispatch;
 
-	(*instance) = inst;
+	(*instance) = &inst->base;
 
 	return 0;
 
@@ -381,13 +694,15 @@ int cm_worker_delete(cm_worker_instance_t *instance)
 	if (instance->handle != NULL) {
 		fsck_plugin_t *pfsck = NULL;
 		pfsck = (fsck_plugin_t*)instance->handle;
+		(void)libcmplug_child_deinit(&pfsck->child);
 		(void)free(pfsck->blkdev_path);
 		(void)free(pfsck);
 	}
 
+	// The instance is allocated as cm_worker_instance_v2_t, base is first member.
 	(void)free(instance);
 
 	return 0;
 err_return:
 	return result;
-}
\ No newline at end of file
+}
@@ -9,9 +9,17 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
 #include <errno.h>
 #include <time.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 int libcmplug_pidfd_open(pid_t pid)
 {
@@ -67,6 +75,205 @@ int libcmplug_node_check(const char *path)
 
 	return 0;
 }
+/**
+ * Get value of "key=value" style option from argument string.
+ *
+ * @param [in]	arg_str	Argument string. Options are separated by space.
+ * @param [in]	key		Option key include '='. (ex. "cgroup=")
+ * @param [out]	buf		Buffer to store value.
+ * @param [in]	size	Size of buffer.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Not found or too long value.
+ */
+int libcmplug_arg_get_value(const char *arg_str, const char *key, char *buf, size_t size)
+{
+	const char *str = NULL;
+	size_t len = 0, keylen = 0;
+
+	if ((arg_str == NULL) || (key == NULL) || (buf == NULL) || (size == 0)) {
+		return -1;
+	}
+
+	keylen = strlen(key);
+	str = arg_str;
+	while ((str = strstr(str, key)) != NULL) {
+		if ((str == arg_str) || (str[-1] == ' ')) {
+			break;
+		}
+		str = &str[keylen];
+	}
+	if (str == NULL) {
+		return -1;
+	}
+
+	str = &str[keylen];
+	len = strcspn(str, " ");
+	if ((len == 0) || (len >= size)) {
+		return -1;
+	}
+
+	(void) memcpy(buf, str, len);
+	buf[len] = '\0';
+
+	return 0;
+}
+/**
+ * Get time budget from "budget=" option in argument string.
+ * Host set budget option (sec) to limit last tier of recovery.
+ *
+ * @param [in]	arg_str	Argument string.
+ * @return int64_t
+ * @retval  >0 Time budget (ms).
+ * @retval  0 No limit.  No budget option or invalid value.
+ */
+int64_t libcmplug_arg_get_budget(const char *arg_str)
+{
+	char buf[32];
+	char *endptr = NULL;
+	long long budget = 0;
+
+	if (libcmplug_arg_get_value(arg_str, "budget=", buf, sizeof(buf)) < 0) {
+		return 0;
+	}
+
+	budget = strtoll(buf, &endptr, 10);
+	if ((endptr == buf) || (*endptr != '\0') || (budget <= 0) || (budget > (INT64_MAX / 1000))) {
+		return 0;
+	}
+
+	return ((int64_t)budget * 1000);
+}
+/**
+ * Create cgroup.procs path from "cgroup=" option in argument string.
+ * Host set cgroup option to throttle recovery I/O.
+ *
+ * @param [in]	arg_str	Argument string.
+ * @param [out]	buf		Buffer to store cgroup.procs path.  When no cgroup option, set empty string.
+ * @param [in]	size	Size of buffer.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 No cgroup option.
+ */
+int libcmplug_cgroup_procs_path(const char *arg_str, char *buf, size_t size)
+{
+	char cgroup[PATH_MAX];
+	int ret = -1;
+
+	buf[0] = '\0';
+
+	ret = libcmplug_arg_get_value(arg_str, "cgroup=", cgroup, sizeof(cgroup));
+	if (ret < 0) {
+		return -1;
+	}
+
+	ret = snprintf(buf, size, "%s/cgroup.procs", cgroup);
+	if (!((size_t)ret < size)) {
+		buf[0] = '\0';
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Move calling process to cgroup.
+ * This function is used in forked child process before exec.
+ *
+ * @param [in]	procs_path	Path to cgroup.procs.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to move.
+ */
+int libcmplug_cgroup_attach_self(const char *procs_path)
+{
+	int fd = -1;
+	ssize_t sret = -1;
+
+	fd = open(procs_path, (O_WRONLY | O_CLOEXEC));
+	if (fd < 0) {
+		return -1;
+	}
+
+	// "0" is calling process.
+	sret = write(fd, "0", 1);
+	(void) close(fd);
+	if (sret != 1) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Read state of ext2/3/4 file system from superblock.
+ * This function use only async-signal-safe system call, it can call from forked child process.
+ * It's shared by container manager and worker plugins.
+ *
+ * @param [in]	devpath		Device node path.  Ex. "/dev/mmcblk0p1"
+ * @param [out]	state		Pointer to store s_state.
+ * @param [out]	incompat	Pointer to store s_feature_incompat.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Not ext file system or fail to read.
+ */
+int libcmplug_ext4_read_state(const char *devpath, uint16_t *state, uint32_t *incompat)
+{
+	unsigned char sb[1024];
+	ssize_t sret = -1;
+	int fd = -1;
+
+	fd = open(devpath, (O_RDONLY | O_CLOEXEC));
+	if (fd < 0) {
+		return -1;
+	}
+
+	// ext superblock is at 1024.
+	sret = pread(fd, sb, sizeof(sb), 1024);
+	(void) close(fd);
+	if (sret != (ssize_t)sizeof(sb)) {
+		return -1;
+	}
+
+	// s_magic (0xEF53) at 56, s_state at 58, s_feature_incompat at 96.  All fields are little endian.
+	if ((sb[56] != 0x53u) || (sb[57] != 0xEFu)) {
+		return -1;
+	}
+	(*state) = (uint16_t)(sb[58] | (sb[59] << 8));
+	(*incompat) = (uint32_t)sb[96] | ((uint32_t)sb[97] << 8) | ((uint32_t)sb[98] << 16) | ((uint32_t)sb[99] << 24);
+
+	return 0;
+}
+/**
+ * The function of clean state test for ext2/3/4 file system.
+ * This function use only async-signal-safe system call, it can call from forked child process.
+ *
+ * @param [in]	devpath	Device node path.  Ex. "/dev/mmcblk0p1"
+ * @return int
+ * @retval  1 Clean.  Valid flag is set, error flag and journal recovery flag are not set.
+ * @retval  0 Not clean.
+ * @retval -1 Not ext file system or fail to read.
+ */
+int libcmplug_ext4_is_clean(const char *devpath)
+{
+	uint16_t state = 0;
+	uint32_t incompat = 0;
+	int ret = -1;
+
+	if (devpath == NULL) {
+		return -1;
+	}
+
+	ret = libcmplug_ext4_read_state(devpath, &state, &incompat);
+	if (ret < 0) {
+		return -1;
+	}
+
+	// EXT2_VALID_FS(0x1), EXT2_ERROR_FS(0x2) and INCOMPAT_RECOVER(0x4).
+	if (((state & 0x1u) == 0) || ((state & 0x2u) != 0) || ((incompat & 0x4u) != 0)) {
+		return 0;
+	}
+
+	return 1;
+}
 /**
  * Get monotonic time counter value by ms resolutions.
  *
@@ -120,4 +327,490 @@ void libcmplug_sleep_ms_time(int64_t wait_time)
 	}
 
 	return;
-}
\ No newline at end of file
+}
+/**
+ * Initialize async child process control.
+ * All event source is combined to one epoll fd.  Worker plugin expose the epoll fd as pollable fd.
+ *
+ * @param [in]	child	Pointer to libcmplug_child_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to initialize.
+ */
+int libcmplug_child_init(libcmplug_child_t *child)
+{
+	struct epoll_event ev;
+	int ret = -1;
+
+	if (child == NULL) {
+		return -1;
+	}
+
+	(void) memset(child, 0, sizeof(libcmplug_child_t));
+	child->epoll_fd = -1;
+	child->cancel_fd = -1;
+	child->timer_fd = -1;
+	child->child_fd = -1;
+	child->progress_fd = -1;
+	child->child_pid = -1;
+	child->exit_code = -1;
+
+	child->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (child->epoll_fd < 0) {
+		goto err_ret;
+	}
+
+	child->cancel_fd = eventfd(0, (EFD_CLOEXEC | EFD_NONBLOCK));
+	if (child->cancel_fd < 0) {
+		goto err_ret;
+	}
+
+	child->timer_fd = timerfd_create(CLOCK_MONOTONIC, (TFD_CLOEXEC | TFD_NONBLOCK));
+	if (child->timer_fd < 0) {
+		goto err_ret;
+	}
+
+	(void) memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = child->cancel_fd;
+	ret = epoll_ctl(child->epoll_fd, EPOLL_CTL_ADD, child->cancel_fd, &ev);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	(void) memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = child->timer_fd;
+	ret = epoll_ctl(child->epoll_fd, EPOLL_CTL_ADD, child->timer_fd, &ev);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	return 0;
+
+err_ret:
+	(void) libcmplug_child_deinit(child);
+
+	return -1;
+}
+/**
+ * Deinitialize async child process control.
+ * When child process is running, child process is killed.
+ *
+ * @param [in]	child	Pointer to libcmplug_child_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Arg. error.
+ */
+int libcmplug_child_deinit(libcmplug_child_t *child)
+{
+	if (child == NULL) {
+		return -1;
+	}
+
+	if (child->child_pid > 0) {
+		int wait_status = 0;
+
+		(void) kill(child->child_pid, SIGKILL);
+		(void) waitpid(child->child_pid, &wait_status, 0);
+		child->child_pid = -1;
+	}
+
+	if (child->progress_fd >= 0) {
+		(void) close(child->progress_fd);
+		child->progress_fd = -1;
+	}
+	if (child->child_fd >= 0) {
+		(void) close(child->child_fd);
+		child->child_fd = -1;
+	}
+	if (child->timer_fd >= 0) {
+		(void) close(child->timer_fd);
+		child->timer_fd = -1;
+	}
+	if (child->cancel_fd >= 0) {
+		(void) close(child->cancel_fd);
+		child->cancel_fd = -1;
+	}
+	if (child->epoll_fd >= 0) {
+		(void) close(child->epoll_fd);
+		child->epoll_fd = -1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function to start child process.  Child process exec argv or run func.
+ *
+ * @param [in]	child		Pointer to initialized libcmplug_child_t.
+ * @param [in]	argv		Argument vector to exec. NULL is run func.
+ * @param [in]	func		Function to run in child process. Used when argv is NULL.
+ * @param [in]	func_arg	Argument for func.
+ * @param [in]	line_cb		Line callback for progress pipe. NULL is no progress pipe.
+ * @param [in]	userdata	The user data for line callback.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to start.
+ */
+static int libcmplug_child_start(libcmplug_child_t *child, char *const argv[], libcmplug_child_func_t func, void *func_arg
+									, libcmplug_line_cb_t line_cb, void *userdata)
+{
+	struct epoll_event ev;
+	int pipefd[2] = {-1, -1};
+	pid_t pid = -1;
+	int ret = -1;
+
+	if (line_cb != NULL) {
+		ret = pipe2(pipefd, O_CLOEXEC);
+		if (ret < 0) {
+			return -1;
+		}
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		goto err_ret;
+	}
+
+	if (pid == 0) {
+		if (child->cgroup_procs[0] != '\0') {
+			(void) libcmplug_cgroup_attach_self(child->cgroup_procs);
+		}
+		if (pipefd[1] >= 0) {
+			if (pipefd[1] == LIBCMPLUG_CHILD_PROGRESS_FD) {
+				(void) fcntl(pipefd[1], F_SETFD, 0);
+			} else {
+				(void) dup2(pipefd[1], LIBCMPLUG_CHILD_PROGRESS_FD);
+			}
+		}
+		if (argv != NULL) {
+			(void) execv(argv[0], argv);
+
+			// Shall not return execv
+			(void) _exit(128);
+		}
+
+		ret = func(func_arg);
+		(void) _exit(ret);
+	}
+
+	child->child_pid = pid;
+	child->exit_code = -1;
+
+	if (pipefd[1] >= 0) {
+		(void) close(pipefd[1]);
+		pipefd[1] = -1;
+	}
+
+	child->child_fd = libcmplug_pidfd_open(pid);
+	if (child->child_fd < 0) {
+		goto err_ret;
+	}
+
+	(void) memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = child->child_fd;
+	ret = epoll_ctl(child->epoll_fd, EPOLL_CTL_ADD, child->child_fd, &ev);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	if (pipefd[0] >= 0) {
+		(void) fcntl(pipefd[0], F_SETFL, O_NONBLOCK);
+
+		(void) memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = pipefd[0];
+		ret = epoll_ctl(child->epoll_fd, EPOLL_CTL_ADD, pipefd[0], &ev);
+		if (ret < 0) {
+			goto err_ret;
+		}
+
+		child->progress_fd = pipefd[0];
+		child->line_cb = line_cb;
+		child->userdata = userdata;
+		child->line_len = 0;
+	}
+
+	return 0;
+
+err_ret:
+	if (child->child_pid > 0) {
+		int wait_status = 0;
+
+		(void) kill(child->child_pid, SIGKILL);
+		(void) waitpid(child->child_pid, &wait_status, 0);
+		child->child_pid = -1;
+	}
+	if (child->child_fd >= 0) {
+		(void) close(child->child_fd);
+		child->child_fd = -1;
+	}
+	if (pipefd[0] >= 0) {
+		(void) close(pipefd[0]);
+	}
+	if (pipefd[1] >= 0) {
+		(void) close(pipefd[1]);
+	}
+
+	return -1;
+}
+/**
+ * Spawn child process.
+ * When line_cb is not NULL, progress pipe is created and assigned to LIBCMPLUG_CHILD_PROGRESS_FD in child process.
+ *
+ * @param [in]	child		Pointer to initialized libcmplug_child_t.
+ * @param [in]	argv		Argument vector. argv[0] shall be absolute path of executable.
+ * @param [in]	line_cb		Line callback for progress pipe. NULL is no progress pipe.
+ * @param [in]	userdata	The user data for line callback.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to spawn.
+ */
+int libcmplug_child_spawn(libcmplug_child_t *child, char *const argv[], libcmplug_line_cb_t line_cb, void *userdata)
+{
+	if ((child == NULL) || (argv == NULL) || (argv[0] == NULL) || (child->child_pid > 0)) {
+		return -1;
+	}
+
+	return libcmplug_child_start(child, argv, NULL, NULL, line_cb, userdata);
+}
+/**
+ * Fork child process to run function.
+ * It's used for long I/O operation that is implemented in plugin.  Exit code of child process is return value of func.
+ * Child process is forked from multi thread process, func shall not use malloc or stdio.  Work memory shall be allocated before fork.
+ *
+ * @param [in]	child		Pointer to initialized libcmplug_child_t.
+ * @param [in]	func		Function to run in child process.
+ * @param [in]	func_arg	Argument for func.
+ * @param [in]	line_cb		Line callback for progress pipe. NULL is no progress pipe.
+ * @param [in]	userdata	The user data for line callback.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to fork.
+ */
+int libcmplug_child_fork(libcmplug_child_t *child, libcmplug_child_func_t func, void *func_arg, libcmplug_line_cb_t line_cb, void *userdata)
+{
+	if ((child == NULL) || (func == NULL) || (child->child_pid > 0)) {
+		return -1;
+	}
+
+	return libcmplug_child_start(child, NULL, func, func_arg, line_cb, userdata);
+}
+/**
+ * Set interval timer.
+ *
+ * @param [in]	child		Pointer to initialized libcmplug_child_t.
+ * @param [in]	interval_ms	Interval time (ms). Less than 1 is stop timer.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to set.
+ */
+int libcmplug_child_set_timer(libcmplug_child_t *child, int64_t interval_ms)
+{
+	struct itimerspec its;
+
+	if (child == NULL) {
+		return -1;
+	}
+
+	(void) memset(&its, 0, sizeof(its));
+	if (interval_ms > 0) {
+		its.it_interval.tv_sec = interval_ms / 1000;
+		its.it_interval.tv_nsec = (interval_ms % 1000) * 1000 * 1000;
+		its.it_value = its.it_interval;
+	}
+
+	return timerfd_settime(child->timer_fd, 0, &its, NULL);
+}
+/**
+ * Terminate running child process without cancel request.
+ * It's used when time budget of current operation is expired.  Exit is notified by LIBCMPLUG_CHILD_EVENT_EXITED.
+ *
+ * @param [in]	child		Pointer to initialized libcmplug_child_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 No running child process.
+ */
+int libcmplug_child_terminate(libcmplug_child_t *child)
+{
+	if ((child == NULL) || (child->child_fd < 0)) {
+		return -1;
+	}
+
+	if (libcmplug_pidfd_send_signal(child->child_fd, SIGTERM, NULL, 0) < 0) {
+		(void) kill(child->child_pid, SIGTERM);
+	}
+
+	return 0;
+}
+/**
+ * Cancel request.
+ * This function is thread safe.  Child process is terminated in libcmplug_child_dispatch.
+ *
+ * @param [in]	child	Pointer to initialized libcmplug_child_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to request.
+ */
+int libcmplug_child_cancel(libcmplug_child_t *child)
+{
+	uint64_t value = 1;
+	ssize_t sret = -1;
+
+	if (child == NULL) {
+		return -1;
+	}
+
+	sret = write(child->cancel_fd, &value, sizeof(value));
+	if (sret != (ssize_t)sizeof(value)) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Clear pending cancel request.
+ * It's used when instance is reused for new job.
+ *
+ * @param [in]	child	Pointer to initialized libcmplug_child_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Arg. error.
+ */
+int libcmplug_child_clear_cancel(libcmplug_child_t *child)
+{
+	uint64_t value = 0;
+
+	if (child == NULL) {
+		return -1;
+	}
+
+	// Non blocking eventfd, fail with EAGAIN when no pending request.
+	(void) read(child->cancel_fd, &value, sizeof(value));
+	child->cancel_request = 0;
+
+	return 0;
+}
+/**
+ * Sub function for read progress pipe and call line callback.
+ *
+ * @param [in]	child	Pointer to initialized libcmplug_child_t.
+ * @return void
+ */
+static void libcmplug_child_read_progress(libcmplug_child_t *child)
+{
+	char buf[256];
+	ssize_t sret = -1;
+
+	if (child->progress_fd < 0) {
+		return;
+	}
+
+	for (;;) {
+		sret = read(child->progress_fd, buf, sizeof(buf));
+		if (sret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		} else if (sret == 0) {
+			// Write side is closed.
+			(void) epoll_ctl(child->epoll_fd, EPOLL_CTL_DEL, child->progress_fd, NULL);
+			(void) close(child->progress_fd);
+			child->progress_fd = -1;
+			break;
+		}
+
+		for (ssize_t i = 0; i < sret; i++) {
+			if ((buf[i] == '\n') || (buf[i] == '\r') || (buf[i] == '\0')) {
+				if (child->line_len > 0u) {
+					child->line_buf[child->line_len] = '\0';
+					child->line_cb(child->userdata, child->line_buf);
+					child->line_len = 0;
+				}
+			} else if (child->line_len < (sizeof(child->line_buf) - 1u)) {
+				child->line_buf[child->line_len] = buf[i];
+				child->line_len++;
+			} else {
+				;	// Too long line, drop.
+			}
+		}
+	}
+
+	return;
+}
+/**
+ * Dispatch event of async child process control.
+ * This function shall call when epoll fd is readable.  This function is not blocking.
+ *
+ * @param [in]	child	Pointer to initialized libcmplug_child_t.
+ * @return int
+ * @retval >=0 Bit mask of got event. LIBCMPLUG_CHILD_EVENT_XXX.
+ * @retval -1 Fail to dispatch.
+ */
+int libcmplug_child_dispatch(libcmplug_child_t *child)
+{
+	struct epoll_event evs[4];
+	int events = 0;
+	int num = 0;
+
+	if (child == NULL) {
+		return -1;
+	}
+
+	num = epoll_wait(child->epoll_fd, evs, (int)(sizeof(evs)/sizeof(evs[0])), 0);
+	if (num < 0) {
+		if (errno == EINTR) {
+			return 0;
+		}
+		return -1;
+	}
+
+	for (int i = 0; i < num; i++) {
+		int fd = evs[i].data.fd;
+		uint64_t value = 0;
+
+		if (fd == child->cancel_fd) {
+			(void) read(child->cancel_fd, &value, sizeof(value));
+			child->cancel_request = 1;
+			events |= LIBCMPLUG_CHILD_EVENT_CANCEL;
+			if (child->child_fd >= 0) {
+				if (libcmplug_pidfd_send_signal(child->child_fd, SIGTERM, NULL, 0) < 0) {
+					(void) kill(child->child_pid, SIGTERM);
+				}
+			}
+		} else if (fd == child->timer_fd) {
+			(void) read(child->timer_fd, &value, sizeof(value));
+			events |= LIBCMPLUG_CHILD_EVENT_TIMER;
+		} else if (fd == child->progress_fd) {
+			libcmplug_child_read_progress(child);
+		} else if ((fd == child->child_fd) && (child->child_fd >= 0)) {
+			siginfo_t child_info;
+			int ret = -1;
+
+			(void) memset(&child_info, 0, sizeof(child_info));
+			ret = waitid(P_PID, (id_t)child->child_pid, &child_info, (WEXITED | WNOHANG));
+			if ((ret == 0) && (child_info.si_pid != 0)) {
+				if (child_info.si_code == CLD_EXITED) {
+					child->exit_code = child_info.si_status;
+				} else {
+					child->exit_code = -1;
+				}
+
+				// Flush remaining progress.
+				libcmplug_child_read_progress(child);
+
+				(void) epoll_ctl(child->epoll_fd, EPOLL_CTL_DEL, child->child_fd, NULL);
+				(void) close(child->child_fd);
+				child->child_fd = -1;
+				child->child_pid = -1;
+				events |= LIBCMPLUG_CHILD_EVENT_EXITED;
+			}
+		} else {
+			;	//nop
+		}
+	}
+
+	return events;
+}
@@ -13,10 +13,87 @@
 #include <signal.h>
 
 //-----------------------------------------------------------------------------
+/**
+ * @def	LIBCMPLUG_CHILD_EVENT_EXITED
+ * @brief	Child process was exited.  Exit code is stored to libcmplug_child_t.exit_code.
+ */
+#define LIBCMPLUG_CHILD_EVENT_EXITED	(0x1)
+/**
+ * @def	LIBCMPLUG_CHILD_EVENT_CANCEL
+ * @brief	Got cancel request.
+ */
+#define LIBCMPLUG_CHILD_EVENT_CANCEL	(0x2)
+/**
+ * @def	LIBCMPLUG_CHILD_EVENT_TIMER
+ * @brief	Interval timer was expired.
+ */
+#define LIBCMPLUG_CHILD_EVENT_TIMER		(0x4)
+
+/**
+ * @def	LIBCMPLUG_CHILD_PROGRESS_FD
+ * @brief	File descriptor number of progress pipe in child process.
+ */
+#define LIBCMPLUG_CHILD_PROGRESS_FD		(3)
+
+/**
+ * @brief Function pointer for line output of child process progress pipe.
+ *
+ * @param [in]	userdata	The user data that was set by libcmplug_child_spawn.
+ * @param [in]	line		One line of progress output without new line.
+ * @return void
+ */
+typedef void (*libcmplug_line_cb_t)(void *userdata, const char *line);
+
+/**
+ * @brief Function pointer for function that is run in forked child process.
+ *
+ * @param [in]	arg		The argument that was set by libcmplug_child_fork.
+ * @return int	Exit code of child process (0-127).
+ */
+typedef int (*libcmplug_child_func_t)(void *arg);
+
+/**
+ * @struct	s_libcmplug_child
+ * @brief	The data structure for async child process control in worker plugin.
+ */
+struct s_libcmplug_child {
+	int epoll_fd;					/**< epoll fd to combine all event source. It's pollable fd for worker plugin. */
+	int cancel_fd;					/**< eventfd for cancel request. */
+	int timer_fd;					/**< timerfd for interval operation. */
+	int child_fd;					/**< pidfd of child process. */
+	int progress_fd;				/**< Read side of progress pipe. */
+	pid_t child_pid;				/**< pid of child process. */
+	int exit_code;					/**< Exit code of child process. -1 is abnormal exit. */
+	int cancel_request;				/**< Got cancel request. */
+	libcmplug_line_cb_t line_cb;	/**< Line callback for progress pipe. */
+	void *userdata;					/**< The user data for line callback. */
+	size_t line_len;				/**< Length of buffered progress line. */
+	char line_buf[256];				/**< Buffer for progress line. */
+	char cgroup_procs[256];			/**< cgroup.procs path to move child process. Empty is not move. */
+};
+typedef struct s_libcmplug_child libcmplug_child_t;	/**< typedef for struct s_libcmplug_child. */
+
+//-----------------------------------------------------------------------------
+int libcmplug_child_init(libcmplug_child_t *child);
+int libcmplug_child_deinit(libcmplug_child_t *child);
+int libcmplug_child_spawn(libcmplug_child_t *child, char *const argv[], libcmplug_line_cb_t line_cb, void *userdata);
+int libcmplug_child_fork(libcmplug_child_t *child, libcmplug_child_func_t func, void *func_arg, libcmplug_line_cb_t line_cb, void *userdata);
+int libcmplug_child_set_timer(libcmplug_child_t *child, int64_t interval_ms);
+int libcmplug_child_terminate(libcmplug_child_t *child);
+int libcmplug_child_cancel(libcmplug_child_t *child);
+int libcmplug_child_clear_cancel(libcmplug_child_t *child);
+int libcmplug_child_dispatch(libcmplug_child_t *child);
+
 int libcmplug_pidfd_open(pid_t pid);
 int libcmplug_pidfd_send_signal(int pidfd, int sig, siginfo_t *info, unsigned int flags);
 const char *libcmplug_trimmed_devname(const char* devnode);
 int libcmplug_node_check(const char *path);
+int libcmplug_arg_get_value(const char *arg_str, const char *key, char *buf, size_t size);
+int64_t libcmplug_arg_get_budget(const char *arg_str);
+int libcmplug_cgroup_procs_path(const char *arg_str, char *buf, size_t size);
+int libcmplug_cgroup_attach_self(const char *procs_path);
+int libcmplug_ext4_read_state(const char *devpath, uint16_t *state, uint32_t *incompat);
+int libcmplug_ext4_is_clean(const char *devpath);
 int64_t libcmplug_get_current_time_ms(void);
 void libcmplug_sleep_ms_time(int64_t wait_time);
 //-----------------------------------------------------------------------------
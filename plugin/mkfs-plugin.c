@@ -21,6 +21,17 @@
 #include <stdlib.h>
 #include <limits.h>
 
+#define MKFS_STATE_IDLE			(0)	/**< Worker is not started. */
+#define MKFS_STATE_WAIT_UNMOUNT	(1)	/**< Worker is waiting for unmount. */
+#define MKFS_STATE_FORMAT		(2)	/**< Worker is running mkfs. */
+#define MKFS_STATE_DONE			(3)	/**< Worker is completed. */
+
+/**
+ * @def	MKFS_UNMOUNT_WAIT_INTERVAL
+ * @brief	Interval of unmount test (ms).
+ */
+#define MKFS_UNMOUNT_WAIT_INTERVAL	(100)
+
 /**
  * @struct	s_erase_mkfs_plugin
  * @brief	The data structure for container manager workqueue worker instance.
@@ -28,6 +39,14 @@
 struct s_mkfs_plugin {
 	char *blkdev_path;
 	int cancel_request;
+	int state;							/**< Worker state. MKFS_STATE_XXX. */
+	int retry_count;					/**< Remaining retry count of unmount wait. */
+	int result;							/**< Result of worker. 1: cancel, 0: success, -1: fail. */
+	int budget_expired;					/**< Time budget of mkfs is expired. */
+	int64_t budget;						/**< Time budget of mkfs (ms).  Set by "budget=" option, 0 is no limit. */
+	libcmplug_child_t child;			/**< Async child process control. */
+	cm_worker_progress_cb_t progress_cb;	/**< Progress callback. */
+	void *progress_userdata;			/**< The user data for progress callback. */
 };
 typedef struct s_mkfs_plugin mkfs_plugin_t;	/**< typedef for struct s_cm_worker_instance. */
 
@@ -60,6 +79,9 @@ static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, si
 
 	pmkfs = (mkfs_plugin_t*)handle;
 
+	// mkfs is not limited unless host set budget.
+	pmkfs->budget = libcmplug_arg_get_budget(arg_str);
+
 	strbuf[sizeof(strbuf)-1u] = '\0';
 	// Typically arg_length is set strlen(arg_str). In this case must set +1 byte to length argument at strncpy to add null terminate.
 	(void) strncpy(strbuf, arg_str, sizeof(strbuf) - 1u);
@@ -77,7 +99,11 @@ static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, si
 					char *device = &substr[cstr_option_device_length];
 					size_t len = strlen(device);
 					if (len > 0u) {
+						(void) free(pmkfs->blkdev_path);
 						pmkfs->blkdev_path = strdup(device);
+						// New job, clear cancel request of previous job.
+						(void) libcmplug_child_clear_cancel(&pmkfs->child);
+						(void) libcmplug_cgroup_procs_path(arg_str, pmkfs->child.cgroup_procs, sizeof(pmkfs->child.cgroup_procs));
 						result = 0;
 						#ifdef _PRINTF_DEBUG_
 						(void) fprintf(stdout,"mkfs-plugin: cm_worker_set_args set device = %s\n", pmkfs->blkdev_path);
@@ -98,27 +124,26 @@ static int cm_worker_set_args(cm_worker_handle_t handle, const char *arg_str, si
 
 static const char *cstr_block_device_test_base = "/sys/fs/ext4/";
 /**
- * @brief Function for unmount wait.
+ * @brief Function for unmount test.
  *
  * @param [in]	pmkfs		Initialized mkfs_plugin_t.
  * @return Description for return value
- * @retval 0	Success to execute worker.
- * @retval -1	Fail to execute worker.
+ * @retval 1	Unmounted.
+ * @retval 0	Still mounted.
+ * @retval -1	Fail to test.
  */
-static int cm_worker_wait_unmount(mkfs_plugin_t *pmkfs)
+static int cm_worker_test_unmount(mkfs_plugin_t *pmkfs)
 {
-	int ret = -1, result = -1;
+	int ret = -1;
 	ssize_t slen = 0, buflen = 0;
 	char test_path[PATH_MAX];
 	const char *devname = NULL;
-	int retry_count = (5000 / 100);	//5000ms
 
 	// test to /sys/fs/ext4/block-device-name
 	devname = libcmplug_trimmed_devname(pmkfs->blkdev_path);
 	if (devname == NULL) {
 		// pmkfs->blkdev_path is not device name.
-		result = -1;
-		goto do_return;
+		return -1;
 	}
 
 	test_path[0] = '\0';
@@ -127,219 +152,307 @@ static int cm_worker_wait_unmount(mkfs_plugin_t *pmkfs)
 	slen = (ssize_t)snprintf(test_path, buflen, "%s%s", cstr_block_device_test_base, devname);
 	if (slen >= buflen) {
 		//May not cause this error.
-		result = -1;
-		goto do_return;
+		return -1;
+	}
+
+	ret = libcmplug_node_check(test_path);
+	if (ret == -1) {
+		// Already unmounted
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout, "mkfs-plugin: cm_worker_test_unmount unmounted at %s\n",test_path);
+		#endif
+		return 1;
+	}
+
+	return 0;
+}
+/**
+ * @brief Function for progress report.
+ *
+ * @param [in]	pmkfs		Initialized mkfs_plugin_t.
+ * @param [in]	phase		Current phase. CM_WORKER_PHASE_XXX.
+ * @param [in]	percent		Progress of current phase.
+ * @return void
+ */
+static void cm_worker_report_progress(mkfs_plugin_t *pmkfs, int phase, int percent)
+{
+	if (pmkfs->progress_cb != NULL) {
+		pmkfs->progress_cb(pmkfs->progress_userdata, phase, percent);
+	}
+}
+/**
+ * @brief Function for disk format execution start.
+ *
+ * @param [in]	pmkfs		Initialized mkfs_plugin_t.
+ * @return Description for return value
+ * @retval 0	Success to start mkfs.
+ * @retval -1	Fail to start mkfs.
+ */
+static int cm_worker_start_mkfs(mkfs_plugin_t *pmkfs)
+{
+	int ret = -1;
+	char *argv[] = {"/sbin/mkfs.ext4", "-I", "256", pmkfs->blkdev_path, NULL};
+
+	// exec /sbin/mkfs.ext4 -I 256
+	ret = libcmplug_child_spawn(&pmkfs->child, argv, NULL, NULL);
+	if (ret < 0) {
+		return -1;
 	}
 
 	#ifdef _PRINTF_DEBUG_
-	(void) fprintf(stdout, "mkfs-plugin: cm_worker_wait_unmount test to %s\n",test_path);
+	(void) fprintf(stdout, "mkfs-plugin: fork and exec mkfs.ext4 pid=%d\n",(int)pmkfs->child.child_pid);
 	#endif
 
-	result = -1;
-	do {
-		ret = libcmplug_node_check(test_path);
-		if (ret == -1) {
-			// Already unmounted
-			result = 0;
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "mkfs-plugin: cm_worker_wait_unmount unmounted at %s\n",test_path);
-			#endif
-			break;
-		}
+	pmkfs->budget_expired = 0;
+	(void) libcmplug_child_set_timer(&pmkfs->child, pmkfs->budget);
+	pmkfs->state = MKFS_STATE_FORMAT;
+	cm_worker_report_progress(pmkfs, CM_WORKER_PHASE_FORMAT, 0);
 
-		libcmplug_sleep_ms_time(100ll);
-		retry_count--;
+	return 0;
+}
+/**
+ * @brief Function for worker completion.
+ *
+ * @param [in]	pmkfs		Initialized mkfs_plugin_t.
+ * @param [in]	result		Result of worker.
+ * @return void
+ */
+static void cm_worker_complete(mkfs_plugin_t *pmkfs, int result)
+{
+	(void) libcmplug_child_set_timer(&pmkfs->child, 0);
+	pmkfs->result = result;
+	pmkfs->state = MKFS_STATE_DONE;
 
-		if (pmkfs->cancel_request == 1) {
-			// Got cancel request.
-			result = -1;
-			break;
-		}
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "mkfs-plugin: complete result = %d\n", result);
+	#endif
+}
+/**
+ * @brief Function pointer for async start to container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @return Description for return value
+ * @retval 0	Success to start worker.
+ * @retval -1	Fail to start worker.
+ */
+static int cm_worker_start(cm_worker_handle_t handle)
+{
+	mkfs_plugin_t *pmkfs = NULL;
+	int ret = -1;
 
-	} while(retry_count > 0);
+	if (handle == NULL) {
+		return -1;
+	}
+	pmkfs = (mkfs_plugin_t*)handle;
 
-	#ifdef _PRINTF_DEBUG_
-	if (result == -1) {
-		(void) fprintf(stdout, "mkfs-plugin: cm_worker_wait_unmount not unmounted at %s\n",test_path);
+	if (((pmkfs->state != MKFS_STATE_IDLE) && (pmkfs->state != MKFS_STATE_DONE)) || (pmkfs->blkdev_path == NULL)) {
+		return -1;
 	}
-	#endif
 
-do_return:
+	pmkfs->cancel_request = 0;
+	pmkfs->child.cancel_request = 0;
+	pmkfs->result = 0;
+	pmkfs->retry_count = (5000 / MKFS_UNMOUNT_WAIT_INTERVAL);	//5000ms
+	pmkfs->state = MKFS_STATE_WAIT_UNMOUNT;
+	cm_worker_report_progress(pmkfs, CM_WORKER_PHASE_PREPARE, 0);
 
-	return result;
+	ret = cm_worker_test_unmount(pmkfs);
+	if (ret < 0) {
+		pmkfs->state = MKFS_STATE_IDLE;
+		return -1;
+	} else if (ret == 1) {
+		ret = cm_worker_start_mkfs(pmkfs);
+		if (ret < 0) {
+			pmkfs->state = MKFS_STATE_IDLE;
+			return -1;
+		}
+	} else {
+		// Test again by interval timer.
+		ret = libcmplug_child_set_timer(&pmkfs->child, MKFS_UNMOUNT_WAIT_INTERVAL);
+		if (ret < 0) {
+			pmkfs->state = MKFS_STATE_IDLE;
+			return -1;
+		}
+	}
+
+	return 0;
 }
 /**
- * @brief Function for disk format execution.
+ * @brief Function pointer for get pollable fd of container workqueue worker.
  *
- * @param [in]	pmkfs		Initialized erase_mkfs_plugin_t.
+ * @param [in]	handle		Initialized cm_worker_handle_t.
  * @return Description for return value
- * @retval 0	Success to execute worker.
- * @retval -1	Fail to execute worker.
+ * @retval >=0	Pollable fd.
+ * @retval -1	Fail to get fd.
  */
-static int cm_worker_exec_mkfs(mkfs_plugin_t *pmkfs)
+static int cm_worker_get_fd(cm_worker_handle_t handle)
 {
-	struct pollfd waiter[1];
-	siginfo_t child_info;
-	int result = -1;
-	int ret = -1;
-	int exit_code = -1;
-	int child_fd = -1;
-	pid_t child_pid = -1;
+	mkfs_plugin_t *pmkfs = NULL;
 
-	child_pid = fork();
-	if (child_pid < 0) {
-		// Fail to fork
-		result = -1;
-		goto do_return;
+	if (handle == NULL) {
+		return -1;
 	}
+	pmkfs = (mkfs_plugin_t*)handle;
 
-	if (child_pid == 0) {
-		// exec /sbin/fsck.ext4 -p
-		(void) execlp("/sbin/mkfs.ext4", "/sbin/mkfs.ext4", "-I", "256", pmkfs->blkdev_path, (char*)NULL);
+	return pmkfs->child.epoll_fd;
+}
+/**
+ * @brief Function pointer for dispatch of container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [out]	result		Result of worker when completed.
+ * @return Description for return value
+ * @retval 1	Worker is completed.
+ * @retval 0	Worker is running.
+ * @retval -1	Fail to dispatch.
+ */
+static int cm_worker_dispatch(cm_worker_handle_t handle, int *result)
+{
+	mkfs_plugin_t *pmkfs = NULL;
+	int events = 0;
+	int ret = -1;
 
-		// Shall not return execlp
-		(void) _exit(128);
+	if ((handle == NULL) || (result == NULL)) {
+		return -1;
 	}
+	pmkfs = (mkfs_plugin_t*)handle;
 
-	#ifdef _PRINTF_DEBUG_
-	(void) fprintf(stdout, "mkfs-plugin: cm_worker_exec fork and exec mkfs.ext4 pid=%d\n",(int)child_pid);
-	#endif
-
-	child_fd = libcmplug_pidfd_open(child_pid);
-	if (child_fd < 0) {
-		// Fail to fork
+	events = libcmplug_child_dispatch(&pmkfs->child);
+	if (events < 0) {
+		cm_worker_complete(pmkfs, -1);
 		goto do_return;
 	}
 
-	(void) memset(waiter, 0, sizeof(struct pollfd)*1u);
-	waiter[0].fd = child_fd;
-	waiter[0].events = POLLIN;
+	if ((events & LIBCMPLUG_CHILD_EVENT_CANCEL) != 0) {
+		pmkfs->cancel_request = 1;
+	}
 
-	do {
-		ret = poll(waiter, 1, 100);	//100ms timeout
-		if (ret > 0) {
-			// Got a event
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "mkfs-plugin: cm_worker_exec got a exit mkfs.ext4.\n");
-			#endif
-			break;
-		} else if (ret == 0) {
-			// Timeout
-			if (pmkfs->cancel_request == 1) {
-				// Need to cancel
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout, "mkfs-plugin: cm_worker_exec got a cancel request.\n");
-				#endif
-				ret = libcmplug_pidfd_send_signal(child_fd, SIGTERM, NULL, 0);
+	if (pmkfs->state == MKFS_STATE_WAIT_UNMOUNT) {
+		if (pmkfs->cancel_request == 1) {
+			// Got cancel request.
+			cm_worker_complete(pmkfs, 1);
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			ret = cm_worker_test_unmount(pmkfs);
+			if (ret == 1) {
+				(void) libcmplug_child_set_timer(&pmkfs->child, 0);
+				ret = cm_worker_start_mkfs(pmkfs);
 				if (ret < 0) {
-					(void) kill(child_pid, SIGTERM);
+					cm_worker_complete(pmkfs, -1);
+				}
+			} else if (ret == 0) {
+				pmkfs->retry_count--;
+				if (pmkfs->retry_count <= 0) {
+					// No unmounted
+					#ifdef _PRINTF_DEBUG_
+					(void) fprintf(stdout, "mkfs-plugin: not unmounted %s\n", pmkfs->blkdev_path);
+					#endif
+					cm_worker_complete(pmkfs, -1);
 				}
-				break;
+			} else {
+				cm_worker_complete(pmkfs, -1);
 			}
 		} else {
-			if (errno != EINTR) {
-				// Can't wait child process.
-				int wait_status = 0;
-
-				(void) kill(child_pid, SIGTERM);
-				(void) waitpid(child_pid, &wait_status, 0);
-				result = -1;
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout, "mkfs-plugin: cm_worker_exec fail (%d)\n", (int)errno);
-				#endif
-				goto do_return;
-			}
+			;	//nop
 		}
-	} while(1);
-
-	(void) memset(&child_info, 0, sizeof(child_info));
-
-	ret = waitid(P_PID, (id_t)child_pid, &child_info, WEXITED);
-	if (ret == 0) {
-		if (child_info.si_code == CLD_EXITED) {
-			// Exited
-			exit_code = child_info.si_status;
+	} else if (pmkfs->state == MKFS_STATE_FORMAT) {
+		if ((events & LIBCMPLUG_CHILD_EVENT_EXITED) != 0) {
 			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "mkfs-plugin: cm_worker_exec mkfs.ext4 exit = %d\n", exit_code);
+			(void) fprintf(stdout, "mkfs-plugin: mkfs.ext4 exit = %d\n", pmkfs->child.exit_code);
 			#endif
+			cm_worker_report_progress(pmkfs, CM_WORKER_PHASE_FORMAT, 100);
+			if (pmkfs->cancel_request == 1) {
+				cm_worker_complete(pmkfs, 1);
+			} else if ((pmkfs->budget_expired == 1) || (pmkfs->child.exit_code != 0)) {
+				cm_worker_complete(pmkfs, -1);
+			} else {
+				cm_worker_complete(pmkfs, 0);
+			}
+		} else if ((events & LIBCMPLUG_CHILD_EVENT_TIMER) != 0) {
+			// Budget expired, wait exit of terminated process.
+			pmkfs->budget_expired = 1;
+			(void) libcmplug_child_set_timer(&pmkfs->child, 0);
+			(void) libcmplug_child_terminate(&pmkfs->child);
 		} else {
-			// Canceled
-			exit_code = 0;	// Set success
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "mkfs-plugin: cm_worker_exec mkfs.ext4 may canceled.\n");
-			#endif
+			;	//nop
 		}
 	} else {
-		result = -1;
-		#ifdef _PRINTF_DEBUG_
-		(void) fprintf(stdout, "mkfs-plugin: cm_worker_exec waitid fail (%d)\n", (int)errno);
-		#endif
-		goto do_return;
-	}
-
-	if (pmkfs->cancel_request == 1) {
-		result = 1;
-	} else {
-		result = 0;
+		;	//nop
 	}
 
 do_return:
-	if (child_fd >= 0) {
-		(void) close(child_fd);
+	if (pmkfs->state == MKFS_STATE_DONE) {
+		(*result) = pmkfs->result;
+		return 1;
 	}
 
-	return result;
+	return 0;
 }
-
 /**
- * @brief Function for erase and mkfs plugin worker execution.
+ * @brief Function pointer for container workqueue execution.
+ * This function execute worker by blocking, it's wrapper of async interface.
  *
  * @param [in]	handle		Initialized cm_worker_handle_t.
  * @return Description for return value
+ * @retval 1	Canceled.
  * @retval 0	Success to execute worker.
  * @retval -1	Fail to execute worker.
  */
 static int cm_worker_exec(cm_worker_handle_t handle)
 {
-	mkfs_plugin_t *pmkfs = NULL;
+	struct pollfd waiter[1];
 	int result = -1;
 	int ret = -1;
 
-	if (handle == NULL) {
-		result = -1;
-		goto do_return;
-	}
-	pmkfs = (mkfs_plugin_t*)handle;
-
-	// unmount wait
-	ret = cm_worker_wait_unmount(pmkfs);
+	ret = cm_worker_start(handle);
 	if (ret < 0) {
-		result = -1;
-		goto do_return;
-	} else if (ret == 1) {
-		// Canceled
-		result = 1;
-		goto do_return;
-	} else {
-		result = 0;
+		return -1;
 	}
 
-	// Do mkfs
-	ret = cm_worker_exec_mkfs(pmkfs);
-	if (ret < 0) {
-		result = -1;
-	} else if (ret == 1) {
-		// Canceled
-		result = 1;
-		goto do_return;
-	} else {
-		result = 0;
-	}
+	(void) memset(waiter, 0, sizeof(struct pollfd)*1u);
+	waiter[0].fd = cm_worker_get_fd(handle);
+	waiter[0].events = POLLIN;
 
-do_return:
+	do {
+		ret = poll(waiter, 1, -1);
+		if ((ret < 0) && (errno != EINTR)) {
+			// Can't wait child process. Child process is killed at cm_worker_delete.
+			result = -1;
+			break;
+		}
+
+		ret = cm_worker_dispatch(handle, &result);
+		if (ret < 0) {
+			result = -1;
+			break;
+		}
+	} while(ret == 0);
 
 	return result;
 }
+/**
+ * @brief Function pointer for set progress callback to container workqueue worker.
+ *
+ * @param [in]	handle		Initialized cm_worker_handle_t.
+ * @param [in]	callback	Progress callback.
+ * @param [in]	userdata	The user data for callback.
+ * @return Description for return value
+ * @retval 0	Success to set.
+ * @retval -1	Fail to set.
+ */
+static int cm_worker_set_progress(cm_worker_handle_t handle, cm_worker_progress_cb_t callback, void *userdata)
+{
+	mkfs_plugin_t *pmkfs = NULL;
+
+	if (handle == NULL) {
+		return -1;
+	}
+	pmkfs = (mkfs_plugin_t*)handle;
+
+	pmkfs->progress_cb = callback;
+	pmkfs->progress_userdata = userdata;
+
+	return 0;
+}
 /**
  * @brief Function pointer for cancel to container workqueue worker.
  *
@@ -358,27 +471,32 @@ int cm_worker_cancel(cm_worker_handle_t handle)
 
 	pmkfs = (mkfs_plugin_t*)handle;
 
-	pmkfs->cancel_request = 1;
-
-	return 0;
+	return libcmplug_child_cancel(&pmkfs->child);
+}
+/*
+ *  cm_worker_api_version for mkfs plugin
+ */
+int cm_worker_api_version(void)
+{
+	return CM_WORKER_API_VERSION_2;
 }
-
 /*
- *  cm_worker_new for fsck plugin
+ *  cm_worker_new for mkfs plugin
  */
 int cm_worker_new(cm_worker_instance_t **instance)
 {
-	cm_worker_instance_t *inst = NULL;
+	cm_worker_instance_v2_t *inst = NULL;
 	mkfs_plugin_t *plug = NULL;
 	int result = -1;
+	int ret = -1;
 
-	inst = (cm_worker_instance_t*)malloc(sizeof(cm_worker_instance_t));
+	inst = (cm_worker_instance_v2_t*)malloc(sizeof(cm_worker_instance_v2_t));
 	if (inst == NULL) {
 		result = -1;
 		goto err_return;
 	}
 
-	(void)memset(inst,0,sizeof(cm_worker_instance_t));
+	(void)memset(inst,0,sizeof(cm_worker_instance_v2_t));
 
 	plug = (mkfs_plugin_t*)malloc(sizeof(mkfs_plugin_t));
 	if (plug == NULL) {
@@ -387,12 +505,23 @@ int cm_worker_new(cm_worker_instance_t **instance)
 	}
 	(void)memset(plug,0,sizeof(mkfs_plugin_t));
 
-	inst->handle = (cm_worker_handle_t)plug;
-	inst->set_args = cm_worker_set_args;
-	inst->exec = cm_worker_exec;
-	inst->cancel = cm_worker_cancel;
+	ret = libcmplug_child_init(&plug->child);
+	if (ret < 0) {
+		result = -1;
+		goto err_return;
+	}
+	plug->state = MKFS_STATE_IDLE;
+
+	inst->base.handle = (cm_worker_handle_t)plug;
+	inst->base.set_args = cm_worker_set_args;
+	inst->base.exec = cm_worker_exec;
+	inst->base.cancel = cm_worker_cancel;
+	inst->set_progress = cm_worker_set_progress;
+	inst->start = cm_worker_start;
+	inst->get_fd = cm_worker_get_fd;
+	inst->dispatch = cm_worker_dispatch;
 
-	(*instance) = inst;
+	(*instance) = &inst->base;
 
 	return 0;
 
@@ -404,7 +533,7 @@ err_return:
 	return result;
 }
 /*
- *  cm_worker_delete for fsck plugin
+ *  cm_worker_delete for mkfs plugin
  */
 int cm_worker_delete(cm_worker_instance_t *instance)
 {
@@ -418,13 +547,15 @@ int cm_worker_delete(cm_worker_instance_t *instance)
 	if (instance->handle != NULL) {
 		mkfs_plugin_t *pmkfs = NULL;
 		pmkfs = (mkfs_plugin_t*)instance->handle;
+		(void)libcmplug_child_deinit(&pmkfs->child);
 		(void)free(pmkfs->blkdev_path);
 		(void)free(pmkfs);
 	}
 
+	// The instance is allocated as cm_worker_instance_v2_t, base is first member.
 	(void)free(instance);
 
 	return 0;
 err_return:
 	return result;
-}
\ No newline at end of file
+}
@@ -7,10 +7,16 @@
 #undef _PRINTF_DEBUG_
 
 #include "block-util.h"
+#include "cm-worker-utils.h"
 
 #include <blkid/blkid.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 
 /**
  * The function of filesystem scan for block device.
@@ -88,3 +94,121 @@ error_ret:
 
 	return -1;
 }
+/**
+ * The function of physical disk lookup for block device.
+ * In case of partition, this function return device number of parent disk.  It's used to avoid parallel heavy I/O to same physical disk.
+ *
+ * @param [in]	devpath	Device node path.  Ex. "/dev/mmcblk0p1"
+ * @param [out]	disk	Pointer to dev_t to store device number of physical disk.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Not block device or fail to lookup.
+ */
+int block_util_get_disk(const char *devpath, dev_t *disk)
+{
+	struct stat sb;
+	char path[PATH_MAX];
+	char buf[32];
+	unsigned int dev_major = 0, dev_minor = 0;
+	ssize_t sret = -1;
+	int fd = -1, ret = -1;
+
+	if ((devpath == NULL) || (disk == NULL)) {
+		return -1;
+	}
+
+	ret = stat(devpath, &sb);
+	if ((ret < 0) || (!S_ISBLK(sb.st_mode))) {
+		return -1;
+	}
+
+	(void) snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/partition", major(sb.st_rdev), minor(sb.st_rdev));
+	if (access(path, F_OK) != 0) {
+		// Not partition, own is physical disk.
+		(*disk) = sb.st_rdev;
+		return 0;
+	}
+
+	// Parent directory of partition in sysfs is physical disk.
+	(void) snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/../dev", major(sb.st_rdev), minor(sb.st_rdev));
+	fd = open(path, (O_RDONLY | O_CLOEXEC));
+	if (fd < 0) {
+		return -1;
+	}
+
+	(void) memset(buf, 0, sizeof(buf));
+	sret = read(fd, buf, sizeof(buf) - 1u);
+	(void) close(fd);
+	if (sret <= 0) {
+		return -1;
+	}
+
+	if (sscanf(buf, "%u:%u", &dev_major, &dev_minor) != 2) {
+		return -1;
+	}
+
+	(*disk) = makedev(dev_major, dev_minor);
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "%s : physical disk = %u:%u\n", devpath, dev_major, dev_minor);
+	#endif
+
+	return 0;
+}
+/**
+ * The function of mount candidate probing for block device.
+ * This function probe file system superblock by blkid (blkid verify superblock checksum when the file system support it).
+ * In case of ext2/3/4, error state is tested also.  Journal recovery is not treated as error, it's normal state after power loss.
+ * This function does not mount the device, it's fast than failed mount of corrupted disk.
+ *
+ * @param [in]	devpath	Device node path.  Ex. "/dev/mmcblk0p1"
+ * @param [in]	fstype	Expected file system type.  When fstype == NULL, any file system is accepted.
+ * @return int
+ * @retval  1 Valid file system.
+ * @retval  0 Valid file system, but kernel was recorded error to the file system.
+ * @retval -1 No device, no file system or file system type mismatch.
+ */
+int block_util_probe_mount_candidate(const char *devpath, const char *fstype)
+{
+	block_device_info_t bdi;
+	uint16_t state = 0;
+	uint32_t incompat = 0;
+	int ret = -1;
+
+	if (devpath == NULL) {
+		return -1;
+	}
+
+	(void) memset(&bdi, 0, sizeof(bdi));
+
+	ret = block_util_getfs(devpath, &bdi);
+	if ((ret < 0) || (bdi.type[0] == '\0')) {
+		return -1;
+	}
+
+	if (strncmp(bdi.type, "ext", 3) == 0) {
+		if ((fstype != NULL) && (strncmp(fstype, "ext", 3) != 0)) {
+			return -1;
+		}
+
+		ret = libcmplug_ext4_read_state(devpath, &state, &incompat);
+		if (ret < 0) {
+			return -1;
+		}
+
+		// EXT2_VALID_FS(0x1) is cleared while mounted or journal recovery is needed, only EXT2_ERROR_FS(0x2) is error.
+		if ((state & 0x2u) != 0) {
+			return 0;
+		}
+	} else {
+		if ((fstype != NULL) && (strcmp(fstype, bdi.type) != 0)) {
+			return -1;
+		}
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "%s : valid mount candidate (%s)\n", devpath, bdi.type);
+	#endif
+
+	return 1;
+}
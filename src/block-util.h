@@ -9,6 +9,7 @@
 //-----------------------------------------------------------------------------
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/types.h>
 
 //-----------------------------------------------------------------------------
 /**
@@ -25,5 +26,7 @@ typedef struct s_block_device_info {
 } block_device_info_t;
 
 int block_util_getfs(const char *devpath, block_device_info_t *bdi);
+int block_util_get_disk(const char *devpath, dev_t *disk);
+int block_util_probe_mount_candidate(const char *devpath, const char *fstype);
 //-----------------------------------------------------------------------------
 #endif //#ifndef BLOCK_UTIL_H
@@ -0,0 +1,779 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	cgroup-device-bpf.c
+ * @brief	cgroup v2 device controller using eBPF for container manager.
+ */
+#include "cgroup-device-bpf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+
+#undef _PRINTF_DEBUG_
+
+/**
+ * @struct	s_cgroup_device_bpf
+ * @brief	The data structure for per guest cgroup v2 device controller.
+ */
+struct s_cgroup_device_bpf {
+	int map_fd;			/**< A fd of device rule map. */
+	int prog_fd;		/**< A fd of BPF_PROG_TYPE_CGROUP_DEVICE program. */
+	int is_attached;	/**< The program is attached to guest cgroup or not. 1: attached, 0: not attached. */
+};
+
+/**
+ * @struct	s_cgroup_device_bpf_key
+ * @brief	The key of device rule map. It must be same layout as a key in BPF program.
+ */
+struct s_cgroup_device_bpf_key {
+	uint32_t type;	/**< Device type. BPF_DEVCG_DEV_BLOCK, BPF_DEVCG_DEV_CHAR or CGROUP_DEVICE_BPF_WILDCARD. */
+	uint32_t major;	/**< Device major number or CGROUP_DEVICE_BPF_WILDCARD. */
+	uint32_t minor;	/**< Device minor number or CGROUP_DEVICE_BPF_WILDCARD. */
+};
+typedef struct s_cgroup_device_bpf_key cgroup_device_bpf_key_t;	/**< typedef for struct s_cgroup_device_bpf_key. */
+
+/**
+ * @def	CGROUP_DEVICE_BPF_WILDCARD
+ * @brief	Wildcard value for the device rule map key.
+ */
+#define CGROUP_DEVICE_BPF_WILDCARD	(0xffffffffu)
+/**
+ * @def	CGROUP_DEVICE_BPF_ACC_ALL
+ * @brief	All access bits (mknod, read, write).
+ */
+#define CGROUP_DEVICE_BPF_ACC_ALL	(BPF_DEVCG_ACC_MKNOD | BPF_DEVCG_ACC_READ | BPF_DEVCG_ACC_WRITE)
+/**
+ * @def	CGROUP_DEVICE_BPF_PROG_MAX
+ * @brief	Maximum number of instructions for device controller program.
+ */
+#define CGROUP_DEVICE_BPF_PROG_MAX	(96)
+/**
+ * @def	CGROUP_DEVICE_BPF_QUERY_MAX
+ * @brief	Maximum number of programs to query from one cgroup.
+ */
+#define CGROUP_DEVICE_BPF_QUERY_MAX	(16)
+
+/**
+ * @def	CDB_INSN
+ * @brief	Create one BPF instruction.
+ */
+#define CDB_INSN(CODE, DST, SRC, OFF, IMM)	\
+	((struct bpf_insn) { .code = (CODE), .dst_reg = (DST), .src_reg = (SRC), .off = (OFF), .imm = (IMM) })
+
+static const char g_cgroup_v2_base_path[] = "/sys/fs/cgroup";
+static const char g_lxc_payload_prefix[] = "lxc.payload";
+
+/**
+ * Wrapper for bpf system call.
+ *
+ * @param [in]	cmd		bpf command.
+ * @param [in]	attr	Pointer to union bpf_attr.
+ * @return int
+ * @retval >=0	Success to bpf system call.
+ * @retval -1	Fail to bpf system call.
+ */
+static int cgroup_device_bpf_syscall(int cmd, union bpf_attr *attr)
+{
+	return (int)syscall(__NR_bpf, cmd, attr, sizeof(union bpf_attr));
+}
+/**
+ * Sub function for program load.
+ * Create a device controller program that lookup device rule map.
+ * The lookup keys are (type, major, minor), (type, major, *), (type, *, minor), (type, *, *) and (*, *, *).
+ * Same as cgroup v1 devices controller, (*, *, *) entry select default behavior.
+ * In default deny, access is allowed when any matched entry allows it (access bits are OR of matched entries).
+ * In default allow, access is denied when any matched entry denies it (access bits are AND of matched entries).
+ *
+ * @param [in]	map_fd	A fd of device rule map.
+ * @return int
+ * @retval >=0	A fd of loaded program.
+ * @retval -1	Fail to load program.
+ */
+static int cgroup_device_bpf_load_program(int map_fd)
+{
+	struct bpf_insn insn[CGROUP_DEVICE_BPF_PROG_MAX];
+	union bpf_attr attr;
+	int pc = 0;
+	int ret = -1;
+
+	(void) memset(insn, 0, sizeof(insn));
+
+	// r6 = ctx, r7 = device type, r8 = requested access
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);
+	insn[pc++] = CDB_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_7, BPF_REG_6, 0, 0);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_8, BPF_REG_7, 0, 0);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_RSH | BPF_K, BPF_REG_8, 0, 0, 16);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_7, 0, 0, 0xffff);
+
+	// key on stack: fp-16 = type, fp-12 = major, fp-8 = minor
+	insn[pc++] = CDB_INSN(BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_7, -16, 0);
+	insn[pc++] = CDB_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_1, BPF_REG_6, 4, 0);
+	insn[pc++] = CDB_INSN(BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_1, -12, 0);
+	insn[pc++] = CDB_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_1, BPF_REG_6, 8, 0);
+	insn[pc++] = CDB_INSN(BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_1, -8, 0);
+
+	// Device type is in key, reuse r7 as AND of matched access. r9 = OR of matched access.
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_7, 0, 0, CGROUP_DEVICE_BPF_ACC_ALL);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_9, 0, 0, 0);
+
+	for (int i = 0; i < 5; i++) {
+		if ((i == 1) || (i == 3)) {
+			// minor wildcard
+			insn[pc++] = CDB_INSN(BPF_ST | BPF_MEM | BPF_W, BPF_REG_10, 0, -8, -1);
+		} else if (i == 2) {
+			// major wildcard with minor (ex. "c *:5"), restore minor. r1-r5 are clobbered by helper call.
+			insn[pc++] = CDB_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_1, BPF_REG_6, 8, 0);
+			insn[pc++] = CDB_INSN(BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_1, -8, 0);
+			insn[pc++] = CDB_INSN(BPF_ST | BPF_MEM | BPF_W, BPF_REG_10, 0, -12, -1);
+		} else if (i == 4) {
+			// type wildcard
+			insn[pc++] = CDB_INSN(BPF_ST | BPF_MEM | BPF_W, BPF_REG_10, 0, -16, -1);
+		} else {
+			;	//nop
+		}
+
+		// r0 = bpf_map_lookup_elem(map, fp-16)
+		insn[pc++] = CDB_INSN(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd);
+		insn[pc++] = CDB_INSN(0, 0, 0, 0, 0);
+		insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0);
+		insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -16);
+		insn[pc++] = CDB_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem);
+
+		if (i < 4) {
+			// Found rule, accumulate access bits.
+			insn[pc++] = CDB_INSN(BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 3, 0);
+			insn[pc++] = CDB_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_1, BPF_REG_0, 0, 0);
+			insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_OR | BPF_X, BPF_REG_9, BPF_REG_1, 0, 0);
+			insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_AND | BPF_X, BPF_REG_7, BPF_REG_1, 0, 0);
+		}
+	}
+
+	// (*, *, *) found: default allow, use AND. Not found: default deny, use OR.
+	insn[pc++] = CDB_INSN(BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 2, 0);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_1, BPF_REG_7, 0, 0);
+	insn[pc++] = CDB_INSN(BPF_JMP | BPF_JA, 0, 0, 1, 0);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_1, BPF_REG_9, 0, 0);
+
+	// Allow when all requested access bits are set.
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_AND | BPF_X, BPF_REG_1, BPF_REG_8, 0, 0);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, 0);
+	insn[pc++] = CDB_INSN(BPF_JMP | BPF_JNE | BPF_X, BPF_REG_1, BPF_REG_8, 1, 0);
+	insn[pc++] = CDB_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, 1);
+	insn[pc++] = CDB_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_CGROUP_DEVICE;
+	attr.insns = (uint64_t)(uintptr_t)insn;
+	attr.insn_cnt = (uint32_t)pc;
+	attr.license = (uint64_t)(uintptr_t)"GPL";
+
+	ret = cgroup_device_bpf_syscall(BPF_PROG_LOAD, &attr);
+	if (ret < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"cgroup_device_bpf_load_program: fail to load (%d)\n", errno);
+		#endif
+		return -1;
+	}
+
+	return ret;
+}
+/**
+ * Sub function for device rule map operation.
+ *
+ * @param [in]	cdb		Pointer to cgroup_device_bpf_t.
+ * @param [in]	key		Pointer to cgroup_device_bpf_key_t.
+ * @param [out]	value	Pointer to access bits buffer.
+ * @return int
+ * @retval 0	Found entry.
+ * @retval -1	Not found entry.
+ */
+static int cgroup_device_bpf_map_lookup(cgroup_device_bpf_t *cdb, cgroup_device_bpf_key_t *key, uint32_t *value)
+{
+	union bpf_attr attr;
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.map_fd = (uint32_t)cdb->map_fd;
+	attr.key = (uint64_t)(uintptr_t)key;
+	attr.value = (uint64_t)(uintptr_t)value;
+
+	return cgroup_device_bpf_syscall(BPF_MAP_LOOKUP_ELEM, &attr);
+}
+/**
+ * Sub function for device rule map operation.
+ *
+ * @param [in]	cdb		Pointer to cgroup_device_bpf_t.
+ * @param [in]	key		Pointer to cgroup_device_bpf_key_t.
+ * @param [in]	value	Access bits.
+ * @return int
+ * @retval 0	Success to update.
+ * @retval -1	Fail to update.
+ */
+static int cgroup_device_bpf_map_update(cgroup_device_bpf_t *cdb, cgroup_device_bpf_key_t *key, uint32_t value)
+{
+	union bpf_attr attr;
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.map_fd = (uint32_t)cdb->map_fd;
+	attr.key = (uint64_t)(uintptr_t)key;
+	attr.value = (uint64_t)(uintptr_t)&value;
+	attr.flags = BPF_ANY;
+
+	return cgroup_device_bpf_syscall(BPF_MAP_UPDATE_ELEM, &attr);
+}
+/**
+ * Sub function for device rule map operation.
+ *
+ * @param [in]	cdb		Pointer to cgroup_device_bpf_t.
+ * @param [in]	key		Pointer to cgroup_device_bpf_key_t.
+ * @return int
+ * @retval 0	Success to delete.
+ * @retval -1	Fail to delete or not found.
+ */
+static int cgroup_device_bpf_map_delete(cgroup_device_bpf_t *cdb, cgroup_device_bpf_key_t *key)
+{
+	union bpf_attr attr;
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.map_fd = (uint32_t)cdb->map_fd;
+	attr.key = (uint64_t)(uintptr_t)key;
+
+	return cgroup_device_bpf_syscall(BPF_MAP_DELETE_ELEM, &attr);
+}
+/**
+ * Sub function for device rule map operation.
+ * Remove all entry from device rule map.
+ *
+ * @param [in]	cdb		Pointer to cgroup_device_bpf_t.
+ * @return int
+ * @retval 0	Success to clear.
+ */
+static int cgroup_device_bpf_map_clear(cgroup_device_bpf_t *cdb)
+{
+	union bpf_attr attr;
+	cgroup_device_bpf_key_t key;
+	int ret = -1;
+
+	do {
+		(void) memset(&key, 0, sizeof(key));
+		(void) memset(&attr, 0, sizeof(attr));
+		attr.map_fd = (uint32_t)cdb->map_fd;
+		attr.key = 0;	// Get first key.
+		attr.next_key = (uint64_t)(uintptr_t)&key;
+
+		ret = cgroup_device_bpf_syscall(BPF_MAP_GET_NEXT_KEY, &attr);
+		if (ret == 0) {
+			(void) cgroup_device_bpf_map_delete(cdb, &key);
+		}
+	} while (ret == 0);
+
+	return 0;
+}
+/**
+ * Sub function for rule parse.
+ * Parse major or minor number with wildcard.
+ *
+ * @param [in]	str		Pointer to number string.
+ * @param [out]	endptr	Pointer to the end of number.
+ * @param [out]	value	Pointer to parsed value.
+ * @return int
+ * @retval 0	Success to parse.
+ * @retval -1	Parse error.
+ */
+static int cgroup_device_bpf_parse_number(const char *str, const char **endptr, uint32_t *value)
+{
+	char *pend = NULL;
+	unsigned long num = 0;
+
+	if (str[0] == '*') {
+		(*value) = CGROUP_DEVICE_BPF_WILDCARD;
+		(*endptr) = &str[1];
+		return 0;
+	}
+
+	num = strtoul(str, &pend, 10);
+	if ((pend == str) || (num >= CGROUP_DEVICE_BPF_WILDCARD)) {
+		return -1;
+	}
+
+	(*value) = (uint32_t)num;
+	(*endptr) = pend;
+
+	return 0;
+}
+/**
+ * Sub function for rule parse.
+ * Parse a device rule string that is same format as devices.allow. (ex. "c 1:3 rwm", "b 8:* rw", "a")
+ *
+ * @param [in]	rule	Pointer to rule string.
+ * @param [out]	key		Pointer to cgroup_device_bpf_key_t.
+ * @param [out]	access	Pointer to access bits.
+ * @return int
+ * @retval 0	Success to parse.
+ * @retval -1	Parse error.
+ */
+static int cgroup_device_bpf_parse_rule(const char *rule, cgroup_device_bpf_key_t *key, uint32_t *access)
+{
+	const char *p = rule;
+	int ret = -1;
+
+	key->type = CGROUP_DEVICE_BPF_WILDCARD;
+	key->major = CGROUP_DEVICE_BPF_WILDCARD;
+	key->minor = CGROUP_DEVICE_BPF_WILDCARD;
+	(*access) = CGROUP_DEVICE_BPF_ACC_ALL;
+
+	if (p[0] == 'a') {
+		return 0;
+	} else if (p[0] == 'b') {
+		key->type = BPF_DEVCG_DEV_BLOCK;
+	} else if (p[0] == 'c') {
+		key->type = BPF_DEVCG_DEV_CHAR;
+	} else {
+		return -1;
+	}
+	p++;
+
+	while (p[0] == ' ') {
+		p++;
+	}
+
+	if (p[0] == '\0') {
+		return 0;
+	}
+
+	ret = cgroup_device_bpf_parse_number(p, &p, &key->major);
+	if ((ret < 0) || (p[0] != ':')) {
+		return -1;
+	}
+	p++;
+
+	ret = cgroup_device_bpf_parse_number(p, &p, &key->minor);
+	if (ret < 0) {
+		return -1;
+	}
+
+	while (p[0] == ' ') {
+		p++;
+	}
+
+	if (p[0] != '\0') {
+		(*access) = 0;
+		for (; p[0] != '\0'; p++) {
+			if (p[0] == 'r') {
+				(*access) |= BPF_DEVCG_ACC_READ;
+			} else if (p[0] == 'w') {
+				(*access) |= BPF_DEVCG_ACC_WRITE;
+			} else if (p[0] == 'm') {
+				(*access) |= BPF_DEVCG_ACC_MKNOD;
+			} else {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+/**
+ * Set a device rule to per guest device map.
+ * When the device controller program was attached, it take effect immediately.
+ * A rule "a" reset all rules, allow "a" is mean all device allow and deny "a" is mean all device deny.
+ * Other rules are exceptions of the default, same as cgroup v1 devices controller.
+ *
+ * @param [in]	cdb			Pointer to cgroup_device_bpf_t.
+ * @param [in]	is_allow	This rule is allow or deny? deny: ==0, allow: !=0.
+ * @param [in]	rule		Device rule string that is same format as devices.allow. (ex. "c 1:3 rwm")
+ * @return int
+ * @retval 0	Success to set rule.
+ * @retval -1	Rule parse error.
+ * @retval -2	Map operation error.
+ * @retval -3	Argument error.
+ */
+int cgroup_device_bpf_set_rule(cgroup_device_bpf_t *cdb, int is_allow, const char *rule)
+{
+	cgroup_device_bpf_key_t key;
+	cgroup_device_bpf_key_t any_key;
+	uint32_t access = 0, value = 0, default_access = 0;
+	int ret = -1;
+
+	if ((cdb == NULL) || (rule == NULL)) {
+		return -3;
+	}
+
+	ret = cgroup_device_bpf_parse_rule(rule, &key, &access);
+	if (ret < 0) {
+		return -1;
+	}
+
+	if (key.type == CGROUP_DEVICE_BPF_WILDCARD) {
+		// "a" rule, reset all rules.
+		(void) cgroup_device_bpf_map_clear(cdb);
+		if (is_allow != 0) {
+			ret = cgroup_device_bpf_map_update(cdb, &key, CGROUP_DEVICE_BPF_ACC_ALL);
+			if (ret < 0) {
+				return -2;
+			}
+		}
+		return 0;
+	}
+
+	any_key.type = CGROUP_DEVICE_BPF_WILDCARD;
+	any_key.major = CGROUP_DEVICE_BPF_WILDCARD;
+	any_key.minor = CGROUP_DEVICE_BPF_WILDCARD;
+	ret = cgroup_device_bpf_map_lookup(cdb, &any_key, &default_access);
+	if (ret < 0) {
+		default_access = 0;
+	}
+
+	// Entry is an exception of default.  No entry is same as default.
+	value = default_access;
+	ret = cgroup_device_bpf_map_lookup(cdb, &key, &value);
+	if (ret < 0) {
+		value = default_access;
+	}
+
+	if (is_allow != 0) {
+		value |= access;
+	} else {
+		value &= ~access;
+	}
+
+	if (value == default_access) {
+		// Same as default, remove entry.
+		(void) cgroup_device_bpf_map_delete(cdb, &key);
+		ret = 0;
+	} else {
+		ret = cgroup_device_bpf_map_update(cdb, &key, value);
+	}
+
+	if (ret < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"cgroup_device_bpf_set_rule: fail to update map %s (%d)\n", rule, errno);
+		#endif
+		return -2;
+	}
+
+	return 0;
+}
+/**
+ * Sub function for attach.
+ * Get cgroup v2 path of target process.
+ *
+ * @param [in]	pid		Target process pid.
+ * @param [out]	path	Buffer for cgroup path.
+ * @param [in]	size	Size of path buffer.
+ * @return int
+ * @retval 0	Success to get cgroup path.
+ * @retval -1	Fail to get cgroup path.
+ */
+static int cgroup_device_bpf_get_cgroup_path(pid_t pid, char *path, size_t size)
+{
+	char buf[PATH_MAX];
+	FILE *fp = NULL;
+	int ret = -1, result = -1;
+
+	ret = snprintf(buf, sizeof(buf), "/proc/%d/cgroup", pid);
+	if (!((size_t)ret < sizeof(buf))) {
+		return -1;
+	}
+
+	fp = fopen(buf, "re");
+	if (fp == NULL) {
+		return -1;
+	}
+
+	while (fgets(buf, sizeof(buf), fp) != NULL) {
+		char *nl = NULL;
+
+		if (strncmp(buf, "0::", 3) != 0) {
+			continue;
+		}
+
+		nl = strchr(buf, '\n');
+		if (nl != NULL) {
+			nl[0] = '\0';
+		}
+
+		ret = snprintf(path, size, "%s%s", g_cgroup_v2_base_path, &buf[3]);
+		if ((size_t)ret < size) {
+			result = 0;
+		}
+		break;
+	}
+
+	(void) fclose(fp);
+
+	return result;
+}
+/**
+ * Sub function for attach.
+ * Get a device controller program that is directly attached to the cgroup.
+ *
+ * @param [in]	cgroup_fd	A fd of target cgroup directory.
+ * @return int
+ * @retval >=0	A fd of attached program.
+ * @retval -1	No program attached.
+ */
+static int cgroup_device_bpf_get_attached_program(int cgroup_fd)
+{
+	union bpf_attr attr;
+	uint32_t prog_ids[CGROUP_DEVICE_BPF_QUERY_MAX];
+	int ret = -1;
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.query.target_fd = (uint32_t)cgroup_fd;
+	attr.query.attach_type = BPF_CGROUP_DEVICE;
+	attr.query.prog_ids = (uint64_t)(uintptr_t)prog_ids;
+	attr.query.prog_cnt = CGROUP_DEVICE_BPF_QUERY_MAX;
+
+	ret = cgroup_device_bpf_syscall(BPF_PROG_QUERY, &attr);
+	if ((ret < 0) || (attr.query.prog_cnt == 0)) {
+		return -1;
+	}
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.prog_id = prog_ids[0];
+
+	return cgroup_device_bpf_syscall(BPF_PROG_GET_FD_BY_ID, &attr);
+}
+/**
+ * Attach the device controller program to guest cgroup.
+ * This function find the device controller program that was attached by lxc inside a guest payload cgroup, and replace it by own program.
+ * When lxc did not attach program (no device restriction), this function do nothing.
+ *
+ * @param [in]	cdb		Pointer to cgroup_device_bpf_t.
+ * @param [in]	pid		A pid of guest init process.
+ * @return int
+ * @retval 1	Guest has no device restriction, not attached.
+ * @retval 0	Success to attach.
+ * @retval -1	Fail to attach.
+ * @retval -2	Argument error.
+ */
+int cgroup_device_bpf_attach(cgroup_device_bpf_t *cdb, pid_t pid)
+{
+	union bpf_attr attr;
+	char path[PATH_MAX];
+	char *pslash = NULL;
+	int cgroup_fd = -1, old_prog_fd = -1;
+	int ret = -1, result = 1;
+
+	if ((cdb == NULL) || (pid <= 0)) {
+		return -2;
+	}
+
+	ret = cgroup_device_bpf_get_cgroup_path(pid, path, sizeof(path));
+	if (ret < 0) {
+		return -1;
+	}
+
+	// Walk up to the lxc payload cgroup. Shall not touch the host side cgroup.
+	while (strlen(path) > (sizeof(g_cgroup_v2_base_path) - 1u)) {
+		pslash = strrchr(path, '/');
+		if (pslash == NULL) {
+			break;
+		}
+
+		cgroup_fd = open(path, (O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+		if (cgroup_fd >= 0) {
+			old_prog_fd = cgroup_device_bpf_get_attached_program(cgroup_fd);
+			if (old_prog_fd >= 0) {
+				break;
+			}
+			(void) close(cgroup_fd);
+			cgroup_fd = -1;
+		}
+
+		if (strncmp(&pslash[1], g_lxc_payload_prefix, sizeof(g_lxc_payload_prefix) - 1u) == 0) {
+			// Top of guest cgroup.
+			break;
+		}
+
+		pslash[0] = '\0';
+	}
+
+	if (old_prog_fd < 0) {
+		// No device restriction by lxc.
+		result = 1;
+		goto do_return;
+	}
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.target_fd = (uint32_t)cgroup_fd;
+	attr.attach_bpf_fd = (uint32_t)cdb->prog_fd;
+	attr.attach_type = BPF_CGROUP_DEVICE;
+
+	ret = -1;
+	#ifdef BPF_F_REPLACE
+	// Atomic replace of lxc program.
+	attr.attach_flags = BPF_F_ALLOW_MULTI | BPF_F_REPLACE;
+	attr.replace_bpf_fd = (uint32_t)old_prog_fd;
+	ret = cgroup_device_bpf_syscall(BPF_PROG_ATTACH, &attr);
+	attr.replace_bpf_fd = 0;
+	#endif
+
+	if (ret < 0) {
+		// Kernel without BPF_F_REPLACE.  Attach own program at first, and detach lxc program.
+		// While both programs are attached, access is allowed only when both allow. It does not open any device.
+		attr.attach_flags = BPF_F_ALLOW_MULTI;
+		ret = cgroup_device_bpf_syscall(BPF_PROG_ATTACH, &attr);
+		if (ret < 0) {
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] cgroup_device_bpf_attach: fail to attach device program to %s (%d).\n", path, errno);
+			#endif
+			result = -1;
+			goto do_return;
+		}
+
+		(void) memset(&attr, 0, sizeof(attr));
+		attr.target_fd = (uint32_t)cgroup_fd;
+		attr.attach_bpf_fd = (uint32_t)old_prog_fd;
+		attr.attach_type = BPF_CGROUP_DEVICE;
+		ret = cgroup_device_bpf_syscall(BPF_PROG_DETACH, &attr);
+		if (ret < 0) {
+			// lxc program is kept, runtime device allow can not take effect.  Remove own program.
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] cgroup_device_bpf_attach: fail to detach lxc device program from %s (%d).\n", path, errno);
+			#endif
+			attr.attach_bpf_fd = (uint32_t)cdb->prog_fd;
+			(void) cgroup_device_bpf_syscall(BPF_PROG_DETACH, &attr);
+			result = -1;
+			goto do_return;
+		}
+	}
+
+	cdb->is_attached = 1;
+	result = 0;
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"cgroup_device_bpf_attach: attached to %s\n", path);
+	#endif
+
+do_return:
+	if (old_prog_fd >= 0) {
+		(void) close(old_prog_fd);
+	}
+
+	if (cgroup_fd >= 0) {
+		(void) close(cgroup_fd);
+	}
+
+	return result;
+}
+/**
+ * Test the device controller program is attached or not.
+ *
+ * @param [in]	cdb		Pointer to cgroup_device_bpf_t.
+ * @return int
+ * @retval 1	Attached.
+ * @retval 0	Not attached.
+ */
+int cgroup_device_bpf_is_attached(cgroup_device_bpf_t *cdb)
+{
+	if (cdb == NULL) {
+		return 0;
+	}
+
+	return cdb->is_attached;
+}
+/**
+ * Create per guest cgroup v2 device controller.
+ * The device rule map is initialized to all device allow. It's same as no device rule in lxc.
+ *
+ * @param [out]	cdb		Double pointer to cgroup_device_bpf_t.
+ * @return int
+ * @retval 0	Success to create.
+ * @retval -1	Fail to create map or program.
+ * @retval -2	Argument error.
+ * @retval -3	Memory allocation error.
+ */
+int cgroup_device_bpf_create(cgroup_device_bpf_t **cdb)
+{
+	cgroup_device_bpf_t *pcdb = NULL;
+	cgroup_device_bpf_key_t key;
+	union bpf_attr attr;
+	int ret = -1, result = -1;
+
+	if (cdb == NULL) {
+		return -2;
+	}
+
+	pcdb = (cgroup_device_bpf_t*)malloc(sizeof(cgroup_device_bpf_t));
+	if (pcdb == NULL) {
+		return -3;
+	}
+
+	(void) memset(pcdb, 0, sizeof(cgroup_device_bpf_t));
+	pcdb->map_fd = -1;
+	pcdb->prog_fd = -1;
+
+	(void) memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_HASH;
+	attr.key_size = sizeof(cgroup_device_bpf_key_t);
+	attr.value_size = sizeof(uint32_t);
+	attr.max_entries = CGROUP_DEVICE_BPF_MAP_ENTRY_MAX;
+
+	ret = cgroup_device_bpf_syscall(BPF_MAP_CREATE, &attr);
+	if (ret < 0) {
+		result = -1;
+		goto err_ret;
+	}
+	pcdb->map_fd = ret;
+
+	ret = cgroup_device_bpf_load_program(pcdb->map_fd);
+	if (ret < 0) {
+		result = -1;
+		goto err_ret;
+	}
+	pcdb->prog_fd = ret;
+
+	// Default allow all.
+	key.type = CGROUP_DEVICE_BPF_WILDCARD;
+	key.major = CGROUP_DEVICE_BPF_WILDCARD;
+	key.minor = CGROUP_DEVICE_BPF_WILDCARD;
+	ret = cgroup_device_bpf_map_update(pcdb, &key, CGROUP_DEVICE_BPF_ACC_ALL);
+	if (ret < 0) {
+		result = -1;
+		goto err_ret;
+	}
+
+	(*cdb) = pcdb;
+
+	return 0;
+
+err_ret:
+	(void) cgroup_device_bpf_release(pcdb);
+
+	return result;
+}
+/**
+ * Release per guest cgroup v2 device controller.
+ * The attached program is kept by the guest cgroup until the cgroup is removed.
+ *
+ * @param [in]	cdb		Pointer to cgroup_device_bpf_t.
+ * @return int
+ * @retval 0	Success to release.
+ * @retval -1	Argument error.
+ */
+int cgroup_device_bpf_release(cgroup_device_bpf_t *cdb)
+{
+	if (cdb == NULL) {
+		return -1;
+	}
+
+	if (cdb->prog_fd >= 0) {
+		(void) close(cdb->prog_fd);
+	}
+
+	if (cdb->map_fd >= 0) {
+		(void) close(cdb->map_fd);
+	}
+
+	(void) free(cdb);
+
+	return 0;
+}
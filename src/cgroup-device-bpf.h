@@ -0,0 +1,31 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	cgroup-device-bpf.h
+ * @brief	The header of cgroup v2 device controller using eBPF for container manager.
+ */
+#ifndef CGROUP_DEVICE_BPF_H
+#define CGROUP_DEVICE_BPF_H
+//-----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+//-----------------------------------------------------------------------------
+/**
+ * @def	CGROUP_DEVICE_BPF_MAP_ENTRY_MAX
+ * @brief	Maximum number of device rules in per guest device map.
+ */
+#define CGROUP_DEVICE_BPF_MAP_ENTRY_MAX	(1024)
+
+struct s_cgroup_device_bpf;
+typedef struct s_cgroup_device_bpf cgroup_device_bpf_t;	/**< typedef for struct s_cgroup_device_bpf. */
+
+//-----------------------------------------------------------------------------
+int cgroup_device_bpf_create(cgroup_device_bpf_t **cdb);
+int cgroup_device_bpf_release(cgroup_device_bpf_t *cdb);
+int cgroup_device_bpf_set_rule(cgroup_device_bpf_t *cdb, int is_allow, const char *rule);
+int cgroup_device_bpf_attach(cgroup_device_bpf_t *cdb, pid_t pid);
+int cgroup_device_bpf_is_attached(cgroup_device_bpf_t *cdb);
+//-----------------------------------------------------------------------------
+#endif //#ifndef CGROUP_DEVICE_BPF_H
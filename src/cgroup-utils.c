@@ -9,7 +9,11 @@
 #include <sys/vfs.h>
 #include <linux/magic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
 
 #include "cm-utils.h"
 
@@ -70,33 +74,307 @@ static const char g_cgroup_v2_config_path[] = "/sys/fs/cgroup/cgroup.subtree_con
 int cgroup_util_cgroup_v2_setup(void)
 {
 	int ret = -1, result = 0;
-	char buf[1024];
+	int fd = -1;
+	char buf[CTRLFILE_BATCH_MAX][32];
+	ctrlfile_batch_t batch;
 
 	(void) memset(buf,0,sizeof(buf));
+	ctrlfile_batch_init(&batch);
 
-	for (int i=0; ;i++) {
+	fd = ctrlfile_open(AT_FDCWD, g_cgroup_v2_config_path);
+	if (fd < 0) {
+		result = -1;
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Can not open %s.\n", g_cgroup_v2_config_path);
+		#endif
+		goto do_return;
+	}
+
+	// Queue all subsystem enable requests to one opened control file.
+	for (int i=0; i < CTRLFILE_BATCH_MAX; i++) {
 		ssize_t szlen = 0;
 		const char* cgv2_subsys = g_cgroup_v2_subsystems[i];
 		if (cgv2_subsys == NULL) {
 			break;
 		}
 
-		szlen = snprintf(buf, (sizeof(buf)-1u), "+%s", cgv2_subsys);
-		if (szlen >= (sizeof(buf)-1u)) {
+		szlen = snprintf(buf[i], (sizeof(buf[i])-1u), "+%s", cgv2_subsys);
+		if (szlen >= (sizeof(buf[i])-1u)) {
 			// Fail safe
 			continue;
 		}
 
-		ret = once_write(g_cgroup_v2_config_path, buf, szlen);
-		if (ret < 0) {
-			result = -1;
-			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
-			(void) fprintf(stderr,"[CM CRITICAL ERROR] Current environment is not supporting %s subsystem in cgroup-v2.\n", cgv2_subsys);
-			#endif
-			goto do_return;
+		(void) ctrlfile_batch_add(&batch, fd, buf[i], szlen);
+	}
+
+	ret = ctrlfile_batch_flush(&batch);
+	if (ret < 0) {
+		result = -1;
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		for (int i=0; i < CTRLFILE_BATCH_MAX; i++) {
+			if ((batch.req[i].data != NULL) && (batch.req[i].result < 0)) {
+				(void) fprintf(stderr,"[CM CRITICAL ERROR] Current environment is not supporting %s subsystem in cgroup-v2.\n", ((const char*)batch.req[i].data) + 1);
+			}
 		}
+		#endif
 	}
 
+	(void) close(fd);
+
 do_return:
 	return result;
-}
\ No newline at end of file
+}
+/**
+ * @def	CGROUP_DEVICES_CTRLFILE_LEVEL_NUM
+ * @brief	Number of cgroup v1 levels to write device allow/deny. (container, inner and system.slice)
+ */
+#define CGROUP_DEVICES_CTRLFILE_LEVEL_NUM	(3)
+
+/**
+ * @struct	s_cgroup_devices_ctrlfile
+ * @brief	The data structure for persistent control files of cgroup v1 devices subsystem for one guest.
+ */
+struct s_cgroup_devices_ctrlfile {
+	char *subdir[CGROUP_DEVICES_CTRLFILE_LEVEL_NUM];	/**< Directory path for each level. Level 0 is absolute, others are relative from upper level. */
+	int dirfd[CGROUP_DEVICES_CTRLFILE_LEVEL_NUM];		/**< Directory fd for each level. */
+	int allow_fd[CGROUP_DEVICES_CTRLFILE_LEVEL_NUM];	/**< fd for devices.allow in each level. */
+	int deny_fd[CGROUP_DEVICES_CTRLFILE_LEVEL_NUM];		/**< fd for devices.deny in each level. */
+};
+
+static const char g_cgroup_v1_devices_base_path[] = "/sys/fs/cgroup/devices";
+/**
+ * Create persistent control files handle for cgroup v1 devices subsystem.
+ * The control files are opened in first write, because guest side cgroup (i.e. system.slice) is created after guest boot.
+ *
+ * @param [out]	ccf			Double pointer to cgroup_devices_ctrlfile_t to get created handle.
+ * @param [in]	container	Container cgroup path. A mirror for lxc.cgroup.dir.container.
+ * @param [in]	inner		Container inner cgroup path. A mirror for lxc.cgroup.dir.container.inner.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Argument error.
+ * @retval -2 Memory allocation error.
+ */
+int cgroup_util_devices_ctrlfile_create(cgroup_devices_ctrlfile_t **ccf, const char *container, const char *inner)
+{
+	int result = -1;
+	ssize_t slen = 0;
+	char buf[PATH_MAX];
+	cgroup_devices_ctrlfile_t *pccf = NULL;
+
+	if ((ccf == NULL) || (container == NULL) || (inner == NULL)) {
+		return -1;
+	}
+
+	slen = (ssize_t)snprintf(buf, sizeof(buf), "%s/%s", g_cgroup_v1_devices_base_path, container);
+	if (((size_t)slen) >= sizeof(buf)) {
+		return -1;
+	}
+
+	pccf = (cgroup_devices_ctrlfile_t*)malloc(sizeof(cgroup_devices_ctrlfile_t));
+	if (pccf == NULL) {
+		return -2;
+	}
+
+	(void) memset(pccf, 0, sizeof(cgroup_devices_ctrlfile_t));
+	for (int i = 0; i < CGROUP_DEVICES_CTRLFILE_LEVEL_NUM; i++) {
+		pccf->dirfd[i] = -1;
+		pccf->allow_fd[i] = -1;
+		pccf->deny_fd[i] = -1;
+	}
+
+	pccf->subdir[0] = strdup(buf);
+	pccf->subdir[1] = strdup(inner);
+	pccf->subdir[2] = strdup("system.slice");	// Option for systemd.
+	if ((pccf->subdir[0] == NULL) || (pccf->subdir[1] == NULL) || (pccf->subdir[2] == NULL)) {
+		result = -2;
+		goto err_ret;
+	}
+
+	(*ccf) = pccf;
+
+	return 0;
+
+err_ret:
+	(void) cgroup_util_devices_ctrlfile_release(pccf);
+
+	return result;
+}
+/**
+ * Close opened control files in one level.
+ *
+ * @param [in]	ccf		Pointer to cgroup_devices_ctrlfile_t.
+ * @param [in]	level	Target level.
+ * @return void
+ */
+static void cgroup_util_devices_ctrlfile_close_level(cgroup_devices_ctrlfile_t *ccf, int level)
+{
+	if (ccf->allow_fd[level] >= 0) {
+		(void) close(ccf->allow_fd[level]);
+		ccf->allow_fd[level] = -1;
+	}
+
+	if (ccf->deny_fd[level] >= 0) {
+		(void) close(ccf->deny_fd[level]);
+		ccf->deny_fd[level] = -1;
+	}
+
+	if (ccf->dirfd[level] >= 0) {
+		(void) close(ccf->dirfd[level]);
+		ccf->dirfd[level] = -1;
+	}
+}
+/**
+ * Release persistent control files handle for cgroup v1 devices subsystem.
+ * All opened control files are closed.
+ *
+ * @param [in]	ccf		Pointer to cgroup_devices_ctrlfile_t.
+ * @return int
+ * @retval  0 Success.
+ */
+int cgroup_util_devices_ctrlfile_release(cgroup_devices_ctrlfile_t *ccf)
+{
+	if (ccf == NULL) {
+		return 0;
+	}
+
+	for (int i = 0; i < CGROUP_DEVICES_CTRLFILE_LEVEL_NUM; i++) {
+		cgroup_util_devices_ctrlfile_close_level(ccf, i);
+		(void) free(ccf->subdir[i]);
+		ccf->subdir[i] = NULL;
+	}
+
+	(void) free(ccf);
+
+	return 0;
+}
+/**
+ * Get control file fd for target level.  When the control file is not opened, open it.
+ *
+ * @param [in]	ccf			Pointer to cgroup_devices_ctrlfile_t.
+ * @param [in]	level		Target level.
+ * @param [in]	is_allow	Target control file. 1: devices.allow, 0: devices.deny.
+ * @return int
+ * @retval  >=0 fd of control file.
+ * @retval -1 Could not open control file.
+ */
+static int cgroup_util_devices_ctrlfile_get_fd(cgroup_devices_ctrlfile_t *ccf, int level, int is_allow)
+{
+	int *pfd = NULL;
+	int parentfd = AT_FDCWD;
+
+	if (is_allow == 0) {
+		pfd = &ccf->deny_fd[level];
+	} else {
+		pfd = &ccf->allow_fd[level];
+	}
+
+	if ((*pfd) >= 0) {
+		return (*pfd);
+	}
+
+	if (ccf->dirfd[level] < 0) {
+		if (level > 0) {
+			parentfd = ccf->dirfd[level - 1];
+			if (parentfd < 0) {
+				return -1;
+			}
+		}
+
+		ccf->dirfd[level] = openat(parentfd, ccf->subdir[level], (O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+		if (ccf->dirfd[level] < 0) {
+			return -1;
+		}
+	}
+
+	if (is_allow == 0) {
+		(*pfd) = ctrlfile_open(ccf->dirfd[level], "devices.deny");
+	} else {
+		(*pfd) = ctrlfile_open(ccf->dirfd[level], "devices.allow");
+	}
+
+	return (*pfd);
+}
+/**
+ * Write device allow/deny rule to all level of guest cgroup using persistent control files.
+ * The write requests to each level are queued and flushed at once.
+ * When a level is failed to write, that level is closed, re-opened and the write is retried once.
+ *
+ * @param [in]	ccf			Pointer to cgroup_devices_ctrlfile_t.
+ * @param [in]	is_allow	Target control file. 1: devices.allow, 0: devices.deny.
+ * @param [in]	value		Device rule string.
+ * @param [in]	size		Length of device rule string.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to write one or more levels.
+ */
+int cgroup_util_devices_ctrlfile_write(cgroup_devices_ctrlfile_t *ccf, int is_allow, const char *value, size_t size)
+{
+	int ret = -1;
+	int fd = -1;
+	int result = 0;
+	int is_retry = 0;
+	int level_index[CGROUP_DEVICES_CTRLFILE_LEVEL_NUM];
+	int level_failed[CGROUP_DEVICES_CTRLFILE_LEVEL_NUM];
+	ctrlfile_batch_t batch;
+
+	ctrlfile_batch_init(&batch);
+
+	for (int i = 0; i < CGROUP_DEVICES_CTRLFILE_LEVEL_NUM; i++) {
+		level_index[i] = -1;
+		level_failed[i] = 0;
+
+		fd = cgroup_util_devices_ctrlfile_get_fd(ccf, i, is_allow);
+		if (fd < 0) {
+			level_failed[i] = 1;
+			is_retry = 1;
+			continue;
+		}
+
+		level_index[i] = ctrlfile_batch_add(&batch, fd, value, size);
+	}
+
+	ret = ctrlfile_batch_flush(&batch);
+	if (ret < 0) {
+		for (int i = 0; i < CGROUP_DEVICES_CTRLFILE_LEVEL_NUM; i++) {
+			if ((level_index[i] >= 0) && (batch.req[level_index[i]].result < 0)) {
+				level_failed[i] = 1;
+				is_retry = 1;
+			}
+		}
+	}
+
+	if (is_retry == 0) {
+		return 0;
+	}
+
+	// The cgroup may be re-created.  Re-open failed levels and retry once.
+	for (int i = 0; i < CGROUP_DEVICES_CTRLFILE_LEVEL_NUM; i++) {
+		level_index[i] = -1;
+
+		if (level_failed[i] == 0) {
+			continue;
+		}
+
+		cgroup_util_devices_ctrlfile_close_level(ccf, i);
+		fd = cgroup_util_devices_ctrlfile_get_fd(ccf, i, is_allow);
+		if (fd < 0) {
+			result = -1;
+			continue;
+		}
+
+		level_index[i] = ctrlfile_batch_add(&batch, fd, value, size);
+	}
+
+	ret = ctrlfile_batch_flush(&batch);
+	if (ret < 0) {
+		for (int i = 0; i < CGROUP_DEVICES_CTRLFILE_LEVEL_NUM; i++) {
+			if ((level_index[i] >= 0) && (batch.req[level_index[i]].result < 0)) {
+				// Re-open at next write.
+				cgroup_util_devices_ctrlfile_close_level(ccf, i);
+			}
+		}
+		result = -1;
+	}
+
+	return result;
+}
@@ -11,8 +11,15 @@
 #include <stddef.h>
 #include <sys/types.h>
 
+//-----------------------------------------------------------------------------
+struct s_cgroup_devices_ctrlfile;
+typedef struct s_cgroup_devices_ctrlfile cgroup_devices_ctrlfile_t;	/**< typedef for struct s_cgroup_devices_ctrlfile. */
+
 //-----------------------------------------------------------------------------
 int cgroup_util_get_cgroup_version(void);
 int cgroup_util_cgroup_v2_setup(void);
+int cgroup_util_devices_ctrlfile_create(cgroup_devices_ctrlfile_t **ccf, const char *container, const char *inner);
+int cgroup_util_devices_ctrlfile_release(cgroup_devices_ctrlfile_t *ccf);
+int cgroup_util_devices_ctrlfile_write(cgroup_devices_ctrlfile_t *ccf, int is_allow, const char *value, size_t size);
 //-----------------------------------------------------------------------------
 #endif //#ifndef CGROUP_UTILS_H
\ No newline at end of file
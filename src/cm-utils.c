@@ -17,6 +17,10 @@
 #include <time.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+
+#include "block-util.h"
+#include "parallel-util.h"
 
 int pidfd_open_syscall_wrapper(pid_t pid)
 {
@@ -26,6 +30,30 @@ int pidfd_send_signal_syscall_wrapper(int pidfd, int sig, siginfo_t *info, unsig
 {
 	return syscall(SYS_pidfd_send_signal, pidfd, sig, info, flags);
 }
+int fsopen_syscall_wrapper(const char *fstype, unsigned int flags)
+{
+	return syscall(SYS_fsopen, fstype, flags);
+}
+int fsconfig_syscall_wrapper(int fsfd, unsigned int cmd, const char *key, const void *value, int aux)
+{
+	return syscall(SYS_fsconfig, fsfd, cmd, key, value, aux);
+}
+int fsmount_syscall_wrapper(int fsfd, unsigned int flags, unsigned int attr_flags)
+{
+	return syscall(SYS_fsmount, fsfd, flags, attr_flags);
+}
+int move_mount_syscall_wrapper(int from_dirfd, const char *from_path, int to_dirfd, const char *to_path, unsigned int flags)
+{
+	return syscall(SYS_move_mount, from_dirfd, from_path, to_dirfd, to_path, flags);
+}
+int open_tree_syscall_wrapper(int dirfd, const char *path, unsigned int flags)
+{
+	return syscall(SYS_open_tree, dirfd, path, flags);
+}
+int mount_setattr_syscall_wrapper(int dirfd, const char *path, unsigned int flags, struct mount_attr *attr, size_t size)
+{
+	return syscall(SYS_mount_setattr, dirfd, path, flags, attr, size);
+}
 /**
  * INTR safe write util.
  * This function support only to less than 4KByte (atomic op limit size) operation.
@@ -82,6 +110,120 @@ int once_write(const char *path, const void* data, size_t size)
 
 	return result;
 }
+/**
+ * Open a control file for persistent write.
+ * The control file is a sysfs or cgroupfs node that is re-written many times in runtime.
+ * The opened fd can be used by ctrlfile_write and ctrlfile_batch_* without re-open.
+ *
+ * @param [in]	dirfd	Directory fd for base of name. Can use AT_FDCWD.
+ * @param [in]	name	File name relative from dirfd.
+ * @return int
+ * @retval  >=0 File descriptor of control file.
+ * @retval -1 Open error.
+ */
+int ctrlfile_open(int dirfd, const char *name)
+{
+	int fd = -1;
+
+	do {
+		fd = openat(dirfd, name, (O_WRONLY | O_CLOEXEC));
+	} while ((fd < 0) && (errno == EINTR));
+
+	return fd;
+}
+/**
+ * Write to opened control file.
+ * A sysfs and cgroupfs node handle each write as a independent request, this function write at file top always.
+ * This function support only to less than 4KByte operation.
+ *
+ * @param [in]	fd		File descriptor of control file.
+ * @param [in]	data	Pointer to write data buffer.
+ * @param [in]	size	Write data size.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Write error.
+ */
+int ctrlfile_write(int fd, const void* data, size_t size)
+{
+	ssize_t ret = -1;
+
+	do {
+		ret = pwrite(fd, data, size, 0);
+	} while ((ret == -1) && (errno == EINTR));
+
+	if (ret < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Initialize control file write batch.
+ *
+ * @param [in]	batch	Pointer to ctrlfile_batch_t.
+ * @return void
+ */
+void ctrlfile_batch_init(ctrlfile_batch_t *batch)
+{
+	(void) memset(batch, 0, sizeof(ctrlfile_batch_t));
+}
+/**
+ * Queue a write request to control file write batch.
+ * The data buffer must be kept until ctrlfile_batch_flush.
+ *
+ * @param [in]	batch	Pointer to ctrlfile_batch_t.
+ * @param [in]	fd		File descriptor of control file.
+ * @param [in]	data	Pointer to write data buffer.
+ * @param [in]	size	Write data size.
+ * @return int
+ * @retval  >=0 Index of queued request.
+ * @retval -1 Batch is full.
+ */
+int ctrlfile_batch_add(ctrlfile_batch_t *batch, int fd, const void* data, size_t size)
+{
+	int index = -1;
+
+	if (batch->num >= CTRLFILE_BATCH_MAX) {
+		return -1;
+	}
+
+	index = batch->num;
+	batch->req[index].fd = fd;
+	batch->req[index].data = data;
+	batch->req[index].size = size;
+	batch->req[index].result = 0;
+	batch->num++;
+
+	return index;
+}
+/**
+ * Flush all queued write requests in control file write batch.
+ * All request is written in queued order, a result of each request is stored to req[].result.
+ * After flush, the batch is empty.
+ *
+ * @param [in]	batch	Pointer to ctrlfile_batch_t.
+ * @return int
+ * @retval  0 Success to write all requests.
+ * @retval -1 One or more requests were failed.
+ */
+int ctrlfile_batch_flush(ctrlfile_batch_t *batch)
+{
+	int ret = -1;
+	int result = 0;
+
+	for (int i = 0; i < batch->num; i++) {
+		ret = ctrlfile_write(batch->req[i].fd, batch->req[i].data, batch->req[i].size);
+		if (ret < 0) {
+			batch->req[i].result = -1;
+			result = -1;
+		} else {
+			batch->req[i].result = 0;
+		}
+	}
+	batch->num = 0;
+
+	return result;
+}
 /**
  * Once read util.
  * This function do three operation by one call. 'open, read and close'
@@ -258,107 +400,308 @@ void sleep_ms_time(int64_t wait_time)
 }
 
 /**
- * Disk mount procedure for failover.
+ * @var		g_mount_api_support
+ * @brief	Cache of new mount api (fsopen/fsmount/move_mount) support state. 0: not support, 1: support.
+ */
+static int g_mount_api_support = 0;
+/**
+ * @var		g_mount_api_probe_once
+ * @brief	Once control for new mount api probe.  The probe is called from parallel mount jobs.
+ */
+static pthread_once_t g_mount_api_probe_once = PTHREAD_ONCE_INIT;
+/**
+ * Probe new mount api support.  This function is called once by pthread_once.
+ * Invalid fstype probe.  When kernel support fsopen, it return EFAULT or EINVAL.  Old kernel return ENOSYS.
  *
- * @param [in]	devs	Array of disk block device. A and B.
- * @param [in]	path	Mount path.
- * @param [in]	fstype	Name of file system. When fstype == NULL, file system is auto.
+ * @return void
+ */
+static void mount_disk_probe_detached_support(void)
+{
+	int ret = -1;
+
+	ret = fsopen_syscall_wrapper(NULL, FSOPEN_CLOEXEC);
+	if (ret >= 0) {
+		(void) close(ret);
+		g_mount_api_support = 1;
+	} else if (errno == ENOSYS) {
+		g_mount_api_support = 0;
+	} else {
+		g_mount_api_support = 1;
+	}
+
+	return;
+}
+/**
+ * Check new mount api (fsopen/fsconfig/fsmount/move_mount) support.
+ * Probe result is cached.  It's safe to call from parallel threads.
+ *
+ * @return int
+ * @retval  1 Support.
+ * @retval  0 Not support.
+ */
+int mount_disk_is_detached_supported(void)
+{
+	(void) pthread_once(&g_mount_api_probe_once, mount_disk_probe_detached_support);
+
+	return g_mount_api_support;
+}
+/**
+ * Create detached mount by new mount api.
+ * This function create superblock and mount object by fsopen/fsconfig/fsmount, but not attach to any path.
+ * Mount attributes (read only, nodev etc.) are applied at the same time.  It's possible to run in parallel.
+ *
+ * @param [in]	dev		Block device.
+ * @param [in]	fstype	Name of file system. Shall not NULL.
  * @param [in]	mntflag	Mount flag.
- * @param [in]	option	Filesystem specific option.
+ * @param [in]	option	Filesystem specific option. Comma separated key or key=value list.
  * @return int
- * @retval  1 Success - secondary.
- * @retval  0 Success - primary.
+ * @retval >=0 Success, mount fd. It need to attach by mount_disk_attach and close by caller.
  * @retval -1 mount error.
  * @retval -2 Syscall error.
  * @retval -3 Arg. error.
  */
-int mount_disk_failover(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option)
+int mount_disk_detached(const char *dev, const char *fstype, unsigned long mntflag, const char *option)
 {
 	int ret = -1;
-	int mntdisk = -1;
-	const char * dev = NULL;
+	int fsfd = -1, mntfd = -1;
+	unsigned int attr = 0;
+	char buf[PATH_MAX];
+	char *saveptr = NULL, *token = NULL;
+
+	if ((dev == NULL) || (fstype == NULL)) {
+		return -3;
+	}
 
-	for (int i=0; i < 2; i++) {
-		dev = devs[i];
+	fsfd = fsopen_syscall_wrapper(fstype, FSOPEN_CLOEXEC);
+	if (fsfd < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"mount_disk_detached: fsopen %s fail (%d).\n", fstype, errno);
+		#endif
+		return -2;
+	}
+
+	ret = fsconfig_syscall_wrapper(fsfd, FSCONFIG_SET_STRING, "source", dev, 0);
+	if (ret < 0) {
+		goto err_ret;
+	}
 
-		ret = mount(dev, path, fstype, mntflag, option);
+	// Superblock flags.
+	if ((mntflag & MS_RDONLY) != 0) {
+		ret = fsconfig_syscall_wrapper(fsfd, FSCONFIG_SET_FLAG, "ro", NULL, 0);
 		if (ret < 0) {
-			if (errno == EBUSY) {
-				// already mounted
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout,"mount_disk_failover: %s is already mounted.\n", path);
-				#endif
-				ret = umount2(path, MNT_DETACH);
-				if (ret < 0) {
-					#ifdef _PRINTF_DEBUG_
-					(void) fprintf(stdout,"mount_disk_failover: %s unmount fail.\n", path);
-					#endif
-					continue;
-				}
+			goto err_ret;
+		}
+	}
+	if ((mntflag & MS_SYNCHRONOUS) != 0) {
+		ret = fsconfig_syscall_wrapper(fsfd, FSCONFIG_SET_FLAG, "sync", NULL, 0);
+		if (ret < 0) {
+			goto err_ret;
+		}
+	}
+	if ((mntflag & MS_DIRSYNC) != 0) {
+		ret = fsconfig_syscall_wrapper(fsfd, FSCONFIG_SET_FLAG, "dirsync", NULL, 0);
+		if (ret < 0) {
+			goto err_ret;
+		}
+	}
 
-				ret = mount(dev, path, fstype, mntflag, option);
-				if (ret < 0) {
-					#ifdef _PRINTF_DEBUG_
-					(void) fprintf(stdout,"mount_disk_failover: %s re-mount fail.\n", path);
-					#endif
-					continue;
-				}
-				mntdisk = i;
-				break;
+	// Filesystem specific options.
+	if ((option != NULL) && (option[0] != '\0')) {
+		if (strlen(option) >= sizeof(buf)) {
+			(void) close(fsfd);
+			return -3;
+		}
+		(void) strncpy(buf, option, sizeof(buf) - 1u);
+		buf[sizeof(buf) - 1u] = '\0';
+
+		token = strtok_r(buf, ",", &saveptr);
+		while (token != NULL) {
+			char *value = strchr(token, '=');
+
+			if (value != NULL) {
+				(*value) = '\0';
+				value++;
+				ret = fsconfig_syscall_wrapper(fsfd, FSCONFIG_SET_STRING, token, value, 0);
 			} else {
-				//error - try to mount secondary disk
-				;
+				ret = fsconfig_syscall_wrapper(fsfd, FSCONFIG_SET_FLAG, token, NULL, 0);
 			}
-		} else {
-			// success to mount
-			mntdisk = i;
+			if (ret < 0) {
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"mount_disk_detached: option %s fail (%d).\n", token, errno);
+				#endif
+				goto err_ret;
+			}
+
+			token = strtok_r(NULL, ",", &saveptr);
+		}
+	}
+
+	ret = fsconfig_syscall_wrapper(fsfd, FSCONFIG_CMD_CREATE, NULL, NULL, 0);
+	if (ret < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"mount_disk_detached: %s create fail (%d).\n", dev, errno);
+		#endif
+		goto err_ret;
+	}
+
+	// Mount attributes.
+	if ((mntflag & MS_RDONLY) != 0) {
+		attr |= MOUNT_ATTR_RDONLY;
+	}
+	if ((mntflag & MS_NOSUID) != 0) {
+		attr |= MOUNT_ATTR_NOSUID;
+	}
+	if ((mntflag & MS_NODEV) != 0) {
+		attr |= MOUNT_ATTR_NODEV;
+	}
+	if ((mntflag & MS_NOEXEC) != 0) {
+		attr |= MOUNT_ATTR_NOEXEC;
+	}
+	if ((mntflag & MS_NOATIME) != 0) {
+		attr |= MOUNT_ATTR_NOATIME;
+	}
+
+	mntfd = fsmount_syscall_wrapper(fsfd, FSMOUNT_CLOEXEC, attr);
+	if (mntfd < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"mount_disk_detached: %s fsmount fail (%d).\n", dev, errno);
+		#endif
+		goto err_ret;
+	}
+
+	(void) close(fsfd);
+
+	return mntfd;
+
+err_ret:
+	(void) close(fsfd);
+
+	return -1;
+}
+/**
+ * Attach detached mount to path.
+ * move_mount stacks a new mount on an existing mount, so already mounted path is rejected same as EBUSY of mount(2).
+ * Existing mount is not touched in this function.
+ *
+ * @param [in]	mntfd	Mount fd created by mount_disk_detached.
+ * @param [in]	path	Mount path.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 mount error.
+ * @retval -2 Path is already mounted.
+ */
+int mount_disk_attach(int mntfd, const char *path)
+{
+	int ret = -1;
+	struct stat sb_path, sb_parent;
+	char buf[PATH_MAX];
+
+	ret = snprintf(buf, sizeof(buf), "%s/..", path);
+	if (!((size_t)ret < sizeof(buf))) {
+		return -1;
+	}
+
+	if ((stat(path, &sb_path) == 0) && (stat(buf, &sb_parent) == 0)) {
+		if ((sb_path.st_dev != sb_parent.st_dev) || (sb_path.st_ino == sb_parent.st_ino)) {
+			// already mounted
 			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout,"mount_disk_failover: mounted %s to %s.\n", dev, path);
+			(void) fprintf(stdout,"mount_disk_attach: %s is already mounted.\n", path);
 			#endif
-			break;
+			errno = EBUSY;
+			return -2;
 		}
 	}
 
-	return mntdisk;
+	ret = move_mount_syscall_wrapper(mntfd, "", AT_FDCWD, path, MOVE_MOUNT_F_EMPTY_PATH);
+	if (ret < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"mount_disk_attach: attach fail to %s (%d).\n", path, errno);
+		#endif
+		return -1;
+	}
+
+	return 0;
 }
 /**
- * Disk mount procedure for a/b.
+ * Attach detached mount to path with busy recovery.
+ * When path is already mounted (ex. stale mount after manager restart), existing mount is lazily unmounted and attach is retried once.
+ * It's same recovery as EBUSY of legacy mount.
  *
- * @param [in]	devs	Array of disk block device. A and B.
+ * @param [in]	mntfd	Mount fd created by mount_disk_detached.
+ * @param [in]	path	Mount path.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 mount error.
+ */
+int mount_disk_attach_remount(int mntfd, const char *path)
+{
+	int ret = -1;
+
+	ret = mount_disk_attach(mntfd, path);
+	if (ret == -2) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"mount_disk_attach_remount: %s is already mounted.\n", path);
+		#endif
+		ret = umount2(path, MNT_DETACH);
+		if (ret < 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"mount_disk_attach_remount: %s unmount fail.\n", path);
+			#endif
+			return -1;
+		}
+
+		ret = mount_disk_attach(mntfd, path);
+		if (ret < 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"mount_disk_attach_remount: %s re-attach fail.\n", path);
+			#endif
+			return -1;
+		}
+	}
+
+	return ret;
+}
+/**
+ * Mount one disk.
+ * In case of new mount api is supported, this function use detached mount and attach.  Otherwise use legacy mount.
+ *
+ * @param [in]	dev		Block device.
  * @param [in]	path	Mount path.
  * @param [in]	fstype	Name of file system. When fstype == NULL, file system is auto.
  * @param [in]	mntflag	Mount flag.
  * @param [in]	option	Filesystem specific option.
- * @param [in]	side	Mount side a(=0) or b(=1).
  * @return int
  * @retval  0 Success.
  * @retval -1 mount error.
- * @retval -2 Syscall error.
- * @retval -3 Arg. error.
  */
-int mount_disk_ab(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option, int side)
+static int mount_disk_single(const char *dev, const char *path, const char *fstype, unsigned long mntflag, char* option)
 {
-	int ret = 1;
-	const char * dev = NULL;
+	int ret = -1;
+	int mntfd = -1;
 
-	if (side < 0 || side >= 2) {
-		//side is 0 or 1 only
-		return -3;
-	}
+	if ((fstype != NULL) && (mount_disk_is_detached_supported() == 1)) {
+		mntfd = mount_disk_detached(dev, fstype, mntflag, option);
+		if (mntfd < 0) {
+			return -1;
+		}
 
-	dev = devs[side];
+		ret = mount_disk_attach_remount(mntfd, path);
+		(void) close(mntfd);
+
+		return ret;
+	}
 
 	ret = mount(dev, path, fstype, mntflag, option);
 	if (ret < 0) {
 		if (errno == EBUSY) {
 			// already mounted
 			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout,"mount_disk_ab: %s is already mounted.\n", path);
+			(void) fprintf(stdout,"mount_disk_single: %s is already mounted.\n", path);
 			#endif
 			ret = umount2(path, MNT_DETACH);
 			if (ret < 0) {
 				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout,"mount_disk_ab: %s unmount fail.\n", path);
+				(void) fprintf(stdout,"mount_disk_single: %s unmount fail.\n", path);
 				#endif
 				return -1;
 			}
@@ -366,18 +709,189 @@ int mount_disk_ab(char **devs, const char *path, const char *fstype, unsigned lo
 			ret = mount(dev, path, fstype, mntflag, option);
 			if (ret < 0) {
 				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout,"mount_disk_ab: %s re-mount fail.\n", path);
+				(void) fprintf(stdout,"mount_disk_single: %s re-mount fail.\n", path);
 				#endif
 				return -1;
 			}
 		} else {
 			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout,"mount_disk_ab: %s mount fail to %s (%d).\n", dev, path, errno);
+			(void) fprintf(stdout,"mount_disk_single: %s mount fail to %s (%d).\n", dev, path, errno);
 			#endif
 			return -1;
 		}
 	}
 
+	return 0;
+}
+/**
+ * @struct	s_mount_disk_probe_arg
+ * @brief	The argument of failover disk probe job.
+ */
+struct s_mount_disk_probe_arg {
+	const char *dev;	/**< Block device. */
+	const char *fstype;	/**< Name of file system. */
+};
+/**
+ * Failover disk probe job.
+ *
+ * @param [in]	arg	Pointer to struct s_mount_disk_probe_arg.
+ * @return int
+ * @retval  1 Valid file system.
+ * @retval  0 Valid file system, but error was recorded.
+ * @retval -1 Invalid.
+ */
+static int mount_disk_probe_job(void *arg)
+{
+	struct s_mount_disk_probe_arg *probe_arg = (struct s_mount_disk_probe_arg*)arg;
+
+	return block_util_probe_mount_candidate(probe_arg->dev, probe_arg->fstype);
+}
+/**
+ * Mount order selection for failover disk.
+ * This function probe primary and secondary disk in parallel without mount, and select mount order.
+ * Valid disk is preferred to the disk that was recorded error, primary disk is preferred in same result.
+ * Invalid disk is not included to mount order.  When both disks are invalid, this function return primary and secondary order as fail safe.
+ *
+ * @param [in]	devs	Array of disk block device. Primary and secondary.
+ * @param [in]	fstype	Name of file system. When fstype == NULL, file system is auto.
+ * @param [out]	order	Array of int (2 elements) to store disk index in mount order.
+ * @return int
+ * @retval  >0 Number of disk in mount order.
+ */
+int mount_disk_failover_select(char **devs, const char *fstype, int *order)
+{
+	struct s_mount_disk_probe_arg args[2];
+	parallel_util_job_t jobs[2];
+	int num = 0;
+
+	(void) memset(jobs, 0, sizeof(jobs));
+
+	for (int i = 0; i < 2; i++) {
+		args[i].dev = devs[i];
+		args[i].fstype = fstype;
+		jobs[i].func = mount_disk_probe_job;
+		jobs[i].arg = (void*)&args[i];
+		jobs[i].group = PARALLEL_UTIL_NO_GROUP;
+	}
+
+	(void) parallel_util_run(jobs, 2, 2);
+
+	for (int result = 1; result >= 0; result--) {
+		for (int i = 0; i < 2; i++) {
+			if (jobs[i].result == result) {
+				order[num] = i;
+				num++;
+			}
+		}
+	}
+
+	if (num == 0) {
+		// Probe is not available (ex. not supported file system by blkid), fall back to mount trial.
+		order[0] = 0;
+		order[1] = 1;
+		num = 2;
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"mount_disk_failover_select: probe result %d,%d first = %s.\n", jobs[0].result, jobs[1].result, devs[order[0]]);
+	#endif
+
+	return num;
+}
+/**
+ * Disk mount procedure for failover.
+ * When previous mount result is cached, this function mount cached disk directly.
+ * Otherwise, mount order is selected by parallel probe.  It avoid slow mount failure of corrupted disk.
+ *
+ * @param [in]	devs	Array of disk block device. A and B.
+ * @param [in]	path	Mount path.
+ * @param [in]	fstype	Name of file system. When fstype == NULL, file system is auto.
+ * @param [in]	mntflag	Mount flag.
+ * @param [in]	option	Filesystem specific option.
+ * @param [in,out]	cache	Pointer to mount result cache. 0: not cached, 1: primary, 2: secondary. When cache == NULL, cache is not used.
+ * @return int
+ * @retval  1 Success - secondary.
+ * @retval  0 Success - primary.
+ * @retval -1 mount error.
+ * @retval -2 Syscall error.
+ * @retval -3 Arg. error.
+ */
+int mount_disk_failover(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option, int *cache)
+{
+	int ret = -1;
+	int mntdisk = -1;
+	int order[2] = {0, 1};
+	int num = 0;
+	const char * dev = NULL;
+
+	if ((cache != NULL) && ((*cache) == 1 || (*cache) == 2)) {
+		dev = devs[(*cache) - 1];
+
+		ret = mount_disk_single(dev, path, fstype, mntflag, option);
+		if (ret == 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"mount_disk_failover: mounted cached %s to %s.\n", dev, path);
+			#endif
+			return ((*cache) - 1);
+		}
+		// Cached disk could not mount, select again.
+		(*cache) = 0;
+	}
+
+	num = mount_disk_failover_select(devs, fstype, order);
+
+	for (int i=0; i < num; i++) {
+		dev = devs[order[i]];
+
+		ret = mount_disk_single(dev, path, fstype, mntflag, option);
+		if (ret == 0) {
+			// success to mount
+			mntdisk = order[i];
+			if (cache != NULL) {
+				(*cache) = mntdisk + 1;
+			}
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"mount_disk_failover: mounted %s to %s.\n", dev, path);
+			#endif
+			break;
+		}
+		//error - try to mount next disk
+	}
+
+	return mntdisk;
+}
+/**
+ * Disk mount procedure for a/b.
+ *
+ * @param [in]	devs	Array of disk block device. A and B.
+ * @param [in]	path	Mount path.
+ * @param [in]	fstype	Name of file system. When fstype == NULL, file system is auto.
+ * @param [in]	mntflag	Mount flag.
+ * @param [in]	option	Filesystem specific option.
+ * @param [in]	side	Mount side a(=0) or b(=1).
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 mount error.
+ * @retval -2 Syscall error.
+ * @retval -3 Arg. error.
+ */
+int mount_disk_ab(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option, int side)
+{
+	int ret = 1;
+	const char * dev = NULL;
+
+	if (side < 0 || side >= 2) {
+		//side is 0 or 1 only
+		return -3;
+	}
+
+	dev = devs[side];
+
+	ret = mount_disk_single(dev, path, fstype, mntflag, option);
+	if (ret < 0) {
+		return -1;
+	}
+
 	#ifdef _PRINTF_DEBUG_
 	(void) fprintf(stdout,"mount_disk_ab(%d): %s mount to %s (%s)\n", side, dev, path, fstype);
 	#endif
@@ -406,34 +920,9 @@ int mount_disk_once(char **devs, const char *path, const char *fstype, unsigned
 	// Only to use primary side.
 	dev = devs[0];
 
-	ret = mount(dev, path, fstype, mntflag, option);
+	ret = mount_disk_single(dev, path, fstype, mntflag, option);
 	if (ret < 0) {
-		if (errno == EBUSY) {
-			// already mounted
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout,"mount_disk_once: %s is already mounted.\n", path);
-			#endif
-			ret = umount2(path, MNT_DETACH);
-			if (ret < 0) {
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout,"mount_disk_once: %s unmount fail.\n", path);
-				#endif
-				return -1;
-			}
-
-			ret = mount(dev, path, fstype, mntflag, option);
-			if (ret < 0) {
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout,"mount_disk_once: %s re-mount fail.\n", path);
-				#endif
-				return -1;
-			}
-		} else {
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout,"mount_disk_once: %s mount fail to %s (%d).\n", dev, path, errno);
-			#endif
-			return -1;
-		}
+		return -1;
 	}
 
 	#ifdef _PRINTF_DEBUG_
@@ -442,8 +931,92 @@ int mount_disk_once(char **devs, const char *path, const char *fstype, unsigned
 
 	return 0;
 }
+/**
+ * Overlay mount procedure for read only disk.
+ * This function mount size limited tmpfs to tmpfs_path and stack overlayfs to path.  The lower layer is current mount at path.
+ * The pages of tmpfs are charged to memory cgroup of writer process, in case of guest rootfs, it's charged to guest.
+ *
+ * @param [in]	path		Mount path of lower layer.  Overlay is mounted to same path.
+ * @param [in]	tmpfs_path	Mount path of tmpfs for upper and work directory.
+ * @param [in]	size		Size of tmpfs. (ex. 64M)
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 mount error.
+ * @retval -2 Syscall error.
+ */
+int mount_disk_overlay(const char *path, const char *tmpfs_path, const char *size)
+{
+	char option[PATH_MAX * 3];
+	char upper[PATH_MAX], work[PATH_MAX];
+	int ret = -1;
+
+	(void) mkdir_p(tmpfs_path, 0755);
+	ret = mkdir(tmpfs_path, 0755);
+	if ((ret < 0) && (errno != EEXIST)) {
+		return -2;
+	}
+
+	ret = snprintf(option, sizeof(option), "size=%s,mode=0755", size);
+	if (!((size_t)ret < sizeof(option)-1u)) {
+		return -2;
+	}
+
+	ret = mount("tmpfs", tmpfs_path, "tmpfs", (MS_NOATIME | MS_NODEV | MS_NOSUID), option);
+	if (ret < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"mount_disk_overlay: tmpfs mount fail to %s (%d).\n", tmpfs_path, errno);
+		#endif
+		return -1;
+	}
+
+	ret = snprintf(upper, sizeof(upper), "%s/upper", tmpfs_path);
+	if (!((size_t)ret < sizeof(upper)-1u)) {
+		goto err_ret;
+	}
+
+	ret = snprintf(work, sizeof(work), "%s/work", tmpfs_path);
+	if (!((size_t)ret < sizeof(work)-1u)) {
+		goto err_ret;
+	}
+
+	ret = mkdir(upper, 0755);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	ret = mkdir(work, 0755);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	ret = snprintf(option, sizeof(option), "lowerdir=%s,upperdir=%s,workdir=%s", path, upper, work);
+	if (!((size_t)ret < sizeof(option)-1u)) {
+		goto err_ret;
+	}
+
+	// Lower dir is resolved before overlay is mounted, it's current mount at path.
+	ret = mount("overlay", path, "overlay", MS_NOATIME, option);
+	if (ret < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"mount_disk_overlay: overlay mount fail to %s (%d).\n", path, errno);
+		#endif
+		goto err_ret;
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"mount_disk_overlay: overlay mount to %s (upper = tmpfs %s)\n", path, size);
+	#endif
+
+	return 0;
+
+err_ret:
+	(void) umount2(tmpfs_path, MNT_DETACH);
+
+	return -1;
+}
 /**
  * Bind mount procedure.
+ * In case of new mount api is supported, read only attribute is applied to detached clone before attach.
  *
  * @param [in]	src_path	Source path of bind mount.
  * @param [in]	dest_path	Destination path of bind mount.
@@ -458,6 +1031,44 @@ int mount_disk_bind(const char *src_path, const char *dest_path, int is_read_onl
 {
 	int ret = 1;
 
+	if (mount_disk_is_detached_supported() == 1) {
+		int treefd = -1;
+
+		treefd = open_tree_syscall_wrapper(AT_FDCWD, src_path, (OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC));
+		if (treefd < 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"mount_disk_bind: %s clone fail (%d).\n", src_path, errno);
+			#endif
+			return -1;
+		}
+
+		if (is_read_only == 1) {
+			struct mount_attr attr;
+
+			(void) memset(&attr, 0, sizeof(attr));
+			attr.attr_set = MOUNT_ATTR_RDONLY;
+			ret = mount_setattr_syscall_wrapper(treefd, "", AT_EMPTY_PATH, &attr, sizeof(attr));
+			if (ret < 0) {
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"mount_disk_bind: read only setattr fail to %s (%d).\n", src_path, errno);
+				#endif
+				(void) close(treefd);
+				return -1;
+			}
+		}
+
+		ret = move_mount_syscall_wrapper(treefd, "", AT_FDCWD, dest_path, MOVE_MOUNT_F_EMPTY_PATH);
+		(void) close(treefd);
+		if (ret < 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"mount_disk_bind: %s bind mount fail to %s (%d).\n", src_path, dest_path, errno);
+			#endif
+			return -1;
+		}
+
+		return 0;
+	}
+
 	ret = mount(src_path, dest_path, NULL, MS_BIND, NULL);
 	if (ret < 0) {
 		#ifdef _PRINTF_DEBUG_
@@ -483,6 +1094,30 @@ int mount_disk_bind(const char *src_path, const char *dest_path, int is_read_onl
 
 	return 0;
 }
+/**
+ * This function change mounted file system to read only.
+ * The read only flag is applied to super block, all bind mount of this file system (ex. guest side mount) become read only.
+ *
+ * @param [in]	path	Mount path.
+ * @param [in]	mntflag	Per mount flag to keep. (ex. MS_NODEV, MS_NOEXEC)
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 remount error.
+ */
+int remount_disk_readonly(const char *path, unsigned long mntflag)
+{
+	int ret = -1;
+
+	ret = mount(NULL, path, NULL, (MS_REMOUNT | MS_RDONLY | mntflag), NULL);
+	if (ret < 0) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"remount_disk_readonly: fail to remount %s (errno = %d).\n", path, errno);
+		#endif
+		return -1;
+	}
+
+	return 0;
+}
 /**
  * This function exec unmount operation.
  *
@@ -11,23 +11,71 @@
 #include <stddef.h>
 #include <sys/types.h>
 #include <signal.h>
+#include <sys/mount.h>
+
+//-----------------------------------------------------------------------------
+/**
+ * @def	CTRLFILE_BATCH_MAX
+ * @brief	Maximum number of queued write request in one control file write batch.
+ */
+#define CTRLFILE_BATCH_MAX	(8)
+
+/**
+ * @struct	s_ctrlfile_batch_req
+ * @brief	The data structure for one write request of control file write batch.
+ */
+struct s_ctrlfile_batch_req {
+	int fd;				/**< File descriptor of control file. */
+	const void *data;	/**< Pointer to write data. */
+	size_t size;		/**< Write data size. */
+	int result;			/**< Result of write. 0: success, -1: fail. */
+};
+typedef struct s_ctrlfile_batch_req ctrlfile_batch_req_t;	/**< typedef for struct s_ctrlfile_batch_req. */
+
+/**
+ * @struct	s_ctrlfile_batch
+ * @brief	The data structure for control file write batch.
+ */
+struct s_ctrlfile_batch {
+	int num;										/**< Number of queued request. */
+	ctrlfile_batch_req_t req[CTRLFILE_BATCH_MAX];	/**< Queued request. */
+};
+typedef struct s_ctrlfile_batch ctrlfile_batch_t;	/**< typedef for struct s_ctrlfile_batch. */
 
 //-----------------------------------------------------------------------------
 int pidfd_open_syscall_wrapper(pid_t pid);
 int pidfd_send_signal_syscall_wrapper(int pidfd, int sig, siginfo_t *info, unsigned int flags);
+int fsopen_syscall_wrapper(const char *fstype, unsigned int flags);
+int fsconfig_syscall_wrapper(int fsfd, unsigned int cmd, const char *key, const void *value, int aux);
+int fsmount_syscall_wrapper(int fsfd, unsigned int flags, unsigned int attr_flags);
+int move_mount_syscall_wrapper(int from_dirfd, const char *from_path, int to_dirfd, const char *to_path, unsigned int flags);
+int open_tree_syscall_wrapper(int dirfd, const char *path, unsigned int flags);
+int mount_setattr_syscall_wrapper(int dirfd, const char *path, unsigned int flags, struct mount_attr *attr, size_t size);
 int intr_safe_write(int fd, const void* data, size_t size);
 int once_write(const char *path, const void* data, size_t size);
 int once_read(const char *path, void* data, size_t size);
+int ctrlfile_open(int dirfd, const char *name);
+int ctrlfile_write(int fd, const void* data, size_t size);
+void ctrlfile_batch_init(ctrlfile_batch_t *batch);
+int ctrlfile_batch_add(ctrlfile_batch_t *batch, int fd, const void* data, size_t size);
+int ctrlfile_batch_flush(ctrlfile_batch_t *batch);
 int node_check(const char *path);
 int mkdir_p(const char *dir, mode_t mode);
 int wait_child_pid(pid_t pid);
 int64_t get_current_time_ms(void);
 void sleep_ms_time(int64_t wait_time);
 
-int mount_disk_failover(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option);
+int mount_disk_is_detached_supported(void);
+int mount_disk_detached(const char *dev, const char *fstype, unsigned long mntflag, const char *option);
+int mount_disk_attach(int mntfd, const char *path);
+int mount_disk_attach_remount(int mntfd, const char *path);
+int mount_disk_failover_select(char **devs, const char *fstype, int *order);
+int mount_disk_failover(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option, int *cache);
 int mount_disk_ab(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option, int side);
 int mount_disk_once(char **devs, const char *path, const char *fstype, unsigned long mntflag, char* option);
+int mount_disk_overlay(const char *path, const char *tmpfs_path, const char *size);
 int mount_disk_bind(const char *src_path, const char *dest_path, int is_read_only);
+int remount_disk_readonly(const char *path, unsigned long mntflag);
 int unmount_disk(const char *path, int64_t timeout_at, int retry_max);
 //-----------------------------------------------------------------------------
 #endif //#ifndef CM_UTIL_H
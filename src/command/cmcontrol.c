@@ -21,6 +21,10 @@ static struct option long_options[] = {
 	{"help", no_argument, 0, 1},
 	{"get-guest-list", no_argument, NULL, 10},
 	{"get-guest-list-json", no_argument, NULL, 11},
+	{"get-can-stats", no_argument, NULL, 12},
+	{"get-net-stats", no_argument, NULL, 13},
+	{"get-recovery-stats", no_argument, NULL, 14},
+	{"get-fs-errors", no_argument, NULL, 15},
 	{"shutdown-guest-name", required_argument, NULL, 20},
 	{"shutdown-guest-role", required_argument, NULL, 21},
 	{"reboot-guest-name", required_argument, NULL, 22},
@@ -49,6 +53,10 @@ static void usage(void)
 	    " --help                   print help strings.\n"
 	    " --get-guest-list         get guest container list from container manager.\n"
 		" --get-guest-list-json    get guest container list from container manager by json.\n"
+	    " --get-can-stats          get CAN gateway statistics of guest vxcan interfaces.\n"
+	    " --get-net-stats          get traffic shaping statistics of guest veth interfaces.\n"
+	    " --get-recovery-stats     get disk recovery statistics of guest containers.\n"
+	    " --get-fs-errors          get file system error reports of guest containers.\n"
 	    " --shutdown-guest-name=N  shutdown request to container manager. (N=guest name)\n"
 	    " --shutdown-guest-role=R  shutdown request to container manager. (R=guest role)\n"
 	    " --reboot-guest-name=N    reboot request to container manager. (N=guest name)\n"
@@ -216,6 +224,263 @@ error_return:
 	return;
 }
 
+void cm_get_can_stats(void)
+{
+	int fd = -1;
+	int ret = -1;
+	ssize_t sret = -1;
+	container_extif_command_get_t packet;
+	container_extif_command_getcanstats_response_t response;
+
+	(void) memset(&packet, 0, sizeof(packet));
+	(void) memset(&response, 0, sizeof(response));
+
+	// Create client socket
+	fd = cm_socket_setup();
+	if (fd < 0) {
+		(void) fprintf(stderr,"Container manager is busy.\n");
+		goto error_return;
+	}
+
+	packet.header.command = CONTAINER_EXTIF_COMMAND_GETCANSTATS;
+	sret = write(fd, &packet, sizeof(packet));
+	if (sret < (ssize_t)sizeof(packet)) {
+		(void) fprintf(stderr,"Container manager is confuse.\n");
+		goto error_return;
+	}
+
+	ret = cm_socket_wait_response(fd, 1000);
+	if (ret < 0) {
+		(void) fprintf(stderr,"Container manager communication is un available.\n");
+		goto error_return;
+	}
+
+	sret = read(fd, &response, sizeof(response));
+	if (sret < (ssize_t)sizeof(response)) {
+		(void) fprintf(stderr,"Container manager is confuse. sret = %ld errno = %d\n", sret, errno);
+		goto error_return;
+	}
+
+	if (response.header.command == CONTAINER_EXTIF_COMMAND_RESPONSE_GETCANSTATS) {
+		(void) fprintf(stdout, "HEADER: %32s,%8s,%12s,%12s,%8s,%12s,%12s,%8s \n"
+			, "name", "ifname", "rx-handled", "rx-dropped", "rx-fps", "tx-handled", "tx-dropped", "tx-fps");
+		for (int i = 0; i < response.num_of_canifs && i < CONTAINER_EXTIF_CANIF_MAX; i++) {
+			container_extif_canif_stat_t *pstat = &response.canifs[i];
+
+			(void) fprintf(stdout, "        %32s,%8s,%12llu,%12llu,%8u,%12llu,%12llu,%8u \n"
+				, pstat->guest_name, pstat->ifname
+				, (unsigned long long)pstat->rx_handled, (unsigned long long)pstat->rx_dropped, pstat->rx_rate
+				, (unsigned long long)pstat->tx_handled, (unsigned long long)pstat->tx_dropped, pstat->tx_rate);
+		}
+	}
+
+error_return:
+	if (fd != -1) {
+		(void) close(fd);
+	}
+
+	return;
+}
+
+void cm_get_net_stats(void)
+{
+	int fd = -1;
+	int ret = -1;
+	ssize_t sret = -1;
+	container_extif_command_get_t packet;
+	container_extif_command_getnetstats_response_t response;
+
+	(void) memset(&packet, 0, sizeof(packet));
+	(void) memset(&response, 0, sizeof(response));
+
+	// Create client socket
+	fd = cm_socket_setup();
+	if (fd < 0) {
+		(void) fprintf(stderr,"Container manager is busy.\n");
+		goto error_return;
+	}
+
+	packet.header.command = CONTAINER_EXTIF_COMMAND_GETNETSTATS;
+	sret = write(fd, &packet, sizeof(packet));
+	if (sret < (ssize_t)sizeof(packet)) {
+		(void) fprintf(stderr,"Container manager is confuse.\n");
+		goto error_return;
+	}
+
+	ret = cm_socket_wait_response(fd, 1000);
+	if (ret < 0) {
+		(void) fprintf(stderr,"Container manager communication is un available.\n");
+		goto error_return;
+	}
+
+	sret = read(fd, &response, sizeof(response));
+	if (sret < (ssize_t)sizeof(response)) {
+		(void) fprintf(stderr,"Container manager is confuse. sret = %ld errno = %d\n", sret, errno);
+		goto error_return;
+	}
+
+	if (response.header.command == CONTAINER_EXTIF_COMMAND_RESPONSE_GETNETSTATS) {
+		(void) fprintf(stdout, "HEADER: %32s,%8s,%10s,%16s,%12s,%12s \n"
+			, "name", "ifname", "class", "bytes", "packets", "drops");
+		for (int i = 0; i < response.num_of_classes && i < CONTAINER_EXTIF_NETCLASS_MAX; i++) {
+			container_extif_netclass_stat_t *pstat = &response.classes[i];
+			char classname[16];
+
+			if (pstat->classid == CONTAINER_EXTIF_NETCLASS_FROM_GUEST) {
+				(void) snprintf(classname, sizeof(classname), "ingress");
+			} else {
+				(void) snprintf(classname, sizeof(classname), "%x:%x", (pstat->classid >> 16), (pstat->classid & 0xffffu));
+			}
+
+			(void) fprintf(stdout, "        %32s,%8s,%10s,%16llu,%12llu,%12llu \n"
+				, pstat->guest_name, pstat->ifname, classname
+				, (unsigned long long)pstat->bytes, (unsigned long long)pstat->packets, (unsigned long long)pstat->drops);
+		}
+	}
+
+error_return:
+	if (fd != -1) {
+		(void) close(fd);
+	}
+
+	return;
+}
+
+void cm_get_recovery_stats(void)
+{
+	int fd = -1;
+	int ret = -1;
+	ssize_t sret = -1;
+	container_extif_command_get_t packet;
+	container_extif_command_getrecoverystats_response_t response;
+	static const char *tier_string[] = {"journal", "check", "recreate"};
+	static const char *phase_string[] = {"prepare", "check", "erase", "format", "journal"};
+
+	(void) memset(&packet, 0, sizeof(packet));
+	(void) memset(&response, 0, sizeof(response));
+
+	// Create client socket
+	fd = cm_socket_setup();
+	if (fd < 0) {
+		(void) fprintf(stderr,"Container manager is busy.\n");
+		goto error_return;
+	}
+
+	packet.header.command = CONTAINER_EXTIF_COMMAND_GETRECOVERYSTATS;
+	sret = write(fd, &packet, sizeof(packet));
+	if (sret < (ssize_t)sizeof(packet)) {
+		(void) fprintf(stderr,"Container manager is confuse.\n");
+		goto error_return;
+	}
+
+	ret = cm_socket_wait_response(fd, 1000);
+	if (ret < 0) {
+		(void) fprintf(stderr,"Container manager communication is un available.\n");
+		goto error_return;
+	}
+
+	sret = read(fd, &response, sizeof(response));
+	if (sret < (ssize_t)sizeof(response)) {
+		(void) fprintf(stderr,"Container manager is confuse. sret = %ld errno = %d\n", sret, errno);
+		goto error_return;
+	}
+
+	if (response.header.command == CONTAINER_EXTIF_COMMAND_RESPONSE_GETRECOVERYSTATS) {
+		(void) fprintf(stdout, "HEADER: %32s,%10s,%8s,%14s,%12s \n"
+			, "name", "tier", "count", "total(ms)", "max(ms)");
+		for (int i = 0; i < response.num_of_guests && i < CONTAINER_EXTIF_GUESTS_MAX; i++) {
+			container_extif_recovery_stat_t *pstat = &response.guests[i];
+			const char *last = "none";
+
+			for (int j = 0; j < CONTAINER_EXTIF_RECOVERY_TIER_MAX; j++) {
+				(void) fprintf(stdout, "        %32s,%10s,%8u,%14llu,%12llu \n"
+					, pstat->guest_name, tier_string[j], pstat->count[j]
+					, (unsigned long long)pstat->total_time_ms[j], (unsigned long long)pstat->max_time_ms[j]);
+			}
+
+			if ((pstat->last_tier >= 0) && (pstat->last_tier < CONTAINER_EXTIF_RECOVERY_TIER_MAX)) {
+				last = tier_string[pstat->last_tier];
+			}
+			(void) fprintf(stdout, "        %32s,%10s,%8u, last: %s (%llu ms)\n"
+				, pstat->guest_name, "failed", pstat->failed, last, (unsigned long long)pstat->last_time_ms);
+
+			if ((pstat->running_phase >= 0) && (pstat->running_phase < (int32_t)(sizeof(phase_string) / sizeof(phase_string[0])))) {
+				if (pstat->running_percent >= 0) {
+					(void) fprintf(stdout, "        %32s,%10s, %s %d%%\n"
+						, pstat->guest_name, "running", phase_string[pstat->running_phase], pstat->running_percent);
+				} else {
+					(void) fprintf(stdout, "        %32s,%10s, %s\n"
+						, pstat->guest_name, "running", phase_string[pstat->running_phase]);
+				}
+			}
+		}
+	}
+
+error_return:
+	if (fd != -1) {
+		(void) close(fd);
+	}
+
+	return;
+}
+
+void cm_get_fs_errors(void)
+{
+	int fd = -1;
+	int ret = -1;
+	ssize_t sret = -1;
+	container_extif_command_get_t packet;
+	container_extif_command_getfserrors_response_t response;
+
+	(void) memset(&packet, 0, sizeof(packet));
+	(void) memset(&response, 0, sizeof(response));
+
+	// Create client socket
+	fd = cm_socket_setup();
+	if (fd < 0) {
+		(void) fprintf(stderr,"Container manager is busy.\n");
+		goto error_return;
+	}
+
+	packet.header.command = CONTAINER_EXTIF_COMMAND_GETFSERRORS;
+	sret = write(fd, &packet, sizeof(packet));
+	if (sret < (ssize_t)sizeof(packet)) {
+		(void) fprintf(stderr,"Container manager is confuse.\n");
+		goto error_return;
+	}
+
+	ret = cm_socket_wait_response(fd, 1000);
+	if (ret < 0) {
+		(void) fprintf(stderr,"Container manager communication is un available.\n");
+		goto error_return;
+	}
+
+	sret = read(fd, &response, sizeof(response));
+	if (sret < (ssize_t)sizeof(response)) {
+		(void) fprintf(stderr,"Container manager is confuse. sret = %ld errno = %d\n", sret, errno);
+		goto error_return;
+	}
+
+	if (response.header.command == CONTAINER_EXTIF_COMMAND_RESPONSE_GETFSERRORS) {
+		(void) fprintf(stdout, "HEADER: %32s,%8s,%8s,%14s, %s \n"
+			, "name", "count", "error", "time(ms)", "path");
+		for (int i = 0; i < response.num_of_guests && i < CONTAINER_EXTIF_GUESTS_MAX; i++) {
+			container_extif_fserror_stat_t *pstat = &response.guests[i];
+
+			(void) fprintf(stdout, "        %32s,%8u,%8d,%14llu, %s \n"
+				, pstat->guest_name, pstat->count, pstat->last_error
+				, (unsigned long long)pstat->last_time_ms, pstat->last_path);
+		}
+	}
+
+error_return:
+	if (fd != -1) {
+		(void) close(fd);
+	}
+
+	return;
+}
+
 const char *cm_control_lifecycle_messages[] = {
 	"Success to shutdown guest: name = %s\n",
 	"Success to shutdown guest: role = %s\n",
@@ -452,6 +717,18 @@ int main(int argc, char *argv[])
 				cm_get_guest_list(0);
 			}
 			break;
+		} else if (ret == 12) {
+			cm_get_can_stats();
+			break;
+		} else if (ret == 13) {
+			cm_get_net_stats();
+			break;
+		} else if (ret == 14) {
+			cm_get_recovery_stats();
+			break;
+		} else if (ret == 15) {
+			cm_get_fs_errors();
+			break;
 		} else if (ret >= 20 && ret <= 25) {
 			cm_get_guest_lifecycle(ret, optarg);
 			break;
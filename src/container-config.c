@@ -298,6 +298,8 @@ containers_t *create_container_configs(const char *config_file)
 					}
 					(void)container_workqueue_initialize(&(cc->workqueue));
 					cc->runtime_stat.status = CONTAINER_DISABLE;
+					cc->runtime_stat.netns_fd = -1;
+					cc->runtime_stat.netns_pid = -1;
 					ca[num] = cc;
 					num = num + 1;
 				}
@@ -0,0 +1,255 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	container-control-devwait.c
+ * @brief	This file include implementation for waiting of guest mandatory block device that is not present yet.
+ */
+#undef _PRINTF_DEBUG_
+
+#include "container-control-internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+#include <libudev.h>
+
+/**
+ * @struct	s_container_devwait
+ * @brief	The data structure for block device add monitor.
+ */
+struct s_container_devwait {
+	struct udev *pudev;					/**< The udev object created by libudev. */
+	struct udev_monitor *pudev_monitor;	/**< The udev_monitor object for block subsystem. */
+	sd_event_source *udev_source;		/**< The sd event source for udev_monitor. */
+};
+
+/**
+ * Device add notification to container manager state machine from block device monitor.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success to send event.
+ * @retval -1 Critical error for sending event.
+ */
+static int container_devwait_notify(containers_t *cs)
+{
+	container_mngsm_notification_t command;
+	ssize_t ret = -1;
+
+	(void) memset(&command, 0, sizeof(command));
+
+	command.header.command = CONTAINER_MNGSM_COMMAND_DEVICE_ADDED;
+
+	ret = write(cs->cms->secondary_fd, &command, sizeof(command));
+	if (ret != (ssize_t)sizeof(command)) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function for block device monitor.
+ * This function test waiting device of all guests.  The device node is checked only when any guest is waiting.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  1 One or more waiting device was appeared.
+ * @retval  0 No waiting device was appeared.
+ */
+static int container_devwait_test(containers_t *cs)
+{
+	int result = 0;
+
+	for (int i = 0; i < cs->num_of_container; i++) {
+		container_config_t *cc = cs->containers[i];
+
+		if (cc->runtime_stat.wait_device == NULL) {
+			continue;
+		}
+
+		if (access(cc->runtime_stat.wait_device, F_OK) == 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"container_devwait: device %s was appeared for %s.\n", cc->runtime_stat.wait_device, cc->name);
+			#endif
+			cc->runtime_stat.wait_device = NULL;
+			result = 1;
+		}
+	}
+
+	return result;
+}
+/**
+ * Event handler for block device monitor.
+ * When waiting device was appeared, this handler send event to container manager state machine.  The guest launch is retried in this event.
+ *
+ * @param [in]	event		udev monitor event source object.
+ * @param [in]	fd			File descriptor for udev_monitor.
+ * @param [in]	revents		Active event (epoll).
+ * @param [in]	userdata	Pointer to containers_t.
+ * @return int
+ * @retval	0	Success to event handling.
+ * @retval	-1	Internal error (Not use).
+ */
+static int container_devwait_udev_handler(sd_event_source *event, int fd, uint32_t revents, void *userdata)
+{
+	containers_t *cs = NULL;
+	struct udev_device *pdev = NULL;
+	const char *action = NULL;
+	int ret = -1;
+
+	if (userdata == NULL) {
+		// Fail safe - disable udev event
+		sd_event_source_disable_unref(event);
+		return 0;
+	}
+
+	cs = (containers_t*)userdata;
+
+	if ((revents & (EPOLLHUP | EPOLLERR)) != 0) {
+		// Fail safe - disable udev event.  Waiting guest is recovered by wait timeout.
+		sd_event_source_disable_unref(event);
+		cs->cms->devwait->udev_source = NULL;
+		return 0;
+	}
+
+	if ((revents & EPOLLIN) == 0) {
+		return 0;
+	}
+
+	pdev = udev_monitor_receive_device(cs->cms->devwait->pudev_monitor);
+	if (pdev == NULL) {
+		return 0;
+	}
+
+	action = udev_device_get_action(pdev);
+	if ((action != NULL) && ((strcmp(action, "add") == 0) || (strcmp(action, "change") == 0))) {
+		// dm device is usable after "change" event.
+		ret = container_devwait_test(cs);
+		if (ret == 1) {
+			(void) container_devwait_notify(cs);
+		}
+	}
+
+	(void) udev_device_unref(pdev);
+
+	return 0;
+}
+/**
+ * Setup block device monitor for device waiting.
+ * This monitor use udev netlink event.  It's sent after udev created device node and symlink (ex. /dev/disk/by-partlabel).
+ * When udev monitor is not available, waiting guest is recovered by wait timeout only.
+ *
+ * @param [in]	cs		Pointer to containers_t.
+ * @param [in]	event	Instance of sd_event.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Internal error.
+ */
+int container_devwait_setup(containers_t *cs, sd_event *event)
+{
+	container_devwait_t *devwait = NULL;
+	int fd = -1;
+	int ret = -1;
+
+	if ((cs == NULL) || (cs->cms == NULL) || (event == NULL)) {
+		return -1;
+	}
+
+	devwait = (container_devwait_t*)malloc(sizeof(container_devwait_t));
+	if (devwait == NULL) {
+		return -1;
+	}
+	(void) memset(devwait, 0, sizeof(container_devwait_t));
+
+	cs->cms->devwait = devwait;
+
+	devwait->pudev = udev_new();
+	if (devwait->pudev == NULL) {
+		goto err_monitor;
+	}
+
+	devwait->pudev_monitor = udev_monitor_new_from_netlink(devwait->pudev, "udev");
+	if (devwait->pudev_monitor == NULL) {
+		goto err_monitor;
+	}
+
+	ret = udev_monitor_filter_add_match_subsystem_devtype(devwait->pudev_monitor, "block", NULL);
+	if (ret < 0) {
+		goto err_monitor;
+	}
+
+	ret = udev_monitor_enable_receiving(devwait->pudev_monitor);
+	if (ret < 0) {
+		goto err_monitor;
+	}
+
+	fd = udev_monitor_get_fd(devwait->pudev_monitor);
+	if (fd < 0) {
+		goto err_monitor;
+	}
+
+	ret = sd_event_add_io(event, &devwait->udev_source, fd, EPOLLIN, container_devwait_udev_handler, cs);
+	if (ret < 0) {
+		devwait->udev_source = NULL;
+		goto err_monitor;
+	}
+
+	return 0;
+
+err_monitor:
+	if (devwait->pudev_monitor != NULL) {
+		(void) udev_monitor_unref(devwait->pudev_monitor);
+		devwait->pudev_monitor = NULL;
+	}
+
+	if (devwait->pudev != NULL) {
+		(void) udev_unref(devwait->pudev);
+		devwait->pudev = NULL;
+	}
+
+	#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+	(void) fprintf(stderr,"[CM CRITICAL INFO] udev monitor is not available, device waiting use timeout only.\n");
+	#endif
+
+	return 0;
+}
+/**
+ * Cleanup block device monitor for device waiting.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Argument error.
+ */
+int container_devwait_cleanup(containers_t *cs)
+{
+	container_devwait_t *devwait = NULL;
+
+	if ((cs == NULL) || (cs->cms == NULL)) {
+		return -1;
+	}
+
+	devwait = cs->cms->devwait;
+	if (devwait == NULL) {
+		return 0;
+	}
+
+	if (devwait->udev_source != NULL) {
+		(void) sd_event_source_disable_unref(devwait->udev_source);
+	}
+
+	if (devwait->pudev_monitor != NULL) {
+		(void) udev_monitor_unref(devwait->pudev_monitor);
+	}
+
+	if (devwait->pudev != NULL) {
+		(void) udev_unref(devwait->pudev);
+	}
+
+	(void) free(devwait);
+	cs->cms->devwait = NULL;
+
+	return 0;
+}
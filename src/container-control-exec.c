@@ -9,6 +9,7 @@
 #include "container-control-internal.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 
@@ -25,9 +26,13 @@
 #include "container-config.h"
 #include "container-workqueue.h"
 #include "device-control.h"
+#include "parallel-util.h"
 
 static int container_start_preprocess_base(container_baseconfig_t *bc);
 static int container_start_preprocess_base_recovery(container_config_t *cc);
+static int container_start_preprocess_base_fserror(container_config_t *cc);
+static int container_start_wait_device_test(container_config_t *cc);
+static int container_start_wait_device_setup(container_config_t *cc);
 static int container_cleanup_preprocess_base(container_baseconfig_t *bc, int64_t timeout);
 static int container_get_active_guest_by_role(containers_t *cs, char *role, container_config_t **active_cc);
 static int container_timeout_set(container_config_t *cc);
@@ -45,6 +50,16 @@ static const int g_reduced_critical_error_mount = 100;
  * @brief	Error log output rate. The type of launch retry error should be reduced using this parameter.
  */
 static const int g_reduced_critical_error_launch = 100;
+/**
+ * @def	CONTAINER_EXTRADISK_MOUNT_PARALLEL_MAX
+ * @brief	Maximum number of parallel extra disk mount in one guest start.
+ */
+#define CONTAINER_EXTRADISK_MOUNT_PARALLEL_MAX	(4)
+/**
+ * @def	CONTAINER_DEVICE_WAIT_TIMEOUT
+ * @brief	Timeout (ms) of mandatory block device waiting.  After timeout, mount is retried without device add event.
+ */
+#define CONTAINER_DEVICE_WAIT_TIMEOUT	(10000)
 
 /**
  * The function for timeout calculate and set.
@@ -118,7 +133,7 @@ int container_netif_update_guest(container_config_t *cc, dynamic_device_manager_
 				cdne->is_available = 1;
 
 				//add net interface to guest container
-				ret = lxcutil_dynamic_networkif_add_to_guest(cc, cdne);
+				ret = container_netif_assign_to_guest(ddm, cc, cdne);
 				if (ret < 0) {
 					// fail back
 					cdne->ifindex = 0;
@@ -187,6 +202,8 @@ int container_netif_remove_element(container_config_t *cc)
 }
 /**
  * Dispatch dynamic network interface update operation to all guest container.
+ * This is full rescan for all guest, link event is handled incrementally by container_netif_link_changed.
+ * This function use to guest start and resync.
  *
  * @param [in]	cs	Pointer to containers_t
  * @return int
@@ -210,12 +227,239 @@ int container_netif_updated(containers_t *cs)
 		}
 	}
 
+	if (cs->netif_index != NULL) {
+		(void) container_netif_index_resync(cs);
+	}
+
 	return 0;
 
 err_ret:
 
 	return result;
 }
+/**
+ * Per container worker completion handling.
+ * When per container workqueue is completed, this function cleanup workqueue and set next container status.
+ *
+ * @param [in]	cc	Pointer to container_config_t.
+ * @return int
+ * @retval  1 Worker is not completed.
+ * @retval  0 Success to cleanup and change next state.
+ */
+static int container_worker_complete(container_config_t *cc)
+{
+	int ret = -1;
+	int status = -1;
+	int after_execute = 0;
+
+	status = container_workqueue_get_status(&cc->workqueue);
+	if (status != CONTAINER_WORKER_COMPLETED) {
+		return 1;
+	}
+
+	// A workqueue is completed, cleanup and set next state.
+	ret = container_workqueue_cleanup(&cc->workqueue, &after_execute);
+	if (ret < 0) {
+		return 1;
+	}
+
+	if (after_execute == 1) {
+		// When CONTAINER_DEAD set to runtime_stat.status, this container will restart in following event execution.
+		cc->runtime_stat.status = CONTAINER_DEAD;
+	} else {
+		cc->runtime_stat.status = CONTAINER_NOT_STARTED;
+	}
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "container_workqueue end of worker exec(%d) at %s\n", after_execute, cc->name);
+	#endif
+
+	return 0;
+}
+/**
+ * Worker completion event handler.
+ * Per container worker completion is applied to container status immediately, guest relaunch is executed in following internal event execution.
+ * Manager worker result is collected by cyclic operation in internal event execution.
+ *
+ * @param [in]	cs		Pointer to containers_t
+ * @param [in]	data	Pointer to container_mngsm_worker_done_data_t, it's include detail of worker completion event.
+ * @return int
+ * @retval  0 Success to handle event.
+ * @retval -1 Got undefined target.
+ */
+int container_worker_done(containers_t *cs, const container_mngsm_worker_done_data_t *data)
+{
+	container_config_t *cc = NULL;
+	int container_num = 0;
+
+	container_num = data->container_number;
+	if (container_num == CONTAINER_MNGSM_WORKER_MANAGER) {
+		// Manager worker, collect by cyclic operation.
+		return 0;
+	}
+
+	if ((container_num < 0) || (cs->num_of_container <= container_num)) {
+		return -1;
+	}
+
+	cc = cs->containers[container_num];
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"container_worker_done : %s result = %d\n", cc->name, data->result);
+	#endif
+
+	if ((cs->sys_state == CM_SYSTEM_STATE_RUN) && (cc->runtime_stat.status == CONTAINER_RUN_WORKER)) {
+		(void) container_worker_complete(cc);
+	}
+
+	return 0;
+}
+/**
+ * Sub function for file system error event handler.  Apply file system error policy to guest disk.
+ *
+ * @param [in]	cs		Pointer to containers_t
+ * @param [in]	cc		Pointer to container_config_t of error disk owner.
+ * @param [in]	data	Pointer to container_mngsm_fs_error_data_t.
+ * @return int
+ * @retval  0 Success to apply policy.
+ * @retval -1 Fail to apply policy or policy is not supported for the disk.
+ */
+static int container_fs_error_apply_policy(containers_t *cs, container_config_t *cc, const container_mngsm_fs_error_data_t *data)
+{
+	container_baseconfig_t *bc = &cc->baseconfig;
+	container_baseconfig_extradisk_t *exdisk = NULL;
+	int policy = bc->fserror_policy;
+	int ret = -1;
+
+	if (data->disk_index != CONTAINER_MNGSM_FS_ERROR_ROOTFS) {
+		int index = 0;
+
+		dl_list_for_each(exdisk, &bc->extradisk_list, container_baseconfig_extradisk_t, list) {
+			if (index == data->disk_index) {
+				break;
+			}
+			index++;
+		}
+		if (index != data->disk_index) {
+			return -1;
+		}
+	}
+
+	if (policy == FSERROR_POLICY_REMOUNT_RO) {
+		if (exdisk == NULL) {
+			if ((bc->rootfs.is_mounted == 0) || (bc->rootfs.mode != DISKMOUNT_TYPE_RW)) {
+				return 0;
+			}
+			ret = remount_disk_readonly(bc->rootfs.path, (MS_NOATIME | MS_NODEV));
+		} else {
+			if ((exdisk->is_mounted == 0) || (exdisk->mode != DISKMOUNT_TYPE_RW)) {
+				return 0;
+			}
+			ret = remount_disk_readonly(exdisk->from, (MS_NOATIME | MS_NODEV | MS_NOEXEC));
+		}
+	} else if ((policy == FSERROR_POLICY_FSCK) || (policy == FSERROR_POLICY_RESTART)) {
+		ret = 0;
+		if ((exdisk != NULL)
+			&& ((exdisk->redundancy == DISKREDUNDANCY_TYPE_FSCK) || (exdisk->redundancy == DISKREDUNDANCY_TYPE_MKFS)
+				|| (exdisk->redundancy == DISKREDUNDANCY_TYPE_CLONE))) {
+			// Recovery is queued at next guest start.
+			exdisk->fs_error_pending = 1;
+		} else {
+			// rootfs, failover and ab disk do not support recovery.
+			ret = -1;
+		}
+
+		if (policy == FSERROR_POLICY_RESTART) {
+			(void) container_request_reboot(cc, cs->sys_state);
+		}
+	} else {
+		// FSERROR_POLICY_NONE, log only.
+		ret = 0;
+	}
+
+	return ret;
+}
+/**
+ * File system error event handler.
+ * File system error is reported by file system monitor while guest disk or manager disk is mounted.
+ * Guest disk error is handled by file system error policy of the guest, manager disk error is log only.
+ *
+ * @param [in]	cs		Pointer to containers_t
+ * @param [in]	data	Pointer to container_mngsm_fs_error_data_t, it's include detail of file system error event.
+ * @return int
+ * @retval  0 Success to handle event.
+ * @retval -1 Got undefined target.
+ */
+int container_fs_error(containers_t *cs, const container_mngsm_fs_error_data_t *data)
+{
+	container_config_t *cc = NULL;
+	container_baseconfig_extradisk_t *exdisk = NULL;
+	const char *path = NULL;
+	int ret = -1;
+
+	if (data->container_number == CONTAINER_MNGSM_WORKER_MANAGER) {
+		container_manager_operation_mount_elem_t *melem = NULL;
+
+		dl_list_for_each(melem, &cs->cmcfg->operation.mount.mount_list, container_manager_operation_mount_elem_t, list) {
+			if (melem->index == data->disk_index) {
+				#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+				(void) fprintf(stderr,"[CM CRITICAL ERROR] File system error (err = %d, count = %u) at manager disk %s.\n"
+								, data->error, data->error_count, melem->to);
+				#endif
+				break;
+			}
+		}
+		return 0;
+	}
+
+	if ((data->container_number < 0) || (cs->num_of_container <= data->container_number)) {
+		return -1;
+	}
+
+	cc = cs->containers[data->container_number];
+
+	if (data->disk_index == CONTAINER_MNGSM_FS_ERROR_ROOTFS) {
+		path = cc->baseconfig.rootfs.path;
+	} else {
+		int index = 0;
+
+		dl_list_for_each(exdisk, &cc->baseconfig.extradisk_list, container_baseconfig_extradisk_t, list) {
+			if (index == data->disk_index) {
+				path = exdisk->from;
+				break;
+			}
+			index++;
+		}
+	}
+
+	if (path == NULL) {
+		return -1;
+	}
+
+	cc->runtime_stat.fserror.count = cc->runtime_stat.fserror.count + data->error_count;
+	cc->runtime_stat.fserror.last_error = data->error;
+	cc->runtime_stat.fserror.last_time = get_current_time_ms();
+	cc->runtime_stat.fserror.last_path = path;
+
+	#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+	(void) fprintf(stderr,"[CM CRITICAL ERROR] File system error (err = %d, count = %u) at %s in container %s.\n"
+					, data->error, data->error_count, path, cc->name);
+	#endif
+
+	if (cs->sys_state != CM_SYSTEM_STATE_RUN) {
+		// Guest will exit, no recovery action.
+		return 0;
+	}
+
+	ret = container_fs_error_apply_policy(cs, cc, data);
+	if (ret < 0) {
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Fail to apply file system error policy (%d) to %s in container %s.\n"
+						, cc->baseconfig.fserror_policy, path, cc->name);
+		#endif
+	}
+
+	return 0;
+}
 /**
  * Container status change event handler in container exit.
  * This handler is judging next container status using system state, current status and exit event.
@@ -690,9 +934,12 @@ int container_exec_internal_event(containers_t *cs)
 										;	//nop
 									}
 								}
-							} else {
+							} else if (ret == 0) {
 								// Change state to CONTAINER_RUN_WORKER
 								cc->runtime_stat.status = CONTAINER_RUN_WORKER;
+							} else {
+								// Physical disk is used by other recovery, retry in following event execution.
+								;	//nop
 							}
 
 						} else {
@@ -701,31 +948,8 @@ int container_exec_internal_event(containers_t *cs)
 					}
 				}
 			} else if (cc->runtime_stat.status == CONTAINER_RUN_WORKER) {
-				// Now run worker
-				int status = -1;
-
-				status = container_workqueue_get_status(&cc->workqueue);
-				if (status == CONTAINER_WORKER_COMPLETED) {
-					// A workqueue is completed, cleanup and set next state.
-					int after_execute = 0;
-
-					ret = container_workqueue_cleanup(&cc->workqueue, &after_execute);
-					if (ret == 0) {
-						if (after_execute == 1) {
-							// When CONTAINER_DEAD set to runtime_stat.status, this container will restart in next event execution cycle.
-							cc->runtime_stat.status = CONTAINER_DEAD;
-						} else {
-							cc->runtime_stat.status = CONTAINER_NOT_STARTED;
-						}
-						#ifdef _PRINTF_DEBUG_
-						(void) fprintf(stdout, "container_workqueue end of worker exec(%d) at %s\n", after_execute, cc->name);
-						#endif
-					} else {
-						;	// nop
-					}
-				} else {
-					;	// nop
-				}
+				// Now run worker. Typically completion is handled by worker completion event, this is fail safe.
+				(void) container_worker_complete(cc);
 			} else {
 				// nop
 				;
@@ -762,6 +986,9 @@ int container_exec_internal_event(containers_t *cs)
 		// Do cyclic operation for manager.
 		(void) container_mngsm_do_cyclic_operation(cs);
 
+		// Follow mount state change to file system error monitor.
+		(void) container_fsmonitor_sync(cs);
+
 	} else if (cs->sys_state == CM_SYSTEM_STATE_SHUTDOWN) {
 		// internal event for shutdown state
 		int exit_count = 0;
@@ -885,6 +1112,22 @@ static int container_launch(container_config_t *cc)
 
 	cc->runtime_stat.status = CONTAINER_STARTED;
 
+	// Take over device permission control from lxc for runtime device allow/deny (cgroup v2 only).
+	ret = lxcutil_cgroup_device_attach(cc);
+	if (ret < 0) {
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Container %s can not attach cgroup v2 device controller.\n", cc->name);
+		#endif
+	}
+
+	// Apply traffic shaping to host side peer of guest network interfaces.
+	ret = lxcutil_netif_shaping_setup(cc);
+	if (ret < 0) {
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Container %s can not apply network traffic shaping.\n", cc->name);
+		#endif
+	}
+
 	return 0;
 }
 /**
@@ -912,9 +1155,28 @@ int container_start(container_config_t *cc)
 	(void) fprintf(stdout, "container_start %s\n", cc->name);
 	#endif
 
+	// When mandatory block device is not present yet, wait device add event without mount retry.
+	ret = container_start_wait_device_test(cc);
+	if (ret == 1) {
+		return -1;
+	}
+
+	// When file system error was reported in previous run, recover before mount.
+	ret = container_start_preprocess_base_fserror(cc);
+	if (ret == 1) {
+		return -1;
+	}
+
 	// run preprocess
 	ret = container_start_preprocess_base(&cc->baseconfig);
 	if (ret < 0) {
+		// When mandatory block device is not present, mount is retried at device add event.
+		ret = container_start_wait_device_setup(cc);
+		if (ret == 1) {
+			cc->runtime_stat.status = CONTAINER_DEAD;
+			return -1;
+		}
+
 		// When got error from container_start_preprocess_base, try to evaluate recovery.
 
 		(void) container_start_preprocess_base_recovery(cc);
@@ -1149,9 +1411,263 @@ static int container_start_preprocess_base_do_mount_rootfs(container_baseconfig_
 
 	return result;
 }
+/**
+ * @struct	s_container_extradisk_mount_arg
+ * @brief	The argument of extra disk mount job for parallel mount.
+ */
+struct s_container_extradisk_mount_arg {
+	container_baseconfig_extradisk_t *exdisk;	/**< Target extra disk. */
+	int side;									/**< Mount side for ab disk. */
+	int is_staged;								/**< Build detached mount only. (1=staged mount) */
+	int mntfd;									/**< Detached mount fd of staged mount. Not created is -1. */
+};
+/**
+ * Extra disk staged mount procedure.
+ * This function create detached mount only, it's attached by main thread after all staged mount were created.
+ *
+ * @param [in]	mount_arg	Pointer to struct s_container_extradisk_mount_arg.
+ * @param [in]	mntflag		Mount flag.
+ * @return int
+ * @retval  >=0 Success. Index of mounted device.
+ * @retval -1 mount error.
+ */
+static int container_start_preprocess_base_stage_extradisk(struct s_container_extradisk_mount_arg *mount_arg, unsigned long mntflag)
+{
+	container_baseconfig_extradisk_t *exdisk = mount_arg->exdisk;
+	int order[2] = {0, 0};
+	int num = 0;
+	int mntfd = -1;
+
+	if (exdisk->redundancy == DISKREDUNDANCY_TYPE_AB) {
+		if ((mount_arg->side < 0) || (mount_arg->side >= 2)) {
+			return -1;
+		}
+		order[0] = mount_arg->side;
+		num = 1;
+	} else if (exdisk->redundancy == DISKREDUNDANCY_TYPE_FAILOVER) {
+		if ((exdisk->failover_cache == 1) || (exdisk->failover_cache == 2)) {
+			// Mount previous disk directly.
+			mntfd = mount_disk_detached(exdisk->blockdev[exdisk->failover_cache - 1], exdisk->filesystem, mntflag, exdisk->option);
+			if (mntfd >= 0) {
+				mount_arg->mntfd = mntfd;
+				return (exdisk->failover_cache - 1);
+			}
+			exdisk->failover_cache = 0;
+		}
+		num = mount_disk_failover_select(exdisk->blockdev, exdisk->filesystem, order);
+	} else {
+		// DISKREDUNDANCY_TYPE_FSCK, DISKREDUNDANCY_TYPE_MKFS or DISKREDUNDANCY_TYPE_CLONE, only to use primary side.
+		order[0] = 0;
+		num = 1;
+	}
+
+	for (int i = 0; i < num; i++) {
+		if (exdisk->blockdev[order[i]] == NULL) {
+			continue;
+		}
+
+		mntfd = mount_disk_detached(exdisk->blockdev[order[i]], exdisk->filesystem, mntflag, exdisk->option);
+		if (mntfd >= 0) {
+			mount_arg->mntfd = mntfd;
+			if (exdisk->redundancy == DISKREDUNDANCY_TYPE_FAILOVER) {
+				exdisk->failover_cache = order[i] + 1;
+				return order[i];
+			}
+			return 0;
+		}
+	}
+
+	return -1;
+}
+/**
+ * Extra disk mount procedure.
+ * This function do mount operation only, it's possible to run in parallel with other extra disk.
+ * In case of staged mount, this function create detached mount only.
+ *
+ * @param [in]	arg	Pointer to struct s_container_extradisk_mount_arg.
+ * @return int
+ * @retval  >=0 Success.
+ * @retval -1 mount error.
+ * @retval -2 Syscall error.
+ * @retval -3 Arg. error.
+ */
+static int container_start_preprocess_base_do_mount_extradisk(void *arg)
+{
+	struct s_container_extradisk_mount_arg *mount_arg = (struct s_container_extradisk_mount_arg*)arg;
+	container_baseconfig_extradisk_t *exdisk = mount_arg->exdisk;
+	unsigned long mntflag = 0;
+	int ret = -1;
+
+	if (exdisk->mode == DISKMOUNT_TYPE_RW) {
+		mntflag = MS_DIRSYNC | MS_NOATIME | MS_NODEV | MS_NOEXEC | MS_SYNCHRONOUS;
+	} else {
+		mntflag = MS_NOATIME | MS_RDONLY;
+	}
+
+	if (mount_arg->is_staged == 1) {
+		return container_start_preprocess_base_stage_extradisk(mount_arg, mntflag);
+	}
+
+	if (exdisk->redundancy == DISKREDUNDANCY_TYPE_AB) {
+		ret = mount_disk_ab(exdisk->blockdev, exdisk->from, exdisk->filesystem, mntflag, exdisk->option, mount_arg->side);
+	} else if (exdisk->redundancy == DISKREDUNDANCY_TYPE_FAILOVER) {
+		ret = mount_disk_failover(exdisk->blockdev, exdisk->from, exdisk->filesystem, mntflag, exdisk->option, &exdisk->failover_cache);
+	} else {
+		// DISKREDUNDANCY_TYPE_FSCK, DISKREDUNDANCY_TYPE_MKFS or DISKREDUNDANCY_TYPE_CLONE
+		ret = mount_disk_once(exdisk->blockdev, exdisk->from, exdisk->filesystem, mntflag, exdisk->option);
+	}
+
+	return ret;
+}
+/**
+ * Extra disk mount result handling.
+ * This function update mount state and error count of extra disk. Shall call from main thread.
+ *
+ * @param [in]	exdisk	Pointer to container_baseconfig_extradisk_t.
+ * @param [in]	ret		Result of container_start_preprocess_base_do_mount_extradisk.
+ * @param [in]	side	Mount side for ab disk.
+ * @return int
+ * @retval  0 Success or optional disk error.
+ * @retval -1 Mandatory disk mount error.
+ */
+static int container_start_preprocess_base_extradisk_result(container_baseconfig_extradisk_t *exdisk, int ret, int side)
+{
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"container_start_preprocess_base: disk %s mount result %d (%lld ms)\n"
+					, exdisk->from, ret, (long long)exdisk->mount_time_ms);
+	#endif
+
+	if (ret >= 0) {
+		// This extra disk mount is succeed.
+		exdisk->is_mounted = 1;
+		// Clear error count
+		exdisk->error_count = 0;
+		return 0;
+	}
+
+	exdisk->error_count = exdisk->error_count + 1;
+
+	if (exdisk->redundancy == DISKREDUNDANCY_TYPE_AB) {
+		// AB disk mount is mandatory function.
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		if ((exdisk->error_count % g_reduced_critical_error_mount) == 1) {
+			// This log should be reduced to one output per 100 time of error.
+			(void) fprintf(stderr
+							,"[CM CRITICAL ERROR] Extra ab mount disk %s could not mount. (count = %d)\n"
+							, exdisk->blockdev[side], exdisk->error_count);
+		}
+		#else
+		(void) side;
+		#endif
+		return -1;
+	} else if (exdisk->redundancy == DISKREDUNDANCY_TYPE_FAILOVER) {
+		// Failover disk mount is optional function.
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		if ((exdisk->error_count % g_reduced_critical_error_mount) == 1) {
+			// This log should be reduced to one output per 100 time of error.
+			(void) fprintf(stderr
+							,"[CM CRITICAL ERROR] Extra failover disk %s could not mount. (count = %d)\n"
+							, exdisk->blockdev[0], exdisk->error_count);
+		}
+		#endif
+		return 0;
+	} else {
+		// DISKREDUNDANCY_TYPE_FSCK, DISKREDUNDANCY_TYPE_MKFS or DISKREDUNDANCY_TYPE_CLONE
+		// This point is critical error but not out critical error log. This log will out in recovery operation.
+		#ifdef _PRINTF_DEBUG_
+		if ((exdisk->error_count % g_reduced_critical_error_mount) == 1) {
+			// This log should be reduced to one output per 100 time of error.
+			(void) fprintf(stdout
+							,"container_start_preprocess_base: disk %s could not mount. (count = %d)\n"
+							, exdisk->blockdev[0], exdisk->error_count);
+		}
+		#endif
+		return -1;
+	}
+}
+/**
+ * Check extra disk mount point is nested under other not mounted extra disk.
+ * Nested extra disk shall mount after parent extra disk.
+ *
+ * @param [in]	bc		Pointer to container_baseconfig_t.
+ * @param [in]	exdisk	Pointer to container_baseconfig_extradisk_t.
+ * @return int
+ * @retval  1 Nested.
+ * @retval  0 Not nested.
+ */
+static int container_start_preprocess_base_extradisk_is_nested(container_baseconfig_t *bc, container_baseconfig_extradisk_t *exdisk)
+{
+	container_baseconfig_extradisk_t *parent = NULL;
+
+	dl_list_for_each(parent, &bc->extradisk_list, container_baseconfig_extradisk_t, list) {
+		size_t len = 0;
+
+		if ((parent == exdisk) || (parent->is_mounted != 0)) {
+			continue;
+		}
+
+		len = strlen(parent->from);
+		if ((strncmp(parent->from, exdisk->from, len) == 0) && ((exdisk->from[len] == '/') || (len > 0 && parent->from[len - 1] == '/'))) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+/**
+ * Attach staged extra disks.
+ * Detached mounts are attached in order of mount path length, parent mount point is attached before nested mount point.
+ * Attach error is reflected to job result.
+ *
+ * @param [in]	args	Array of struct s_container_extradisk_mount_arg.
+ * @param [in]	jobs	Array of parallel_util_job_t.
+ * @param [in]	num		Number of jobs.
+ * @return void
+ */
+static void container_start_preprocess_base_attach_extradisk(struct s_container_extradisk_mount_arg *args, parallel_util_job_t *jobs, int num)
+{
+	int ret = -1;
+
+	for (;;) {
+		int target = -1;
+		size_t target_len = 0;
+
+		for (int i = 0; i < num; i++) {
+			size_t len = 0;
+
+			if (args[i].mntfd < 0) {
+				continue;
+			}
+
+			len = strlen(args[i].exdisk->from);
+			if ((target < 0) || (len < target_len)) {
+				target = i;
+				target_len = len;
+			}
+		}
+
+		if (target < 0) {
+			break;
+		}
+
+		// Stale mount on mount point is replaced, same as legacy mount.
+		ret = mount_disk_attach_remount(args[target].mntfd, args[target].exdisk->from);
+		if (ret < 0) {
+			jobs[target].result = -1;
+		}
+
+		(void) close(args[target].mntfd);
+		args[target].mntfd = -1;
+	}
+
+	return;
+}
 /**
  * Preprocess for container start.
  * This function exec mount operation a part of base config operation.
+ * Independent extra disks are mounted in parallel by bounded threads, after that nested extra disks are mounted in list order.
+ * When new mount api is supported, all extra disks (include nested) are created as detached mount in parallel and attached in one pass.
+ * When one or more mandatory extra disk (ab, fsck and mkfs type) fail to mount, this function return error.
  *
  * @param [in]	bc	Pointer to container_baseconfig_t.
  * @return int
@@ -1162,7 +1678,6 @@ static int container_start_preprocess_base_do_mount_rootfs(container_baseconfig_
 static int container_start_preprocess_base(container_baseconfig_t *bc)
 {
 	int ret = 1;
-	unsigned long mntflag = 0;
 
 	// mount rootfs
 	if (bc->rootfs.is_mounted == 0) {
@@ -1180,92 +1695,137 @@ static int container_start_preprocess_base(container_baseconfig_t *bc)
 			}
 			#endif
 			return -1;
-		} else {
-			// root fs mount is succeed.
-			bc->rootfs.is_mounted = 1;
-			// Clear error count
-			bc->rootfs.error_count = 0;
 		}
+
+		if (bc->rootfs.overlay_size != NULL) {
+			// Stack volatile upper layer to read only rootfs.
+			ret = mount_disk_overlay(bc->rootfs.path, bc->rootfs.overlay_path, bc->rootfs.overlay_size);
+			if (ret < 0) {
+				(void) unmount_disk(bc->rootfs.path, 0, 1);
+				bc->rootfs.error_count = bc->rootfs.error_count + 1;
+				#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+				if ((bc->rootfs.error_count % g_reduced_critical_error_mount) == 1) {
+					// This log should be reduced to one output per 100 time (default) of error.
+					(void) fprintf(stderr
+									,"[CM CRITICAL ERROR] Overlay for %s could not mount. (count = %d)\n"
+									, bc->rootfs.path, bc->rootfs.error_count);
+				}
+				#endif
+				return -1;
+			}
+			bc->rootfs.is_overlay_mounted = 1;
+		}
+
+		// root fs mount is succeed.
+		bc->rootfs.is_mounted = 1;
+		// Clear error count
+		bc->rootfs.error_count = 0;
 	}
 
 	// mount extradisk - optional
 	if (!dl_list_empty(&bc->extradisk_list)) {
 		container_baseconfig_extradisk_t *exdisk = NULL;
+		struct s_container_extradisk_mount_arg *args = NULL;
+		parallel_util_job_t *jobs = NULL;
+		int num_of_disk = 0, num_of_job = 0, result = 0;
+		int is_staged_supported = 0;
 
 		dl_list_for_each(exdisk, &bc->extradisk_list, container_baseconfig_extradisk_t, list) {
-			if (exdisk->is_mounted == 0) {
-				// When already mounted, bypass this mount operation.
-				if (exdisk->mode == DISKMOUNT_TYPE_RW) {
-					mntflag = MS_DIRSYNC | MS_NOATIME | MS_NODEV | MS_NOEXEC | MS_SYNCHRONOUS;
-				} else {
-					mntflag = MS_NOATIME | MS_RDONLY;
+			num_of_disk++;
+		}
+
+		args = (struct s_container_extradisk_mount_arg*)malloc(sizeof(struct s_container_extradisk_mount_arg) * (size_t)num_of_disk);
+		jobs = (parallel_util_job_t*)malloc(sizeof(parallel_util_job_t) * (size_t)num_of_disk);
+		if ((args == NULL) || (jobs == NULL)) {
+			(void) free(args);
+			(void) free(jobs);
+			return -2;
+		}
+		(void) memset(jobs, 0, sizeof(parallel_util_job_t) * (size_t)num_of_disk);
+
+		is_staged_supported = mount_disk_is_detached_supported();
+
+		// Stage 1: independent extra disks and staged extra disks. When already mounted, bypass this mount operation.
+		dl_list_for_each(exdisk, &bc->extradisk_list, container_baseconfig_extradisk_t, list) {
+			int is_staged = 0;
+
+			if (exdisk->is_mounted != 0) {
+				continue;
+			}
+
+			if ((is_staged_supported == 1) && (exdisk->filesystem != NULL)) {
+				// Detached mount is independent from mount point.
+				is_staged = 1;
+			}
+
+			if ((is_staged == 1) || (container_start_preprocess_base_extradisk_is_nested(bc, exdisk) == 0)) {
+				args[num_of_job].exdisk = exdisk;
+				args[num_of_job].side = bc->abboot;
+				args[num_of_job].is_staged = is_staged;
+				args[num_of_job].mntfd = -1;
+				jobs[num_of_job].func = container_start_preprocess_base_do_mount_extradisk;
+				jobs[num_of_job].arg = (void*)&args[num_of_job];
+				jobs[num_of_job].group = PARALLEL_UTIL_NO_GROUP;
+				num_of_job++;
+			}
+		}
+
+		(void) parallel_util_run(jobs, num_of_job, CONTAINER_EXTRADISK_MOUNT_PARALLEL_MAX);
+
+		// Attach staged extra disks.
+		container_start_preprocess_base_attach_extradisk(args, jobs, num_of_job);
+
+		for (int i = 0; i < num_of_job; i++) {
+			args[i].exdisk->mount_time_ms = jobs[i].elapsed_ms;
+			ret = container_start_preprocess_base_extradisk_result(args[i].exdisk, jobs[i].result, args[i].side);
+			if (ret < 0) {
+				result = -1;
+			}
+		}
+
+		// Stage 2: nested extra disks, mount in list order after parent.
+		if (result == 0) {
+			dl_list_for_each(exdisk, &bc->extradisk_list, container_baseconfig_extradisk_t, list) {
+				struct s_container_extradisk_mount_arg arg;
+				int64_t start_time = 0;
+				int is_done = 0;
+
+				if (exdisk->is_mounted != 0) {
+					continue;
 				}
 
-				if (exdisk->redundancy == DISKREDUNDANCY_TYPE_AB)
-				{
-					ret = mount_disk_ab(exdisk->blockdev, exdisk->from, exdisk->filesystem, mntflag, exdisk->option, bc->abboot);
-					if (ret < 0) {
-						// AB disk mount is mandatory function.
-						exdisk->error_count = exdisk->error_count + 1;
-						#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
-						if ((exdisk->error_count % g_reduced_critical_error_mount) == 1) {
-							// This log should be reduced to one output per 100 time of error.
-							(void) fprintf(stderr
-											,"[CM CRITICAL ERROR] Extra ab mount disk %s could not mount. (count = %d)\n"
-											, exdisk->blockdev[bc->abboot], exdisk->error_count);
-						}
-						#endif
-						return -1;
-					} else {
-						// This extra disk mount is succeed.
-						exdisk->is_mounted = 1;
-						// Clear error count
-						exdisk->error_count = 0;
-					}
-				} else if (exdisk->redundancy == DISKREDUNDANCY_TYPE_FAILOVER) {
-					ret = mount_disk_failover(exdisk->blockdev, exdisk->from, exdisk->filesystem, mntflag, exdisk->option);
-					if (ret < 0) {
-						// Failover disk mount is optional function.
-						exdisk->error_count = exdisk->error_count + 1;
-						#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
-						if ((exdisk->error_count % g_reduced_critical_error_mount) == 1) {
-							// This log should be reduced to one output per 100 time of error.
-							(void) fprintf(stderr
-											,"[CM CRITICAL ERROR] Extra failover disk %s could not mount. (count = %d)\n"
-											, exdisk->blockdev[0], exdisk->error_count);
-						}
-						#endif
-						continue;
-					} else {
-						// This extra disk mount is succeed.
-						exdisk->is_mounted = 1;
-						// Clear error count
-						exdisk->error_count = 0;
-					}
-				} else {
-					// DISKREDUNDANCY_TYPE_FSCK or DISKREDUNDANCY_TYPE_MKFS
-					ret = mount_disk_once(exdisk->blockdev, exdisk->from, exdisk->filesystem, mntflag, exdisk->option);
-					if (ret < 0) {
-						exdisk->error_count = exdisk->error_count + 1;
-						// This point is critical error but not out critical error log. This log will out in recovery operation.
-						#ifdef _PRINTF_DEBUG_
-						if ((exdisk->error_count % g_reduced_critical_error_mount) == 1) {
-							// This log should be reduced to one output per 100 time of error.
-							(void) fprintf(stdout
-											,"container_start_preprocess_base: disk %s could not mount. (count = %d)\n"
-											, exdisk->blockdev[0], exdisk->error_count);
-						}
-						#endif
-						return -1;
-					} else {
-						// This extra disk mount is succeed.
-						exdisk->is_mounted = 1;
-						// Clear error count
-						exdisk->error_count = 0;
+				for (int i = 0; i < num_of_job; i++) {
+					if (args[i].exdisk == exdisk) {
+						// Failed failover disk at stage 1, not retry in this time.
+						is_done = 1;
+						break;
 					}
 				}
+				if (is_done == 1) {
+					continue;
+				}
+
+				arg.exdisk = exdisk;
+				arg.side = bc->abboot;
+				arg.is_staged = 0;
+				arg.mntfd = -1;
+				start_time = get_current_time_ms();
+				ret = container_start_preprocess_base_do_mount_extradisk((void*)&arg);
+				exdisk->mount_time_ms = get_current_time_ms() - start_time;
+				ret = container_start_preprocess_base_extradisk_result(exdisk, ret, arg.side);
+				if (ret < 0) {
+					result = -1;
+					break;
+				}
 			}
 		}
+
+		(void) free(args);
+		(void) free(jobs);
+
+		if (result < 0) {
+			return -1;
+		}
 	}
 
 	return 0;
@@ -1306,6 +1866,13 @@ static int container_start_preprocess_base_recovery(container_config_t *cc)
 					}
 
 					if (exdisk->redundancy == DISKREDUNDANCY_TYPE_FSCK) {
+						if (exdisk->error_count > 1) {
+							// Previous recovery could not fix, skip journal replay tier.
+							ret = snprintf(option_str, sizeof(option_str), "device=%s tier=check", exdisk->blockdev[0]);
+							if (!((size_t)ret < sizeof(option_str)-1u)) {
+								return -1;
+							}
+						}
 						ret = container_workqueue_schedule(&cc->workqueue, "fsck", option_str, 1);
 						if (ret == 0) {
 							#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
@@ -1317,11 +1884,67 @@ static int container_start_preprocess_base_recovery(container_config_t *cc)
 							return 1;
 						}
 					} else if (exdisk->redundancy == DISKREDUNDANCY_TYPE_MKFS) {
-						ret = container_workqueue_schedule(&cc->workqueue, "mkfs", option_str, 1);
-						if (ret == 0) {
+						const char *queued = "mkfs";
+
+						if (exdisk->error_count == 1) {
+							// First error, try to fsck at first. When fsck can not recover, mkfs in same pass.
+							ret = container_workqueue_schedule(&cc->workqueue, "fsck", option_str, 1);
+							if (ret == 0) {
+								ret = container_workqueue_schedule_next(&cc->workqueue, "mkfs", option_str, 0, CONTAINER_WORKER_RUN_ON_FAIL);
+								if (ret >= 0) {
+									queued = "fsck, then mkfs on failure";
+								} else {
+									// Can not chain, fall back to mkfs only.
+									#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+									(void) fprintf(stderr,"[CM CRITICAL ERROR] Fail to chain mkfs to fsck (%d), queue mkfs only to disk %s.\n", ret, exdisk->blockdev[0]);
+									#endif
+									(void) container_workqueue_remove(&cc->workqueue, NULL);
+									ret = container_workqueue_schedule(&cc->workqueue, "mkfs", option_str, 1);
+								}
+							}
+						} else {
+							// Previous recovery could not fix, force mkfs.
+							ret = container_workqueue_schedule(&cc->workqueue, "mkfs", option_str, 1);
+						}
+						if (ret >= 0) {
 							#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
 							// This log is output every time. Because this operation is force recovery, may not fail cyclic.
-							(void) fprintf(stderr,"[CM CRITICAL ERROR] Queued mkfs recovery to disk %s.\n", exdisk->blockdev[0]);
+							(void) fprintf(stderr,"[CM CRITICAL ERROR] Queued %s recovery to disk %s.\n", queued, exdisk->blockdev[0]);
+							#endif
+							return 1;
+						}
+					} else if (exdisk->redundancy == DISKREDUNDANCY_TYPE_CLONE) {
+						const char *queued = "clone";
+						char clone_option_str[1024];
+
+						ret = snprintf(clone_option_str, sizeof(clone_option_str), "device=%s template=%s", exdisk->blockdev[0], exdisk->template_image);
+						if (!((size_t)ret < sizeof(clone_option_str)-1u)) {
+							return -1;
+						}
+
+						if (exdisk->error_count == 1) {
+							// First error, try to fsck at first. When fsck can not recover, clone in same pass.
+							ret = container_workqueue_schedule(&cc->workqueue, "fsck", option_str, 1);
+							if (ret == 0) {
+								ret = container_workqueue_schedule_next(&cc->workqueue, "clone", clone_option_str, 0, CONTAINER_WORKER_RUN_ON_FAIL);
+								if (ret >= 0) {
+									queued = "fsck, then clone on failure";
+								} else {
+									// Can not chain, fall back to clone only.
+									#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+									(void) fprintf(stderr,"[CM CRITICAL ERROR] Fail to chain clone to fsck (%d), queue clone only to disk %s.\n", ret, exdisk->blockdev[0]);
+									#endif
+									(void) container_workqueue_remove(&cc->workqueue, NULL);
+									ret = container_workqueue_schedule(&cc->workqueue, "clone", clone_option_str, 1);
+								}
+							}
+						} else {
+							// Previous recovery could not fix, force clone.
+							ret = container_workqueue_schedule(&cc->workqueue, "clone", clone_option_str, 1);
+						}
+						if (ret >= 0) {
+							#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+							(void) fprintf(stderr,"[CM CRITICAL ERROR] Queued %s recovery to disk %s.\n", queued, exdisk->blockdev[0]);
 							#endif
 							return 1;
 						}
@@ -1336,6 +1959,126 @@ static int container_start_preprocess_base_recovery(container_config_t *cc)
 	return 0;
 }
 
+/**
+ * Preprocess for container start.
+ * This function queue fsck recovery to extra disk that was reported file system error in previous run.
+ * The recovery is executed by per container workqueue after unmount all disk of this guest.
+ *
+ * @param [in]	cc	Pointer to container_config_t.
+ * @return int
+ * @retval  1 Success (recovery queued).
+ * @retval  0 Success (recovery not queued).
+ * @retval -1 operation error.
+ */
+static int container_start_preprocess_base_fserror(container_config_t *cc)
+{
+	container_baseconfig_extradisk_t *exdisk = NULL;
+	int ret = -1;
+
+	dl_list_for_each(exdisk, &cc->baseconfig.extradisk_list, container_baseconfig_extradisk_t, list) {
+		char option_str[1024];
+
+		if (exdisk->fs_error_pending == 0) {
+			continue;
+		}
+
+		// Kernel reported error, journal replay is not enough.
+		ret = snprintf(option_str, sizeof(option_str), "device=%s tier=check", exdisk->blockdev[0]);
+		if (!((size_t)ret < sizeof(option_str)-1u)) {
+			return -1;
+		}
+
+		ret = container_workqueue_schedule(&cc->workqueue, "fsck", option_str, 1);
+		if (ret == 0) {
+			exdisk->fs_error_pending = 0;
+			// Workqueue is run in not started state.
+			cc->runtime_stat.status = CONTAINER_NOT_STARTED;
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] Queued fsck recovery to disk %s by file system error.\n", exdisk->blockdev[0]);
+			#endif
+			return 1;
+		}
+	}
+
+	return 0;
+}
+/**
+ * Test for mandatory block device waiting in container start.
+ * While guest is waiting device, mount is not retried.  Waiting is cancelled by device add event (block device monitor) or timeout.
+ *
+ * @param [in]	cc	Pointer to container_config_t.
+ * @return int
+ * @retval  1 Waiting device.
+ * @retval  0 Not waiting.
+ */
+static int container_start_wait_device_test(container_config_t *cc)
+{
+	if (cc->runtime_stat.wait_device == NULL) {
+		return 0;
+	}
+
+	if (cc->runtime_stat.status == CONTAINER_DEAD) {
+		if (get_current_time_ms() < cc->runtime_stat.wait_timeout) {
+			return 1;
+		}
+
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Device %s is not appeared in %d ms, retry mount in container %s.\n"
+						, cc->runtime_stat.wait_device, CONTAINER_DEVICE_WAIT_TIMEOUT, cc->name);
+		#endif
+	}
+
+	// Timeout or launch request from other state, retry mount.
+	cc->runtime_stat.wait_device = NULL;
+
+	return 0;
+}
+/**
+ * Setup mandatory block device waiting in container start.
+ * When rootfs or ab extra disk mount fail by device is not present, this function set the device to waiting device.
+ *
+ * @param [in]	cc	Pointer to container_config_t.
+ * @return int
+ * @retval  1 Start device waiting.
+ * @retval  0 All mandatory device is present, not wait.
+ */
+static int container_start_wait_device_setup(container_config_t *cc)
+{
+	container_baseconfig_t *bc = &cc->baseconfig;
+	container_baseconfig_extradisk_t *exdisk = NULL;
+	const char *device = NULL;
+
+	if ((bc->rootfs.is_mounted == 0) && (bc->rootfs.device_type == DEVICE_TYPE_BLOCK)) {
+		if (access(bc->rootfs.rootfs_dev[bc->abboot], F_OK) != 0) {
+			device = bc->rootfs.rootfs_dev[bc->abboot];
+		}
+	}
+
+	if (device == NULL) {
+		dl_list_for_each(exdisk, &bc->extradisk_list, container_baseconfig_extradisk_t, list) {
+			if ((exdisk->is_mounted == 0) && (exdisk->redundancy == DISKREDUNDANCY_TYPE_AB)
+				&& (exdisk->blockdev[bc->abboot] != NULL)) {
+				if (access(exdisk->blockdev[bc->abboot], F_OK) != 0) {
+					device = exdisk->blockdev[bc->abboot];
+					break;
+				}
+			}
+		}
+	}
+
+	if (device == NULL) {
+		return 0;
+	}
+
+	cc->runtime_stat.wait_device = device;
+	cc->runtime_stat.wait_timeout = get_current_time_ms() + CONTAINER_DEVICE_WAIT_TIMEOUT;
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"container_start: wait device %s for %s.\n", device, cc->name);
+	#endif
+
+	return 1;
+}
 /**
  * Cleanup for container start base preprocess.
  * This function exec unmount operation a part of base config cleanup operation.
@@ -1379,6 +2122,12 @@ static int container_cleanup_preprocess_base(container_baseconfig_t *bc, int64_t
 
 	// unmount rootfs
 	if (bc->rootfs.is_mounted != 0) {
+		if (bc->rootfs.is_overlay_mounted != 0) {
+			// Overlay is stacked on lower rootfs, unmount overlay and volatile upper layer at first.
+			(void) unmount_disk(bc->rootfs.path, timeout_time, retry_max);
+			(void) unmount_disk(bc->rootfs.overlay_path, timeout_time, retry_max);
+			bc->rootfs.is_overlay_mounted = 0;
+		}
 		(void) unmount_disk(bc->rootfs.path, timeout_time, retry_max);
 		// Clear mount flag
 		bc->rootfs.is_mounted = 0;
@@ -0,0 +1,581 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	container-control-fsmonitor.c
+ * @brief	This file include implementation for file system error monitoring of guest and manager disks.
+ */
+#undef _PRINTF_DEBUG_
+
+#include "container-control-internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/statfs.h>
+#include <sys/sysmacros.h>
+#include <sys/fanotify.h>
+
+#include "cm-utils.h"
+
+#ifndef FAN_FS_ERROR
+#define FAN_FS_ERROR	(0x00008000)	/**< Fallback definition for old kernel header. */
+#endif
+#ifndef FAN_EVENT_INFO_TYPE_ERROR
+#define FAN_EVENT_INFO_TYPE_ERROR	(5)	/**< Fallback definition for old kernel header. */
+#endif
+
+/**
+ * @def	CONTAINER_FSMONITOR_WATCH_MAX
+ * @brief	Maximum number of monitored disks.
+ */
+#define CONTAINER_FSMONITOR_WATCH_MAX		(64)
+/**
+ * @def	CONTAINER_FSMONITOR_POLL_INTERVAL
+ * @brief	Interval (ms) of ext4 errors_count polling for the disk that can not monitor by fanotify.
+ */
+#define CONTAINER_FSMONITOR_POLL_INTERVAL	(1000)
+
+/**
+ * @struct	s_container_fsmonitor_info_error
+ * @brief	The data structure for FAN_EVENT_INFO_TYPE_ERROR record.  Same as struct fanotify_event_info_error in kernel header.
+ */
+struct s_container_fsmonitor_info_error {
+	struct fanotify_event_info_header hdr;	/**< Info record header. */
+	int32_t error;							/**< Error code of first error. */
+	uint32_t error_count;					/**< Number of error after last event. */
+};
+
+/**
+ * @struct	s_container_fsmonitor_watch
+ * @brief	The data structure for one monitored disk.
+ */
+struct s_container_fsmonitor_watch {
+	const int *is_mounted;			/**< Pointer to mount flag of monitored disk. NULL is unused entry. */
+	const char *path;				/**< Mount path of monitored disk. */
+	int container_number;			/**< Guest container number. CONTAINER_MNGSM_WORKER_MANAGER is manager mount disk. */
+	int disk_index;					/**< Disk index. CONTAINER_MNGSM_FS_ERROR_ROOTFS or index of extradisk list (manager mount list). */
+	int32_t fsid[2];				/**< File system id of monitored disk. */
+	int is_marked;					/**< fanotify mark was added (=1). */
+	char errors_count_path[128];	/**< ext4 sysfs errors_count path for polling. Empty is not available. */
+	uint32_t errors_count;			/**< Last read value of errors_count. */
+};
+typedef struct s_container_fsmonitor_watch container_fsmonitor_watch_t;	/**< typedef for struct s_container_fsmonitor_watch. */
+
+/**
+ * @struct	s_container_fsmonitor
+ * @brief	The data structure for file system error monitor.
+ */
+struct s_container_fsmonitor {
+	int fanotify_fd;					/**< fanotify fd. -1 is not available, use polling only. */
+	sd_event_source *fanotify_source;	/**< The sd event source for fanotify fd. */
+	int64_t last_poll;					/**< Last polling time (ms). */
+	container_fsmonitor_watch_t watch[CONTAINER_FSMONITOR_WATCH_MAX];	/**< Monitored disks. */
+};
+
+/**
+ * File system error notification to container manager state machine from file system monitor.
+ *
+ * @param [in]	cs			Pointer to containers_t.
+ * @param [in]	watch		Pointer to container_fsmonitor_watch_t that reported error.
+ * @param [in]	error		Error code (errno). 0 is unknown.
+ * @param [in]	error_count	Number of error.
+ * @return int
+ * @retval  0 Success to send event.
+ * @retval -1 Critical error for sending event.
+ */
+static int container_fsmonitor_notify(containers_t *cs, const container_fsmonitor_watch_t *watch, int error, uint32_t error_count)
+{
+	container_mngsm_fs_error_t command;
+	ssize_t ret = -1;
+
+	(void) memset(&command, 0, sizeof(command));
+
+	command.header.command = CONTAINER_MNGSM_COMMAND_FS_ERROR;
+	command.data.container_number = watch->container_number;
+	command.data.disk_index = watch->disk_index;
+	command.data.error = error;
+	command.data.error_count = error_count;
+
+	ret = write(cs->cms->secondary_fd, &command, sizeof(command));
+	if (ret != (ssize_t)sizeof(command)) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function to read ext4 errors_count.
+ *
+ * @param [in]	path	Path to errors_count in sysfs.
+ * @param [out]	count	Pointer to store errors_count.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to read.
+ */
+static int container_fsmonitor_read_errors_count(const char *path, uint32_t *count)
+{
+	char buf[32];
+	unsigned long value = 0;
+	int ret = -1;
+
+	(void) memset(buf, 0, sizeof(buf));
+	ret = once_read(path, buf, sizeof(buf) - 1u);
+	if (ret < 0) {
+		return -1;
+	}
+
+	if (sscanf(buf, "%lu", &value) != 1) {
+		return -1;
+	}
+	(*count) = (uint32_t)value;
+
+	return 0;
+}
+/**
+ * Sub function to lookup ext4 errors_count path for mounted disk.
+ * ext4 create sysfs node by kernel block device name.
+ *
+ * @param [in]	path	Mount path.
+ * @param [out]	buf		Buffer to store errors_count path.
+ * @param [in]	size	Size of buf.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Not ext4 or fail to lookup.
+ */
+static int container_fsmonitor_get_errors_count_path(const char *path, char *buf, size_t size)
+{
+	struct stat sb;
+	char sysfs_path[PATH_MAX];
+	char link[PATH_MAX];
+	char *name = NULL;
+	ssize_t sret = -1;
+	int ret = -1;
+
+	ret = stat(path, &sb);
+	if (ret < 0) {
+		return -1;
+	}
+
+	(void) snprintf(sysfs_path, sizeof(sysfs_path), "/sys/dev/block/%u:%u", major(sb.st_dev), minor(sb.st_dev));
+	sret = readlink(sysfs_path, link, sizeof(link) - 1u);
+	if (sret <= 0) {
+		return -1;
+	}
+	link[sret] = '\0';
+
+	name = strrchr(link, '/');
+	if (name == NULL) {
+		name = link;
+	} else {
+		name++;
+	}
+
+	ret = snprintf(buf, size, "/sys/fs/ext4/%s/errors_count", name);
+	if (!((size_t)ret < size)) {
+		return -1;
+	}
+
+	if (access(buf, R_OK) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function to add monitored disk.
+ * When fanotify mark is not available, ext4 errors_count polling is used.
+ *
+ * @param [in]	fsmon				Pointer to container_fsmonitor_t.
+ * @param [in]	is_mounted			Pointer to mount flag of the disk.
+ * @param [in]	path				Mount path.
+ * @param [in]	container_number	Guest container number. CONTAINER_MNGSM_WORKER_MANAGER is manager mount disk.
+ * @param [in]	disk_index			Disk index.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 No free entry or fail to get file system information.
+ */
+static int container_fsmonitor_add(container_fsmonitor_t *fsmon, const int *is_mounted, const char *path, int container_number, int disk_index)
+{
+	container_fsmonitor_watch_t *watch = NULL;
+	struct statfs sfs;
+	int ret = -1;
+
+	for (int i = 0; i < CONTAINER_FSMONITOR_WATCH_MAX; i++) {
+		if (fsmon->watch[i].is_mounted == NULL) {
+			watch = &fsmon->watch[i];
+			break;
+		}
+	}
+
+	if (watch == NULL) {
+		return -1;
+	}
+
+	ret = statfs(path, &sfs);
+	if (ret < 0) {
+		return -1;
+	}
+
+	(void) memset(watch, 0, sizeof(container_fsmonitor_watch_t));
+	(void) memcpy(watch->fsid, &sfs.f_fsid, sizeof(watch->fsid));
+	watch->path = path;
+	watch->container_number = container_number;
+	watch->disk_index = disk_index;
+
+	if (fsmon->fanotify_fd >= 0) {
+		// Filesystem mark is shared by all mount of same super block.
+		ret = fanotify_mark(fsmon->fanotify_fd, (FAN_MARK_ADD | FAN_MARK_FILESYSTEM), FAN_FS_ERROR, AT_FDCWD, path);
+		if (ret == 0) {
+			watch->is_marked = 1;
+		}
+	}
+
+	if (watch->is_marked == 0) {
+		ret = container_fsmonitor_get_errors_count_path(path, watch->errors_count_path, sizeof(watch->errors_count_path));
+		if (ret == 0) {
+			// Errors before monitoring start are not reported.
+			ret = container_fsmonitor_read_errors_count(watch->errors_count_path, &watch->errors_count);
+		}
+		if (ret < 0) {
+			// Not supported file system, keep entry to avoid retry.
+			watch->errors_count_path[0] = '\0';
+		}
+	}
+
+	watch->is_mounted = is_mounted;
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"container_fsmonitor_add: %s (marked = %d, polling = %s)\n", path, watch->is_marked, watch->errors_count_path);
+	#endif
+
+	return 0;
+}
+/**
+ * Sub function to test the disk is monitored or not.
+ *
+ * @param [in]	fsmon		Pointer to container_fsmonitor_t.
+ * @param [in]	is_mounted	Pointer to mount flag of the disk.
+ * @return int
+ * @retval  1 Monitored.
+ * @retval  0 Not monitored.
+ */
+static int container_fsmonitor_is_watched(container_fsmonitor_t *fsmon, const int *is_mounted)
+{
+	for (int i = 0; i < CONTAINER_FSMONITOR_WATCH_MAX; i++) {
+		if (fsmon->watch[i].is_mounted == is_mounted) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+/**
+ * Sub function to dispatch one fanotify event.
+ *
+ * @param [in]	cs		Pointer to containers_t.
+ * @param [in]	meta	Pointer to fanotify event.
+ * @return void
+ */
+static void container_fsmonitor_dispatch_event(containers_t *cs, const struct fanotify_event_metadata *meta)
+{
+	container_fsmonitor_t *fsmon = cs->cms->fsmon;
+	const uint8_t *base = (const uint8_t*)meta;
+	int32_t fsid[2] = {0, 0};
+	int has_fsid = 0;
+	int error = 0;
+	uint32_t error_count = 1;
+	size_t offset = 0;
+
+	offset = meta->metadata_len;
+	while ((offset + sizeof(struct fanotify_event_info_header)) <= meta->event_len) {
+		const struct fanotify_event_info_header *hdr = (const struct fanotify_event_info_header*)(base + offset);
+
+		if ((hdr->len == 0) || ((offset + hdr->len) > meta->event_len)) {
+			break;
+		}
+
+		if ((hdr->info_type == FAN_EVENT_INFO_TYPE_FID) && (hdr->len >= sizeof(struct fanotify_event_info_fid))) {
+			const struct fanotify_event_info_fid *fid = (const struct fanotify_event_info_fid*)hdr;
+
+			(void) memcpy(fsid, &fid->fsid, sizeof(fsid));
+			has_fsid = 1;
+		} else if ((hdr->info_type == FAN_EVENT_INFO_TYPE_ERROR) && (hdr->len >= sizeof(struct s_container_fsmonitor_info_error))) {
+			const struct s_container_fsmonitor_info_error *info = (const struct s_container_fsmonitor_info_error*)hdr;
+
+			error = info->error;
+			error_count = info->error_count;
+		} else {
+			;	//nop
+		}
+
+		offset = offset + hdr->len;
+	}
+
+	if (has_fsid == 0) {
+		return;
+	}
+
+	for (int i = 0; i < CONTAINER_FSMONITOR_WATCH_MAX; i++) {
+		container_fsmonitor_watch_t *watch = &fsmon->watch[i];
+
+		if ((watch->is_mounted == NULL) || (watch->is_marked == 0)) {
+			continue;
+		}
+
+		if (memcmp(watch->fsid, fsid, sizeof(fsid)) == 0) {
+			(void) container_fsmonitor_notify(cs, watch, error, error_count);
+		}
+	}
+}
+/**
+ * Event handler for fanotify.
+ * fanotify report FAN_FS_ERROR when file system detect an error, typically in ext4_error.
+ *
+ * @param [in]	event		Socket event source object.
+ * @param [in]	fd			File descriptor for fanotify.
+ * @param [in]	revents		Active event (epoll).
+ * @param [in]	userdata	Pointer to containers_t.
+ * @return int
+ * @retval	0	Success to event handling.
+ * @retval	-1	Internal error (Not use).
+ */
+static int container_fsmonitor_fanotify_handler(sd_event_source *event, int fd, uint32_t revents, void *userdata)
+{
+	containers_t *cs = NULL;
+	uint64_t buf[4096/sizeof(uint64_t)];
+	ssize_t len = -1;
+
+	if (userdata == NULL) {
+		//  Fail safe it unref.
+		(void) sd_event_source_disable_unref(event);
+		return 0;
+	}
+
+	cs = (containers_t*)userdata;
+
+	if ((revents & (EPOLLHUP | EPOLLERR)) != 0) {
+		// Fatal error, disable fanotify.
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] File system error monitor was stopped.\n");
+		#endif
+		(void) sd_event_source_disable_unref(event);
+		cs->cms->fsmon->fanotify_source = NULL;
+		return 0;
+	}
+
+	for (;;) {
+		const struct fanotify_event_metadata *meta = NULL;
+
+		len = read(fd, buf, sizeof(buf));
+		if (len < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			// EAGAIN: No more event.
+			break;
+		} else if (len == 0) {
+			break;
+		} else {
+			;	//nop
+		}
+
+		meta = (const struct fanotify_event_metadata*)buf;
+		while (FAN_EVENT_OK(meta, len)) {
+			if (meta->vers != FANOTIFY_METADATA_VERSION) {
+				break;
+			}
+
+			if ((meta->mask & FAN_FS_ERROR) != 0) {
+				container_fsmonitor_dispatch_event(cs, meta);
+			}
+
+			if (meta->fd >= 0) {
+				// May not get fd in FAN_REPORT_FID mode, fail safe.
+				(void) close(meta->fd);
+			}
+
+			meta = FAN_EVENT_NEXT(meta, len);
+		}
+	}
+
+	return 0;
+}
+/**
+ * Polling for the disk that can not monitor by fanotify.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return void
+ */
+static void container_fsmonitor_poll(containers_t *cs)
+{
+	container_fsmonitor_t *fsmon = cs->cms->fsmon;
+	int64_t now = 0;
+
+	now = get_current_time_ms();
+	if ((now - fsmon->last_poll) < CONTAINER_FSMONITOR_POLL_INTERVAL) {
+		return;
+	}
+	fsmon->last_poll = now;
+
+	for (int i = 0; i < CONTAINER_FSMONITOR_WATCH_MAX; i++) {
+		container_fsmonitor_watch_t *watch = &fsmon->watch[i];
+		uint32_t count = 0;
+		int ret = -1;
+
+		if ((watch->is_mounted == NULL) || (watch->is_marked == 1) || (watch->errors_count_path[0] == '\0')) {
+			continue;
+		}
+
+		ret = container_fsmonitor_read_errors_count(watch->errors_count_path, &count);
+		if ((ret == 0) && (count > watch->errors_count)) {
+			(void) container_fsmonitor_notify(cs, watch, 0, (count - watch->errors_count));
+			watch->errors_count = count;
+		}
+	}
+}
+/**
+ * Synchronize monitored disks with mount state of guest and manager disks.
+ * This function is called in every internal event execution, it operate syscall only to changed disks.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Monitor is not available.
+ */
+int container_fsmonitor_sync(containers_t *cs)
+{
+	container_fsmonitor_t *fsmon = NULL;
+	container_manager_operation_mount_elem_t *melem = NULL;
+
+	if ((cs == NULL) || (cs->cms == NULL) || (cs->cms->fsmon == NULL)) {
+		return -1;
+	}
+
+	fsmon = cs->cms->fsmon;
+
+	// Remove unmounted disks. Filesystem mark is removed by kernel at super block destruction.
+	for (int i = 0; i < CONTAINER_FSMONITOR_WATCH_MAX; i++) {
+		if ((fsmon->watch[i].is_mounted != NULL) && ((*fsmon->watch[i].is_mounted) == 0)) {
+			fsmon->watch[i].is_mounted = NULL;
+		}
+	}
+
+	// Add mounted guest disks.
+	for (int i = 0; i < cs->num_of_container; i++) {
+		container_baseconfig_t *bc = &cs->containers[i]->baseconfig;
+		container_baseconfig_extradisk_t *exdisk = NULL;
+		int index = 0;
+
+		// In overlay mode, rootfs path is covered by overlay and lower disk is read only.
+		if ((bc->rootfs.is_mounted != 0) && (bc->rootfs.device_type == DEVICE_TYPE_BLOCK) && (bc->rootfs.is_overlay_mounted == 0)
+			&& (container_fsmonitor_is_watched(fsmon, &bc->rootfs.is_mounted) == 0)) {
+			(void) container_fsmonitor_add(fsmon, &bc->rootfs.is_mounted, bc->rootfs.path, i, CONTAINER_MNGSM_FS_ERROR_ROOTFS);
+		}
+
+		dl_list_for_each(exdisk, &bc->extradisk_list, container_baseconfig_extradisk_t, list) {
+			if ((exdisk->is_mounted != 0) && (container_fsmonitor_is_watched(fsmon, &exdisk->is_mounted) == 0)) {
+				(void) container_fsmonitor_add(fsmon, &exdisk->is_mounted, exdisk->from, i, index);
+			}
+			index++;
+		}
+	}
+
+	// Add mounted manager disks.
+	dl_list_for_each(melem, &cs->cmcfg->operation.mount.mount_list, container_manager_operation_mount_elem_t, list) {
+		if ((melem->is_mounted != 0) && (container_fsmonitor_is_watched(fsmon, &melem->is_mounted) == 0)) {
+			(void) container_fsmonitor_add(fsmon, &melem->is_mounted, melem->to, CONTAINER_MNGSM_WORKER_MANAGER, melem->index);
+		}
+	}
+
+	container_fsmonitor_poll(cs);
+
+	return 0;
+}
+/**
+ * Setup file system error monitor.
+ * When fanotify FAN_FS_ERROR is not supported, file system monitor use ext4 errors_count polling only.
+ *
+ * @param [in]	cs		Pointer to containers_t.
+ * @param [in]	event	Instance of sd_event.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Internal error.
+ */
+int container_fsmonitor_setup(containers_t *cs, sd_event *event)
+{
+	container_fsmonitor_t *fsmon = NULL;
+	int ret = -1;
+
+	if ((cs == NULL) || (cs->cms == NULL) || (event == NULL)) {
+		return -1;
+	}
+
+	fsmon = (container_fsmonitor_t*)malloc(sizeof(container_fsmonitor_t));
+	if (fsmon == NULL) {
+		return -1;
+	}
+	(void) memset(fsmon, 0, sizeof(container_fsmonitor_t));
+	fsmon->fanotify_fd = -1;
+
+	// FAN_FS_ERROR require FAN_REPORT_FID.
+	fsmon->fanotify_fd = fanotify_init((FAN_CLASS_NOTIF | FAN_REPORT_FID | FAN_CLOEXEC | FAN_NONBLOCK), O_RDONLY);
+	if (fsmon->fanotify_fd >= 0) {
+		ret = sd_event_add_io(event, &fsmon->fanotify_source, fsmon->fanotify_fd, EPOLLIN, container_fsmonitor_fanotify_handler, cs);
+		if (ret < 0) {
+			(void) close(fsmon->fanotify_fd);
+			fsmon->fanotify_fd = -1;
+			fsmon->fanotify_source = NULL;
+		}
+	}
+
+	if (fsmon->fanotify_fd < 0) {
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL INFO] fanotify is not available, file system error monitor use polling.\n");
+		#endif
+	}
+
+	cs->cms->fsmon = fsmon;
+
+	return 0;
+}
+/**
+ * Cleanup file system error monitor.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Argument error.
+ */
+int container_fsmonitor_cleanup(containers_t *cs)
+{
+	container_fsmonitor_t *fsmon = NULL;
+
+	if ((cs == NULL) || (cs->cms == NULL)) {
+		return -1;
+	}
+
+	fsmon = cs->cms->fsmon;
+	if (fsmon == NULL) {
+		return 0;
+	}
+
+	if (fsmon->fanotify_source != NULL) {
+		(void) sd_event_source_disable_unref(fsmon->fanotify_source);
+	}
+
+	if (fsmon->fanotify_fd >= 0) {
+		(void) close(fsmon->fanotify_fd);
+	}
+
+	(void) free(fsmon);
+	cs->cms->fsmon = NULL;
+
+	return 0;
+}
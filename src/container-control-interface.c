@@ -30,7 +30,9 @@
 #include "container-config.h"
 
 static int container_mngsm_netif_updated(struct s_container_control_interface *cci);
+static int container_mngsm_netif_link_changed(struct s_container_control_interface *cci, int is_add, int ifindex, const char *ifname);
 static int container_mngsm_system_shutdown(struct s_container_control_interface *cci);
+static int container_mngsm_worker_done(struct s_container_control_interface *cci, int container_number, int result);
 
 /**
  * Get container manager state machine interface to use internal event passing from sub block.
@@ -62,7 +64,9 @@ int container_mngsm_interface_get(container_control_interface_t **pcci, containe
 
 		cci->mngsm = (void*)cs->cms;
 		cci->netif_updated = container_mngsm_netif_updated;
+		cci->netif_link_changed = container_mngsm_netif_link_changed;
 		cci->system_shutdown = container_mngsm_system_shutdown;
+		cci->worker_done = container_mngsm_worker_done;
 
 		cs->cci = (container_control_interface_t*)cci;
 	}
@@ -126,6 +130,44 @@ static int container_mngsm_netif_updated(struct s_container_control_interface *c
 
 	return 0;
 }
+/**
+ * Network interface link add/remove notification to container manager state machine.
+ * This notification carry a delta of network interface list.
+ *
+ * @param [in]	cci		Pointer to s_container_control_interface, it's got by container_mngsm_interface_get.
+ * @param [in]	is_add	Link event type. 1: add, 0: remove.
+ * @param [in]	ifindex	Network interface index.
+ * @param [in]	ifname	Network interface name.
+ * @return int
+ * @retval  0	Success to send event.
+ * @retval -1	Critical error for sending event.
+ */
+static int container_mngsm_netif_link_changed(struct s_container_control_interface *cci, int is_add, int ifindex, const char *ifname)
+{
+	struct s_container_mngsm *cm = NULL;
+	container_mngsm_netif_link_t command;
+	ssize_t ret = -1;
+
+	if ((cci == NULL) || (ifname == NULL)) {
+		return -1;
+	}
+
+	cm = (struct s_container_mngsm*)cci->mngsm;
+
+	(void) memset(&command, 0, sizeof(command));
+
+	command.header.command = CONTAINER_MNGSM_COMMAND_NETIF_LINK;
+	command.data.is_add = is_add;
+	command.data.ifindex = ifindex;
+	(void) strncpy(command.data.ifname, ifname, sizeof(command.data.ifname) - 1u);
+
+	ret = write(cm->secondary_fd, &command, sizeof(command));
+	if (ret != (ssize_t)sizeof(command)) {
+		return -1;
+	}
+
+	return 0;
+}
 /**
  * Received shutdown request notification to container manager state machine.
  *
@@ -156,4 +198,40 @@ static int container_mngsm_system_shutdown(struct s_container_control_interface
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
+/**
+ * Worker completion notification to container manager state machine.
+ * This function is thread safe, it can call from worker thread.
+ *
+ * @param [in]	cci					Pointer to s_container_control_interface, it's got by container_mngsm_interface_get.
+ * @param [in]	container_number	Guest container number of completed worker. CONTAINER_MNGSM_WORKER_MANAGER is manager worker.
+ * @param [in]	result				Result of worker. 1: cancel, 0: success, -1: fail.
+ * @return int
+ * @retval  0	Success to send event.
+ * @retval -1	Critical error for sending event.
+ */
+static int container_mngsm_worker_done(struct s_container_control_interface *cci, int container_number, int result)
+{
+	struct s_container_mngsm *cm = NULL;
+	container_mngsm_worker_done_t command;
+	ssize_t ret = -1;
+
+	if (cci == NULL) {
+		return -1;
+	}
+
+	cm = (struct s_container_mngsm*)cci->mngsm;
+
+	(void) memset(&command, 0, sizeof(command));
+
+	command.header.command = CONTAINER_MNGSM_COMMAND_WORKER_DONE;
+	command.data.container_number = container_number;
+	command.data.result = result;
+
+	ret = write(cm->secondary_fd, &command, sizeof(command));
+	if (ret != (ssize_t)sizeof(command)) {
+		return -1;
+	}
+
+	return 0;
+}
@@ -18,8 +18,11 @@ struct s_container_control_interface {
 	void *mngsm;	/**< Pointer to parent container manager state machine. */
 
 	int (*netif_updated)(struct s_container_control_interface *cci);	/**< Function pointer for network interface update notification interface. */
+	int (*netif_link_changed)(struct s_container_control_interface *cci, int is_add, int ifindex, const char *ifname);	/**< Function pointer for network interface link add/remove notification interface. */
 
 	int (*system_shutdown)(struct s_container_control_interface *cci);	/**< Function pointer for received shutdown request notification interface. */
+
+	int (*worker_done)(struct s_container_control_interface *cci, int container_number, int result);	/**< Function pointer for worker completion notification interface. */
 };
 typedef struct s_container_control_interface container_control_interface_t;	/**< typedef for struct s_container_control_interface. */
 
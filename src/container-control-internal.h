@@ -18,6 +18,10 @@
 //-----------------------------------------------------------------------------
 struct s_cm_external_interface;
 typedef struct s_cm_external_interface cm_external_interface_t;
+struct s_container_fsmonitor;
+typedef struct s_container_fsmonitor container_fsmonitor_t;
+struct s_container_devwait;
+typedef struct s_container_devwait container_devwait_t;
 
 /**
  * @struct	s_container_mngsm
@@ -29,6 +33,8 @@ struct s_container_mngsm {
 	sd_event_source *timer_source;		/**< The sd event source for internal timer. */
 	sd_event_source *socket_source;		/**< The sd event source for internal event communication to use receiving event. */
 	int secondary_fd;					/**< The file descriptor for internal event communication to use sending event. */
+	container_fsmonitor_t *fsmon;		/**< Pointer to file system error monitor object. */
+	container_devwait_t *devwait;		/**< Pointer to block device monitor object for device waiting. */
 };
 
 //-----------------------------------------------------------------------------
@@ -70,6 +76,39 @@ typedef struct s_container_mngsm_notification {
 	container_mngsm_command_header_t header;	/**< Header for this notification packet. */
 } container_mngsm_notification_t;
 
+/**
+ * @def	CONTAINER_MNGSM_COMMAND_NETIF_LINK
+ * @brief	Defined command code for network interface link add/remove notification event.
+ */
+#define CONTAINER_MNGSM_COMMAND_NETIF_LINK	(0x2100u)
+
+/**
+ * @typedef	container_mngsm_netif_link_data_t
+ * @brief	Typedef for struct s_container_mngsm_netif_link_data.
+ */
+/**
+ * @struct	s_container_mngsm_netif_link_data
+ * @brief	Defining data block for network interface link add/remove notification packet.
+ */
+typedef struct s_container_mngsm_netif_link_data {
+	int is_add;					/**< Link event type. 1: RTM_NEWLINK, 0: RTM_DELLINK. */
+	int ifindex;				/**< Network interface index. */
+	char ifname[IFNAMSIZ+1];	/**< Network interface name. */
+} container_mngsm_netif_link_data_t;
+
+/**
+ * @typedef	container_mngsm_netif_link_t
+ * @brief	Typedef for struct s_container_mngsm_netif_link.
+ */
+/**
+ * @struct	s_container_mngsm_netif_link
+ * @brief	Defining network interface link add/remove notification packet for container manager internal event communication.
+ */
+typedef struct s_container_mngsm_netif_link {
+	container_mngsm_command_header_t header;	/**< Header for this notification packet. */
+	container_mngsm_netif_link_data_t data;		/**< Data for this notification packet. */
+} container_mngsm_netif_link_t;
+
 /**
  * @def	CONTAINER_MNGSM_COMMAND_GUEST_EXIT
  * @brief	Defined command code for container exit notification event.
@@ -101,6 +140,90 @@ typedef struct s_container_mngsm_guest_exit {
 	container_mngsm_guest_exit_data_t data;		/**< Data for this notification packet. */
 } container_mngsm_guest_status_exit_t;
 
+/**
+ * @def	CONTAINER_MNGSM_COMMAND_WORKER_DONE
+ * @brief	Defined command code for worker completion notification event.
+ */
+#define CONTAINER_MNGSM_COMMAND_WORKER_DONE	(0x3100u)
+
+/**
+ * @def	CONTAINER_MNGSM_WORKER_MANAGER
+ * @brief	Container number for container manager worker.  It use at s_container_mngsm_worker_done_data.container_number.
+ */
+#define CONTAINER_MNGSM_WORKER_MANAGER	(-1)
+
+/**
+ * @typedef	container_mngsm_worker_done_data_t
+ * @brief	Typedef for struct s_container_mngsm_worker_done_data.
+ */
+/**
+ * @struct	s_container_mngsm_worker_done_data
+ * @brief	Defining data block for worker completion notification packet.
+ */
+typedef struct s_container_mngsm_worker_done_data {
+	int container_number;	/**< Guest container number of completed worker. CONTAINER_MNGSM_WORKER_MANAGER is manager worker. */
+	int result;				/**< Result of worker. 1: cancel, 0: success, -1: fail. */
+} container_mngsm_worker_done_data_t;
+
+/**
+ * @typedef	container_mngsm_worker_done_t
+ * @brief	Typedef for struct s_container_mngsm_worker_done.
+ */
+/**
+ * @struct	s_container_mngsm_worker_done
+ * @brief	Defining worker completion notification packet for container manager internal event communication.
+ */
+typedef struct s_container_mngsm_worker_done {
+	container_mngsm_command_header_t header;		/**< Header for this notification packet. */
+	container_mngsm_worker_done_data_t data;		/**< Data for this notification packet. */
+} container_mngsm_worker_done_t;
+
+/**
+ * @def	CONTAINER_MNGSM_COMMAND_FS_ERROR
+ * @brief	Defined command code for file system error notification event.
+ */
+#define CONTAINER_MNGSM_COMMAND_FS_ERROR	(0x3200u)
+
+/**
+ * @def	CONTAINER_MNGSM_FS_ERROR_ROOTFS
+ * @brief	Disk index for guest rootfs.  It use at s_container_mngsm_fs_error_data.disk_index.
+ */
+#define CONTAINER_MNGSM_FS_ERROR_ROOTFS	(-1)
+
+/**
+ * @typedef	container_mngsm_fs_error_data_t
+ * @brief	Typedef for struct s_container_mngsm_fs_error_data.
+ */
+/**
+ * @struct	s_container_mngsm_fs_error_data
+ * @brief	Defining data block for file system error notification packet.
+ */
+typedef struct s_container_mngsm_fs_error_data {
+	int container_number;	/**< Guest container number of error disk. CONTAINER_MNGSM_WORKER_MANAGER is manager mount disk. */
+	int disk_index;			/**< Index of error disk. CONTAINER_MNGSM_FS_ERROR_ROOTFS or index of extradisk list (manager mount list). */
+	int error;				/**< Error code (errno) reported by kernel. 0 is unknown. */
+	uint32_t error_count;	/**< Number of error reported by kernel in this event. */
+} container_mngsm_fs_error_data_t;
+
+/**
+ * @typedef	container_mngsm_fs_error_t
+ * @brief	Typedef for struct s_container_mngsm_fs_error.
+ */
+/**
+ * @struct	s_container_mngsm_fs_error
+ * @brief	Defining file system error notification packet for container manager internal event communication.
+ */
+typedef struct s_container_mngsm_fs_error {
+	container_mngsm_command_header_t header;	/**< Header for this notification packet. */
+	container_mngsm_fs_error_data_t data;		/**< Data for this notification packet. */
+} container_mngsm_fs_error_t;
+
+/**
+ * @def	CONTAINER_MNGSM_COMMAND_DEVICE_ADDED
+ * @brief	Defined command code for waiting block device add notification event.  It use container_mngsm_notification_t.
+ */
+#define CONTAINER_MNGSM_COMMAND_DEVICE_ADDED	(0x3300u)
+
 /**
  * @def	CONTAINER_MNGSM_COMMAND_SYSTEM_SHUTDOWN
  * @brief	Defined command code for received system shutdown notification event.
@@ -115,7 +238,14 @@ typedef struct s_container_mngsm_guest_exit {
 //-----------------------------------------------------------------------------
 
 int container_netif_updated(containers_t *cs);
+int container_netif_link_changed(containers_t *cs, const container_mngsm_netif_link_data_t *data);
+int container_netif_assign_to_guest(dynamic_device_manager_t *ddm, container_config_t *cc, container_dynamic_netif_elem_t *cdne);
+int container_netif_index_create(containers_t *cs);
+int container_netif_index_release(containers_t *cs);
+int container_netif_index_resync(containers_t *cs);
 int container_exited(containers_t *cs, const container_mngsm_guest_exit_data_t *data);
+int container_worker_done(containers_t *cs, const container_mngsm_worker_done_data_t *data);
+int container_fs_error(containers_t *cs, const container_mngsm_fs_error_data_t *data);
 int container_manager_shutdown(containers_t *cs);
 int container_exec_internal_event(containers_t *cs);
 int container_request_shutdown(container_config_t *cc, int sys_state);
@@ -124,6 +254,11 @@ int container_request_reboot(container_config_t *cc, int sys_state);
 int container_all_dynamic_device_update_notification(containers_t *cs);
 
 int container_monitor_addguest(containers_t *cs, container_config_t *cc);
+int container_fsmonitor_setup(containers_t *cs, sd_event *event);
+int container_fsmonitor_sync(containers_t *cs);
+int container_fsmonitor_cleanup(containers_t *cs);
+int container_devwait_setup(containers_t *cs, sd_event *event);
+int container_devwait_cleanup(containers_t *cs);
 
 int container_start_by_role(containers_t *cs, char *role);
 int container_start(container_config_t *cc);
@@ -0,0 +1,364 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	container-control-netif.c
+ * @brief	This file include incremental dynamic network interface assignment using ifname ownership index.
+ */
+#include "container-control-internal.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lxc-util.h"
+#include "device-control.h"
+
+/**
+ * @def	CONTAINER_NETIF_INDEX_HASH_SIZE
+ * @brief	Number of hash bucket for ifname and ifindex ownership index. Shall be power of 2.
+ */
+#define CONTAINER_NETIF_INDEX_HASH_SIZE	(64u)
+
+/**
+ * @struct	s_container_netif_owner
+ * @brief	The data structure for one entry of ownership index. It's bind dynamic network interface config to owner guest.
+ */
+struct s_container_netif_owner {
+	struct dl_list name_list;				/**< Double link list header for ifname hash bucket. */
+	struct dl_list index_list;				/**< Double link list header for ifindex hash bucket. */
+	int is_indexed;							/**< This owner is linked to ifindex hash bucket. 1: linked, 0: not linked. */
+	container_config_t *cc;					/**< Owner guest container. */
+	container_dynamic_netif_elem_t *cdne;	/**< Dynamic network interface config in owner guest. */
+};
+typedef struct s_container_netif_owner container_netif_owner_t;	/**< typedef for struct s_container_netif_owner. */
+
+/**
+ * @struct	s_container_netif_index
+ * @brief	The data structure for ownership index of dynamic network interface.
+ */
+struct s_container_netif_index {
+	struct dl_list name_bucket[CONTAINER_NETIF_INDEX_HASH_SIZE];	/**< ifname hash bucket - container_netif_owner_t. */
+	struct dl_list index_bucket[CONTAINER_NETIF_INDEX_HASH_SIZE];	/**< ifindex hash bucket - container_netif_owner_t. */
+};
+
+/**
+ * Calculate ifname hash bucket number.
+ *
+ * @param [in]	ifname	Network interface name.
+ * @return unsigned int	Hash bucket number.
+ */
+static unsigned int container_netif_name_hash(const char *ifname)
+{
+	uint32_t hash = 2166136261u;	// FNV-1a
+
+	for (int i = 0; (ifname[i] != '\0') && (i < IFNAMSIZ); i++) {
+		hash = hash ^ (uint32_t)(unsigned char)ifname[i];
+		hash = hash * 16777619u;
+	}
+
+	return (unsigned int)(hash & (CONTAINER_NETIF_INDEX_HASH_SIZE - 1u));
+}
+/**
+ * Calculate ifindex hash bucket number.
+ *
+ * @param [in]	ifindex	Network interface index.
+ * @return unsigned int	Hash bucket number.
+ */
+static unsigned int container_netif_index_hash(int ifindex)
+{
+	return ((unsigned int)ifindex & (CONTAINER_NETIF_INDEX_HASH_SIZE - 1u));
+}
+/**
+ * Update ifindex hash bucket link for the owner to follow current assigned ifindex.
+ *
+ * @param [in]	cni		Pointer to container_netif_index_t.
+ * @param [in]	owner	Pointer to container_netif_owner_t.
+ * @return void
+ */
+static void container_netif_index_relink(container_netif_index_t *cni, container_netif_owner_t *owner)
+{
+	if (owner->is_indexed == 1) {
+		dl_list_del(&owner->index_list);
+		dl_list_init(&owner->index_list);
+		owner->is_indexed = 0;
+	}
+
+	if (owner->cdne->ifindex > 0) {
+		dl_list_add(&cni->index_bucket[container_netif_index_hash(owner->cdne->ifindex)], &owner->index_list);
+		owner->is_indexed = 1;
+	}
+}
+/**
+ * Create ownership index of dynamic network interface from all guest configs.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Memory allocation error.
+ * @retval -2 Argument error.
+ */
+int container_netif_index_create(containers_t *cs)
+{
+	container_netif_index_t *cni = NULL;
+	container_netif_owner_t *owner = NULL;
+	container_dynamic_netif_elem_t *cdne = NULL;
+	container_config_t *cc = NULL;
+
+	if (cs == NULL) {
+		return -2;
+	}
+
+	cni = (container_netif_index_t*)malloc(sizeof(container_netif_index_t));
+	if (cni == NULL) {
+		return -1;
+	}
+
+	(void) memset(cni, 0, sizeof(container_netif_index_t));
+	for (unsigned int i = 0; i < CONTAINER_NETIF_INDEX_HASH_SIZE; i++) {
+		dl_list_init(&cni->name_bucket[i]);
+		dl_list_init(&cni->index_bucket[i]);
+	}
+
+	// Owner entries are added in boot priority order. When some guests request same ifname, higher priority guest get it.
+	for (int i = 0; i < cs->num_of_container; i++) {
+		cc = cs->containers[i];
+
+		dl_list_for_each(cdne, &cc->netifconfig.dynamic_netif.dynamic_netiflist, container_dynamic_netif_elem_t, list) {
+			if (cdne->ifname == NULL) {
+				continue;
+			}
+
+			owner = (container_netif_owner_t*)malloc(sizeof(container_netif_owner_t));
+			if (owner == NULL) {
+				cs->netif_index = cni;
+				(void) container_netif_index_release(cs);
+				return -1;
+			}
+
+			(void) memset(owner, 0, sizeof(container_netif_owner_t));
+			dl_list_init(&owner->name_list);
+			dl_list_init(&owner->index_list);
+			owner->cc = cc;
+			owner->cdne = cdne;
+
+			dl_list_add_tail(&cni->name_bucket[container_netif_name_hash(cdne->ifname)], &owner->name_list);
+			container_netif_index_relink(cni, owner);
+		}
+	}
+
+	cs->netif_index = cni;
+
+	return 0;
+}
+/**
+ * Release ownership index of dynamic network interface.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -2 Argument error.
+ */
+int container_netif_index_release(containers_t *cs)
+{
+	container_netif_index_t *cni = NULL;
+	container_netif_owner_t *owner = NULL, *owner_n = NULL;
+
+	if (cs == NULL) {
+		return -2;
+	}
+
+	cni = cs->netif_index;
+	if (cni == NULL) {
+		return 0;
+	}
+
+	for (unsigned int i = 0; i < CONTAINER_NETIF_INDEX_HASH_SIZE; i++) {
+		dl_list_for_each_safe(owner, owner_n, &cni->name_bucket[i], container_netif_owner_t, name_list) {
+			dl_list_del(&owner->name_list);
+			(void) free(owner);
+		}
+	}
+
+	(void) free(cni);
+	cs->netif_index = NULL;
+
+	return 0;
+}
+/**
+ * Re-synchronize ifindex hash bucket after full rescan.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -2 Argument error.
+ */
+int container_netif_index_resync(containers_t *cs)
+{
+	container_netif_index_t *cni = NULL;
+	container_netif_owner_t *owner = NULL;
+
+	if ((cs == NULL) || (cs->netif_index == NULL)) {
+		return -2;
+	}
+
+	cni = cs->netif_index;
+
+	for (unsigned int i = 0; i < CONTAINER_NETIF_INDEX_HASH_SIZE; i++) {
+		dl_list_for_each(owner, &cni->name_bucket[i], container_netif_owner_t, name_list) {
+			container_netif_index_relink(cni, owner);
+		}
+	}
+
+	return 0;
+}
+/**
+ * Move network interface to guest container.
+ * Native netns move request is queued, it's flushed and acknowledged asynchronously on event loop.
+ * When native netns move is not available, it fall back to lxc attach_interface.
+ *
+ * @param [in]	ddm		Pointer to dynamic_device_manager_t.
+ * @param [in]	cc		Pointer to container_config_t.
+ * @param [in]	cdne	Pointer to container_dynamic_netif_elem_t, that include target network interface data.
+ * @return int
+ * @retval  0 Success to operation (or queue).
+ * @retval -1 Fail to operation.
+ */
+int container_netif_assign_to_guest(dynamic_device_manager_t *ddm, container_config_t *cc, container_dynamic_netif_elem_t *cdne)
+{
+	int ret = -1;
+	int netns_fd = -1;
+
+	netns_fd = lxcutil_get_netns_fd(cc);
+	if (netns_fd >= 0) {
+		ret = netifmonitor_netns_move_queue(ddm, cdne->ifindex, cdne->ifname, netns_fd);
+		if (ret == 0) {
+			return 0;
+		}
+	}
+
+	return lxcutil_dynamic_networkif_add_to_guest(cc, cdne);
+}
+/**
+ * Apply new network interface to owner guest.
+ *
+ * @param [in]	cs		Pointer to containers_t
+ * @param [in]	ifindex	Network interface index.
+ * @param [in]	ifname	Network interface name.
+ * @return int
+ * @retval  1 Assigned to guest.
+ * @retval  0 No operation.
+ */
+static int container_netif_link_add(containers_t *cs, int ifindex, const char *ifname)
+{
+	int ret = -1;
+	container_netif_index_t *cni = cs->netif_index;
+	container_netif_owner_t *owner = NULL;
+
+	// Already assigned interface (i.e. link state change) is no operation.
+	dl_list_for_each(owner, &cni->index_bucket[container_netif_index_hash(ifindex)], container_netif_owner_t, index_list) {
+		if (owner->cdne->ifindex == ifindex) {
+			owner->cdne->is_available = 1;
+			return 0;
+		}
+	}
+
+	dl_list_for_each(owner, &cni->name_bucket[container_netif_name_hash(ifname)], container_netif_owner_t, name_list) {
+		if ((owner->cc->runtime_stat.status != CONTAINER_STARTED) || (owner->cdne->ifindex != 0)) {
+			continue;
+		}
+
+		if (strncmp(ifname, owner->cdne->ifname, IFNAMSIZ) != 0) {
+			continue;
+		}
+
+		// found new interface for own
+		owner->cdne->ifindex = ifindex;
+		owner->cdne->is_available = 1;
+
+		//add net interface to guest container
+		ret = container_netif_assign_to_guest(cs->ddm, owner->cc, owner->cdne);
+		if (ret < 0) {
+			// fail back
+			owner->cdne->ifindex = 0;
+			owner->cdne->is_available = 0;
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout, "[fail] network if update add %s to %s\n", owner->cdne->ifname, owner->cc->name);
+			#endif
+			continue;
+		}
+
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout, "network if update add %s to %s\n", owner->cdne->ifname, owner->cc->name);
+		#endif
+		container_netif_index_relink(cni, owner);
+
+		return 1;
+	}
+
+	return 0;
+}
+/**
+ * Remove network interface from owner guest.
+ *
+ * @param [in]	cni		Pointer to container_netif_index_t.
+ * @param [in]	ifindex	Network interface index.
+ * @return int
+ * @retval  1 Removed from guest.
+ * @retval  0 No operation.
+ */
+static int container_netif_link_del(container_netif_index_t *cni, int ifindex)
+{
+	int result = 0;
+	container_netif_owner_t *owner = NULL, *owner_n = NULL;
+
+	dl_list_for_each_safe(owner, owner_n, &cni->index_bucket[container_netif_index_hash(ifindex)], container_netif_owner_t, index_list) {
+		if (owner->cdne->ifindex != ifindex) {
+			continue;
+		}
+
+		owner->cdne->ifindex = 0;
+		owner->cdne->is_available = 0;
+		container_netif_index_relink(cni, owner);
+		result = 1;
+
+		// Don't need memory free.
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout, "network if update removed %s from %s\n", owner->cdne->ifname, owner->cc->name);
+		#endif
+	}
+
+	return result;
+}
+/**
+ * Dispatch one network interface link event to owner guest.
+ * This function apply only delta of the link event. When ownership index is not available, fall back to full rescan.
+ *
+ * @param [in]	cs		Pointer to containers_t
+ * @param [in]	data	Pointer to container_mngsm_netif_link_data_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Critical error.
+ */
+int container_netif_link_changed(containers_t *cs, const container_mngsm_netif_link_data_t *data)
+{
+	char ifname[IFNAMSIZ+1];
+
+	if (cs->netif_index == NULL) {
+		return container_netif_updated(cs);
+	}
+
+	if (data->ifindex <= 0) {
+		return 0;
+	}
+
+	(void) memcpy(ifname, data->ifname, sizeof(ifname));
+	ifname[IFNAMSIZ] = '\0';
+
+	if (data->is_add == 1) {
+		(void) container_netif_link_add(cs, data->ifindex, ifname);
+	} else {
+		(void) container_netif_link_del(cs->netif_index, data->ifindex);
+	}
+
+	return 0;
+}
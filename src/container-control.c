@@ -22,6 +22,8 @@
 #include "lxc-util.h"
 #include "cgroup-utils.h"
 #include "container-config.h"
+#include "container-workqueue.h"
+#include "recovery-scheduler.h"
 
 #undef _PRINTF_DEBUG_
 
@@ -60,6 +62,13 @@ static int container_mngsm_state_machine(containers_t *cs, const uint8_t *buf)
 			(void) container_netif_updated(cs);
 		}
 		break;
+	case CONTAINER_MNGSM_COMMAND_NETIF_LINK :
+		{
+			const container_mngsm_netif_link_t *p = (const container_mngsm_netif_link_t*)buf;
+
+			(void) container_netif_link_changed(cs, &p->data);
+		}
+		break;
 	case CONTAINER_MNGSM_COMMAND_GUEST_EXIT :
 		{
 			const container_mngsm_guest_status_exit_t *p = (const container_mngsm_guest_status_exit_t*)buf;
@@ -67,6 +76,26 @@ static int container_mngsm_state_machine(containers_t *cs, const uint8_t *buf)
 			(void) container_exited(cs, &p->data);
 		}
 		break;
+	case CONTAINER_MNGSM_COMMAND_WORKER_DONE :
+		{
+			const container_mngsm_worker_done_t *p = (const container_mngsm_worker_done_t*)buf;
+
+			(void) container_worker_done(cs, &p->data);
+		}
+		break;
+	case CONTAINER_MNGSM_COMMAND_FS_ERROR :
+		{
+			const container_mngsm_fs_error_t *p = (const container_mngsm_fs_error_t*)buf;
+
+			(void) container_fs_error(cs, &p->data);
+		}
+		break;
+	case CONTAINER_MNGSM_COMMAND_DEVICE_ADDED :
+		{
+			// Waiting guest is launched in following internal event execution.
+			;	//nop
+		}
+		break;
 	case CONTAINER_MNGSM_COMMAND_SYSTEM_SHUTDOWN :
 		{
 			(void) container_manager_shutdown(cs);
@@ -194,6 +223,34 @@ err_return:
 
 	return -1;
 }
+/**
+ * Sub function for setup worker completion notification.
+ * Per container workqueue push completion event to state machine through internal event communication socket.
+ * Version 2 worker plugin is dispatched in the event loop.
+ *
+ * @param [in]	cs		Instance of containers_t.
+ * @param [in]	event	Instance of sd_event.
+ * @return int
+ * @retval	0	Success to setup.
+ * @retval	-1	Internal error.
+ */
+static int container_mngsm_worker_notification_setup(containers_t *cs, sd_event *event)
+{
+	container_control_interface_t *cci = NULL;
+	int ret = -1;
+
+	ret = container_mngsm_interface_get(&cci, cs);
+	if (ret < 0) {
+		return -1;
+	}
+
+	for (int i = 0; i < cs->num_of_container; i++) {
+		(void) container_workqueue_set_notification(&(cs->containers[i]->workqueue), cci, i, event);
+		(void) container_workqueue_set_priority(&(cs->containers[i]->workqueue), cs->containers[i]->baseconfig.bootpriority);
+	}
+
+	return 0;
+}
 /**
  * Sub function for cleanup socket pair connection.
  *
@@ -505,6 +562,9 @@ static int container_mngsm_cgroup_setup(containers_t *cs)
 			result = -1;
 			goto do_return;
 		}
+
+		// Recovery I/O throttle. When it's not available, recovery is executed without throttle.
+		(void) recovery_scheduler_setup(cs->cmcfg->operation.recovery_ioweight, cs->cmcfg->operation.recovery_iomax);
 	} else {
 		result = -1;
 		goto do_return;
@@ -551,6 +611,8 @@ static int container_mngsm_do_system(containers_t *cs)
 		goto do_return;
 	}
 
+	(void) recovery_scheduler_set_budget(cs->cmcfg->operation.recovery_budget);
+
 do_return:
 	return result;
 }
@@ -681,11 +743,31 @@ int container_mngsm_setup(containers_t **pcs, sd_event *event, const char *confi
 		goto err_return;
 	}
 
+	ret = container_netif_index_create(cs);
+	if (ret < 0) {
+		goto err_return;
+	}
+
 	ret = container_mngsm_commsocket_setup(cs, event);
 	if (ret < 0) {
 		goto err_return;
 	}
 
+	ret = container_mngsm_worker_notification_setup(cs, event);
+	if (ret < 0) {
+		goto err_return;
+	}
+
+	ret = container_fsmonitor_setup(cs, event);
+	if (ret < 0) {
+		goto err_return;
+	}
+
+	ret = container_devwait_setup(cs, event);
+	if (ret < 0) {
+		goto err_return;
+	}
+
 	ret = container_mngsm_internal_timer_setup(cs, event);
 	if (ret < 0) {
 		goto err_return;
@@ -708,11 +790,15 @@ err_return:
 	if (cs->cms != NULL) {
 		(void) container_external_interface_cleanup(cs);
 		(void) container_mngsm_internal_timer_cleanup(cs);
+		(void) container_devwait_cleanup(cs);
+		(void) container_fsmonitor_cleanup(cs);
 		(void) container_mngsm_commsocket_cleanup(cs);
 		(void) container_mngsm_cleanup_system(cs);
 		(void) free(cs->cms);
 	}
 
+	(void) container_netif_index_release(cs);
+
 	if (cs != NULL) {
 		(void) release_container_configs(cs);
 	}
@@ -771,11 +857,15 @@ int container_mngsm_cleanup(containers_t *cs)
 	if (cs->cms != NULL) {
 		(void) container_external_interface_cleanup(cs);
 		(void) container_mngsm_internal_timer_cleanup(cs);
+		(void) container_devwait_cleanup(cs);
+		(void) container_fsmonitor_cleanup(cs);
 		(void) container_mngsm_commsocket_cleanup(cs);
 		(void) container_mngsm_cleanup_system(cs);
 		(void) free(cs->cms);
 	}
 
+	(void) container_netif_index_release(cs);
+
 	(void)release_container_configs(cs);
 
 	return 0;
@@ -11,6 +11,9 @@
 #include "container.h"
 
 #include "lxc-util.h"
+#include "socketcan-util.h"
+#include "tc-util.h"
+#include "cm-utils.h"
 
 #include <errno.h>
 #include <stdlib.h>
@@ -130,6 +133,402 @@ static int container_external_interface_command_get(cm_external_interface_t *pex
 
 	return ret;
 }
+/**
+ * Calculate frame rate from two counter samples.
+ *
+ * @param [in]	now		Current counter value.
+ * @param [in]	prev	Previous counter value.
+ * @param [in]	elapsed	Elapsed time between samples (ms).
+ * @return uint32_t	Frames per second.
+ */
+static uint32_t container_external_interface_frame_rate(uint64_t now, uint64_t prev, int64_t elapsed)
+{
+	uint64_t rate = 0;
+
+	// Kernel counter is 32bit, ignore wrap around or reset.
+	if ((elapsed <= 0) || (now < prev)) {
+		return 0;
+	}
+
+	rate = ((now - prev) * 1000u) / (uint64_t)elapsed;
+	if (rate > UINT32_MAX) {
+		rate = UINT32_MAX;
+	}
+
+	return (uint32_t)rate;
+}
+/**
+ * Command handler for "get-can-stats".
+ *
+ * @param [in]	cs			Pointer to containers_t
+ * @param [out]	canstats	Pointer to container_extif_command_getcanstats_response_t
+ * @return int
+ * @retval 0	Success to get information.
+ * @retval -1	Internal error.(Reserve)
+ * @retval -2	Argment error.
+ */
+static int container_external_interface_get_can_stats(containers_t *cs, container_extif_command_getcanstats_response_t *canstats)
+{
+	int num = 0;
+	int64_t timestamp = 0;
+
+	if ((cs == NULL) || (canstats == NULL)) {
+		return -2;
+	}
+
+	timestamp = get_current_time_ms();
+
+	for (int i =0; i < cs->num_of_container; i++) {
+		container_config_t *cc = cs->containers[i];
+		container_static_netif_elem_t *netelem = NULL;
+
+		dl_list_for_each(netelem, &cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list) {
+			netif_elem_vxcan_t *vxcan = NULL;
+			container_extif_canif_stat_t *pstat = NULL;
+			socketcanutil_gw_stat_t gwstat;
+			int ret = -1;
+
+			if (netelem->type != STATICNETIF_VXCAN) {
+				continue;
+			}
+
+			vxcan = (netif_elem_vxcan_t*)netelem->setting;
+			if ((vxcan->peer_host == NULL) || (num >= CONTAINER_EXTIF_CANIF_MAX)) {
+				continue;
+			}
+
+			ret = socketcanutil_get_gateway_stat(vxcan->peer_host, &gwstat);
+			if (ret < 0) {
+				continue;
+			}
+
+			pstat = &canstats->canifs[num];
+			(void) strncpy(pstat->guest_name, cc->name, sizeof(pstat->guest_name) - 1u);
+			(void) strncpy(pstat->ifname, vxcan->name, sizeof(pstat->ifname) - 1u);
+			pstat->rx_handled = gwstat.rx_handled;
+			pstat->rx_dropped = gwstat.rx_dropped;
+			pstat->tx_handled = gwstat.tx_handled;
+			pstat->tx_dropped = gwstat.tx_dropped;
+
+			if (vxcan->last_stat.timestamp != 0) {
+				int64_t elapsed = timestamp - vxcan->last_stat.timestamp;
+
+				pstat->rx_rate = container_external_interface_frame_rate(gwstat.rx_handled, vxcan->last_stat.rx_handled, elapsed);
+				pstat->tx_rate = container_external_interface_frame_rate(gwstat.tx_handled, vxcan->last_stat.tx_handled, elapsed);
+			}
+
+			vxcan->last_stat.rx_handled = gwstat.rx_handled;
+			vxcan->last_stat.rx_dropped = gwstat.rx_dropped;
+			vxcan->last_stat.tx_handled = gwstat.tx_handled;
+			vxcan->last_stat.tx_dropped = gwstat.tx_dropped;
+			vxcan->last_stat.timestamp = timestamp;
+
+			num++;
+		}
+	}
+
+	canstats->num_of_canifs = num;
+
+	return 0;
+}
+/**
+ * Command group handler for "get-can-stats".
+ *
+ * @param [in]	pextif	Pointer to cm_external_interface_t
+ * @param [in]	fd		File descriptor to use send response.
+ * @param [in]	buf		Received data buffer
+ * @param [in]	size	Received data size
+ * @return int
+ * @retval 0	Success to exec command.
+ * @retval -1	Internal error.
+ */
+static int container_external_interface_command_getcanstats(cm_external_interface_t *pextif, int fd, void *buf, ssize_t size)
+{
+	container_extif_command_getcanstats_response_t canstats;
+	int ret = -1;
+	ssize_t sret = -1;
+
+	(void) memset(&canstats, 0 , sizeof(canstats));
+
+	if(size >= (ssize_t)sizeof(container_extif_command_get_t)) {
+		canstats.header.command = CONTAINER_EXTIF_COMMAND_RESPONSE_GETCANSTATS;
+		ret = container_external_interface_get_can_stats(pextif->cs, &canstats);
+		if (ret == 0) {
+			sret = write(fd, &canstats, sizeof(canstats));
+			if (sret != (ssize_t)sizeof(canstats)) {
+				ret = -1;
+			}
+		} else {
+			ret = -1;
+		}
+	} else {
+		ret = -1;
+	}
+
+	return ret;
+}
+/**
+ * Command handler for "get-net-stats".
+ *
+ * @param [in]	cs			Pointer to containers_t
+ * @param [out]	netstats	Pointer to container_extif_command_getnetstats_response_t
+ * @return int
+ * @retval 0	Success to get information.
+ * @retval -1	Internal error.(Reserve)
+ * @retval -2	Argment error.
+ */
+static int container_external_interface_get_net_stats(containers_t *cs, container_extif_command_getnetstats_response_t *netstats)
+{
+	int num = 0;
+
+	if ((cs == NULL) || (netstats == NULL)) {
+		return -2;
+	}
+
+	for (int i =0; i < cs->num_of_container; i++) {
+		container_config_t *cc = cs->containers[i];
+		container_static_netif_elem_t *netelem = NULL;
+
+		dl_list_for_each(netelem, &cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list) {
+			netif_elem_veth_t *veth = NULL;
+			tcutil_stat_t stats[CONTAINER_EXTIF_NETCLASS_MAX];
+			int ret = -1;
+
+			if (netelem->type != STATICNETIF_VETH) {
+				continue;
+			}
+
+			veth = (netif_elem_veth_t*)netelem->setting;
+			if ((veth->shaping == NULL) || (veth->peer_host == NULL) || (num >= CONTAINER_EXTIF_NETCLASS_MAX)) {
+				continue;
+			}
+
+			ret = tcutil_get_stats(veth->peer_host, stats, CONTAINER_EXTIF_NETCLASS_MAX - num);
+			if (ret < 0) {
+				continue;
+			}
+
+			for (int j = 0; j < ret; j++) {
+				container_extif_netclass_stat_t *pstat = &netstats->classes[num];
+
+				(void) strncpy(pstat->guest_name, cc->name, sizeof(pstat->guest_name) - 1u);
+				if (veth->name != NULL) {
+					(void) strncpy(pstat->ifname, veth->name, sizeof(pstat->ifname) - 1u);
+				}
+				pstat->classid = stats[j].classid;
+				pstat->bytes = stats[j].bytes;
+				pstat->packets = stats[j].packets;
+				pstat->drops = stats[j].drops;
+				num++;
+			}
+		}
+	}
+
+	netstats->num_of_classes = num;
+
+	return 0;
+}
+/**
+ * Command group handler for "get-net-stats".
+ *
+ * @param [in]	pextif	Pointer to cm_external_interface_t
+ * @param [in]	fd		File descriptor to use send response.
+ * @param [in]	buf		Received data buffer
+ * @param [in]	size	Received data size
+ * @return int
+ * @retval 0	Success to exec command.
+ * @retval -1	Internal error.
+ */
+static int container_external_interface_command_getnetstats(cm_external_interface_t *pextif, int fd, void *buf, ssize_t size)
+{
+	container_extif_command_getnetstats_response_t netstats;
+	int ret = -1;
+	ssize_t sret = -1;
+
+	(void) memset(&netstats, 0 , sizeof(netstats));
+
+	if(size >= (ssize_t)sizeof(container_extif_command_get_t)) {
+		netstats.header.command = CONTAINER_EXTIF_COMMAND_RESPONSE_GETNETSTATS;
+		ret = container_external_interface_get_net_stats(pextif->cs, &netstats);
+		if (ret == 0) {
+			sret = write(fd, &netstats, sizeof(netstats));
+			if (sret != (ssize_t)sizeof(netstats)) {
+				ret = -1;
+			}
+		} else {
+			ret = -1;
+		}
+	} else {
+		ret = -1;
+	}
+
+	return ret;
+}
+/**
+ * Command handler for "get-recovery-stats".
+ *
+ * @param [in]	cs			Pointer to containers_t
+ * @param [out]	recstats	Pointer to container_extif_command_getrecoverystats_response_t
+ * @return int
+ * @retval 0	Success to get information.
+ * @retval -1	Internal error.(Reserve)
+ * @retval -2	Argment error.
+ */
+static int container_external_interface_get_recovery_stats(containers_t *cs, container_extif_command_getrecoverystats_response_t *recstats)
+{
+	int num = 0;
+
+	if ((cs == NULL) || (recstats == NULL)) {
+		return -2;
+	}
+
+	for (int i =0; (i < cs->num_of_container) && (num < CONTAINER_EXTIF_GUESTS_MAX); i++) {
+		container_config_t *cc = cs->containers[i];
+		container_extif_recovery_stat_t *pstat = &recstats->guests[num];
+		container_recovery_stat_t stat;
+		int ret = -1;
+
+		ret = container_workqueue_get_recovery_stat(&cc->workqueue, &stat);
+		if (ret < 0) {
+			continue;
+		}
+
+		(void) strncpy(pstat->guest_name, cc->name, sizeof(pstat->guest_name) - 1u);
+		for (int j = 0; (j < CONTAINER_RECOVERY_TIER_MAX) && (j < CONTAINER_EXTIF_RECOVERY_TIER_MAX); j++) {
+			pstat->count[j] = stat.count[j];
+			pstat->total_time_ms[j] = (uint64_t)stat.total_time_ms[j];
+			pstat->max_time_ms[j] = (uint64_t)stat.max_time_ms[j];
+		}
+		pstat->failed = stat.failed;
+		pstat->last_tier = stat.last_tier;
+		pstat->last_time_ms = (uint64_t)stat.last_time_ms;
+
+		pstat->running_phase = CONTAINER_EXTIF_RECOVERY_PHASE_NONE;
+		pstat->running_percent = -1;
+		if (container_workqueue_get_status(&cc->workqueue) == CONTAINER_WORKER_STARTED) {
+			int phase = 0, percent = -1;
+
+			ret = container_workqueue_get_progress(&cc->workqueue, &phase, &percent);
+			if (ret == 0) {
+				pstat->running_phase = phase;
+				pstat->running_percent = percent;
+			}
+		}
+		num++;
+	}
+
+	recstats->num_of_guests = num;
+
+	return 0;
+}
+/**
+ * Command group handler for "get-recovery-stats".
+ *
+ * @param [in]	pextif	Pointer to cm_external_interface_t
+ * @param [in]	fd		File descriptor to use send response.
+ * @param [in]	buf		Received data buffer
+ * @param [in]	size	Received data size
+ * @return int
+ * @retval 0	Success to exec command.
+ * @retval -1	Internal error.
+ */
+static int container_external_interface_command_getrecoverystats(cm_external_interface_t *pextif, int fd, void *buf, ssize_t size)
+{
+	container_extif_command_getrecoverystats_response_t recstats;
+	int ret = -1;
+	ssize_t sret = -1;
+
+	(void) memset(&recstats, 0 , sizeof(recstats));
+
+	if(size >= (ssize_t)sizeof(container_extif_command_get_t)) {
+		recstats.header.command = CONTAINER_EXTIF_COMMAND_RESPONSE_GETRECOVERYSTATS;
+		ret = container_external_interface_get_recovery_stats(pextif->cs, &recstats);
+		if (ret == 0) {
+			sret = write(fd, &recstats, sizeof(recstats));
+			if (sret != (ssize_t)sizeof(recstats)) {
+				ret = -1;
+			}
+		} else {
+			ret = -1;
+		}
+	} else {
+		ret = -1;
+	}
+
+	return ret;
+}
+/**
+ * Command handler for "get-fs-errors".
+ *
+ * @param [in]	cs			Pointer to containers_t
+ * @param [out]	fserrors	Pointer to container_extif_command_getfserrors_response_t
+ * @return int
+ * @retval 0	Success to get information.
+ * @retval -1	Internal error.(Reserve)
+ * @retval -2	Argment error.
+ */
+static int container_external_interface_get_fs_errors(containers_t *cs, container_extif_command_getfserrors_response_t *fserrors)
+{
+	int num = 0;
+
+	if ((cs == NULL) || (fserrors == NULL)) {
+		return -2;
+	}
+
+	for (int i =0; (i < cs->num_of_container) && (num < CONTAINER_EXTIF_GUESTS_MAX); i++) {
+		container_config_t *cc = cs->containers[i];
+		container_extif_fserror_stat_t *pstat = &fserrors->guests[num];
+
+		(void) strncpy(pstat->guest_name, cc->name, sizeof(pstat->guest_name) - 1u);
+		pstat->count = cc->runtime_stat.fserror.count;
+		pstat->last_error = cc->runtime_stat.fserror.last_error;
+		pstat->last_time_ms = (uint64_t)cc->runtime_stat.fserror.last_time;
+		if (cc->runtime_stat.fserror.last_path != NULL) {
+			(void) strncpy(pstat->last_path, cc->runtime_stat.fserror.last_path, sizeof(pstat->last_path) - 1u);
+		}
+		num++;
+	}
+
+	fserrors->num_of_guests = num;
+
+	return 0;
+}
+/**
+ * Command group handler for "get-fs-errors".
+ *
+ * @param [in]	pextif	Pointer to cm_external_interface_t
+ * @param [in]	fd		File descriptor to use send response.
+ * @param [in]	buf		Received data buffer
+ * @param [in]	size	Received data size
+ * @return int
+ * @retval 0	Success to exec command.
+ * @retval -1	Internal error.
+ */
+static int container_external_interface_command_getfserrors(cm_external_interface_t *pextif, int fd, void *buf, ssize_t size)
+{
+	container_extif_command_getfserrors_response_t fserrors;
+	int ret = -1;
+	ssize_t sret = -1;
+
+	(void) memset(&fserrors, 0 , sizeof(fserrors));
+
+	if(size >= (ssize_t)sizeof(container_extif_command_get_t)) {
+		fserrors.header.command = CONTAINER_EXTIF_COMMAND_RESPONSE_GETFSERRORS;
+		ret = container_external_interface_get_fs_errors(pextif->cs, &fserrors);
+		if (ret == 0) {
+			sret = write(fd, &fserrors, sizeof(fserrors));
+			if (sret != (ssize_t)sizeof(fserrors)) {
+				ret = -1;
+			}
+		} else {
+			ret = -1;
+		}
+	} else {
+		ret = -1;
+	}
+
+	return ret;
+}
 /**
  * Event handler for force reboot guest.
  *
@@ -548,6 +947,18 @@ static int container_external_interface_exec(cm_external_interface_t *pextif, in
 	case CONTAINER_EXTIF_COMMAND_GETGUESTS :
 		ret = container_external_interface_command_get(pextif, fd, buf, size);
 		break;
+	case CONTAINER_EXTIF_COMMAND_GETCANSTATS :
+		ret = container_external_interface_command_getcanstats(pextif, fd, buf, size);
+		break;
+	case CONTAINER_EXTIF_COMMAND_GETNETSTATS :
+		ret = container_external_interface_command_getnetstats(pextif, fd, buf, size);
+		break;
+	case CONTAINER_EXTIF_COMMAND_GETRECOVERYSTATS :
+		ret = container_external_interface_command_getrecoverystats(pextif, fd, buf, size);
+		break;
+	case CONTAINER_EXTIF_COMMAND_GETFSERRORS :
+		ret = container_external_interface_command_getfserrors(pextif, fd, buf, size);
+		break;
 	case CONTAINER_EXTIF_COMMAND_LIFECYCLE_GUEST_NAME :
 		ret = container_external_interface_command_lifecycle(pextif, fd, buf, size, 0);
 		break;
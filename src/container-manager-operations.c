@@ -13,7 +13,12 @@
 #include <poll.h>
 
 #include "container.h"
+#include "container-control-internal.h"
 #include "cm-utils.h"
+#include "recovery-scheduler.h"
+#include "block-util.h"
+#include "cm-worker-utils.h"
+#include "parallel-util.h"
 
 /**
  * @struct	s_container_manager_operation_storage
@@ -34,6 +39,8 @@ struct s_worker_operation_storage {
 	struct dl_list mount_list;	/**< Double link list for worker operation. */
 
 	int worker_fd;		/**< Socket fd for worker. */
+	int parallel;		/**< Number of concurrent mount and recovery operations. */
+	container_control_interface_t *cci;	/**< Container control interface to notify worker response. */
 };
 typedef struct s_worker_operation_storage worker_operation_storage_t;	/**< typedef for struct s_worker_operation_storage. */
 
@@ -61,6 +68,33 @@ typedef struct s_worker_response worker_response_t;	/**< typedef for struct s_wo
 static int manager_operation_mount_elem_free(container_manager_operation_mount_elem_t *celem);
 static int manager_operation_delayed_storage_list_free(worker_operation_storage_t *wos);
 
+/**
+ * Send response to worker host.
+ * After response packet write, this function push worker event to container manager state machine to collect response immediately.
+ * Shall call from worker thread only.
+ *
+ * @param [in]	wos		Initialized worker_operation_storage_t.
+ * @param [in]	wres	Pointer to response packet.
+ * @return int
+ * @retval 0	Success.
+ * @retval -1	Fail to send response.
+ */
+static int manager_worker_send_response(worker_operation_storage_t *wos, const worker_response_t *wres)
+{
+	int ret = -1;
+
+	ret = intr_safe_write(wos->worker_fd, wres, sizeof(worker_response_t));
+	if (ret < 0) {
+		return -1;
+	}
+
+	if ((wos->cci != NULL) && (wos->cci->worker_done != NULL)) {
+		(void) wos->cci->worker_done(wos->cci, CONTAINER_MNGSM_WORKER_MANAGER, wres->result);
+	}
+
+	return 0;
+}
+
 
 /**
  * @brief Function for disk format execution.
@@ -97,266 +131,561 @@ static int manager_worker_set_and_test_cancel(worker_operation_storage_t *wos, i
 	return result;
 }
 /**
- * @brief Function for fsck operation.
+ * Sub function for manager mount operation.  Do mount or unmount operation of one element.
+ * This function is possible to run in parallel with other element.
  *
- * @param [in]	handle		Initialized cm_worker_handle_t.
- * @param [in]	handle		Initialized cm_worker_handle_t.
- * @return Description for return value
- * @retval 0	Success to execute worker.
- * @retval -1	Need to optional worker.
+ * @param [in]	arg		Pointer to container_manager_operation_mount_elem_t.
+ * @return int
+ * @retval >=0	Success to operation.
+ * @retval -1	Mount or unmount error.
+ * @retval -2	Syscall error.
+ * @retval -3	Not supported.
  */
-static int manager_mount_operation(int control_fd, worker_operation_storage_t *wos, int is_retake)
+static int manager_mount_operation_do(void *arg)
 {
-	container_manager_operation_mount_elem_t *celem = NULL, *celem_n = NULL;
+	container_manager_operation_mount_elem_t *celem = (container_manager_operation_mount_elem_t*)arg;
 	unsigned long mntflag = 0;
-	int result = 0, ret = -1;
+	int ret = -1;
 
-	dl_list_for_each_safe(celem, celem_n, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
-		worker_response_t wres;
-		wres.index = celem->index;
-		wres.result = 0;
+	if (celem->is_mounted == 0) {
+		// Set mount flag
+		if (celem->mode == MANAGER_DISKMOUNT_TYPE_RW) {
+			mntflag = MS_DIRSYNC | MS_NOATIME | MS_NODEV | MS_NOEXEC | MS_SYNCHRONOUS;
+		} else {
+			mntflag = MS_NOATIME | MS_RDONLY;
+		}
 
-		if (celem->is_mounted == 0) {
-			// do mount operation
-			wres.operation = 0;
+		// do mount operations
+		if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FAILOVER) {
+			ret = mount_disk_failover(celem->blockdev, celem->to, celem->filesystem, mntflag, celem->option, &celem->failover_cache);
+		} else if ((celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FSCK) || (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_MKFS)) {
+			ret = mount_disk_once(celem->blockdev, celem->to, celem->filesystem, mntflag, celem->option);
+		} else {
+			// AB and other not support.
+			ret = -3;
+		}
+	} else {
+		// do unmount operation.
+		int64_t timeout_time = 0;
+		int retry_max = 0;
 
-			// Set mount flag
-			if (celem->mode == MANAGER_DISKMOUNT_TYPE_RW) {
-				mntflag = MS_DIRSYNC | MS_NOATIME | MS_NODEV | MS_NOEXEC | MS_SYNCHRONOUS;
-			} else {
-				mntflag = MS_NOATIME | MS_RDONLY;
-			}
+		// 1s timeout.
+		timeout_time = get_current_time_ms() + 1000ll;
+		retry_max = (1000 / 50) + 1;
 
-			// do mount operations
-			if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FAILOVER) {
-				ret = mount_disk_failover(celem->blockdev, celem->to, celem->filesystem, mntflag, celem->option);
-				dl_list_del(&celem->list);
-				celem->state = MANAGER_WORKER_STATE_COMPLETE;
-				if (ret < 0) {
-					wres.result = -1;
-				}
-				(void) manager_operation_mount_elem_free(celem);
-				(void) intr_safe_write(wos->worker_fd, &wres, sizeof(wres));
-			} else if ((celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FSCK) || (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_MKFS)) {
-				ret = mount_disk_once(celem->blockdev, celem->to, celem->filesystem, mntflag, celem->option);
-				if ((ret != -1) && (is_retake == 0)) {
-					// In case of success or error without mount error, return operation result.
-					dl_list_del(&celem->list);
-					celem->state = MANAGER_WORKER_STATE_COMPLETE;
-					if (ret < 0) {
-						wres.result = -1;
-					}
-					#ifdef _PRINTF_DEBUG_
-					(void) fprintf(stdout, "manager_mount_operation: mount_disk_once ret %d.\n", ret);
-					#endif
-					(void) manager_operation_mount_elem_free(celem);
-					(void) intr_safe_write(wos->worker_fd, &wres, sizeof(wres));
-				} else {
-					// In case of mount error, need to exec next step. Keep this object in list.
-					result = -1;
-					#ifdef _PRINTF_DEBUG_
-					(void) fprintf(stdout, "manager_mount_operation: mount_disk_once fail do need to recover.\n");
-					#endif
-				}
-			} else {
-				// AB and other not support, remove element from list.
-				dl_list_del(&celem->list);
-				celem->state = MANAGER_WORKER_STATE_COMPLETE;
-				wres.result = -1;
-				(void) manager_operation_mount_elem_free(celem);
-				(void) intr_safe_write(wos->worker_fd, &wres, sizeof(wres));
-			}
-		} else {
-			// do unmount operation.
-			int64_t timeout_time = 0;
-			int retry_max = 0;
+		ret = unmount_disk(celem->to, timeout_time, retry_max);
+	}
 
-			wres.operation = 1;
+	return ret;
+}
+/**
+ * Sub function for manager mount operation.  Handle result of one element and send response to host.
+ * Shall call from worker thread only.
+ *
+ * @param [in]	wos			Initialized worker_operation_storage_t.
+ * @param [in]	celem		Pointer to container_manager_operation_mount_elem_t.
+ * @param [in]	ret			Result of manager_mount_operation_do.
+ * @param [in]	is_retake	Retake mount after recovery (=1) or not (=0).
+ * @return int
+ * @retval 0	Operation is completed. The element is removed from list.
+ * @retval -1	Need to recovery. The element is kept in list.
+ */
+static int manager_mount_operation_result(worker_operation_storage_t *wos, container_manager_operation_mount_elem_t *celem, int ret, int is_retake)
+{
+	worker_response_t wres;
 
-			// 1s timeout.
-			timeout_time = get_current_time_ms() + 1000ll;
-			retry_max = (1000 / 50) + 1;
+	wres.index = celem->index;
+	wres.result = 0;
 
-			ret = unmount_disk(celem->to, timeout_time, retry_max);
-			dl_list_del(&celem->list);
-			celem->state = MANAGER_WORKER_STATE_COMPLETE;
-			if(ret < 0) {
-				wres.result = -1;
+	if (celem->is_mounted == 0) {
+		wres.operation = 0;
+
+		if ((celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FSCK) || (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_MKFS)) {
+			if (!((ret != -1) && (is_retake == 0))) {
+				// In case of mount error, need to exec next step. Keep this object in list.
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout, "manager_mount_operation: mount_disk_once fail do need to recover.\n");
+				#endif
+				return -1;
 			}
-			(void) manager_operation_mount_elem_free(celem);
-			(void) intr_safe_write(wos->worker_fd, &wres, sizeof(wres));
+			// In case of success or error without mount error, return operation result.
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout, "manager_mount_operation: mount_disk_once ret %d.\n", ret);
+			#endif
 		}
+	} else {
+		wres.operation = 1;
 	}
 
-	return result;
+	dl_list_del(&celem->list);
+	celem->state = MANAGER_WORKER_STATE_COMPLETE;
+	if (ret < 0) {
+		wres.result = -1;
+	}
+	(void) manager_operation_mount_elem_free(celem);
+	(void) manager_worker_send_response(wos, &wres);
+
+	return 0;
 }
 /**
- * @brief Function for fsck operation.
+ * Sub function for manager mount operation.  Test mount path of the element is nested with other element or not.
+ * Nested elements shall operate in list order.
  *
- * @param [in]	handle		Initialized cm_worker_handle_t.
- * @param [in]	handle		Initialized cm_worker_handle_t.
- * @return Description for return value
+ * @param [in]	wos		Initialized worker_operation_storage_t.
+ * @param [in]	celem	Pointer to container_manager_operation_mount_elem_t.
+ * @return int
+ * @retval 1	Nested.
+ * @retval 0	Not nested.
+ */
+static int manager_mount_operation_is_nested(worker_operation_storage_t *wos, container_manager_operation_mount_elem_t *celem)
+{
+	container_manager_operation_mount_elem_t *other = NULL;
+	size_t len = strlen(celem->to);
+
+	dl_list_for_each(other, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
+		size_t olen = 0;
+
+		if (other == celem) {
+			continue;
+		}
+
+		olen = strlen(other->to);
+		if ((olen < len) && (strncmp(other->to, celem->to, olen) == 0) && (celem->to[olen] == '/')) {
+			return 1;
+		}
+		if ((len < olen) && (strncmp(celem->to, other->to, len) == 0) && (other->to[len] == '/')) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+/**
+ * Manager mount operation.
+ * Independent elements are operated in parallel up to wos->parallel, nested elements are operated in list order.
+ * Nested unmount is operated before parallel stage and nested mount is operated after parallel stage.
+ *
+ * @param [in]	control_fd	Socket fd for worker control.
+ * @param [in]	wos			Initialized worker_operation_storage_t.
+ * @param [in]	is_retake	Retake mount after recovery (=1) or not (=0).
+ * @return int
  * @retval 0	Success to execute worker.
- * @retval -1	Fail to execute worker.
+ * @retval -1	Need to optional worker.
  */
-static int manager_worker_exec(int control_fd, worker_operation_storage_t *wos)
+static int manager_mount_operation(int control_fd, worker_operation_storage_t *wos, int is_retake)
 {
-	struct pollfd waiter[2];
 	container_manager_operation_mount_elem_t *celem = NULL, *celem_n = NULL;
-	siginfo_t child_info;
-	int result = -1;
-	int ret = -1;
-	int exit_code = -1;
-	int child_fd = -1;
-	pid_t child_pid = -1;
+	container_manager_operation_mount_elem_t **elems = NULL;
+	int *is_nested = NULL;
+	parallel_util_job_t *jobs = NULL;
+	int num_of_elem = 0, num_of_job = 0;
+	int result = 0, ret = -1;
 
-	if (wos == NULL) {
-		result = -1;
+	(void) control_fd;
+
+	dl_list_for_each(celem, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
+		num_of_elem++;
+	}
+
+	if (num_of_elem == 0) {
+		return 0;
+	}
+
+	elems = (container_manager_operation_mount_elem_t**)malloc(sizeof(container_manager_operation_mount_elem_t*) * (size_t)num_of_elem);
+	is_nested = (int*)malloc(sizeof(int) * (size_t)num_of_elem);
+	jobs = (parallel_util_job_t*)malloc(sizeof(parallel_util_job_t) * (size_t)num_of_elem);
+	if ((elems == NULL) || (is_nested == NULL) || (jobs == NULL)) {
+		// Fallback to serial operation.
+		dl_list_for_each_safe(celem, celem_n, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
+			ret = manager_mount_operation_do((void*)celem);
+			if (manager_mount_operation_result(wos, celem, ret, is_retake) < 0) {
+				result = -1;
+			}
+		}
 		goto do_return;
 	}
+	(void) memset(jobs, 0, sizeof(parallel_util_job_t) * (size_t)num_of_elem);
 
-	dl_list_for_each_safe(celem, celem_n, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
-		if (celem->state != MANAGER_WORKER_STATE_QUEUED) {
-			// Already canceled. Skip.
-			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "manager_worker_exec: %s operation was canceled.\n", celem->blockdev[0]);
-			#endif
-			continue;
+	// Snapshot list order before element remove.
+	num_of_elem = 0;
+	dl_list_for_each(celem, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
+		elems[num_of_elem] = celem;
+		is_nested[num_of_elem] = manager_mount_operation_is_nested(wos, celem);
+		num_of_elem++;
+	}
+
+	// Nested unmount: inner mount shall unmount first, operate in list order.
+	for (int i = 0; i < num_of_elem; i++) {
+		if ((is_nested[i] == 1) && (elems[i]->is_mounted != 0)) {
+			ret = manager_mount_operation_do((void*)elems[i]);
+			if (manager_mount_operation_result(wos, elems[i], ret, is_retake) < 0) {
+				result = -1;
+			}
 		}
+	}
 
+	// Independent elements.
+	for (int i = 0; i < num_of_elem; i++) {
+		if (is_nested[i] == 0) {
+			jobs[num_of_job].func = manager_mount_operation_do;
+			jobs[num_of_job].arg = (void*)elems[i];
+			jobs[num_of_job].group = PARALLEL_UTIL_NO_GROUP;
+			num_of_job++;
+		}
+	}
+
+	(void) parallel_util_run(jobs, num_of_job, wos->parallel);
+
+	for (int i = 0; i < num_of_job; i++) {
 		#ifdef _PRINTF_DEBUG_
-		(void) fprintf(stdout, "manager_worker_exec: do %s operation.\n", celem->blockdev[0]);
+		(void) fprintf(stdout, "manager_mount_operation: %s ret %d (%lld ms).\n"
+						, ((container_manager_operation_mount_elem_t*)jobs[i].arg)->to, jobs[i].result, (long long)jobs[i].elapsed_ms);
 		#endif
-
-		child_pid = fork();
-		if (child_pid < 0) {
-			// Fail to fork
-			celem->state = MANAGER_WORKER_STATE_CANCELED;
-			continue;
+		if (manager_mount_operation_result(wos, (container_manager_operation_mount_elem_t*)jobs[i].arg, jobs[i].result, is_retake) < 0) {
+			result = -1;
 		}
+	}
 
-		if (child_pid == 0) {
-			if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FSCK) {
-				// exec /sbin/fsck.ext4 -p
-				(void) execlp("/sbin/fsck.ext4", "/sbin/fsck.ext4", "-p", celem->blockdev[0], (char*)NULL);
-			} else if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_MKFS) {
-				// exec /sbin/fsck.ext4 -p
-				(void) execlp("/sbin/mkfs.ext4", "/sbin/mkfs.ext4", "-I", "256", celem->blockdev[0], (char*)NULL);
-			} else {
-				;	//nop
+	// Nested mount: outer mount shall mount first, operate in list order.
+	for (int i = 0; i < num_of_elem; i++) {
+		if ((is_nested[i] == 1) && (elems[i]->is_mounted == 0)) {
+			ret = manager_mount_operation_do((void*)elems[i]);
+			if (manager_mount_operation_result(wos, elems[i], ret, is_retake) < 0) {
+				result = -1;
 			}
-			// Shall not return execlp
-			(void) _exit(128);
 		}
+	}
+
+do_return:
+	(void) free(elems);
+	(void) free(is_nested);
+	(void) free(jobs);
+
+	return result;
+}
+/**
+ * @struct	s_manager_worker_slot
+ * @brief	The data structure for running recovery operation.
+ */
+struct s_manager_worker_slot {
+	container_manager_operation_mount_elem_t *celem;	/**< Target element. */
+	pid_t pid;		/**< Pid of recovery process. */
+	int pidfd;		/**< pidfd of recovery process. -1 is not available. */
+};
+/**
+ * @def	MANAGER_JOURNAL_BUDGET_SEC
+ * @brief	Time budget of journal replay (sec).  Journal replay process is killed by SIGALRM when it's expired.
+ */
+#define MANAGER_JOURNAL_BUDGET_SEC	(10u)
+/**
+ * Sub function for manager worker recovery process.  Journal replay as fast path of fsck.
+ * This function is called in forked child process, it use only async-signal-safe functions.
+ *
+ * @param [in]	devpath	Device node path to recover.
+ * @return int
+ * @retval 0	Journal replay was enough, file system is clean.
+ * @retval -1	Need to full check.
+ */
+static int manager_worker_journal_replay(const char *devpath)
+{
+	pid_t pid = -1;
+	int status = 0;
+
+	pid = fork();
+	if (pid < 0) {
+		return -1;
+	}
+
+	if (pid == 0) {
+		// Budget is applied by alarm, it's kept across exec.
+		(void) alarm(MANAGER_JOURNAL_BUDGET_SEC);
+		(void) execlp("/sbin/fsck.ext4", "/sbin/fsck.ext4", "-p", "-E", "journal_only", devpath, (char*)NULL);
+		// Shall not return execlp
+		(void) _exit(128);
+	}
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			return -1;
+		}
+	}
+
+	// Exit code 4 or more is errors left uncorrected or operational error.
+	if ((!WIFEXITED(status)) || (WEXITSTATUS(status) >= 4)) {
+		return -1;
+	}
+
+	if (libcmplug_ext4_is_clean(devpath) != 1) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function for manager worker.  Fork and exec recovery process for one element.
+ *
+ * @param [in]	celem	Pointer to container_manager_operation_mount_elem_t.
+ * @return pid_t
+ * @retval >0	Pid of recovery process.
+ * @retval -1	Fail to fork.
+ */
+static pid_t manager_worker_spawn(container_manager_operation_mount_elem_t *celem)
+{
+	pid_t child_pid = -1;
+
+	child_pid = fork();
+	if (child_pid < 0) {
+		return -1;
+	}
+
+	if (child_pid == 0) {
+		// Recovery I/O is throttled by recovery cgroup.
+		(void) recovery_scheduler_attach_self();
 
-		#ifdef _PRINTF_DEBUG_
 		if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FSCK) {
-			(void) fprintf(stdout, "manager_worker_exec fsck fork and exec fsck.ext4 pid=%d\n",(int)child_pid);
+			// Fast path: when journal replay is enough, skip full check.
+			if (manager_worker_journal_replay(celem->blockdev[0]) == 0) {
+				(void) _exit(0);
+			}
+			// exec /sbin/fsck.ext4 -p
+			(void) execlp("/sbin/fsck.ext4", "/sbin/fsck.ext4", "-p", celem->blockdev[0], (char*)NULL);
 		} else if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_MKFS) {
-			(void) fprintf(stdout, "manager_worker_exec mkfs fork and exec mkfs.ext4 pid=%d\n",(int)child_pid);
+			// exec /sbin/fsck.ext4 -p
+			(void) execlp("/sbin/mkfs.ext4", "/sbin/mkfs.ext4", "-I", "256", celem->blockdev[0], (char*)NULL);
 		} else {
 			;	//nop
 		}
+		// Shall not return execlp
+		(void) _exit(128);
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_FSCK) {
+		(void) fprintf(stdout, "manager_worker_exec fsck fork and exec fsck.ext4 pid=%d\n",(int)child_pid);
+	} else if (celem->redundancy == MANAGER_DISKREDUNDANCY_TYPE_MKFS) {
+		(void) fprintf(stdout, "manager_worker_exec mkfs fork and exec mkfs.ext4 pid=%d\n",(int)child_pid);
+	} else {
+		;	//nop
+	}
+	#endif
+
+	return child_pid;
+}
+/**
+ * Sub function for manager worker.  Reap exited recovery process and update element state.
+ *
+ * @param [in]	slot	Pointer to struct s_manager_worker_slot.
+ * @param [in]	options	Options for waitid. WNOHANG is available.
+ * @return int
+ * @retval 1	Reaped.
+ * @retval 0	Not exited yet.
+ */
+static int manager_worker_reap(struct s_manager_worker_slot *slot, int options)
+{
+	siginfo_t child_info;
+	int ret = -1;
+
+	(void) memset(&child_info, 0, sizeof(child_info));
+
+	ret = waitid(P_PID, (id_t)slot->pid, &child_info, (WEXITED | options));
+	if ((ret == 0) && (child_info.si_pid == 0)) {
+		// WNOHANG and not exited.
+		return 0;
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout, "manager_worker_exec got a exit child process %d (code %d).\n", (int)slot->pid, child_info.si_status);
+	#endif
+
+	if (slot->pidfd >= 0) {
+		(void) close(slot->pidfd);
+		slot->pidfd = -1;
+	}
+
+	(void) recovery_scheduler_release(&slot->celem->ticket);
+
+	if (slot->celem->state != MANAGER_WORKER_STATE_CANCELED) {
+		// When this elem was not canceled, it set complete state.
+		slot->celem->state = MANAGER_WORKER_STATE_COMPLETE;
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout, "manager_worker_exec %s recovery complete.\n", slot->celem->blockdev[0]);
 		#endif
+	}
 
-		child_fd = pidfd_open_syscall_wrapper(child_pid);
-		// Fail to create pidfd, it handled error case of poll.
+	return 1;
+}
+/**
+ * Sub function for manager worker.  Handle request from host.
+ *
+ * @param [in]	wos			Initialized worker_operation_storage_t.
+ * @param [in]	control_fd	Socket fd for worker control.
+ * @param [in]	slots		Array of running recovery operation.
+ * @param [in]	num_running	Number of running recovery operation.
+ * @return int
+ * @retval 0	Success.
+ */
+static int manager_worker_handle_request(worker_operation_storage_t *wos, int control_fd, struct s_manager_worker_slot *slots, int num_running)
+{
+	worker_request_t wreq;
+	worker_response_t wres;
+	ssize_t sret = -1;
+	int ret = -1;
 
-		(void) memset(waiter, 0, sizeof(waiter));
-		waiter[0].fd = child_fd;
-		waiter[0].events = POLLIN;
-		waiter[1].fd = control_fd;
-		waiter[1].events = POLLIN;
-
-		do {
-			ret = poll(waiter, 2, 100);	//100ms timeout
-			if (ret > 0) {
-				// Got a event
-				if (waiter[0].revents != 0) {
-					// child process was exited.
-					#ifdef _PRINTF_DEBUG_
-					(void) fprintf(stdout, "manager_worker_exec got a exit child process.\n");
-					#endif
-					break;
+	(void) memset(&wreq, 0, sizeof(wreq));
+	sret = read(control_fd, &wreq, sizeof(wreq));
+	if ((sret >= 0) && (wreq.request == 1)) {
+		(void) manager_worker_set_and_test_cancel(wos, wreq.index);
+		// Send cancel response.
+		wres.index = wreq.index;
+		wres.operation = 0;
+		wres.result = 1;
+		(void) manager_worker_send_response(wos, &wres);
+
+		// Target is now operating?
+		for (int i = 0; i < num_running; i++) {
+			if (slots[i].celem->index == wreq.index) {
+				// Do cancel operation
+				ret = pidfd_send_signal_syscall_wrapper(slots[i].pidfd, SIGTERM, NULL, 0);
+				if (ret < 0) {
+					(void) kill(slots[i].pid, SIGTERM);
 				}
+			}
+		}
+	}
 
-				if (waiter[1].revents != 0) {
-					// Message receive from host.
-					worker_request_t wreq;
-					worker_response_t wres;
-					ssize_t sret = -1;
-
-					(void) memset(&wreq, 0, sizeof(wreq));
-					sret = read(waiter[1].fd, &wreq, sizeof(wreq));
-					if (sret >= 0) {
-						if (wreq.request == 1) {
-							(void) manager_worker_set_and_test_cancel(wos, wreq.index);
-							// Send cancel response.
-							wres.index = wreq.index;
-							wres.operation = 0;
-							wres.result = 1;
-							(void) intr_safe_write(wos->worker_fd, &wres, sizeof(wres));
-
-							// Target is now operating?
-							if (celem->index == wreq.index) {
-								// Do cancel operation
-								ret = pidfd_send_signal_syscall_wrapper(child_fd, SIGTERM, NULL, 0);
-								if (ret < 0) {
-									(void) kill(child_pid, SIGTERM);
-								}
-								break;
-							}
-						}
-					}
-				}
-				break;
-			} else if (ret == 0) {
-				// Timeout, test to canceled.
-				ret = manager_worker_set_and_test_cancel(wos, -1);
-				if (ret == 1) {
-					// All worker was canceled or completed.
-					break;
-				}
-			} else {
-				if (errno != EINTR) {
-					// Can't wait child process.
-					(void) kill(child_pid, SIGTERM);
-					break;
+	return 0;
+}
+/**
+ * Manager worker recovery operation.
+ * The fsck/mkfs operations are run in parallel up to wos->parallel.  Operations to partitions on same physical disk are not run at same time.
+ * Physical disk is acquired from global recovery scheduler, it's shared with guest recovery.
+ *
+ * @param [in]	control_fd	Socket fd for worker control.
+ * @param [in]	wos			Initialized worker_operation_storage_t.
+ * @return int
+ * @retval 0	Success to execute worker.
+ * @retval -1	Fail to execute worker.
+ */
+static int manager_worker_exec(int control_fd, worker_operation_storage_t *wos)
+{
+	struct pollfd waiter[MANAGER_OPERATION_PARALLEL_MAX + 1];
+	struct s_manager_worker_slot slots[MANAGER_OPERATION_PARALLEL_MAX];
+	container_manager_operation_mount_elem_t *celem = NULL, *celem_n = NULL;
+	int num_running = 0, num_waiting = 0, parallel = 0;
+	int result = -1;
+	int ret = -1;
+
+	if (wos == NULL) {
+		result = -1;
+		goto do_return;
+	}
+
+	parallel = wos->parallel;
+	if (parallel < 1) {
+		parallel = 1;
+	} else if (parallel > MANAGER_OPERATION_PARALLEL_MAX) {
+		parallel = MANAGER_OPERATION_PARALLEL_MAX;
+	} else {
+		;	//nop
+	}
+
+	do {
+		// Launch queued operations.
+		num_waiting = 0;
+		dl_list_for_each(celem, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
+			struct s_manager_worker_slot *slot = NULL;
+
+			if (celem->state != MANAGER_WORKER_STATE_QUEUED) {
+				// Already canceled, running or completed. Skip.
+				if (celem->state == MANAGER_WORKER_STATE_CANCELED) {
+					(void) recovery_scheduler_release(&celem->ticket);
 				}
+				continue;
 			}
-		} while(1);
-
-		if (child_fd >= 0) {
-			(void) close(child_fd);
-		}
 
-		(void) memset(&child_info, 0, sizeof(child_info));
+			if (num_running >= parallel) {
+				num_waiting++;
+				continue;
+			}
 
-		ret = waitid(P_PID, (id_t)child_pid, &child_info, WEXITED);
-		if (ret == 0) {
-			if (child_info.si_code == CLD_EXITED) {
-				// Exited
-				exit_code = child_info.si_status;
-			} else {
-				// Canceled
-				exit_code = 0;	// Set success
+			ret = recovery_scheduler_try_acquire(&celem->ticket, celem->blockdev[0], RECOVERY_SCHEDULER_PRIORITY_MANAGER);
+			if (ret == 0) {
+				// Same physical disk is under recovery, wait to finish.
+				num_waiting++;
+				continue;
 			}
-		}
 
-		if (celem->state != MANAGER_WORKER_STATE_CANCELED) {
-			// When this elem was not canceled, it set complete state.
-			celem->state = MANAGER_WORKER_STATE_COMPLETE;
 			#ifdef _PRINTF_DEBUG_
-			(void) fprintf(stdout, "manager_worker_exec %s recovery complete.\n", celem->blockdev[0]);
+			(void) fprintf(stdout, "manager_worker_exec: do %s operation.\n", celem->blockdev[0]);
 			#endif
+
+			slot = &slots[num_running];
+			slot->pid = manager_worker_spawn(celem);
+			if (slot->pid < 0) {
+				// Fail to fork
+				(void) recovery_scheduler_release(&celem->ticket);
+				celem->state = MANAGER_WORKER_STATE_CANCELED;
+				continue;
+			}
+			// Fail to create pidfd, it handled by polling timeout.
+			slot->pidfd = pidfd_open_syscall_wrapper(slot->pid);
+			slot->celem = celem;
+			celem->state = MANAGER_WORKER_STATE_RUNNING;
+			num_running++;
 		}
 
-		ret = manager_worker_set_and_test_cancel(wos, -1);
-		if (ret == 1) {
-			// All object was canceled or completed. Go out list operation.
+		if ((num_running == 0) && (num_waiting == 0)) {
+			// All operations were completed or canceled.
 			break;
 		}
-	}
+
+		(void) memset(waiter, 0, sizeof(waiter));
+		for (int i = 0; i < num_running; i++) {
+			waiter[i].fd = slots[i].pidfd;
+			waiter[i].events = POLLIN;
+		}
+		waiter[num_running].fd = control_fd;
+		waiter[num_running].events = POLLIN;
+
+		ret = poll(waiter, (nfds_t)num_running + 1u, 100);	//100ms timeout
+		if ((ret < 0) && (errno != EINTR)) {
+			// Can't wait child process.
+			for (int i = 0; i < num_running; i++) {
+				(void) kill(slots[i].pid, SIGTERM);
+				(void) manager_worker_reap(&slots[i], 0);
+			}
+			num_running = 0;
+			break;
+		}
+
+		if ((ret > 0) && (waiter[num_running].revents != 0)) {
+			// Message receive from host.
+			(void) manager_worker_handle_request(wos, control_fd, slots, num_running);
+		}
+
+		// Reap exited child process.  Without pidfd, test by WNOHANG.
+		for (int i = 0; i < num_running;) {
+			int is_reaped = 0;
+
+			if (slots[i].pidfd < 0) {
+				is_reaped = manager_worker_reap(&slots[i], WNOHANG);
+			} else if ((ret > 0) && (waiter[i].revents != 0)) {
+				is_reaped = manager_worker_reap(&slots[i], 0);
+			} else {
+				;	//nop
+			}
+
+			if (is_reaped == 1) {
+				// Remove slot, waiter is not used after this point in this cycle.
+				num_running--;
+				slots[i] = slots[num_running];
+				waiter[i] = waiter[num_running];
+				waiter[num_running].revents = 0;
+			} else {
+				i++;
+			}
+		}
+	} while(1);
 
 	// Remove canceled elem
 	dl_list_for_each_safe(celem, celem_n, &wos->mount_list, container_manager_operation_mount_elem_t, list) {
@@ -476,6 +805,8 @@ int manager_operation_delayed_launch(containers_t *cs)
 
 	(void) memset(wos, 0, sizeof(worker_operation_storage_t));
 	dl_list_init(&wos->mount_list);
+	wos->parallel = cmo->parallel;
+	wos->cci = cs->cci;
 
 	// Create worker communication socket.
 	ret = socketpair(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC|SOCK_NONBLOCK, AF_UNIX, pairfd);
@@ -589,54 +920,63 @@ int manager_operation_delayed_poll(containers_t *cs)
 		result = -1;
 		goto do_return;
 	}
-	// When running worker.
-	(void) memset(&wres, 0, sizeof(wres));
-	sret = read(cmo->storage->host_fd, &wres, sizeof(wres));
-	if (sret < 0) {
-		if ((errno == EAGAIN) || (errno == EINTR)) {
-			// Not get packet
-			result = 0;
-			goto do_asses;
+	// When running worker. Collect all received response.
+	for (;;) {
+		(void) memset(&wres, 0, sizeof(wres));
+		sret = read(cmo->storage->host_fd, &wres, sizeof(wres));
+		if (sret < 0) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN) {
+				// No more packet
+				result = 0;
+				goto do_asses;
+			} else {
+				// Abnormal error
+				result = -3;
+				goto do_return;
+			}
+		} else if (sret == 0) {
+			// Worker side is closed.
+			break;
 		} else {
-			// Abnormal error
-			result = -3;
-			goto do_return;
+			;	//nop
 		}
-	}
 
-	dl_list_for_each(cmom_elem, &cmo->mount.mount_list, container_manager_operation_mount_elem_t, list) {
-		if (cmom_elem->index == wres.index) {
-			// Match index
-			if (wres.operation == 0) {
-				// Mount operation
-				if (wres.result == 0) {
-					// mounted
-					cmom_elem->is_mounted = 1;
-					#ifdef _PRINTF_DEBUG_
-					(void) fprintf(stdout, "manager_operation_delayed_poll got mounted %s to %s.\n", cmom_elem->blockdev[0], cmom_elem->to);
-					#endif
-				} else if (wres.result == 1) {
-					// canceled
+		dl_list_for_each(cmom_elem, &cmo->mount.mount_list, container_manager_operation_mount_elem_t, list) {
+			if (cmom_elem->index == wres.index) {
+				// Match index
+				if (wres.operation == 0) {
+					// Mount operation
+					if (wres.result == 0) {
+						// mounted
+						cmom_elem->is_mounted = 1;
+						#ifdef _PRINTF_DEBUG_
+						(void) fprintf(stdout, "manager_operation_delayed_poll got mounted %s to %s.\n", cmom_elem->blockdev[0], cmom_elem->to);
+						#endif
+					} else if (wres.result == 1) {
+						// canceled
+						cmom_elem->is_mounted = 0;
+						#ifdef _PRINTF_DEBUG_
+						(void) fprintf(stdout, "manager_operation_delayed_poll got canceled %s to %s.\n", cmom_elem->blockdev[0], cmom_elem->to);
+						#endif
+					} else {
+						// error
+						cmom_elem->error_count++;
+					}
+					// Already completed worker operation
+					cmom_elem->is_dispatched = 0;
+				} else if (wres.operation == 1) {
+					// Unmount operation
 					cmom_elem->is_mounted = 0;
+					// Already completed worker operation
+					cmom_elem->is_dispatched = 0;
 					#ifdef _PRINTF_DEBUG_
-					(void) fprintf(stdout, "manager_operation_delayed_poll got canceled %s to %s.\n", cmom_elem->blockdev[0], cmom_elem->to);
+					(void) fprintf(stdout, "manager_operation_delayed_poll got unmounted %s from %s.\n", cmom_elem->blockdev[0], cmom_elem->to);
 					#endif
 				} else {
-					// error
-					cmom_elem->error_count++;
+					;	//nop
 				}
-				// Already completed worker operation
-				cmom_elem->is_dispatched = 0;
-			} else if (wres.operation == 1) {
-				// Unmount operation
-				cmom_elem->is_mounted = 0;
-				// Already completed worker operation
-				cmom_elem->is_dispatched = 0;
-				#ifdef _PRINTF_DEBUG_
-				(void) fprintf(stdout, "manager_operation_delayed_poll got unmounted %s from %s.\n", cmom_elem->blockdev[0], cmom_elem->to);
-				#endif
-			} else {
-				;	//nop
 			}
 		}
 	}
@@ -705,6 +1045,8 @@ int manager_operation_delayed_terminate(containers_t *cs)
 
 	(void) memset(wos, 0, sizeof(worker_operation_storage_t));
 	dl_list_init(&wos->mount_list);
+	wos->parallel = cmo->parallel;
+	wos->cci = cs->cci;
 
 	// Create worker communication socket.
 	ret = socketpair(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC|SOCK_NONBLOCK, AF_UNIX, pairfd);
@@ -808,6 +1150,7 @@ static int manager_operation_mount_elem_free(container_manager_operation_mount_e
 		return -1;
 	}
 
+	(void) recovery_scheduler_release(&celem->ticket);
 	(void) free(celem->to);
 	(void) free(celem->filesystem);
 	(void) free(celem->option);
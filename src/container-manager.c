@@ -17,6 +17,7 @@
 #include "device-control.h"
 #include "container-control.h"
 #include "container-config.h"
+#include "socketcan-util.h"
 
 #include <systemd/sd-daemon.h>
 #include <systemd/sd-event.h>
@@ -146,6 +147,7 @@ finish:
 		(void) devc_device_manager_cleanup(cs);
 		(void) container_mngsm_cleanup(cs);
 	}
+	(void) socketcanutil_session_close();
 	event = sd_event_unref(event);
 
 	return result;
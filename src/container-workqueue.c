@@ -9,18 +9,27 @@
 #include <pthread.h>
 #include <dlfcn.h>
 #include <limits.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
 
 #include "container-workqueue.h"
+#include "container-control-interface.h"
+#include "cm-utils.h"
 #include "worker-plugin-interface.h"
+#include "recovery-scheduler.h"
 
+#define PLUGIN_CHAR_MAX	(128)
 struct s_cm_worker_object {
+	struct s_cm_worker_object *next;
+	char key[PLUGIN_CHAR_MAX];
 	void *plugin_dlhandle;
 	cm_worker_instance_t *instance;
 	cm_worker_new_t cm_worker_new;
 	cm_worker_delete_t cm_worker_delete;
+	int api_version;
 };
 
-#define PLUGIN_CHAR_MAX	(128)
 struct s_cm_worker_operation_elem {
 	char key[PLUGIN_CHAR_MAX];
 	char plugin_module[PLUGIN_CHAR_MAX];
@@ -39,10 +48,16 @@ static const cm_worker_operation_elem_t g_worker_operation[] = {
 	{
 		.key = "mkfs",
 		.plugin_module = "cm-worker-mkfs.so",
+	},
+	{
+		.key = "clone",
+		.plugin_module = "cm-worker-clone.so",
 	}
 };
 static const char *g_plugin_directory = "/usr/lib/container-manager";
 
+static int container_workqueue_start_job(container_workqueue_t *workqueue);
+
 /**
  * Sub function for plugin exec.
  *
@@ -117,25 +132,18 @@ error_return:
 /**
  * Sub function for plugin set args.
  *
- * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
- * @param [in]	arg			Pointer to argument string.
+ * @param [in]	obj		Pointer to loaded worker object.
+ * @param [in]	arg		Pointer to argument string.
  * @return int
- * @retval 1	Success to cancel worker.
- * @retval 0	Success to exec worker.
- * @retval -1	Fail to exec worker.
+ * @retval 0	Success to set args.
+ * @retval -1	Fail to set args.
  */
-static int container_workqueue_set_args(container_workqueue_t *workqueue, const char *arg)
+static int container_workqueue_set_args(struct s_cm_worker_object *obj, const char *arg)
 {
-	struct s_cm_worker_object *obj = NULL;
 	cm_worker_instance_t *inst = NULL;
 	int ret = -1;
 
-	if (workqueue == NULL) {
-		goto error_return;
-	}
-
-	obj = workqueue->object;
-	if (obj == NULL) {
+	if ((obj == NULL) || (arg == NULL)) {
 		goto error_return;
 	}
 
@@ -177,14 +185,16 @@ static int container_workqueue_get_plugin(const char *key, char *module)
 }
 /**
  * Load container workqueue plugin.
+ * Loaded plugin is cached in the workqueue and reused across jobs.
  *
  * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
  * @param [in]	key			Pointer to string for the plugin key.
+ * @param [out]	pobj		Pointer to set loaded worker object.
  * @return int
  * @retval 0	Success to load plugin.
  * @retval -1	Fail to load plugin.
  */
-static int container_workqueue_load_plugin(container_workqueue_t *workqueue, const char *key)
+static int container_workqueue_load_plugin(container_workqueue_t *workqueue, const char *key, struct s_cm_worker_object **pobj)
 {
 	int ret = -1;
 	struct s_cm_worker_object *obj = NULL;
@@ -194,6 +204,14 @@ static int container_workqueue_load_plugin(container_workqueue_t *workqueue, con
 	module[0] = '\0';
 	plugin_path[0] = '\0';
 
+	// Lookup from cache.
+	for (obj = workqueue->plugin_cache; obj != NULL; obj = obj->next) {
+		if (strcmp(obj->key, key) == 0) {
+			(*pobj) = obj;
+			return 0;
+		}
+	}
+
 	ret = container_workqueue_get_plugin(key, module);
 	if (ret < 0) {
 		return -1;
@@ -210,6 +228,7 @@ static int container_workqueue_load_plugin(container_workqueue_t *workqueue, con
 	}
 
 	(void) memset(obj, 0, sizeof(struct s_cm_worker_object));
+	(void) strncpy(obj->key, key, sizeof(obj->key) - 1u);
 
 	obj->plugin_dlhandle = dlopen(plugin_path, (RTLD_NOW | RTLD_NODELETE));
 	if (obj->plugin_dlhandle == NULL) {
@@ -234,6 +253,19 @@ static int container_workqueue_load_plugin(container_workqueue_t *workqueue, con
 		goto error_return;
 	}
 
+	// Optional symbol.  The plugin that is not export cm_worker_api_version is version 1.
+	obj->api_version = CM_WORKER_API_VERSION_1;
+	{
+		cm_worker_api_version_t api_version_func = NULL;
+
+		api_version_func = (cm_worker_api_version_t)dlsym(obj->plugin_dlhandle, "cm_worker_api_version");
+		if (api_version_func != NULL) {
+			if (api_version_func() >= CM_WORKER_API_VERSION_2) {
+				obj->api_version = CM_WORKER_API_VERSION_2;
+			}
+		}
+	}
+
 	ret = obj->cm_worker_new(&obj->instance);
 	if (ret < 0) {
 		#ifdef _PRINTF_DEBUG_
@@ -242,7 +274,9 @@ static int container_workqueue_load_plugin(container_workqueue_t *workqueue, con
 		goto error_return;
 	}
 
-	workqueue->object = obj;
+	obj->next = workqueue->plugin_cache;
+	workqueue->plugin_cache = obj;
+	(*pobj) = obj;
 
 	return 0;
 
@@ -257,7 +291,7 @@ error_return:
 	return -1;
 }
 /**
- * Unload container workqueue plugin.
+ * Unload all cached container workqueue plugin.
  *
  * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
  * @return int
@@ -267,37 +301,383 @@ error_return:
 static int container_workqueue_unload_plugin(container_workqueue_t *workqueue)
 {
 	int ret = -1;
+	int result = 0;
 	struct s_cm_worker_object *obj = NULL;
 
 	if (workqueue == NULL) {
-		goto error_return;
+		return -1;
 	}
 
-	obj = (struct s_cm_worker_object*)workqueue->object;
-	if (obj == NULL) {
-		goto error_return;
+	workqueue->object = NULL;
+
+	while (workqueue->plugin_cache != NULL) {
+		obj = workqueue->plugin_cache;
+		workqueue->plugin_cache = obj->next;
+
+		ret = obj->cm_worker_delete(obj->instance);
+		if (ret < 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"container_workqueue_unload_plugin: fail to %s\n", "cm_worker_delete");
+			#endif
+			result = -1;
+		}
+		obj->instance = NULL;
+
+		(void) dlclose(obj->plugin_dlhandle);
+		(void) free(obj);
 	}
 
-	ret = obj->cm_worker_delete(obj->instance);
+	return result;
+}
+/**
+ * Clear all queued jobs.  Loaded plugins are kept in cache.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @return void
+ */
+static void container_workqueue_clear_job(container_workqueue_t *workqueue)
+{
+	for (int i = 0; i < workqueue->num_of_job; i++) {
+		(void) free(workqueue->job[i].args);
+		(void) memset(&workqueue->job[i], 0, sizeof(container_workqueue_job_t));
+	}
+
+	workqueue->num_of_job = 0;
+	workqueue->current_job = 0;
+	workqueue->cancel_request = 0;
+	workqueue->object = NULL;
+
+	(void) recovery_scheduler_release(&workqueue->ticket);
+}
+/**
+ * Progress callback for version 2 worker plugin.
+ * This function may call from worker thread.
+ *
+ * @param [in]	userdata	Pointer to own container_workqueue_t.
+ * @param [in]	phase		Current phase of worker. CM_WORKER_PHASE_XXX.
+ * @param [in]	percent		Progress of current phase.
+ * @return void
+ */
+static void container_workqueue_progress(void *userdata, int phase, int percent)
+{
+	container_workqueue_t *workqueue = (container_workqueue_t*)userdata;
+
+	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+	workqueue->progress_phase = phase;
+	workqueue->progress_percent = percent;
+	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"container_workqueue_progress: phase %d %d%%\n", phase, percent);
+	#endif
+}
+/**
+ * Add a job to the workqueue.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [in]	key			Pointer to string for the plugin key.
+ * @param [in]	args		Pointer to argument string for the plugin.
+ * @param [in]	depend		Index of depend job. CONTAINER_WORKER_NO_DEPEND is no dependency.
+ * @param [in]	condition	Run condition by result of depend job. CONTAINER_WORKER_RUN_XXX.
+ * @return int
+ * @retval >=0	Success to add, index of added job.
+ * @retval -1	Job queue is full.
+ * @retval -2	Arg. error.
+ * @retval -3	Fail to load plugin.
+ */
+static int container_workqueue_add_job(container_workqueue_t *workqueue, const char *key, const char *args, int depend, int condition)
+{
+	container_workqueue_job_t *job = NULL;
+	struct s_cm_worker_object *obj = NULL;
+	int index = 0;
+	int ret = -1;
+
+	if (workqueue->num_of_job >= CONTAINER_WORKQUEUE_JOB_MAX) {
+		return -1;
+	}
+
+	index = workqueue->num_of_job;
+	if ((depend != CONTAINER_WORKER_NO_DEPEND) && ((depend < 0) || (depend >= index))) {
+		return -2;
+	}
+
+	ret = container_workqueue_load_plugin(workqueue, key, &obj);
 	if (ret < 0) {
-		#ifdef _PRINTF_DEBUG_
-		(void) fprintf(stdout,"container_workqueue_unload_plugin: fail to %s\n", "cm_worker_delete");
-		#endif
-		goto error_return;
+		return -3;
 	}
 
-	obj->instance = NULL;
+	if (obj->api_version >= CM_WORKER_API_VERSION_2) {
+		cm_worker_instance_v2_t *inst = (cm_worker_instance_v2_t*)obj->instance;
 
-	(void) dlclose(obj->plugin_dlhandle);
-	(void) free(obj);
-	workqueue->object = NULL;
+		(void) inst->set_progress(inst->base.handle, container_workqueue_progress, (void*)workqueue);
+	}
+
+	// Args check by plugin.  Args are set again at job start.
+	ret = container_workqueue_set_args(obj, args);
+	if (ret < 0) {
+		return -2;
+	}
+
+	job = &workqueue->job[index];
+	(void) memset(job, 0, sizeof(container_workqueue_job_t));
+	job->args = strdup(args);
+	if (job->args == NULL) {
+		return -3;
+	}
+	job->object = obj;
+	job->depend = depend;
+	job->condition = condition;
+	job->is_executed = 0;
+	job->result = 0;
+
+	workqueue->num_of_job = index + 1;
+
+	return index;
+}
+/**
+ * Test to run condition of the job.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [in]	index		Index of test target job.
+ * @return int
+ * @retval 1	Need to run.
+ * @retval 0	Skip.
+ */
+static int container_workqueue_test_job(container_workqueue_t *workqueue, int index)
+{
+	container_workqueue_job_t *job = &workqueue->job[index];
+	container_workqueue_job_t *dep = NULL;
+
+	if (job->depend == CONTAINER_WORKER_NO_DEPEND) {
+		return 1;
+	}
+
+	dep = &workqueue->job[job->depend];
+	if ((dep->is_executed == 0) || (dep->result == 1)) {
+		// Depend job was skipped or canceled.
+		return 0;
+	}
+
+	if (job->condition == CONTAINER_WORKER_RUN_ON_SUCCESS) {
+		if (dep->result == 0) {
+			return 1;
+		}
+	} else if (job->condition == CONTAINER_WORKER_RUN_ON_FAIL) {
+		if (dep->result < 0) {
+			return 1;
+		}
+	} else {
+		return 1;
+	}
 
 	return 0;
+}
+/**
+ * Prepare the job to run.  It set args to the plugin and set current object.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [in]	index		Index of target job.
+ * @return int
+ * @retval 0	Success to prepare.
+ * @retval -1	Fail to prepare.
+ * @retval -2	Got cancel request.
+ */
+static int container_workqueue_prepare_job(container_workqueue_t *workqueue, int index)
+{
+	container_workqueue_job_t *job = &workqueue->job[index];
+	const char *cgroup = NULL;
+	char args[1024];
+	size_t len = 0;
+	int budget = 0;
+	int ret = -1;
 
-error_return:
+	ret = snprintf(args, sizeof(args), "%s", job->args);
+	if (!((size_t)ret < sizeof(args))) {
+		return -1;
+	}
+	len = (size_t)ret;
+
+	// Recovery process is throttled by recovery cgroup.
+	cgroup = recovery_scheduler_get_cgroup();
+	if (cgroup != NULL) {
+		ret = snprintf(&args[len], sizeof(args) - len, " cgroup=%s", cgroup);
+		if (!((size_t)ret < (sizeof(args) - len))) {
+			return -1;
+		}
+		len = len + (size_t)ret;
+	}
+
+	// Time budget of last tier recovery.  When it's not set, plugin run without time limit.
+	budget = recovery_scheduler_get_budget();
+	if (budget > 0) {
+		ret = snprintf(&args[len], sizeof(args) - len, " budget=%d", budget);
+		if (!((size_t)ret < (sizeof(args) - len))) {
+			return -1;
+		}
+	}
+
+	// Set args before publish to current object.  Plugin may clear cancel request at set args.
+	ret = container_workqueue_set_args(job->object, args);
+	if (ret < 0) {
+		return -1;
+	}
+
+	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+	if (workqueue->cancel_request == 1) {
+		ret = -2;
+	} else {
+		workqueue->current_job = index;
+		workqueue->object = job->object;
+		ret = 0;
+	}
+	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+
+	return ret;
+}
+/**
+ * Store result of current job and select next job.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [in]	result		Result of current job.
+ * @return int
+ * @retval >=0	Index of next job.  It's prepared.
+ * @retval -1	No more job.
+ */
+static int container_workqueue_next_job(container_workqueue_t *workqueue, int result)
+{
+	container_workqueue_job_t *job = &workqueue->job[workqueue->current_job];
+	int ret = -1;
+
+	job->is_executed = 1;
+	job->result = result;
+
+	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+	workqueue->result = result;
+	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+
+	if (result == 1) {
+		// Canceled, not run following jobs.
+		return -1;
+	}
+
+	for (int i = workqueue->current_job + 1; i < workqueue->num_of_job; i++) {
+		ret = container_workqueue_test_job(workqueue, i);
+		if (ret == 0) {
+			continue;
+		}
+
+		ret = container_workqueue_prepare_job(workqueue, i);
+		if (ret == 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"container_workqueue_next_job: run job %d (%s)\n", i, workqueue->job[i].object->key);
+			#endif
+			return i;
+		} else if (ret == -2) {
+			(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+			workqueue->result = 1;
+			(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+			return -1;
+		} else {
+			// Fail to prepare, this job is failed.
+			workqueue->job[i].is_executed = 1;
+			workqueue->job[i].result = -1;
+			workqueue->current_job = i;
+			(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+			workqueue->result = -1;
+			(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+		}
+	}
 
 	return -1;
 }
+/**
+ * Sub function to get recovery tier of current job.
+ * Version 2 plugin report tier by phase, version 1 plugin is evaluated by plugin key.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @return int	Recovery tier. CONTAINER_RECOVERY_TIER_XXX.
+ */
+static int container_workqueue_get_tier(container_workqueue_t *workqueue)
+{
+	int tier = CONTAINER_RECOVERY_TIER_RECREATE;
+
+	if (workqueue->progress_phase == CM_WORKER_PHASE_JOURNAL) {
+		tier = CONTAINER_RECOVERY_TIER_JOURNAL;
+	} else if (workqueue->progress_phase == CM_WORKER_PHASE_CHECK) {
+		tier = CONTAINER_RECOVERY_TIER_CHECK;
+	} else if ((workqueue->progress_phase == CM_WORKER_PHASE_ERASE) || (workqueue->progress_phase == CM_WORKER_PHASE_FORMAT)) {
+		tier = CONTAINER_RECOVERY_TIER_RECREATE;
+	} else if (strcmp(workqueue->job[workqueue->current_job].object->key, "fsck") == 0) {
+		tier = CONTAINER_RECOVERY_TIER_CHECK;
+	} else {
+		;	//nop
+	}
+
+	return tier;
+}
+/**
+ * Sub function to update recovery statistics.  Shall call with workqueue_mutex.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [in]	result		Result of queued jobs.
+ * @return void
+ */
+static void container_workqueue_update_stat(container_workqueue_t *workqueue, int result)
+{
+	container_recovery_stat_t *stat = &workqueue->recovery_stat;
+	int64_t elapsed = 0;
+	int tier = CONTAINER_RECOVERY_TIER_NONE;
+
+	if (result == 1) {
+		// Canceled, not a result of recovery.
+		return;
+	}
+
+	elapsed = get_current_time_ms() - workqueue->start_time;
+	stat->last_time_ms = elapsed;
+
+	if (result < 0) {
+		stat->failed++;
+		stat->last_tier = CONTAINER_RECOVERY_TIER_NONE;
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Recovery failed %d (%lld ms).\n", result, (long long)elapsed);
+		#endif
+	} else {
+		tier = container_workqueue_get_tier(workqueue);
+		stat->count[tier]++;
+		stat->total_time_ms[tier] += elapsed;
+		if (stat->max_time_ms[tier] < elapsed) {
+			stat->max_time_ms[tier] = elapsed;
+		}
+		stat->last_tier = tier;
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL INFO] Recovery success at tier %d (%lld ms).\n", tier, (long long)elapsed);
+		#endif
+	}
+}
+/**
+ * Set workqueue completion and push completion event.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @return void
+ */
+static void container_workqueue_finish(container_workqueue_t *workqueue)
+{
+	int result = -1;
+
+	(void) recovery_scheduler_release(&workqueue->ticket);
+
+	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+	result = workqueue->result;
+	container_workqueue_update_stat(workqueue, result);
+	workqueue->status = CONTAINER_WORKER_COMPLETED;
+	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+
+	// Push completion event to state machine.
+	if ((workqueue->cci != NULL) && (workqueue->cci->worker_done != NULL)) {
+		(void) workqueue->cci->worker_done(workqueue->cci, workqueue->container_number, result);
+	}
+}
 /**
  * Cleanup scheduled per container workqueue.
  *
@@ -336,11 +716,122 @@ int container_workqueue_cleanup(container_workqueue_t *workqueue, int *after_exe
 	(void) fprintf(stdout,"container_workqueue_cleanup: got result %d\n", workqueue->result);
 	#endif
 
-	(void) container_workqueue_unload_plugin(workqueue);
+	container_workqueue_clear_job(workqueue);
 
 	return 0;
 }
 
+/**
+ * Event handler for in-loop dispatch of version 2 worker plugin.
+ *
+ * @param [in]	event		Socket event source object.
+ * @param [in]	fd			File discriptor for worker plugin.
+ * @param [in]	revents		Active event (epoll).
+ * @param [in]	userdata	Pointer to own container_workqueue_t.
+ * @return int
+ * @retval	0	Success to handle event.
+ * @retval	-1	Internal error (Not use).
+ */
+static int container_workqueue_dispatch_handler(sd_event_source *event, int fd, uint32_t revents, void *userdata)
+{
+	container_workqueue_t *workqueue = (container_workqueue_t*)userdata;
+	cm_worker_instance_v2_t *inst = NULL;
+	int result = -1;
+	int ret = -1;
+
+	(void) fd;
+	(void) revents;
+
+	if (workqueue == NULL) {
+		return 0;
+	}
+
+	inst = (cm_worker_instance_v2_t*)workqueue->object->instance;
+
+	ret = inst->dispatch(inst->base.handle, &result);
+	if (ret == 0) {
+		// Worker is running.
+		return 0;
+	} else if (ret < 0) {
+		result = -1;
+	} else {
+		;	//nop
+	}
+
+	(void) sd_event_source_set_enabled(event, SD_EVENT_OFF);
+	workqueue->worker_source = sd_event_source_unref(workqueue->worker_source);
+
+	// Continue to next job.
+	while (container_workqueue_next_job(workqueue, result) >= 0) {
+		ret = container_workqueue_start_job(workqueue);
+		if (ret == 0) {
+			return 0;
+		}
+		result = -1;
+	}
+
+	container_workqueue_finish(workqueue);
+
+	return 0;
+}
+/**
+ * Sub function for in-loop start of version 2 worker plugin.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @return int
+ * @retval 0	Success to start.
+ * @retval -1	Fail to start.
+ */
+static int container_workqueue_start_async(container_workqueue_t *workqueue)
+{
+	cm_worker_instance_v2_t *inst = NULL;
+	sd_event_source *source = NULL;
+	int fd = -1;
+	int ret = -1;
+
+	inst = (cm_worker_instance_v2_t*)workqueue->object->instance;
+
+	ret = inst->start(inst->base.handle);
+	if (ret < 0) {
+		return -1;
+	}
+
+	fd = inst->get_fd(inst->base.handle);
+	if (fd < 0) {
+		goto err_ret;
+	}
+
+	ret = sd_event_add_io(workqueue->event, &source, fd, EPOLLIN, container_workqueue_dispatch_handler, (void*)workqueue);
+	if (ret < 0) {
+		goto err_ret;
+	}
+
+	workqueue->worker_source = source;
+
+	return 0;
+
+err_ret:
+	// Started worker need to stop.  Use blocking wait of cancel operation.
+	(void) inst->base.cancel(inst->base.handle);
+	if (fd >= 0) {
+		struct pollfd waiter[1];
+		int result = -1;
+
+		(void) memset(waiter, 0, sizeof(struct pollfd)*1u);
+		waiter[0].fd = fd;
+		waiter[0].events = POLLIN;
+
+		do {
+			ret = poll(waiter, 1, -1);
+			if ((ret < 0) && (errno != EINTR)) {
+				break;
+			}
+			ret = inst->dispatch(inst->base.handle, &result);
+		} while(ret == 0);
+	}
+
+	return -1;
+}
 /**
  * Thread entry point for per container workqueue.
  *
@@ -356,23 +847,89 @@ static void* container_workqueue_thread(void *args)
 		pthread_exit(NULL);
 	}
 
-	ret = container_workqueue_exec(workqueue);
+	// Execute current job and following jobs by blocking exec.
+	do {
+		ret = container_workqueue_exec(workqueue);
+	} while (container_workqueue_next_job(workqueue, ret) >= 0);
 
-	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
-	workqueue->result = ret;
-	workqueue->status = CONTAINER_WORKER_COMPLETED;
-	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+	container_workqueue_finish(workqueue);
 
 	pthread_exit(NULL);
 
 	return NULL;
 }
 
+/**
+ * Start current job of per container workqueue.
+ * Version 2 plugin is dispatched in the event loop, other is executed by worker thread.
+ * Worker thread execute following jobs too.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @return int
+ * @retval 0	Success to start.
+ * @retval -1	Fail to start.
+ */
+static int container_workqueue_start_job(container_workqueue_t *workqueue)
+{
+	int ret = -1;
+	pthread_attr_t thread_attr;
+
+	if ((workqueue->object != NULL) && (workqueue->object->api_version >= CM_WORKER_API_VERSION_2)
+		&& (workqueue->event != NULL)) {
+		// In-loop async mode. Not need worker thread.
+		return container_workqueue_start_async(workqueue);
+	}
+
+	// Version 1 plugin (or no event loop) use worker thread and blocking exec.
+	(void) pthread_attr_init(&thread_attr);
+	(void) pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED);
+
+	ret = pthread_create(&(workqueue->worker_thread), &thread_attr, container_workqueue_thread, (void*)workqueue);
+	(void) pthread_attr_destroy(&thread_attr);
+	if (ret != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function to get device path from plugin args.
+ *
+ * @param [in]	args	Pointer to argument string for the plugin.
+ * @param [out]	device	Buffer to store device path.
+ * @param [in]	size	Size of buffer.
+ * @return int
+ * @retval 0	Success to get.
+ * @retval -1	No device in args.
+ */
+static int container_workqueue_get_device(const char *args, char *device, size_t size)
+{
+	const char *str = NULL;
+	size_t len = 0;
+
+	str = strstr(args, "device=");
+	if (str == NULL) {
+		return -1;
+	}
+	str = &str[strlen("device=")];
+
+	len = strcspn(str, " ");
+	if ((len == 0) || (len >= size)) {
+		return -1;
+	}
+
+	(void) memcpy(device, str, len);
+	device[len] = '\0';
+
+	return 0;
+}
 /**
  * Run scheduled per container workqueue.
+ * Physical disk of the jobs is acquired from global recovery scheduler.  When the disk is used by other recovery, caller shall retry later.
  *
  * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
  * @return int
+ * @retval 1	Waiting for disk. Retry later.
  * @retval 0	Success to schedule.
  * @retval -1	Is not scheduled workqueue.
  * @retval -2	Arg. error.
@@ -380,8 +937,8 @@ static void* container_workqueue_thread(void *args)
  */
 int container_workqueue_run(container_workqueue_t *workqueue)
 {
+	char device[PATH_MAX];
 	int ret = -1;
-	pthread_attr_t thread_attr;
 
 	if (workqueue == NULL) {
 		return -2;
@@ -391,17 +948,30 @@ int container_workqueue_run(container_workqueue_t *workqueue)
 		return -1;
 	}
 
-	(void) pthread_attr_init(&thread_attr);
-	(void) pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED);
+	ret = container_workqueue_get_device(workqueue->job[0].args, device, sizeof(device));
+	if (ret == 0) {
+		ret = recovery_scheduler_try_acquire(&workqueue->ticket, device, workqueue->priority);
+		if (ret == 0) {
+			return 1;
+		}
+	}
+
+	// First job has no dependency.
+	ret = container_workqueue_prepare_job(workqueue, 0);
+	if (ret < 0) {
+		(void) recovery_scheduler_release(&workqueue->ticket);
+		return -3;
+	}
 
 	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
 	workqueue->status = CONTAINER_WORKER_STARTED;
+	workqueue->start_time = get_current_time_ms();
 	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
 
-	ret = pthread_create(&(workqueue->worker_thread), &thread_attr, container_workqueue_thread, (void*)workqueue);
-	(void) pthread_attr_destroy(&thread_attr);
+	ret = container_workqueue_start_job(workqueue);
 	if (ret < 0) {
 		// Fail back status.
+		(void) recovery_scheduler_release(&workqueue->ticket);
 		workqueue->status = CONTAINER_WORKER_SCHEDULED;
 		return -3;
 	}
@@ -436,8 +1006,11 @@ int container_workqueue_cancel(container_workqueue_t *workqueue)
 		// Worker is scheduled but not run. Can remove worker.
 		result = 0;
 	} else {
-		// Cancel operation
+		// Cancel operation.  Following jobs are not run.
+		(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+		workqueue->cancel_request = 1;
 		ret = container_workqueue_exec_cancel(workqueue);
+		(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
 		if (ret == 0) {
 			result = 1;
 		} else {
@@ -479,28 +1052,30 @@ int container_workqueue_remove(container_workqueue_t *workqueue, int *after_exec
 	workqueue->state_after_execute = 0;
 	workqueue->result = 0;
 
-	(void) container_workqueue_unload_plugin(workqueue);
+	container_workqueue_clear_job(workqueue);
 
 	return 0;
 }
 
 /**
  * Schedule per container workqueue.
+ * This function schedule first job, following jobs are added by container_workqueue_schedule_next.
  *
  * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
- * @param [in]	func		Pointer to worker function.
+ * @param [in]	key			Pointer to string for the plugin key.
+ * @param [in]	args		Pointer to argument string for the plugin.
  * @param [in]	launch_after_end	The flag of launch container after worker executed. 1: launch container, 0: keep current state.
  * @return int
  * @retval 0	Success to schedule.
  * @retval -1	Already scheduled.
  * @retval -2	Arg. error.
+ * @retval -3	Fail to load plugin.
  */
 int container_workqueue_schedule(container_workqueue_t *workqueue, const char *key, const char *args, int launch_after_end)
 {
 	int ret = -1;
-	int result = -2;
 
-	if ((workqueue == NULL) || (key == NULL)) {
+	if ((workqueue == NULL) || (key == NULL) || (args == NULL)) {
 		return -2;
 	}
 
@@ -508,22 +1083,51 @@ int container_workqueue_schedule(container_workqueue_t *workqueue, const char *k
 		return -1;
 	}
 
-	ret = container_workqueue_load_plugin(workqueue, key);
-	if (ret < 0) {
+	container_workqueue_clear_job(workqueue);
+
+	ret = container_workqueue_add_job(workqueue, key, args, CONTAINER_WORKER_NO_DEPEND, CONTAINER_WORKER_RUN_ALWAYS);
+	if (ret == -3) {
 		return -3;
+	} else if (ret < 0) {
+		container_workqueue_clear_job(workqueue);
+		return -2;
+	} else {
+		;	//nop
 	}
 
-	ret = container_workqueue_set_args(workqueue, args);
-	if (ret == 0) {
-		workqueue->status = CONTAINER_WORKER_SCHEDULED;
-		workqueue->state_after_execute = launch_after_end;
-		workqueue->result = 0;
-		result = 0;
-	 } else {
-		result = -2;
-	 }
+	workqueue->status = CONTAINER_WORKER_SCHEDULED;
+	workqueue->state_after_execute = launch_after_end;
+	workqueue->result = 0;
+	workqueue->progress_phase = CM_WORKER_PHASE_PREPARE;
+	workqueue->progress_percent = -1;
 
-	return result;
+	return 0;
+}
+/**
+ * Add following job to scheduled per container workqueue.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [in]	key			Pointer to string for the plugin key.
+ * @param [in]	args		Pointer to argument string for the plugin.
+ * @param [in]	depend		Index of depend job.  Index of first job is 0.
+ * @param [in]	condition	Run condition by result of depend job. CONTAINER_WORKER_RUN_XXX.
+ * @return int
+ * @retval >=0	Success to schedule, index of added job.
+ * @retval -1	Is not scheduled workqueue or job queue is full.
+ * @retval -2	Arg. error.
+ * @retval -3	Fail to load plugin.
+ */
+int container_workqueue_schedule_next(container_workqueue_t *workqueue, const char *key, const char *args, int depend, int condition)
+{
+	if ((workqueue == NULL) || (key == NULL) || (args == NULL) || (depend < 0)) {
+		return -2;
+	}
+
+	if (workqueue->status != CONTAINER_WORKER_SCHEDULED) {
+		return -1;
+	}
+
+	return container_workqueue_add_job(workqueue, key, args, depend, condition);
 }
 
 /**
@@ -539,13 +1143,108 @@ int container_workqueue_schedule(container_workqueue_t *workqueue, const char *k
  */
 int container_workqueue_get_status(container_workqueue_t *workqueue)
 {
+	int status = CONTAINER_WORKER_DISABLE;
+
 	if (workqueue == NULL) {
 		return CONTAINER_WORKER_DISABLE;
 	}
 
-	return workqueue->status;
+	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+	status = workqueue->status;
+	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+
+	return status;
+}
+/**
+ * Get progress of per container workqueue.
+ * Progress is reported by version 2 worker plugin only.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [out]	phase		Pointer to int to store current phase. CM_WORKER_PHASE_XXX.
+ * @param [out]	percent		Pointer to int to store progress of current phase. -1 is not reported.
+ * @return int
+ * @retval 0	Success to get.
+ * @retval -1	Arg. error.
+ */
+int container_workqueue_get_progress(container_workqueue_t *workqueue, int *phase, int *percent)
+{
+	if ((workqueue == NULL) || (phase == NULL) || (percent == NULL)) {
+		return -1;
+	}
+
+	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+	(*phase) = workqueue->progress_phase;
+	(*percent) = workqueue->progress_percent;
+	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
+
+	return 0;
 }
+/**
+ * Get recovery statistics of per container workqueue.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [out]	stat		Pointer to container_recovery_stat_t to store statistics.
+ * @return int
+ * @retval 0	Success to get.
+ * @retval -1	Arg. error.
+ */
+int container_workqueue_get_recovery_stat(container_workqueue_t *workqueue, container_recovery_stat_t *stat)
+{
+	if ((workqueue == NULL) || (stat == NULL)) {
+		return -1;
+	}
+
+	(void) pthread_mutex_lock(&(workqueue->workqueue_mutex));
+	(*stat) = workqueue->recovery_stat;
+	(void) pthread_mutex_unlock(&(workqueue->workqueue_mutex));
 
+	return 0;
+}
+/**
+ * Set completion notification of per container workqueue.
+ * When worker is completed, worker thread push completion event to container manager state machine by cci.
+ * When event is set, version 2 worker plugin is dispatched in the event loop without worker thread.
+ *
+ * @param [in]	workqueue			Pointer to initialized container_workqueue_t.
+ * @param [in]	cci					Pointer to container control interface.
+ * @param [in]	container_number	Guest container number of this workqueue.
+ * @param [in]	event				Instance of sd_event. NULL is thread execution only.
+ * @return int
+ * @retval 0	Success to set.
+ * @retval -1	Arg. error.
+ */
+int container_workqueue_set_notification(container_workqueue_t *workqueue, container_control_interface_t *cci, int container_number, sd_event *event)
+{
+	if (workqueue == NULL) {
+		return -1;
+	}
+
+	workqueue->cci = cci;
+	workqueue->container_number = container_number;
+	workqueue->event = event;
+
+	return 0;
+}
+
+/**
+ * Set recovery priority of per container workqueue.
+ *
+ * @param [in]	workqueue	Pointer to initialized container_workqueue_t.
+ * @param [in]	priority	Recovery priority. Small value is high priority.
+ * @return int
+ * @retval 0	Success to set.
+ * @retval -1	Arg. error.
+ */
+int container_workqueue_set_priority(container_workqueue_t *workqueue, int priority)
+{
+	if (workqueue == NULL) {
+		return -1;
+	}
+
+	workqueue->priority = priority;
+
+	return 0;
+}
 /**
  * Per container workqueue initialize.
  *
@@ -578,6 +1277,8 @@ int container_workqueue_initialize(container_workqueue_t *workqueue)
 	workqueue->status = CONTAINER_WORKER_INACTIVE;
 	workqueue->state_after_execute = 0;
 	workqueue->result = 0;
+	workqueue->progress_percent = -1;
+	workqueue->recovery_stat.last_tier = CONTAINER_RECOVERY_TIER_NONE;
 err_ret:
 
 	(void) pthread_mutexattr_destroy(&mutex_attr);
@@ -611,6 +1312,9 @@ int container_workqueue_deinitialize(container_workqueue_t *workqueue)
 		return -2;
 	}
 
+	container_workqueue_clear_job(workqueue);
+	(void) container_workqueue_unload_plugin(workqueue);
+
 	workqueue->status = CONTAINER_WORKER_DISABLE;
 	workqueue->state_after_execute = 0;
 	(void) pthread_mutex_destroy(&(workqueue->workqueue_mutex));
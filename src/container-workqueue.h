@@ -16,7 +16,12 @@ int container_workqueue_run(container_workqueue_t *workqueue);
 int container_workqueue_cancel(container_workqueue_t *workqueue);
 int container_workqueue_remove(container_workqueue_t *workqueue, int *after_execute);
 int container_workqueue_schedule(container_workqueue_t *workqueue, const char *key, const char *args, int launch_after_end);
+int container_workqueue_schedule_next(container_workqueue_t *workqueue, const char *key, const char *args, int depend, int condition);
 int container_workqueue_get_status(container_workqueue_t *workqueue);
+int container_workqueue_get_progress(container_workqueue_t *workqueue, int *phase, int *percent);
+int container_workqueue_get_recovery_stat(container_workqueue_t *workqueue, container_recovery_stat_t *stat);
+int container_workqueue_set_notification(container_workqueue_t *workqueue, container_control_interface_t *cci, int container_number, sd_event *event);
+int container_workqueue_set_priority(container_workqueue_t *workqueue, int priority);
 int container_workqueue_initialize(container_workqueue_t *workqueue);
 int container_workqueue_deinitialize(container_workqueue_t *workqueue);
 
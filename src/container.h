@@ -48,6 +48,11 @@
  * @brief	Disk mount redundancy type is AB (Automatically run mkfs in case of mount fail). It use at s_container_baseconfig_extradisk.redundancy.
  */
 #define DISKREDUNDANCY_TYPE_MKFS	(3)
+/**
+ * @def	DISKREDUNDANCY_TYPE_CLONE
+ * @brief	Disk mount redundancy type is clone (Automatically write template image and grow it in case of mount fail). It use at s_container_baseconfig_extradisk.redundancy.
+ */
+#define DISKREDUNDANCY_TYPE_CLONE	(4)
 /**
  * @def	DISKREDUNDANCY_TYPE_AB
  * @brief	Disk mount redundancy type is fsck (Automatically run file system check in case of mount fail). It use at s_container_baseconfig_extradisk.redundancy.
@@ -58,6 +63,31 @@
  * @brief	Disk mount redundancy type is AB (Automatically run mkfs in case of mount fail). It use at s_container_baseconfig_extradisk.redundancy.
  */
 #define DEVICE_TYPE_HOST_ROOTFILESYSTEM	(1)
+/**
+ * @def	FSERROR_POLICY_NONE
+ * @brief	File system error policy is log only. It use at s_container_baseconfig.fserror_policy.
+ */
+#define FSERROR_POLICY_NONE			(0)
+/**
+ * @def	FSERROR_POLICY_REMOUNT_RO
+ * @brief	File system error policy is remount read only. It use at s_container_baseconfig.fserror_policy.
+ */
+#define FSERROR_POLICY_REMOUNT_RO	(1)
+/**
+ * @def	FSERROR_POLICY_FSCK
+ * @brief	File system error policy is fsck at next guest start. It use at s_container_baseconfig.fserror_policy.
+ */
+#define FSERROR_POLICY_FSCK			(2)
+/**
+ * @def	FSERROR_POLICY_RESTART
+ * @brief	File system error policy is restart guest now with fsck. It use at s_container_baseconfig.fserror_policy.
+ */
+#define FSERROR_POLICY_RESTART		(3)
+/**
+ * @def	ROOTFS_OVERLAY_SIZE_DEFAULT
+ * @brief	Default size of volatile tmpfs upper layer in rootfs overlay mode. It use at s_container_baseconfig_rootfs.overlay_size.
+ */
+#define ROOTFS_OVERLAY_SIZE_DEFAULT	"32M"
 /**
  * @struct	s_container_baseconfig_rootfs
  * @brief	The data structure for container root filesystem.  It's a part of s_container_baseconfig.
@@ -69,8 +99,11 @@ struct s_container_baseconfig_rootfs {
 	char *option;			/**< file system specific mount option. (ex. data=ordered,errors=remount-ro at ext4)*/
 	int device_type;	/**< rootfs device type. (block device = DEVICE_TYPE_BLOCK/ path of host rootfilesystem = DEVICE_TYPE_HOST_ROOTFILESYSTEM) */
 	char *rootfs_dev[2];	/**< rootfilesystem device for rootfs with A/B update. 0=a.1=b */
+	char *overlay_size;		/**< Size of volatile tmpfs upper layer in overlay mode. (ex. 64M) NULL is overlay disabled. */
+	char *overlay_path;		/**< tmpfs mount path in host for overlay upper and work directory. */
 	//--- internal control data
 	int is_mounted;		/**< rootfs is mounted or not. 0: not mounted. 1: mounted.*/
+	int is_overlay_mounted;	/**< overlay and tmpfs upper layer are mounted or not. 0: not mounted. 1: mounted.*/
 	int error_count;		/**< mount error count of rootfs. That exclude busy error.*/
 };
 typedef struct s_container_baseconfig_rootfs container_baseconfig_rootfs_t;	/**< typedef for struct s_container_baseconfig_rootfs. */
@@ -88,9 +121,13 @@ struct s_container_baseconfig_extradisk {
 	char *option;			/**< file system specific mount option. (ex. data=ordered,errors=remount-ro at ext4)*/
 	int	redundancy;			/**< redundancy mode. (failover=DISKREDUNDANCY_TYPE_FAILOVER/ab=DISKREDUNDANCY_TYPE_AB) */
 	char *blockdev[2];		/**< block device for rootfs primary and secondary. */
+	char *template_image;	/**< template file system image for clone redundancy. */
 	//--- internal control data
 	int is_mounted;			/**< This extra disk is mounted or not. 0: not mounted. 1: mounted.*/
 	int error_count;		/**< mount error count of this extra disk. That exclude busy error.*/
+	int64_t mount_time_ms;	/**< Latency of last mount operation of this extra disk (ms). */
+	int fs_error_pending;	/**< File system error was reported while mounted, need to recover at next guest start (=1). */
+	int failover_cache;		/**< Mounted disk of failover redundancy in previous guest start. 0: not cached, 1: primary, 2: secondary. */
 };
 typedef struct s_container_baseconfig_extradisk container_baseconfig_extradisk_t;	/**< typedef for struct s_container_baseconfig_extradisk. */
 /**
@@ -179,6 +216,7 @@ struct s_container_baseconfig {
 	container_baseconfig_tty_t tty;				/**< The data structure for tty setting. */
 	container_baseconfig_idmaps_t idmaps;		/**< The data structure for id mapping to use unprivileged container. */
 	struct dl_list envlist;						/**< Double link list for s_container_baseconfig_env. */
+	int fserror_policy;							/**< Policy for file system error that is reported while guest running. FSERROR_POLICY_XXX. */
 	//--- internal control data
 	int abboot;									/**< Reserved. */
 };
@@ -232,6 +270,11 @@ struct s_container_resource {
 };
 typedef struct s_container_resource container_resource_t;	/**< typedef for struct s_container_resource. */
 
+struct s_cgroup_device_bpf;
+typedef struct s_cgroup_device_bpf cgroup_device_bpf_t;	/**< typedef for struct s_cgroup_device_bpf. */
+struct s_cgroup_devices_ctrlfile;
+typedef struct s_cgroup_devices_ctrlfile cgroup_devices_ctrlfile_t;	/**< typedef for struct s_cgroup_devices_ctrlfile. */
+
 /**
  * @struct	s_container_resourceconfig
  * @brief	The data structure for container resource control settings.  It's including resource control config for guest container.
@@ -244,6 +287,8 @@ struct s_container_resourceconfig {
 	char *cgroup_path_container;								/**< A mirror for lxc.cgroup.dir.container. */
 	char *cgroup_path_monitor;									/**< A mirror for lxc.cgroup.dir.monitor. */
 	char *cgroup_subpath_container_inner;						/**< A mirror for lxc.cgroup.dir.container.inner. */
+	cgroup_device_bpf_t *cgroup_device_bpf;						/**< The cgroup v2 device controller for this guest. */
+	cgroup_devices_ctrlfile_t *cgroup_devices_ctrlfile;			/**< The persistent cgroup v1 devices control files for this guest. */
 };
 typedef struct s_container_resourceconfig container_resourceconfig_t;	/**< typedef for struct s_container_resourceconfig. */
 //-----------------------------------------------------------------------------
@@ -595,6 +640,58 @@ typedef struct s_container_deviceconfig container_deviceconfig_t;	/**< typedef f
  */
 #define STATICNETIF_VXCAN	(2)
 
+/**
+ * @def	STATICNETIF_MACVLAN
+ * @brief	Static network interface type is macvlan.  It use in static network interface setting.
+ */
+#define STATICNETIF_MACVLAN	(3)
+
+/**
+ * @def	STATICNETIF_IPVLAN
+ * @brief	Static network interface type is ipvlan.  It use in static network interface setting.
+ */
+#define STATICNETIF_IPVLAN	(4)
+
+/**
+ * @def	NETIF_SHAPING_CLASS_MAX
+ * @brief	Maximum number of priority classes in one shaping direction.
+ */
+#define NETIF_SHAPING_CLASS_MAX	(8)
+
+/**
+ * @struct	s_netif_shaping_class
+ * @brief	The data structure for one priority class of traffic shaping.
+ */
+struct s_netif_shaping_class {
+	uint64_t rate;		/**< Guaranteed rate (bytes per sec). */
+	uint64_t ceil;		/**< Maximum rate with borrowing (bytes per sec). */
+	uint32_t priority;	/**< Priority to borrow spare bandwidth. 0 is highest. */
+	int dscp;			/**< IPv4 DSCP value to classify into this class. -1 is default class. */
+};
+typedef struct s_netif_shaping_class netif_shaping_class_t;	/**< typedef for struct s_netif_shaping_class. */
+
+/**
+ * @struct	s_netif_shaping_direction
+ * @brief	The data structure for traffic shaping setting of one direction.
+ */
+struct s_netif_shaping_direction {
+	uint64_t rate;		/**< Total rate limit (bytes per sec).  0 is no limit. */
+	uint32_t burst;		/**< Burst size (bytes).  0 is automatic. */
+	int num_of_class;	/**< Number of classes. */
+	netif_shaping_class_t classes[NETIF_SHAPING_CLASS_MAX];	/**< Priority classes. Support to_guest direction only. */
+};
+typedef struct s_netif_shaping_direction netif_shaping_direction_t;	/**< typedef for struct s_netif_shaping_direction. */
+
+/**
+ * @struct	s_netif_shaping
+ * @brief	The data structure for traffic shaping setting of guest network interface.  It's applied to host side peer.
+ */
+struct s_netif_shaping {
+	netif_shaping_direction_t to_guest;		/**< Traffic from host to guest. Shaped by htb at host side peer egress. */
+	netif_shaping_direction_t from_guest;	/**< Traffic from guest to host. Policed at host side peer ingress. */
+};
+typedef struct s_netif_shaping netif_shaping_t;	/**< typedef for struct s_netif_shaping. */
+
 /**
  * @struct	s_netif_elem_veth
  * @brief	The data structure for veth setting.  It's assign to s_container_static_netif_elem.setting in case of type is STATICNETIF_VETH.
@@ -607,9 +704,69 @@ struct s_netif_elem_veth {
 	char *mode;		/**< veth mode. bridge or router. */
 	char *address;	/**< Initial ip address setting for veth. - ipv4. */
 	char *gateway;	/**< Initial default gateway setting for veth. - ipv4. */
+	netif_shaping_t *shaping;	/**< Traffic shaping setting. NULL is no shaping. */
+	//--- internal control data
+	char *peer_host;	/**< The veth name of host. It is set when pre-created by network preparation stage. */
+	char *peer_guest;	/**< The veth name of guest. It is set when pre-created by network preparation stage. */
+	int is_prepared;	/**< The veth pair is pre-created and not used yet (=1). */
 };
 typedef struct s_netif_elem_veth netif_elem_veth_t;	/**< typedef for struct s_netif_elem_veth. */
 
+/**
+ * @struct	s_netif_elem_macvlan
+ * @brief	The data structure for macvlan setting.  It's assign to s_container_static_netif_elem.setting in case of type is STATICNETIF_MACVLAN.
+ */
+struct s_netif_elem_macvlan {
+	char *name;		/**< The name of macvlan. */
+	char *link;		/**< Lower network interface in host. */
+	char *flags;	/**< Initial flag setting of macvlan if. up or down. */
+	char *hwaddr;	/**< MAC address setting for macvlan. */
+	char *mode;		/**< macvlan mode. private, vepa or bridge. */
+	char *address;	/**< Initial ip address setting for macvlan. - ipv4. */
+	char *gateway;	/**< Initial default gateway setting for macvlan. - ipv4. */
+};
+typedef struct s_netif_elem_macvlan netif_elem_macvlan_t;	/**< typedef for struct s_netif_elem_macvlan. */
+
+/**
+ * @struct	s_netif_elem_ipvlan
+ * @brief	The data structure for ipvlan setting.  It's assign to s_container_static_netif_elem.setting in case of type is STATICNETIF_IPVLAN.
+ */
+struct s_netif_elem_ipvlan {
+	char *name;			/**< The name of ipvlan. */
+	char *link;			/**< Lower network interface in host. */
+	char *flags;		/**< Initial flag setting of ipvlan if. up or down. */
+	char *mode;			/**< ipvlan mode. l2, l3 or l3s. */
+	char *isolation;	/**< ipvlan isolation. bridge, private or vepa. */
+	char *address;		/**< Initial ip address setting for ipvlan. - ipv4. */
+	char *gateway;		/**< Initial default gateway setting for ipvlan. - ipv4. */
+};
+typedef struct s_netif_elem_ipvlan netif_elem_ipvlan_t;	/**< typedef for struct s_netif_elem_ipvlan. */
+
+/**
+ * @struct	s_netif_vxcan_filter
+ * @brief	The data structure for CAN gateway filter of vxcan.  Frame is passed when (frame id & can_mask) == (can_id & can_mask).
+ */
+struct s_netif_vxcan_filter {
+	uint32_t can_id;		/**< CAN ID for filter. */
+	uint32_t can_mask;		/**< CAN ID mask for filter. */
+	int is_rewrite;			/**< Rewrite CAN ID of passed frame (=1) or not (=0). */
+	uint32_t rewrite_id;	/**< New CAN ID to rewrite.  It is valid in case of is_rewrite == 1. */
+};
+typedef struct s_netif_vxcan_filter netif_vxcan_filter_t;	/**< typedef for struct s_netif_vxcan_filter. */
+
+/**
+ * @struct	s_netif_vxcan_stat
+ * @brief	The data structure for vxcan CAN gateway statistics.  Counters are sum of all rules.
+ */
+struct s_netif_vxcan_stat {
+	uint64_t rx_handled;	/**< Handled frames from upstream to guest. */
+	uint64_t rx_dropped;	/**< Dropped frames from upstream to guest. */
+	uint64_t tx_handled;	/**< Handled frames from guest to upstream. */
+	uint64_t tx_dropped;	/**< Dropped frames from guest to upstream. */
+	int64_t timestamp;		/**< Sampled time (ms). */
+};
+typedef struct s_netif_vxcan_stat netif_vxcan_stat_t;	/**< typedef for struct s_netif_vxcan_stat. */
+
 /**
  * @struct	s_netif_elem_vxcan
  * @brief	The data structure for vxcan setting.  It's assign to s_container_static_netif_elem.setting in case of type is STATICNETIF_VXCAN.
@@ -617,9 +774,15 @@ typedef struct s_netif_elem_veth netif_elem_veth_t;	/**< typedef for struct s_ne
 struct s_netif_elem_vxcan {
 	char *name;		/**< The name of vxcan. */
 	char *upstream;		/**< Upstream CAN interface. */
+	netif_vxcan_filter_t *rx_filter;	/**< CAN gateway filters from upstream to guest.  When num_of_rx_filter is 0, all frames are forwarded. */
+	int num_of_rx_filter;				/**< Number of rx_filter. */
+	netif_vxcan_filter_t *tx_filter;	/**< CAN gateway filters from guest to upstream.  When num_of_tx_filter is 0, no frame is forwarded. */
+	int num_of_tx_filter;				/**< Number of tx_filter. */
 	//--- internal control data
 	char *peer_host;	/**< The vxcan name of host */
 	char *peer_guest;	/**< The vxcan name of guest */
+	int is_prepared;	/**< The vxcan pair is pre-created by network preparation stage and not used yet (=1). */
+	netif_vxcan_stat_t last_stat;	/**< Last sampled CAN gateway statistics.  Use to calculate frame rate. */
 };
 typedef struct s_netif_elem_vxcan netif_elem_vxcan_t;	/**< typedef for struct s_netif_elem_vxcan. */
 
@@ -629,7 +792,7 @@ typedef struct s_netif_elem_vxcan netif_elem_vxcan_t;	/**< typedef for struct s_
  */
 struct s_container_static_netif_elem {
 	struct dl_list list;	/**< Double link list header. */
-	int type;				/**< Static network interface type. Currently support only STATICNETIF_VETH. */
+	int type;				/**< Static network interface type. STATICNETIF_VETH, STATICNETIF_VXCAN, STATICNETIF_MACVLAN or STATICNETIF_IPVLAN. */
 	void *setting;			/**< Network interface specific setting. Need to cast to real type by type member. */
 };
 typedef struct s_container_static_netif_elem container_static_netif_elem_t;	/**< typedef for struct s_container_static_netif_elem. */
@@ -710,6 +873,66 @@ typedef int (*container_worker_func_t)(void);
 
 struct s_cm_worker_object;
 
+/**
+ * @def	CONTAINER_WORKQUEUE_JOB_MAX
+ * @brief	Maximum number of jobs in per container workqueue.
+ */
+#define CONTAINER_WORKQUEUE_JOB_MAX	(4)
+/**
+ * @def	CONTAINER_WORKER_NO_DEPEND
+ * @brief	Job does not depend on other job.  It use at s_container_workqueue_job.depend.
+ */
+#define CONTAINER_WORKER_NO_DEPEND	(-1)
+/**
+ * @def	CONTAINER_WORKER_RUN_ALWAYS
+ * @brief	Job run when depend job is completed without cancel.
+ */
+#define CONTAINER_WORKER_RUN_ALWAYS	(0)
+/**
+ * @def	CONTAINER_WORKER_RUN_ON_SUCCESS
+ * @brief	Job run when depend job is succeeded.
+ */
+#define CONTAINER_WORKER_RUN_ON_SUCCESS	(1)
+/**
+ * @def	CONTAINER_WORKER_RUN_ON_FAIL
+ * @brief	Job run when depend job is failed.
+ */
+#define CONTAINER_WORKER_RUN_ON_FAIL	(2)
+
+/**
+ * @struct	s_container_workqueue_job
+ * @brief	The data structure for one job in per container workqueue.
+ */
+struct s_container_workqueue_job {
+	struct s_cm_worker_object *object;		/**< Worker object to execute this job. It's owned by plugin cache. */
+	char *args;								/**< Argument string for the worker plugin. */
+	int depend;								/**< Index of job that this job depends on. CONTAINER_WORKER_NO_DEPEND is no dependency. */
+	int condition;							/**< Run condition by result of depend job. CONTAINER_WORKER_RUN_XXX. */
+	int is_executed;						/**< Executed flag. 1: executed, 0: not executed or skipped. */
+	int result;								/**< Result of this job. 1: cancel, 0: success, -1: fail.*/
+};
+typedef struct s_container_workqueue_job container_workqueue_job_t;	/**< typedef for struct s_container_workqueue_job. */
+
+#define CONTAINER_RECOVERY_TIER_JOURNAL		(0)	/**< Recovered by journal replay. */
+#define CONTAINER_RECOVERY_TIER_CHECK		(1)	/**< Recovered by file system check. */
+#define CONTAINER_RECOVERY_TIER_RECREATE	(2)	/**< Recovered by file system recreation (mkfs, clone or erase). */
+#define CONTAINER_RECOVERY_TIER_MAX			(3)	/**< Number of recovery tier. */
+#define CONTAINER_RECOVERY_TIER_NONE		(-1)	/**< Not recovered. */
+
+/**
+ * @struct	s_container_recovery_stat
+ * @brief	The data structure for recovery statistics of per container workqueue.
+ */
+struct s_container_recovery_stat {
+	uint32_t count[CONTAINER_RECOVERY_TIER_MAX];		/**< Number of recovery that was succeeded at each tier. */
+	int64_t total_time_ms[CONTAINER_RECOVERY_TIER_MAX];	/**< Total recovery time at each tier (ms). */
+	int64_t max_time_ms[CONTAINER_RECOVERY_TIER_MAX];	/**< Maximum recovery time at each tier (ms). */
+	uint32_t failed;									/**< Number of recovery that was failed at all tier. */
+	int last_tier;										/**< Succeeded tier of last recovery. CONTAINER_RECOVERY_TIER_XXX. */
+	int64_t last_time_ms;								/**< Time of last recovery (ms). */
+};
+typedef struct s_container_recovery_stat container_recovery_stat_t;	/**< typedef for struct s_container_recovery_stat. */
+
 /**
  * @struct	s_container_workqueue
  * @brief	The data structure for per container extra operation.
@@ -717,10 +940,25 @@ struct s_cm_worker_object;
 struct s_container_workqueue {
 	pthread_t worker_thread;				/**< Worker thread object. */
 	pthread_mutex_t workqueue_mutex;		/**< Mutex for container workqueue. */
-	struct s_cm_worker_object *object;		/**< Worker object.*/
+	struct s_cm_worker_object *object;		/**< Worker object of current job.*/
+	struct s_cm_worker_object *plugin_cache;	/**< Loaded worker plugins.  It's reused across jobs until deinitialize. */
+	container_workqueue_job_t job[CONTAINER_WORKQUEUE_JOB_MAX];	/**< Queued jobs. Jobs are executed by index order. */
+	int num_of_job;							/**< Number of queued jobs. */
+	int current_job;						/**< Index of current job. */
+	int cancel_request;						/**< Cancel request for queued jobs. */
+	int priority;							/**< Recovery priority of this workqueue. It use at global recovery scheduler. */
+	recovery_ticket_t ticket;				/**< Recovery scheduler ticket for physical disk of queued jobs. */
 	int status;								/**< Status of this workqueue. */
 	int state_after_execute;				/**< Container state after workqueue execute. Keep stop: 0. Restart: 1. Other: error.*/
 	int result;								/**< Result of worker execute. 1: cancel, 0: success, -1: fail.*/
+	struct s_container_control_interface *cci;	/**< Container control interface to notify worker completion. NULL is no notification. */
+	int container_number;					/**< Guest container number to use worker completion notification. */
+	sd_event *event;						/**< Event loop to dispatch version 2 worker plugin. NULL is thread execution only. */
+	sd_event_source *worker_source;			/**< Event source for in-loop worker dispatch. */
+	int progress_phase;						/**< Last reported phase of worker. CM_WORKER_PHASE_XXX. */
+	int progress_percent;					/**< Last reported progress of worker (0-100). -1 is not reported. */
+	int64_t start_time;						/**< Start time of queued jobs (ms). */
+	container_recovery_stat_t recovery_stat;	/**< Recovery statistics.  It's kept across jobs. */
 };
 typedef struct s_container_workqueue container_workqueue_t;	/**< typedef for struct s_container_workqueue. */
 
@@ -767,6 +1005,18 @@ typedef struct s_container_workqueue container_workqueue_t;	/**< typedef for str
  */
 #define CONTAINER_RUN_WORKER	(7)
 
+/**
+ * @struct	s_container_fserror_stat
+ * @brief	The data structure for file system error statistics of guest disks.
+ */
+struct s_container_fserror_stat {
+	uint32_t count;			/**< Number of file system error that was reported while mounted. */
+	int last_error;			/**< Error code (errno) of last file system error. 0 is unknown. */
+	int64_t last_time;		/**< Time of last file system error (ms). */
+	const char *last_path;	/**< Mount path of the disk that reported last file system error. */
+};
+typedef struct s_container_fserror_stat container_fserror_stat_t;	/**< typedef for struct s_container_fserror_stat. */
+
 /**
  * @struct	s_container_runtime_status
  * @brief	The runtime data of this guest container.
@@ -778,6 +1028,11 @@ struct s_container_runtime_status {
 	int launch_error_count;			/**< A error counter for launch. */
 	pid_t pid;						/**< A pid of guest container init process. */
 	sd_event_source *pidfd_source;	/**< A pidfd event source for guest container init process. It use guest monitoring. */
+	int netns_fd;					/**< A cached fd of network namespace for guest container. It use dynamic network interface assignment. */
+	pid_t netns_pid;				/**< A pid of guest container init process that netns_fd was opened from. */
+	container_fserror_stat_t fserror;	/**< File system error statistics of guest disks. */
+	const char *wait_device;		/**< Mandatory block device that is not present yet. Launch is retried at device add event or wait_timeout. NULL is not waiting. */
+	int64_t wait_timeout;			/**< Timeout point of device waiting. */
 };
 typedef struct s_container_runtime_status container_runtime_status_t;	/**< typedef for struct s_container_runtime_status. */
 //-----------------------------------------------------------------------------
@@ -827,6 +1082,9 @@ typedef struct s_container_control_interface container_control_interface_t;
  * @struct	s_containers
  * @brief	The top data structure for container manager.  It’s include all of data for container manager.
  */
+struct s_container_netif_index;
+typedef struct s_container_netif_index container_netif_index_t;	/**< typedef for struct s_container_netif_index. */
+
 struct s_containers {
 	container_manager_config_t *cmcfg;	/**< Global config for container manager*/
 
@@ -837,6 +1095,7 @@ struct s_containers {
 	container_mngsm_t *cms;				/**< container management state machine */
 	container_control_interface_t *cci;	/**< container control interface */
 	dynamic_device_manager_t *ddm;		/**< dynamic device manager */
+	container_netif_index_t *netif_index;	/**< Ownership index for dynamic network interface */
 
 	sd_event *event;					/**< Systemd event loop object at main loop. */
 };
@@ -12,7 +12,11 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
 #include <sys/sysmacros.h>
+#include <linux/netlink.h>
+#include <libmnl/libmnl.h>
 
 #include "container.h"
 #include "lxc-util.h"
@@ -29,31 +33,45 @@ struct s_dynamic_device_udev {
 	struct udev* pudev;					/**< The udev object created by libudev. */
 	struct udev_monitor *pudev_monitor;	/**< The udev_monitor object created by libudev.  */
 	sd_event_source *libudev_source ;	/**< The sd event source controlled by libudev. */
+	struct mnl_socket *uevent_nl;		/**< The kernel uevent netlink socket for raw uevent mode. */
+	sd_event_source *uevent_source;		/**< The sd event source for raw uevent mode. */
 	containers_t *cs;					/**< Pointer to the top data structure for container manager. */
 };
 
+/**
+ * @def	DCD_RAW_UEVENT_RCVBUF_SIZE
+ * @brief	Socket receive buffer size for the kernel uevent netlink socket in raw uevent mode.
+ */
+#define DCD_RAW_UEVENT_RCVBUF_SIZE	(1024 * 1024)
+
+/**
+ * @def	DCD_RAW_UEVENT_DEVNODE_MAX
+ * @brief	Buffer size for the device node path that is created from the DEVNAME property in raw uevent mode.
+ */
+#define DCD_RAW_UEVENT_DEVNODE_MAX	(256)
+
 /**
  * The function pointer type for subsystem specific assignment rule check.
  *
  * @param [in]	extra_list	Extra rule list from container config.
- * @param [in]	pdev		Pointer to struct udev_device.
+ * @param [in]	devnode		Device node path for target device. (ex. /dev/sda1)
  * @param [in]	action		Uevent action.
  * @return int
  * @retval	1	Match to rule.
  * @retval	0	Not match to rule.
  * @retval	-1	Generic error.
  */
-typedef int (*extra_checker_func_t)(struct dl_list *extra_list,  struct udev_device *pdev, int action);
+typedef int (*extra_checker_func_t)(struct dl_list *extra_list, const char *devnode, int action);
 
 /**
  * @struct	s_uevent_device_info
  * @brief	The data structure for device assignment rule check.
  */
 struct s_uevent_device_info {
-	const char *devpath;	/**< The devpath property from libudev. */
-	const char *subsystem;	/**< The subsystem property from libudev. */
-	const char *action;		/**< The action property from libudev. */
-	const char *devtype;	/**< The devtype property from libudev. */
+	const char *devpath;	/**< The devpath property from uevent. */
+	const char *subsystem;	/**< The subsystem property from uevent. */
+	const char *action;		/**< The action property from uevent. */
+	const char *devtype;	/**< The devtype property from uevent. */
 	extra_checker_func_t checker_func;	/**< The function pointer for subsystem specific assignment rule check. */
 };
 typedef struct s_uevent_device_info uevent_device_info_t;	/**< typedef for struct s_uevent_device_info. */
@@ -79,15 +97,22 @@ static const char *force_exclude_fs[] = {
 };
 
 static int device_control_dynamic_udev_devevent(dynamic_device_manager_t *ddm);
+static int device_control_dynamic_raw_devevent(dynamic_device_manager_t *ddm);
 static int device_control_dynamic_udev_create_info(uevent_device_info_t *udi, lxcutil_dynamic_device_request_t *lddr, struct udev_list_entry *le);
-static container_config_t *device_control_dynamic_udev_get_target_container(containers_t *cs, uevent_device_info_t *udi, struct udev_device *pdev
+static int device_control_dynamic_raw_create_info(uevent_device_info_t *udi, lxcutil_dynamic_device_request_t *lddr, const char *buf, size_t length);
+static void device_control_dynamic_raw_strip_seqnum(uevent_injection_message_t *uim);
+static void device_control_dynamic_set_info_elem(uevent_device_info_t *udi, lxcutil_dynamic_device_request_t *lddr
+												, const char *elem_name, size_t name_length, const char *elem_value);
+static int device_control_dynamic_device_operation(containers_t *cs, uevent_device_info_t *udi, lxcutil_dynamic_device_request_t *lddr
+													, container_config_t **target, dynamic_device_entry_items_behavior_t **behavior);
+static container_config_t *device_control_dynamic_udev_get_target_container(containers_t *cs, uevent_device_info_t *udi, const char *devnode
 																			, dynamic_device_entry_items_behavior_t **behavior);
-static int device_control_dynamic_udev_rule_judgment(container_config_t *cc, uevent_device_info_t *udi, struct udev_device *pdev
+static int device_control_dynamic_udev_rule_judgment(container_config_t *cc, uevent_device_info_t *udi, const char *devnode
 													, dynamic_device_entry_items_behavior_t **behavior);
 static int device_control_dynamic_udev_create_injection_message(uevent_injection_message_t *uim, uevent_device_info_t *udi, struct udev_list_entry *le);
 static int device_control_dynamic_udev_get_uevent_action_code(const char *actionstr);
 
-static int extra_checker_block_device(struct dl_list *extra_list,  struct udev_device *pdev, int action);
+static int extra_checker_block_device(struct dl_list *extra_list, const char *devnode, int action);
 
 /**
  * Event handler for libudev.
@@ -126,6 +151,43 @@ static int udev_event_handler(sd_event_source *event, int fd, uint32_t revents,
 
 	return ret;
 }
+/**
+ * Event handler for kernel uevent netlink socket (raw uevent mode).
+ * This function analyze received uevent from kernel directly.
+ *
+ * @param [in]	event		Kernel uevent netlink event source object.
+ * @param [in]	fd			File descriptor for kernel uevent netlink socket.
+ * @param [in]	revents		Active event (epoll).
+ * @param [in]	userdata	Pointer to dynamic_device_manager_t.
+ * @return int
+ * @retval	0	Success to event handling.
+ * @retval	-1	Internal error (Not use).
+ */
+static int raw_uevent_event_handler(sd_event_source *event, int fd, uint32_t revents, void *userdata)
+{
+	int ret = 0;
+	dynamic_device_manager_t *ddm = NULL;
+
+	if (userdata == NULL) {
+		// Fail safe - disable uevent event
+		sd_event_source_disable_unref(event);
+		return 0;
+	}
+
+	ddm = (dynamic_device_manager_t*)userdata;
+
+	if ((revents & (EPOLLHUP | EPOLLERR)) != 0) {
+		// Fail safe - disable uevent event
+		sd_event_source_disable_unref(event);
+	} else if ((revents & EPOLLIN) != 0) {
+		// Receive
+		(void)device_control_dynamic_raw_devevent(ddm);
+	} else {
+		;	//nop
+	}
+
+	return ret;
+}
 
 /**
  * Sub function for uevent monitor.
@@ -163,34 +225,17 @@ static int device_control_dynamic_udev_devevent(dynamic_device_manager_t *ddm)
 	}
 
 	ret = device_control_dynamic_udev_create_info(&udi, &lddr, le);
-	if (ret == 0) {
-		#ifdef _PRINTF_DEBUG_
-		(void) fprintf(stdout,"udi: action=%s devpath=%s devtype=%s subsystem=%s\n", udi.action, udi.devpath, udi.devtype, udi.subsystem);
-		#endif
-
-		cc = device_control_dynamic_udev_get_target_container(ddu->cs, &udi, pdev, &behavior);
-		if (cc == NULL) {
-			goto bypass_ret;	// Not match rule
-		}
-	} else {
+	if (ret < 0) {
 		goto bypass_ret;	// Not match rule
 	}
 
-	if ((behavior->devnode == 1) || (behavior->allow == 1)) {
-		if (behavior->devnode == 1) {
-			lddr.is_create_node = 1;
-		}
-
-		if (behavior->allow == 1) {
-			lddr.is_allow_device = 1;
-		}
-
-		lddr.permission = behavior->permission;
-
-		ret = lxcutil_dynamic_device_operation(cc, &lddr);
-		if (ret < 0){
-			goto error_ret;
-		}
+	ret = device_control_dynamic_device_operation(ddu->cs, &udi, &lddr, &cc, &behavior);
+	if (ret == 0) {
+		goto bypass_ret;	// Not match rule
+	} else if (ret < 0) {
+		goto error_ret;
+	} else {
+		;	//nop
 	}
 
 	le = udev_device_get_properties_list_entry(pdev);
@@ -228,6 +273,151 @@ error_ret:
 	return -1;
 }
 
+/**
+ * Sub function for uevent monitor.
+ * This function select target container and do device allow/deny and device node operation.
+ * It's common part for libudev mode and raw uevent mode.
+ *
+ * @param [in]	cs			Pointer to containers_t.
+ * @param [in]	udi			Pointer to uevent_device_info_t.
+ * @param [in]	lddr		Pointer to lxcutil_dynamic_device_request_t.
+ * @param [out]	target		Double pointer to container_config_t. It use to get reference to the target container.
+ * @param [out]	behavior	Double pointer to dynamic_device_entry_items_behavior_t.
+ * @return int
+ * @retval	1	Success to device operation.
+ * @retval	0	Not match rule.
+ * @retval	-1	Internal error.
+ */
+static int device_control_dynamic_device_operation(containers_t *cs, uevent_device_info_t *udi, lxcutil_dynamic_device_request_t *lddr
+													, container_config_t **target, dynamic_device_entry_items_behavior_t **behavior)
+{
+	int ret = -1;
+	container_config_t *cc = NULL;
+
+	if ((udi->action == NULL) || (udi->devpath == NULL) || (udi->subsystem == NULL)) {
+		return 0;	// Incomplete uevent, not match rule.
+	}
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"udi: action=%s devpath=%s devtype=%s subsystem=%s\n", udi->action, udi->devpath, udi->devtype, udi->subsystem);
+	#endif
+
+	cc = device_control_dynamic_udev_get_target_container(cs, udi, lddr->devnode, behavior);
+	if (cc == NULL) {
+		return 0;	// Not match rule
+	}
+
+	if (((*behavior)->devnode == 1) || ((*behavior)->allow == 1)) {
+		if ((*behavior)->devnode == 1) {
+			lddr->is_create_node = 1;
+		}
+
+		if ((*behavior)->allow == 1) {
+			lddr->is_allow_device = 1;
+		}
+
+		lddr->permission = (*behavior)->permission;
+
+		ret = lxcutil_dynamic_device_operation(cc, lddr);
+		if (ret < 0){
+			return -1;
+		}
+	}
+
+	(*target) = cc;
+
+	return 1;
+}
+/**
+ * Sub function for uevent monitor (raw uevent mode).
+ * This function receive uevent from kernel, analyze it and forward original payload to guest if necessary.
+ *
+ * @param [in]	ddm	Pointer to dynamic_device_manager_t.
+ * @return int
+ * @retval	0	Success to get device info.
+ * @retval	-1	Internal error.
+ * @retval	-2	Argument error. (Reserve)
+ */
+static int device_control_dynamic_raw_devevent(dynamic_device_manager_t *ddm)
+{
+	int ret = -1;
+	ssize_t sret = -1;
+	struct s_dynamic_device_udev *ddu = NULL;
+	struct sockaddr_nl addr;
+	socklen_t addrlen = 0;
+	uevent_device_info_t udi;
+	lxcutil_dynamic_device_request_t lddr;
+	uevent_injection_message_t uim;
+	container_config_t *cc = NULL;
+	dynamic_device_entry_items_behavior_t *behavior = NULL;
+	char devnode[DCD_RAW_UEVENT_DEVNODE_MAX];
+
+	ddu = (struct s_dynamic_device_udev*)ddm->ddu;
+
+	// Receive to injection buffer directly, forward original payload without rebuild.
+	(void) memset(&addr, 0, sizeof(addr));
+	addrlen = sizeof(addr);
+	sret = recvfrom(mnl_socket_get_fd(ddu->uevent_nl), uim.message, sizeof(uim.message) - 1, (MSG_DONTWAIT | MSG_TRUNC)
+					, (struct sockaddr*)&addr, &addrlen);
+	if (sret < 0) {
+		if ((errno == EAGAIN) || (errno == EINTR)) {
+			return 0;
+		}
+		return -1;
+	}
+
+	if ((size_t)sret > (sizeof(uim.message) - 1)) {
+		// Truncated uevent, drop.
+		return 0;
+	}
+
+	if ((addrlen != sizeof(addr)) || (addr.nl_pid != 0)) {
+		// Not from kernel, drop.
+		return 0;
+	}
+
+	uim.message[sret] = '\0';
+	uim.used = (int)sret;
+
+	(void) memset(&udi, 0, sizeof(udi));
+	(void) memset(&lddr, 0, sizeof(lddr));
+
+	ret = device_control_dynamic_raw_create_info(&udi, &lddr, uim.message, (size_t)sret);
+	if (ret < 0) {
+		return 0;	// Not match rule
+	}
+
+	if (lddr.devnode != NULL) {
+		// Kernel DEVNAME is not include "/dev/" prefix.
+		ret = snprintf(devnode, sizeof(devnode), "/dev/%s", lddr.devnode);
+		if (!((size_t)ret < sizeof(devnode))) {
+			return 0;	// Too long devname, drop.
+		}
+		lddr.devnode = devnode;
+	}
+
+	ret = device_control_dynamic_device_operation(ddu->cs, &udi, &lddr, &cc, &behavior);
+	if (ret <= 0) {
+		return ret;
+	}
+
+	if (behavior->injection == 1) {
+		pid_t target_pid = 0;
+
+		// Host sequence number is not forwarded, same as libudev mode.  udi and lddr are not used after this.
+		device_control_dynamic_raw_strip_seqnum(&uim);
+
+		target_pid = lxcutil_get_init_pid(cc);
+		if (target_pid >= 0) {
+			ret = uevent_injection_to_pid(target_pid, &uim);
+			if (ret < 0) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
 /**
  * Get point to /dev/ trimmed devname.
  *
@@ -357,81 +547,196 @@ static int device_control_dynamic_udev_create_info(uevent_device_info_t *udi, lx
 		elem_name = udev_list_entry_get_name(le);
 		elem_value = udev_list_entry_get_value(le);
 
-		if (strcmp(elem_name, "ACTION") == 0) {
-			// set to uevent device info
-			udi->action = elem_value;
-
-			// set to lxcutil dynamic device request
-			lddr->operation = device_control_dynamic_udev_get_uevent_action_code(elem_value);
-		} else if (strcmp(elem_name, "DEVPATH") == 0) {
-			// set to uevent device info
-			udi->devpath = elem_value;
-
-		} else if (strcmp(elem_name, "SUBSYSTEM") == 0) {
-			// set to uevent device info
-			udi->subsystem = elem_value;
-
-			// set to lxcutil dynamic device request
-			if (strcmp(elem_value, dev_subsys_block) == 0) {
-				lddr->devtype = DEVNODE_TYPE_BLK;
-				udi->checker_func = extra_checker_block_device;
-			} else if (strcmp(elem_value, dev_subsys_net) == 0) {
-				lddr->devtype = DEVNODE_TYPE_NET;
-			} else {
-				lddr->devtype = DEVNODE_TYPE_CHR;
-			}
-		} else if (strcmp(elem_name, "DEVTYPE") == 0) {
-			// set to uevent device info
-			udi->devtype = elem_value;
-
-		} else if (strcmp(elem_name, "DEVNAME") == 0) {
-			// set to lxcutil dynamic device request
-			lddr->devnode = elem_value;
-
-		} else if (strcmp(elem_name, "MAJOR") == 0) {
-			char *endptr = NULL;
-			int value = 0;
-
-			// set to lxcutil dynamic device request
-			value = strtol(elem_value, &endptr, 10);
-			if (elem_value == endptr) {
-				lddr->dev_major = -1;
-			} else {
-				lddr->dev_major = value;
-			}
-		} else if (strcmp(elem_name, "MINOR") == 0) {
-			char *endptr = NULL;
-			int value = 0;
-
-			// set to lxcutil dynamic device request
-			value = strtol(elem_value, &endptr, 10);
-			if (elem_value == endptr) {
-				lddr->dev_minor = -1;
-			} else {
-				lddr->dev_minor = value;
-			}
+		device_control_dynamic_set_info_elem(udi, lddr, elem_name, strlen(elem_name), elem_value);
+
+		le = udev_list_entry_get_next(le);
+	}
+
+	return 0;
+}
+/**
+ * Sub function for uevent monitor (raw uevent mode).
+ * This function create uevent info to use device assignment check and operations from kernel uevent payload.
+ * The kernel uevent payload is "action@devpath\0KEY=VALUE\0KEY=VALUE\0...". All pointers in udi and lddr are refer to inside of buf.
+ *
+ * @param [out]	udi		Pointer to uevent_device_info_t.
+ * @param [out]	lddr	Pointer to lxcutil_dynamic_device_request_t.
+ * @param [in]	buf		Pointer to NULL terminated kernel uevent payload.
+ * @param [in]	length	Length of kernel uevent payload.
+ * @return int
+ * @retval	0	Success to get device info.
+ * @retval	-1	Is not kernel uevent.
+ * @retval	-2	Argument error. (Reserve)
+ */
+static int device_control_dynamic_raw_create_info(uevent_device_info_t *udi, lxcutil_dynamic_device_request_t *lddr, const char *buf, size_t length)
+{
+	size_t pos = 0;
+	const char *elem = NULL;
+	const char *separator = NULL;
+
+	lddr->dev_major = -1;
+	lddr->dev_minor = -1;
+
+	// Header "action@devpath"
+	elem = &buf[0];
+	if (strchr(elem, '@') == NULL) {
+		return -1;
+	}
+	pos = strlen(elem) + 1;
+
+	// Body
+	while (pos < length) {
+		elem = &buf[pos];
+
+		separator = strchr(elem, '=');
+		if (separator != NULL) {
+			device_control_dynamic_set_info_elem(udi, lddr, elem, (size_t)(separator - elem), &separator[1]);
+		}
+
+		pos = pos + strlen(elem) + 1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function for uevent monitor (raw uevent mode).
+ * This function remove SEQNUM property from kernel uevent payload in place.
+ * Guest udevd shall not see host sequence number, it is not continuous in guest and conflict with own.
+ *
+ * @param [in,out]	uim	Pointer to uevent_injection_message_t that has kernel uevent payload.
+ * @return void
+ */
+static void device_control_dynamic_raw_strip_seqnum(uevent_injection_message_t *uim)
+{
+	static const char seqnum[] = "SEQNUM=";
+	size_t pos = 0, length = 0, elem_len = 0;
+	char *elem = NULL;
+
+	length = (size_t)uim->used;
+	pos = strlen(&uim->message[0]) + 1;
+
+	while (pos < length) {
+		elem = &uim->message[pos];
+		elem_len = strlen(elem) + 1;
+		if ((pos + elem_len) > length) {
+			// Last element without NULL term.
+			elem_len = length - pos;
+		}
+
+		if (strncmp(elem, seqnum, sizeof(seqnum) - 1) == 0) {
+			(void) memmove(elem, &elem[elem_len], length - (pos + elem_len));
+			length = length - elem_len;
 		} else {
-			;	//skip this data
+			pos = pos + elem_len;
 		}
+	}
 
-		le = udev_list_entry_get_next(le);
+	uim->message[length] = '\0';
+	uim->used = (int)length;
+}
+/**
+ * Sub function for uevent monitor.
+ * Test uevent property name.
+ *
+ * @param [in]	elem_name	The string of uevent property name. It may not be NULL terminated at name_length.
+ * @param [in]	name_length	Length of uevent property name.
+ * @param [in]	key			The NULL terminated string of compare target.
+ * @return int
+ * @retval	1	Match.
+ * @retval	0	Not match.
+ */
+static int device_control_dynamic_is_key(const char *elem_name, size_t name_length, const char *key)
+{
+	if ((strlen(key) == name_length) && (strncmp(elem_name, key, name_length) == 0)) {
+		return 1;
 	}
 
 	return 0;
 }
+/**
+ * Sub function for uevent monitor.
+ * This function set one uevent property to uevent info and dynamic device request.
+ *
+ * @param [out]	udi			Pointer to uevent_device_info_t.
+ * @param [out]	lddr		Pointer to lxcutil_dynamic_device_request_t.
+ * @param [in]	elem_name	The string of uevent property name.
+ * @param [in]	name_length	Length of uevent property name.
+ * @param [in]	elem_value	The NULL terminated string of uevent property value.
+ * @return void
+ */
+static void device_control_dynamic_set_info_elem(uevent_device_info_t *udi, lxcutil_dynamic_device_request_t *lddr
+												, const char *elem_name, size_t name_length, const char *elem_value)
+{
+	if (device_control_dynamic_is_key(elem_name, name_length, "ACTION") == 1) {
+		// set to uevent device info
+		udi->action = elem_value;
+
+		// set to lxcutil dynamic device request
+		lddr->operation = device_control_dynamic_udev_get_uevent_action_code(elem_value);
+	} else if (device_control_dynamic_is_key(elem_name, name_length, "DEVPATH") == 1) {
+		// set to uevent device info
+		udi->devpath = elem_value;
+
+	} else if (device_control_dynamic_is_key(elem_name, name_length, "SUBSYSTEM") == 1) {
+		// set to uevent device info
+		udi->subsystem = elem_value;
+
+		// set to lxcutil dynamic device request
+		if (strcmp(elem_value, dev_subsys_block) == 0) {
+			lddr->devtype = DEVNODE_TYPE_BLK;
+			udi->checker_func = extra_checker_block_device;
+		} else if (strcmp(elem_value, dev_subsys_net) == 0) {
+			lddr->devtype = DEVNODE_TYPE_NET;
+		} else {
+			lddr->devtype = DEVNODE_TYPE_CHR;
+		}
+	} else if (device_control_dynamic_is_key(elem_name, name_length, "DEVTYPE") == 1) {
+		// set to uevent device info
+		udi->devtype = elem_value;
+
+	} else if (device_control_dynamic_is_key(elem_name, name_length, "DEVNAME") == 1) {
+		// set to lxcutil dynamic device request
+		lddr->devnode = elem_value;
+
+	} else if (device_control_dynamic_is_key(elem_name, name_length, "MAJOR") == 1) {
+		char *endptr = NULL;
+		int value = 0;
+
+		// set to lxcutil dynamic device request
+		value = strtol(elem_value, &endptr, 10);
+		if (elem_value == endptr) {
+			lddr->dev_major = -1;
+		} else {
+			lddr->dev_major = value;
+		}
+	} else if (device_control_dynamic_is_key(elem_name, name_length, "MINOR") == 1) {
+		char *endptr = NULL;
+		int value = 0;
+
+		// set to lxcutil dynamic device request
+		value = strtol(elem_value, &endptr, 10);
+		if (elem_value == endptr) {
+			lddr->dev_minor = -1;
+		} else {
+			lddr->dev_minor = value;
+		}
+	} else {
+		;	//skip this data
+	}
+}
 /**
  * Sub function for uevent monitor.
  * This function check device assignment to all containers. It return behavior for target device.
  *
  * @param [in]	cs		Pointer to containers_t.
  * @param [in]	udi		Pointer to uevent_device_info_t.
- * @param [in]	pdev	Pointer to struct udev_device.
+ * @param [in]	devnode	Device node path for target device. (Can be NULL)
  * @param [out]	le		Double pointer to dynamic_device_entry_items_behavior_t.
  * @return int
  * @retval	!= NULL	A container_config_t for device assignment target.
  * @retval	NULL	Not found target.
  */
-static container_config_t *device_control_dynamic_udev_get_target_container(containers_t *cs, uevent_device_info_t *udi, struct udev_device *pdev
+static container_config_t *device_control_dynamic_udev_get_target_container(containers_t *cs, uevent_device_info_t *udi, const char *devnode
 																			, dynamic_device_entry_items_behavior_t **behavior)
 {
 	int num = 0, ret = -1;
@@ -441,7 +746,7 @@ static container_config_t *device_control_dynamic_udev_get_target_container(cont
 
 	for(int i=0;i < num;i++) {
 		cc = cs->containers[i];
-		ret = device_control_dynamic_udev_rule_judgment(cc, udi, pdev, behavior);
+		ret = device_control_dynamic_udev_rule_judgment(cc, udi, devnode, behavior);
 		if (ret == 1) {
 			return cc;
 		}
@@ -557,13 +862,13 @@ static int device_control_dynamic_udev_test_action(const char *actionstr, uevent
  *
  * @param [in]	cc			Pointer to container_config_t.
  * @param [in]	udi			Pointer to uevent_device_info_t.
- * @param [in]	pdev		Pointer to struct udev_device.
+ * @param [in]	devnode		Device node path for target device. (Can be NULL)
  * @param [out]	behavior	Double pointer to dynamic_device_entry_items_behavior_t.  It use to get reference to the behavior data.
  * @return int
  * @retval	0	Success to event handling.
  * @retval	-1	Internal error (Not use).
  */
-static int device_control_dynamic_udev_rule_judgment(container_config_t *cc, uevent_device_info_t *udi, struct udev_device *pdev
+static int device_control_dynamic_udev_rule_judgment(container_config_t *cc, uevent_device_info_t *udi, const char *devnode
 													, dynamic_device_entry_items_behavior_t **behavior)
 {
 	container_dynamic_device_t *cdd = NULL;
@@ -624,7 +929,7 @@ static int device_control_dynamic_udev_rule_judgment(container_config_t *cc, uev
 				if ((udi->checker_func != NULL) && (result == 1)) {
 					// Have a extra rule?
 					if (dl_list_empty(&ddei->rule.extra_list) == 0) {
-						ret = udi->checker_func(&ddei->rule.extra_list, pdev, action_code);
+						ret = udi->checker_func(&ddei->rule.extra_list, devnode, action_code);
 						if (ret != 1) {
 							result = 0;
 						}
@@ -647,40 +952,22 @@ function_return:
  * Extra uevent checker function for block device.
  *
  * @param [in]	extra_list	Pointer to extra rule lest inside a container config.
- * @param [in]	pdev		Pointer to struct udev_device.
+ * @param [in]	devnode		Device node path for target device. (ex. /dev/sda1)
  * @param [in]	action		Uevent action.
  * @retval	1	Match to rule.
  * @retval	0	Not match to rule.
  * @retval	-1	Internal error (Not use).
  */
-static int extra_checker_block_device(struct dl_list *extra_list,  struct udev_device *pdev, int action)
+static int extra_checker_block_device(struct dl_list *extra_list, const char *devnode, int action)
 {
 	int ret = -1, result = 0;
-	struct udev_list_entry *le = NULL;
 	dynamic_device_entry_items_rule_extra_t *pre= NULL;
-	const char *devnode = NULL;
 
 	// Block device is only to check in add event case.
 	if (action != DCD_UEVENT_ACTION_ADD) {
 		return 1;
 	}
 
-	// Analyze udev properties list.
-	le = udev_device_get_properties_list_entry(pdev);
-	while (le != NULL) {
-		const char* elem_name = NULL;
-		const char* elem_value = NULL;
-
-		elem_name = udev_list_entry_get_name(le);
-		elem_value = udev_list_entry_get_value(le);
-
-		if (strcmp(elem_name, "DEVNAME") == 0) {
-			devnode = elem_value;
-		}
-
-		le = udev_list_entry_get_next(le);
-	}
-
 	if (devnode != NULL) {
 		block_device_info_t bdi;
 
@@ -723,6 +1010,58 @@ bypass_ret:
 
 	return result;
 }
+/**
+ * Sub function for uevent monitor (raw uevent mode).
+ * Setup for the kernel uevent netlink socket.
+ *
+ * @param [out]	ddu		Pointer to struct s_dynamic_device_udev.
+ * @param [in]	ddm		Pointer to dynamic_device_manager_t.
+ * @param [in]	event	Instance of sd_event. (main loop)
+ * @return int
+ * @retval	0	Success to setup.
+ * @retval	-1	Internal error.
+ */
+static int device_control_dynamic_raw_setup(struct s_dynamic_device_udev *ddu, dynamic_device_manager_t *ddm, sd_event *event)
+{
+	struct mnl_socket *nl = NULL;
+	sd_event_source *uevent_source = NULL;
+	int rcvbuf = DCD_RAW_UEVENT_RCVBUF_SIZE;
+	int ret = -1;
+
+	nl = mnl_socket_open2(NETLINK_KOBJECT_UEVENT, (SOCK_CLOEXEC | SOCK_NONBLOCK));
+	if (nl == NULL) {
+		goto err_return;
+	}
+
+	// Prefer to not lose uevent at burst. Fail to set size is not critical.
+	ret = setsockopt(mnl_socket_get_fd(nl), SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf));
+	if (ret < 0) {
+		(void) setsockopt(mnl_socket_get_fd(nl), SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	}
+
+	/* There is one single group in kobject over netlink */
+	ret = mnl_socket_bind(nl, 1u, MNL_SOCKET_AUTOPID);
+	if (ret < 0) {
+		goto err_return;
+	}
+
+	ret = sd_event_add_io(event, &uevent_source, mnl_socket_get_fd(nl), EPOLLIN, raw_uevent_event_handler, ddm);
+	if (ret < 0) {
+		goto err_return;
+	}
+
+	ddu->uevent_nl = nl;
+	ddu->uevent_source = uevent_source;
+
+	return 0;
+
+err_return:
+	if (nl != NULL) {
+		(void) mnl_socket_close(nl);
+	}
+
+	return -1;
+}
 /**
  * Sub function for uevent monitor.
  * Setup for the uevent monitor event loop.
@@ -755,6 +1094,18 @@ int device_control_dynamic_udev_setup(dynamic_device_manager_t *ddm, containers_
 
 	(void) memset(ddu, 0, sizeof(struct s_dynamic_device_udev));
 
+	if ((cs->cmcfg != NULL) && (cs->cmcfg->dynamicdevice.uevent_source == MANAGER_UEVENT_SOURCE_RAW)) {
+		ret = device_control_dynamic_raw_setup(ddu, ddm, event);
+		if (ret < 0) {
+			goto err_return;
+		}
+
+		ddu->cs = cs;
+		ddm->ddu = (dynamic_device_udev_t*)ddu;
+
+		return 0;
+	}
+
 	pudev = udev_new();
 	if (pudev == NULL) {
 		goto err_return;
@@ -820,6 +1171,14 @@ int device_control_dynamic_udev_cleanup(dynamic_device_manager_t *ddm)
 
 	ddu = (struct s_dynamic_device_udev*)ddm->ddu;
 
+	if (ddu->uevent_source != NULL) {
+		(void) sd_event_source_disable_unref(ddu->uevent_source);
+	}
+
+	if (ddu->uevent_nl != NULL) {
+		(void) mnl_socket_close(ddu->uevent_nl);
+	}
+
 	if (ddu->libudev_source != NULL) {
 		(void) sd_event_source_disable_unref(ddu->libudev_source);
 	}
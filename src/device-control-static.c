@@ -15,17 +15,19 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/sysmacros.h>
-#include <sys/ioctl.h>
-#include <linux/sockios.h>
+#include <net/if.h>
 
 #include "cm-utils.h"
+#include "net-util.h"
 
 static int devc_static_devnode_scan(container_static_device_t *sdevc);
 static int devc_gpionode_scan(container_static_device_t *devc);
 static int devc_iionode_scan(container_static_device_t *sdevc);
 static int devc_netbridge_setup(container_manager_config_t *cmc);
+static int devc_netif_prepare(containers_t *cs);
 
 /**
  * Start up time device initialization.
@@ -44,6 +46,7 @@ int devc_early_device_setup(containers_t *cs)
 	container_config_t *cc = NULL;
 
 	(void)devc_netbridge_setup(cs->cmcfg);
+	(void)devc_netif_prepare(cs);
 
 	num = cs->num_of_container;
 
@@ -167,6 +170,7 @@ static int devc_gpionode_scan(container_static_device_t *sdevc)
 {
 	int ret = 1;
 	int result = -1;
+	int export_fd = -1;
 	char buf[1024];
 	char directionbuf[128];
 	ssize_t slen = 0, buflen = 0;
@@ -196,7 +200,14 @@ static int devc_gpionode_scan(container_static_device_t *sdevc)
 			#ifdef _PRINTF_DEBUG_
 			(void) fprintf(stdout,"devc: gpio node %s will export\n", buf);
 			#endif
-			ret = once_write(gpio_export_node, buf, slen);
+			// Export node is opened at first export and re-used to all ports.
+			if (export_fd < 0) {
+				export_fd = ctrlfile_open(AT_FDCWD, gpio_export_node);
+			}
+			ret = -1;
+			if (export_fd >= 0) {
+				ret = ctrlfile_write(export_fd, buf, slen);
+			}
 			if (ret == 0) {
 				ret = node_check(gpioelem->from);
 				if (ret == -1) {
@@ -231,9 +242,16 @@ static int devc_gpionode_scan(container_static_device_t *sdevc)
 		#endif
 	}
 
+	if (export_fd >= 0) {
+		(void) close(export_fd);
+	}
+
 	return 0;
 
 err_ret:
+	if (export_fd >= 0) {
+		(void) close(export_fd);
+	}
 
 	return result;
 }
@@ -313,7 +331,7 @@ err_ret:
 }
 /**
  * Start up time network initialization for bridge device.
- * This function create network bridge.
+ * This function create network bridge.  All bridges are created by one rtnetlink transaction.
  *
  * @param [in]	cmc	Pointer to container_manager_config_t.
  * @return int
@@ -325,12 +343,11 @@ static int devc_netbridge_setup(container_manager_config_t *cmc)
 {
 	int ret = -1;
 	int result = 0;
-	int sock = -1;
-	char buf[IFNAMSIZ+1];
+	netutil_link_batch_t *nlb = NULL;
 	container_manager_bridge_config_t *elem = NULL;
 
-	sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
-	if (sock < 0) {
+	ret = netutil_link_batch_create(&nlb);
+	if (ret < 0) {
 		return -2;
 	}
 
@@ -343,16 +360,239 @@ static int devc_netbridge_setup(container_manager_config_t *cmc)
 			continue;
 		}
 
-		(void) memset(buf, 0, sizeof(buf));
-		(void) strncpy(buf, elem->name, IFNAMSIZ);
-
-		ret = ioctl(sock, SIOCBRADDBR, buf);
-		if ((ret < 0) && (errno != EEXIST)) {
+		ret = netutil_link_batch_add_bridge(nlb, elem->name);
+		if (ret < 0) {
 			result = -2;
 		}
 	}
 
-	(void) close(sock);
+	ret = netutil_link_batch_commit(nlb);
+	if (ret < 0) {
+		result = -2;
+	}
+
+	(void) netutil_link_batch_release(nlb);
+
+	return result;
+}
+/**
+ * Sub function for network preparation stage.  Allocate host and guest side interface name.
+ * To avoid name conflict, add monotonic ms time and serial number to if name.
+ *
+ * @param [out]	peer_host	Double pointer to store allocated host side name.
+ * @param [out]	peer_guest	Double pointer to store allocated guest side name.
+ * @param [in]	prefix		Prefix of if name.
+ * @param [in]	id			Unique id for if name.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Memory allocation error.
+ */
+static int devc_netif_prepare_name(char **peer_host, char **peer_guest, const char *prefix, uint32_t id)
+{
+	size_t if_name_alloc_size = (size_t)IFNAMSIZ + 1u;
+	char *host = NULL, *guest = NULL;
+
+	host = (char*)malloc(if_name_alloc_size);
+	guest = (char*)malloc(if_name_alloc_size);
+	if ((host == NULL) || (guest == NULL)) {
+		(void) free(host);
+		(void) free(guest);
+		return -1;
+	}
+
+	(void) memset(host, 0, if_name_alloc_size);
+	(void) memset(guest, 0, if_name_alloc_size);
+	(void) snprintf(host, IFNAMSIZ, "%sh%08x", prefix, id);
+	(void) snprintf(guest, IFNAMSIZ, "%sg%08x", prefix, id);
+
+	(*peer_host) = host;
+	(*peer_guest) = guest;
+
+	return 0;
+}
+/**
+ * Sub function for network preparation stage.  Set result of preparation to static netif element.
+ * In case of fail, allocated interface names are released and the interface is created by lxc util at guest start.
+ *
+ * @param [in]	netelem		Pointer to container_static_netif_elem_t.
+ * @param [in]	is_prepared	Interface is pre-created (=1) or not (=0).
+ * @return int
+ * @retval  0 Success.
+ */
+static int devc_netif_prepare_result(container_static_netif_elem_t *netelem, int is_prepared)
+{
+	char **peer_host = NULL, **peer_guest = NULL;
+
+	if (netelem->type == STATICNETIF_VETH) {
+		netif_elem_veth_t *veth = (netif_elem_veth_t*)netelem->setting;
+
+		veth->is_prepared = is_prepared;
+		peer_host = &veth->peer_host;
+		peer_guest = &veth->peer_guest;
+	} else {
+		netif_elem_vxcan_t *vxcan = (netif_elem_vxcan_t*)netelem->setting;
+
+		vxcan->is_prepared = is_prepared;
+		peer_host = &vxcan->peer_host;
+		peer_guest = &vxcan->peer_guest;
+	}
+
+	if (is_prepared == 0) {
+		(void) free(*peer_host);
+		(void) free(*peer_guest);
+		(*peer_host) = NULL;
+		(*peer_guest) = NULL;
+	}
+
+	return 0;
+}
+/**
+ * Sub function for network preparation stage.  Remove the pre-created interface pair of static netif element when it exists.
+ * It's used when the result of preparation is not acknowledged.
+ *
+ * @param [in]	netelem		Pointer to container_static_netif_elem_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to remove.
+ */
+static int devc_netif_prepare_cleanup(container_static_netif_elem_t *netelem)
+{
+	const char *peer_host = NULL;
+
+	if (netelem->type == STATICNETIF_VETH) {
+		peer_host = ((netif_elem_veth_t*)netelem->setting)->peer_host;
+	} else {
+		peer_host = ((netif_elem_vxcan_t*)netelem->setting)->peer_host;
+	}
+
+	if ((peer_host == NULL) || (if_nametoindex(peer_host) == 0)) {
+		// Not created.
+		return 0;
+	}
+
+	// Peer is removed together.
+	if (netutil_link_remove(peer_host) < 0) {
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Fail to remove unacknowledged pre-created interface %s.\n", peer_host);
+		#endif
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Start up time network initialization for guest network interfaces.
+ * This function pre-create veth pairs and vxcan pairs for all guests by one rtnetlink transaction.
+ * The host side interfaces are linked up and attached to bridge.  The guest side interfaces are moved
+ * into guest by lxc as phys type at guest start.  Interfaces that could not prepare are created by
+ * lxc util at guest start as before.
+ *
+ * @param [in]	cs	Pointer to containers_t.
+ * @return int
+ * @retval  0 Success to operations.
+ * @retval -1 Some interfaces could not prepare.
+ * @retval -2 Syscall error.
+ */
+static int devc_netif_prepare(containers_t *cs)
+{
+	int ret = -1;
+	int result = 0;
+	int num = 0;
+	uint32_t id = 0;
+	netutil_link_batch_t *nlb = NULL;
+	container_static_netif_elem_t *prepared[NETUTIL_LINK_BATCH_MSG_MAX];
+
+	ret = netutil_link_batch_create(&nlb);
+	if (ret < 0) {
+		return -2;
+	}
+
+	id = (uint32_t)get_current_time_ms();
+
+	for (int i = 0; i < cs->num_of_container; i++) {
+		container_config_t *cc = cs->containers[i];
+		container_static_netif_elem_t *netelem = NULL;
+
+		dl_list_for_each(netelem, &cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list) {
+			if (num >= NETUTIL_LINK_BATCH_MSG_MAX) {
+				result = -1;
+				break;
+			}
+
+			if (netelem->type == STATICNETIF_VETH) {
+				netif_elem_veth_t *veth = (netif_elem_veth_t*)netelem->setting;
+				unsigned int master = 0;
+
+				// Only support bridge mode. Router mode need host side routing setup by lxc.
+				if ((veth->link == NULL) || ((veth->mode != NULL) && (strcmp(veth->mode, "bridge") != 0))) {
+					continue;
+				}
+
+				master = if_nametoindex(veth->link);
+				if (master == 0) {
+					result = -1;
+					continue;
+				}
+
+				ret = devc_netif_prepare_name(&veth->peer_host, &veth->peer_guest, "veth", id);
+				if (ret < 0) {
+					result = -1;
+					continue;
+				}
+				id++;
+
+				ret = netutil_link_batch_add_veth(nlb, veth->peer_host, veth->peer_guest, master);
+			} else if (netelem->type == STATICNETIF_VXCAN) {
+				netif_elem_vxcan_t *vxcan = (netif_elem_vxcan_t*)netelem->setting;
+
+				ret = devc_netif_prepare_name(&vxcan->peer_host, &vxcan->peer_guest, "vxcan", id);
+				if (ret < 0) {
+					result = -1;
+					continue;
+				}
+				id++;
+
+				ret = netutil_link_batch_add_vxcan(nlb, vxcan->peer_host, vxcan->peer_guest);
+			} else {
+				continue;
+			}
+
+			prepared[num] = netelem;
+			if (ret < 0) {
+				// Batch is full, fall back to lxc util.
+				(void) devc_netif_prepare_result(netelem, 0);
+				result = -1;
+				continue;
+			}
+
+			num++;
+		}
+	}
+
+	ret = netutil_link_batch_commit(nlb);
+	if (ret == -1) {
+		result = -1;
+	} else if (ret < 0) {
+		result = -2;
+	}
+
+	for (int i = 0; i < num; i++) {
+		int is_prepared = 0;
+		int msg_result = netutil_link_batch_get_result(nlb, i);
+
+		if ((ret == 0) || (((ret == -1) || (ret == -3)) && (msg_result == 0))) {
+			is_prepared = 1;
+		} else if ((ret == -3) && (msg_result == -EIO)) {
+			// Socket error after send, kernel may create this pair without acknowledgement.  Remove it to release the names.
+			(void) devc_netif_prepare_cleanup(prepared[i]);
+		} else {
+			;	//nop
+		}
+
+		(void) devc_netif_prepare_result(prepared[i], is_prepared);
+	}
+
+	(void) netutil_link_batch_release(nlb);
 
 	return result;
 }
@@ -19,6 +19,7 @@ int devc_device_manager_setup(containers_t *cs, container_control_interface_t *c
 int devc_device_manager_cleanup(containers_t *cs);
 
 int network_interface_info_get(network_interface_manager_t **netif, dynamic_device_manager_t *ddm);
+int netifmonitor_netns_move_queue(dynamic_device_manager_t *ddm, int ifindex, const char *ifname, int netns_fd);
 
 //-----------------------------------------------------------------------------
 #endif //#ifndef DEVICE_CONTROL_H
@@ -8,11 +8,14 @@
 #include "lxc-util.h"
 #include "cm-utils.h"
 #include "cgroup-utils.h"
+#include "cgroup-device-bpf.h"
 
 #include "socketcan-util.h"
+#include "net-util.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #include <lxc/lxccontainer.h>
 
 #ifdef _PRINTF_DEBUG_
@@ -250,6 +253,7 @@ err_ret:
 static int lxcutil_create_per_guest_cgroup_v1(struct lxc_container *plxc, container_resourceconfig_t *rsc, const char *name)
 {
 	int result = -1;
+	int ret = -1;
 	bool bret = false;
 	char buf[1024];
 	char *tmp_str = NULL;
@@ -337,6 +341,19 @@ static int lxcutil_create_per_guest_cgroup_v1(struct lxc_container *plxc, contai
 		goto err_ret;
 	}
 
+	// Persistent control files for runtime device allow/deny.
+	if (rsc->cgroup_devices_ctrlfile != NULL) {
+		(void) cgroup_util_devices_ctrlfile_release(rsc->cgroup_devices_ctrlfile);
+		rsc->cgroup_devices_ctrlfile = NULL;
+	}
+
+	ret = cgroup_util_devices_ctrlfile_create(&rsc->cgroup_devices_ctrlfile, rsc->cgroup_path_container, rsc->cgroup_subpath_container_inner);
+	if (ret < 0) {
+		rsc->cgroup_devices_ctrlfile = NULL;
+		result = -2;
+		goto err_ret;
+	}
+
 	rsc->enable_cgroup_inner_outer_mode = 1;
 
 	return 0;
@@ -369,6 +386,22 @@ err_ret:
  */
 static int lxcutil_create_per_guest_cgroup_v2(struct lxc_container *plxc, container_resourceconfig_t *rsc, const char *name)
 {
+	int ret = -1;
+
+	// Create device controller for runtime device allow/deny. When it's not available, dynamic device permission is not changed at runtime.
+	if (rsc->cgroup_device_bpf != NULL) {
+		(void) cgroup_device_bpf_release(rsc->cgroup_device_bpf);
+		rsc->cgroup_device_bpf = NULL;
+	}
+
+	ret = cgroup_device_bpf_create(&rsc->cgroup_device_bpf);
+	if (ret < 0) {
+		rsc->cgroup_device_bpf = NULL;
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL INFO] Container %s can not use cgroup v2 device controller (%d).\n", name, ret);
+		#endif
+	}
+
 	// This feature is not support v2 environment.
 	rsc->cgroup_subpath_container_inner = NULL;
 	rsc->cgroup_path_monitor = NULL;
@@ -423,6 +456,16 @@ static int lxcutil_release_per_guest_cgroup_runtime_data(container_resourceconfi
 
 	rsc->enable_cgroup_inner_outer_mode = 0;
 
+	if (rsc->cgroup_device_bpf != NULL) {
+		(void) cgroup_device_bpf_release(rsc->cgroup_device_bpf);
+		rsc->cgroup_device_bpf = NULL;
+	}
+
+	if (rsc->cgroup_devices_ctrlfile != NULL) {
+		(void) cgroup_util_devices_ctrlfile_release(rsc->cgroup_devices_ctrlfile);
+		rsc->cgroup_devices_ctrlfile = NULL;
+	}
+
 	return 0;
 }
 /**
@@ -652,13 +695,14 @@ err_ret:
  * Set lxc config from container config deviceconfig sub part for set default.
  *
  * @param [in]	plxc		The lxc container instance to set config.
+ * @param [in]	rsc			Pointer to container_resourceconfig_t. In cgroup v2, the setting mirror to device controller.
  * @param [in]	is_allow	If this parameter set true, it set allow.  If this parameter set true, it set deny.
  * @param [in]	config_str	Device setting string.
  * @return bool
  * @retval true	Success to set lxc config.
  * @retval false Fail to set lxc config.
  */
-static bool lxcutil_set_cgroup_device(struct lxc_container *plxc, bool is_allow, const char *config_str)
+static bool lxcutil_set_cgroup_device(struct lxc_container *plxc, container_resourceconfig_t *rsc, bool is_allow, const char *config_str)
 {
 	int ret = -1;
 	bool bret = false;
@@ -678,6 +722,11 @@ static bool lxcutil_set_cgroup_device(struct lxc_container *plxc, bool is_allow,
 		} else {
 			bret = plxc->set_config_item(plxc, "lxc.cgroup2.devices.deny", config_str);
 		}
+
+		// Mirror to device controller. It replace lxc device program after guest start.
+		if ((bret == true) && (rsc->cgroup_device_bpf != NULL)) {
+			(void) cgroup_device_bpf_set_rule(rsc->cgroup_device_bpf, ((is_allow == true) ? 1 : 0), config_str);
+		}
 	} else {
 		bret = false;
 	}
@@ -688,6 +737,7 @@ static bool lxcutil_set_cgroup_device(struct lxc_container *plxc, bool is_allow,
  * Create lxc config from container config deviceconfig sub part for set default.
  *
  * @param [in]	plxc	The lxc container instance to set config.
+ * @param [in]	rsc		Pointer to container_resourceconfig_t.
  * @return int
  * @retval 0	Success to set lxc config from devc.
  * @retval -1	Got lxc error.
@@ -704,13 +754,13 @@ static const char *g_default_allow_devices[] = {
 	"c 136:* rwm",	// /dev/pts/x
 	NULL,
 };
-static int lxcutil_set_config_static_device_default(struct lxc_container *plxc)
+static int lxcutil_set_config_static_device_default(struct lxc_container *plxc, container_resourceconfig_t *rsc)
 {
 	int result = 0;
 	bool bret = false;
 
 	// Set all devices are deny
-	bret = lxcutil_set_cgroup_device(plxc, false, "a");
+	bret = lxcutil_set_cgroup_device(plxc, rsc, false, "a");
 	if (bret == false) {
 		result = -1;
 		goto err_ret;
@@ -723,7 +773,7 @@ static int lxcutil_set_config_static_device_default(struct lxc_container *plxc)
 			break;
 		}
 
-		bret = lxcutil_set_cgroup_device(plxc, true, config_str);
+		bret = lxcutil_set_cgroup_device(plxc, rsc, true, config_str);
 		if (bret == false) {
 			result = -1;
 			goto err_ret;
@@ -739,12 +789,13 @@ err_ret:
  *
  * @param [in]	plxc	The lxc container instance to set config.
  * @param [in]	devc	Pointer to container_deviceconfig_t.
+ * @param [in]	rsc		Pointer to container_resourceconfig_t.
  * @return int
  * @retval 0	Success to set lxc config from devc.
  * @retval -1	Got lxc error.
  * @retval -2	A bytes of config string is larger than buffer size. Critical case only.
  */
-static int lxcutil_set_config_static_device(struct lxc_container *plxc, container_deviceconfig_t *devc)
+static int lxcutil_set_config_static_device(struct lxc_container *plxc, container_deviceconfig_t *devc, container_resourceconfig_t *rsc)
 {
 	int result = -1, ret = -1;
 	bool bret = false;
@@ -759,7 +810,7 @@ static int lxcutil_set_config_static_device(struct lxc_container *plxc, containe
 	(void) memset(buf,0,sizeof(buf));
 
 	if (devc->enable_protection == 1) {
-		ret = lxcutil_set_config_static_device_default(plxc);
+		ret = lxcutil_set_config_static_device_default(plxc, rsc);
 		if (ret < 0) {
 			result = -1;
 			goto err_ret;
@@ -837,7 +888,7 @@ static int lxcutil_set_config_static_device(struct lxc_container *plxc, containe
 			}
 		}
 
-		bret = lxcutil_set_cgroup_device(plxc, true, buf);
+		bret = lxcutil_set_cgroup_device(plxc, rsc, true, buf);
 	}
 
 	// gpio
@@ -968,7 +1019,7 @@ static int lxcutil_set_config_static_device(struct lxc_container *plxc, containe
 					continue;	// buffer over -> drop data
 				}
 
-				bret = lxcutil_set_cgroup_device(plxc, true, buf);
+				bret = lxcutil_set_cgroup_device(plxc, rsc, true, buf);
 				if (bret == false) {
 					result = -1;
 					#ifdef _PRINTF_DEBUG_
@@ -998,6 +1049,95 @@ err_ret:
 
 	return result;
 }
+/**
+ * Set lxc net config items for one network interface.
+ *
+ * @param [in]	plxc	The lxc container instance to set config.
+ * @param [in]	num		Number of if setting index.
+ * @param [in]	keys	Array of config key under lxc.net.N.
+ * @param [in]	values	Array of config value.  Optional value is not set when it is NULL.
+ * @param [in]	count	Number of keys and values.
+ * @return int
+ * @retval 0	Success to set lxc config.
+ * @retval -1	Got lxc error.
+ */
+static int lxcutil_set_config_netif_items(struct lxc_container *plxc, int num, const char * const *keys, const char * const *values, size_t count)
+{
+	bool bret = false;
+	char buf[1024];
+
+	for (size_t i = 0; i < count; i++) {
+		if (values[i] == NULL) {
+			continue;
+		}
+
+		(void)snprintf(buf, sizeof(buf), "lxc.net.%d.%s", num, keys[i]);	//No issue for buffer length.
+		bret = plxc->set_config_item(plxc, buf, values[i]);
+		if (bret == false) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"lxcutil: lxcutil_set_config_netif_items set config %s = %s fail.\n", buf, values[i]);
+			#endif
+			return -1;
+		}
+	}
+
+	return 0;
+}
+/**
+ * Create lxc config for pre-created veth pair.  The guest side interface is moved into guest as phys type.
+ *
+ * @param [in]	plxc	The lxc container instance to set config.
+ * @param [in]	veth	Pointer to netif_elem_veth_t.
+ * @param [in]	num		Number of if setting index.
+ * @return int
+ * @retval 0	Success to set lxc config from netc.
+ * @retval -1	Got lxc error.
+ */
+static int lxcutil_set_config_static_netif_veth_prepared(struct lxc_container *plxc, netif_elem_veth_t *veth, int num)
+{
+	const char * const keys[] = {"type", "link", "name", "flags", "hwaddr", "ipv4.address", "ipv4.gateway"};
+	const char * const values[] = {"phys", veth->peer_guest, veth->name, veth->flags, veth->hwaddr, veth->address, veth->gateway};
+
+	return lxcutil_set_config_netif_items(plxc, num, keys, values, (sizeof(keys) / sizeof(keys[0])));
+}
+/**
+ * Create lxc config from container config netifconfig sub part for macvlan.
+ *
+ * @param [in]	plxc	The lxc container instance to set config.
+ * @param [in]	macvlan	Pointer to netif_elem_macvlan_t.
+ * @param [in]	num		Number of if setting index.
+ * @return int
+ * @retval 0	Success to set lxc config from netc.
+ * @retval -1	Got lxc error.
+ */
+static int lxcutil_set_config_static_netif_macvlan(struct lxc_container *plxc, netif_elem_macvlan_t *macvlan, int num)
+{
+	// mode is optional, lxc default is private mode.
+	const char * const keys[] = {"type", "link", "macvlan.mode", "name", "flags", "hwaddr", "ipv4.address", "ipv4.gateway"};
+	const char * const values[] = {"macvlan", macvlan->link, macvlan->mode, macvlan->name, macvlan->flags, macvlan->hwaddr
+									, macvlan->address, macvlan->gateway};
+
+	return lxcutil_set_config_netif_items(plxc, num, keys, values, (sizeof(keys) / sizeof(keys[0])));
+}
+/**
+ * Create lxc config from container config netifconfig sub part for ipvlan.
+ *
+ * @param [in]	plxc	The lxc container instance to set config.
+ * @param [in]	ipvlan	Pointer to netif_elem_ipvlan_t.
+ * @param [in]	num		Number of if setting index.
+ * @return int
+ * @retval 0	Success to set lxc config from netc.
+ * @retval -1	Got lxc error.
+ */
+static int lxcutil_set_config_static_netif_ipvlan(struct lxc_container *plxc, netif_elem_ipvlan_t *ipvlan, int num)
+{
+	// mode and isolation are optional, lxc default is l3 mode and bridge isolation.
+	const char * const keys[] = {"type", "link", "ipvlan.mode", "ipvlan.isolation", "name", "flags", "ipv4.address", "ipv4.gateway"};
+	const char * const values[] = {"ipvlan", ipvlan->link, ipvlan->mode, ipvlan->isolation, ipvlan->name, ipvlan->flags
+									, ipvlan->address, ipvlan->gateway};
+
+	return lxcutil_set_config_netif_items(plxc, num, keys, values, (sizeof(keys) / sizeof(keys[0])));
+}
 /**
  * Create lxc config from container config netifconfig sub part for veth.
  *
@@ -1018,6 +1158,22 @@ static int lxcutil_set_config_static_netif_veth(struct lxc_container *plxc, neti
 
 	(void) memset(buf,0,sizeof(buf));
 
+	if (veth->is_prepared == 1) {
+		// veth pair is pre-created by network preparation stage, move guest side into guest as phys.
+		veth->is_prepared = 0;
+		return lxcutil_set_config_static_netif_veth_prepared(plxc, veth, num);
+	}
+
+	// if veth->peer_host != NULL, previous pre-created veth pair was returned from guest. Shall remove it.
+	if (veth->peer_host != NULL) {
+		(void) netutil_link_remove(veth->peer_host);
+		(void) free(veth->peer_host);
+		(void) free(veth->peer_guest);
+		veth->peer_host = NULL;
+		veth->peer_guest = NULL;
+	}
+
+	// veth specific keys are accepted after type is set, set type first.
 	(void)snprintf(buf, sizeof(buf), "lxc.net.%d.type", num);	//No issue for buffer length.
 	bret = plxc->set_config_item(plxc, buf, "veth");
 	if (bret == false) {
@@ -1028,6 +1184,30 @@ static int lxcutil_set_config_static_netif_veth(struct lxc_container *plxc, neti
 		goto err_ret;
 	}
 
+	// Traffic shaping is applied to host side peer after guest start, shall name host side peer.
+	if (veth->shaping != NULL) {
+		size_t if_name_alloc_size = (size_t)IFNAMSIZ + 1u;
+
+		veth->peer_host = (char*)malloc(if_name_alloc_size);
+		if (veth->peer_host == NULL) {
+			result = -3;
+			goto err_ret;
+		}
+		(void) memset(veth->peer_host, 0, if_name_alloc_size);
+		// To avoid name conflict, add monotonic ms time to if name.
+		(void) snprintf(veth->peer_host, IFNAMSIZ, "vethh%08x", (uint32_t)get_current_time_ms() + (uint32_t)num);
+
+		(void)snprintf(buf, sizeof(buf), "lxc.net.%d.veth.pair", num);	//No issue for buffer length.
+		bret = plxc->set_config_item(plxc, buf, veth->peer_host);
+		if (bret == false) {
+			result = -1;
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"lxcutil: lxcutil_set_config_static_netif set config %s = %s fail.\n", buf, veth->peer_host);
+			#endif
+			goto err_ret;
+		}
+	}
+
 	// name is optional, lxc default is ethX.
 	if (veth->name != NULL) {
 		(void)snprintf(buf, sizeof(buf), "lxc.net.%d.name", num);	//No issue for buffer length.
@@ -1141,6 +1321,7 @@ static int lxcutil_set_config_static_netif_vxcan(struct lxc_container *plxc, net
 {
 	int64_t ms_time = 0;
 	int result = -1, ret = -1;
+	int is_prepared = 0;
 	char *peer_host = NULL, *peer_guest = NULL;
 	size_t if_name_alloc_size = (size_t)IFNAMSIZ + 1u;
 	bool bret = false;
@@ -1153,6 +1334,15 @@ static int lxcutil_set_config_static_netif_vxcan(struct lxc_container *plxc, net
 
 	(void) memset(buf,0,sizeof(buf));
 
+	if (vxcan->is_prepared == 1) {
+		// vxcan pair is pre-created and linked up by network preparation stage.
+		vxcan->is_prepared = 0;
+		is_prepared = 1;
+		peer_host = vxcan->peer_host;
+		peer_guest = vxcan->peer_guest;
+		goto set_config;
+	}
+
 	// if vxcan->peer_host and vxcan->peer_guest != NULL. Shall free memory and try to remove previous interface.
 	if (vxcan->peer_host != NULL) {
 		ret = socketcanutil_remove_vxcan_peer(vxcan->peer_host);
@@ -1191,6 +1381,7 @@ static int lxcutil_set_config_static_netif_vxcan(struct lxc_container *plxc, net
 	vxcan->peer_host = peer_host;
 	vxcan->peer_guest = peer_guest;
 
+set_config:
 	//VXCAN support - use phys type
 	(void)snprintf(buf, sizeof(buf), "lxc.net.%d.type", num);	//No issue for buffer length.
 	bret = plxc->set_config_item(plxc, buf, "phys");
@@ -1213,9 +1404,13 @@ static int lxcutil_set_config_static_netif_vxcan(struct lxc_container *plxc, net
 		goto err_ret;
 	}
 
-	// Create VXCAN pair.
-	ret = socketcanutil_create_vxcan_peer(peer_host, peer_guest);
-	if (ret < 0) {
+	// Create VXCAN pair and link up host side in one transaction. Link up fail (-3) is not critical.
+	if (is_prepared == 0) {
+		ret = socketcanutil_setup_vxcan_peer(peer_host, peer_guest);
+	} else {
+		ret = 0;
+	}
+	if ((ret < 0) && (ret != -3)) {
 		result = -3;
 		#ifdef _PRINTF_DEBUG_
 		(void) fprintf(stdout,"lxcutil: lxcutil_set_config_static_netif vxcan pair creation fail. %s, %s.\n", peer_host, peer_guest);
@@ -1243,9 +1438,38 @@ static int lxcutil_set_config_static_netif_vxcan(struct lxc_container *plxc, net
 		goto err_ret;
 	}
 
-	(void) socketcanutil_up_can_if(vxcan->peer_host);
+	if (vxcan->num_of_rx_filter == 0) {
+		// No filter, forward all frames.
+		(void) socketcanutil_configure_gateway(vxcan->upstream, vxcan->peer_host);
+	} else {
+		for (int i = 0; i < vxcan->num_of_rx_filter; i++) {
+			netif_vxcan_filter_t *filter = &vxcan->rx_filter[i];
+
+			ret = socketcanutil_add_gateway_rule(vxcan->upstream, vxcan->peer_host, filter->can_id, filter->can_mask
+												, filter->is_rewrite, filter->rewrite_id);
+			if (ret < 0) {
+				// Not fatal.  Missing rule only drop frames to guest, it does not pass unexpected frames.
+				#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+				(void) fprintf(stderr,"[CM CRITICAL ERROR] vxcan %s rx filter %x/%x could not install (%d).\n", vxcan->name, filter->can_id, filter->can_mask, ret);
+				#endif
+			}
+		}
+	}
 
-	(void) socketcanutil_configure_gateway(vxcan->upstream, vxcan->peer_host);
+	for (int i = 0; i < vxcan->num_of_tx_filter; i++) {
+		netif_vxcan_filter_t *filter = &vxcan->tx_filter[i];
+
+		ret = socketcanutil_add_gateway_rule(vxcan->peer_host, vxcan->upstream, filter->can_id, filter->can_mask
+											, filter->is_rewrite, filter->rewrite_id);
+		if (ret < 0) {
+			// Not fatal.  Missing rule only drop frames from guest, it does not pass unexpected frames.
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] vxcan %s tx filter %x/%x could not install (%d).\n", vxcan->name, filter->can_id, filter->can_mask, ret);
+			#endif
+		}
+	}
+
+	(void) memset(&vxcan->last_stat, 0, sizeof(vxcan->last_stat));
 
 	return 0;
 
@@ -1306,6 +1530,30 @@ static int lxcutil_set_config_static_netif(struct lxc_container *plxc, container
 				#endif
 				goto do_return;
 			}
+		} else if (netelem->type == STATICNETIF_MACVLAN) {
+			// macvlan support
+			netif_elem_macvlan_t *macvlan = (netif_elem_macvlan_t*)netelem->setting;
+
+			ret = lxcutil_set_config_static_netif_macvlan(plxc, macvlan, num);
+			if (ret < 0) {
+				result = -1;
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"lxcutil: lxcutil_set_config_static_netif fail.\n");
+				#endif
+				goto do_return;
+			}
+		} else if (netelem->type == STATICNETIF_IPVLAN) {
+			// ipvlan support
+			netif_elem_ipvlan_t *ipvlan = (netif_elem_ipvlan_t*)netelem->setting;
+
+			ret = lxcutil_set_config_static_netif_ipvlan(plxc, ipvlan, num);
+			if (ret < 0) {
+				result = -1;
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"lxcutil: lxcutil_set_config_static_netif fail.\n");
+				#endif
+				goto do_return;
+			}
 		}
 
 		num++;
@@ -1369,7 +1617,7 @@ int lxcutil_create_instance(container_config_t *cc)
 		goto err_ret;
 	}
 
-	ret = lxcutil_set_config_static_device(plxc, &cc->deviceconfig);
+	ret = lxcutil_set_config_static_device(plxc, &cc->deviceconfig, &cc->resourceconfig);
 	if (ret < 0) {
 		result = -1;
 		goto err_ret;
@@ -1432,8 +1680,14 @@ int lxcutil_release_instance(container_config_t *cc)
 
 	(void) lxcutil_release_config_runtime_data_resource(&cc->resourceconfig);
 
+	if (cc->runtime_stat.netns_fd >= 0) {
+		(void) close(cc->runtime_stat.netns_fd);
+	}
+
 	cc->runtime_stat.lxc = NULL;
 	cc->runtime_stat.pid = -1;
+	cc->runtime_stat.netns_fd = -1;
+	cc->runtime_stat.netns_pid = -1;
 
 	return 0;
 }
\ No newline at end of file
@@ -8,15 +8,22 @@
 #include "lxc-util.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
 #include <sys/sysmacros.h>
 #include <sys/stat.h>
 #include <sys/mount.h>
 #include <lxc/lxccontainer.h>
 
 #include "cm-utils.h"
+#include "cgroup-utils.h"
+#include "cgroup-device-bpf.h"
+#include "tc-util.h"
 #include "uevent_injection.h"
 
 /**
@@ -95,6 +102,55 @@ pid_t lxcutil_get_init_pid(container_config_t *cc)
 
 	return target_pid;
 }
+/**
+ * Get network namespace fd of guest by container_config_t.
+ * The fd is opened at first call and cached until lxcutil_release_instance.
+ * When guest init pid was changed (i.e. guest restart), cached fd is closed and re-opened from current init pid.
+ *
+ * @param [in]	cc 	container_config_t
+ * @return int
+ * @retval >=0	Success get network namespace fd of guest.
+ * @retval -1	Can not open network namespace.
+ */
+int lxcutil_get_netns_fd(container_config_t *cc)
+{
+	pid_t target_pid = -1;
+	int fd = -1;
+	char buf[PATH_MAX];
+	ssize_t slen = 0;
+
+	target_pid = lxcutil_get_init_pid(cc);
+
+	if (cc->runtime_stat.netns_fd >= 0) {
+		if ((target_pid > 0) && (target_pid == cc->runtime_stat.netns_pid)) {
+			return cc->runtime_stat.netns_fd;
+		}
+
+		// Stale cache - guest init was changed or exited.
+		(void) close(cc->runtime_stat.netns_fd);
+		cc->runtime_stat.netns_fd = -1;
+		cc->runtime_stat.netns_pid = -1;
+	}
+
+	if (target_pid <= 0) {
+		return -1;
+	}
+
+	slen = (ssize_t)snprintf(buf, sizeof(buf), "/proc/%d/ns/net", target_pid);
+	if (((size_t)slen) >= sizeof(buf)) {
+		return -1;
+	}
+
+	fd = open(buf, (O_RDONLY | O_CLOEXEC));
+	if (fd < 0) {
+		return -1;
+	}
+
+	cc->runtime_stat.netns_fd = fd;
+	cc->runtime_stat.netns_pid = target_pid;
+
+	return fd;
+}
 /**
  * Add or remove device node in guest container.
  * This function is sub function for lxcutil_dynamic_device_add_to_guest.
@@ -213,14 +269,11 @@ static int lxcutil_add_remove_guest_node(pid_t target_pid, const char *path, int
  * @retval 0	Success to operations.
  * @retval -1	Critical error.
  */
-static const char *cgroup_fs_devices_base_path = "/sys/fs/cgroup/devices";
 int lxcutil_cgroup_device_operation(container_config_t *cc, int is_add, const char *value)
 {
 	int ret = -1;
 	int result = -1;
 	size_t value_length = 0;
-	char *operation_node = NULL;
-	char buf[PATH_MAX];
 
 	// Device allow/deny setting using cgroup.
 	value_length = strlen(value);
@@ -230,50 +283,99 @@ int lxcutil_cgroup_device_operation(container_config_t *cc, int is_add, const ch
 		goto err_ret;
 	}
 
-	if (is_add == 0) {
-		operation_node = "devices.deny";
-	} else {
-		operation_node = "devices.allow";
+	ret = cgroup_util_get_cgroup_version();
+	if (ret == 2) {
+		// cgroup v2: Update device rule map of the device controller.
+		if (cgroup_device_bpf_is_attached(cc->resourceconfig.cgroup_device_bpf) == 0) {
+			// Guest has no device restriction.
+			return 0;
+		}
+
+		ret = cgroup_device_bpf_set_rule(cc->resourceconfig.cgroup_device_bpf, is_add, value);
+		if (ret < 0) {
+			result = -1;
+			goto err_ret;
+		}
+
+		return 0;
 	}
 
-	// Path for intermediate group
-	ret = snprintf(buf, sizeof(buf), "%s/%s/%s", cgroup_fs_devices_base_path
-					, cc->resourceconfig.cgroup_path_container, operation_node);
-	if (((size_t)ret) >= sizeof(buf)) {
-		// Too long path. Error.
+	// cgroup v1: Write to persistent control files for intermediate group, guest group and system.slice (option for systemd).
+	if (cc->resourceconfig.cgroup_devices_ctrlfile == NULL) {
 		result = -1;
 		goto err_ret;
 	}
-	// Write value to ptah.
-	(void) once_write(buf, value, value_length);
 
-	// Path for guest group
-	ret = snprintf(buf, sizeof(buf), "%s/%s/%s/%s", cgroup_fs_devices_base_path
-					, cc->resourceconfig.cgroup_path_container, cc->resourceconfig.cgroup_subpath_container_inner
-					, operation_node);
-	if (((size_t)ret) >= sizeof(buf)) {
-		// Too long path. Error.
-		result = -1;
-		goto err_ret;
+	(void) cgroup_util_devices_ctrlfile_write(cc->resourceconfig.cgroup_devices_ctrlfile, is_add, value, value_length);
+
+	return 0;
+
+err_ret:
+
+	return result;
+}
+/**
+ * Attach the cgroup v2 device controller to running guest.
+ * It replace the device program that was created by lxc, after that device allow/deny operate to the device rule map.
+ * In cgroup v1 environment, this function do nothing.
+ *
+ * @param [in]	cc		Pointer to container_config_t of target container.
+ * @return int
+ * @retval 0	Success to attach or not need to attach.
+ * @retval -1	Fail to attach.
+ */
+int lxcutil_cgroup_device_attach(container_config_t *cc)
+{
+	int ret = -1;
+	pid_t target_pid = -1;
+
+	if (cc->resourceconfig.cgroup_device_bpf == NULL) {
+		return 0;
 	}
-	// Write value to ptah.
-	(void) once_write(buf, value, value_length);
 
-	// Option for systemd.  Add value to system.slice.
-	ret = snprintf(buf, sizeof(buf), "%s/%s/%s/%s/%s", cgroup_fs_devices_base_path
-					, cc->resourceconfig.cgroup_path_container, cc->resourceconfig.cgroup_subpath_container_inner
-					, "system.slice", operation_node);
-	if (((size_t)ret) >= sizeof(buf)) {
-		// Too long path. Error.
-		result = -1;
-		goto err_ret;
+	target_pid = lxcutil_get_init_pid(cc);
+	if (target_pid <= 0) {
+		return -1;
+	}
+
+	ret = cgroup_device_bpf_attach(cc->resourceconfig.cgroup_device_bpf, target_pid);
+	if (ret < 0) {
+		return -1;
 	}
-	// Write value to ptah.
-	(void) once_write(buf, value, value_length);
 
 	return 0;
+}
+/**
+ * Apply traffic shaping to host side peer of guest network interfaces.
+ * The qdisc at guest side is destroyed when the interface move to guest netns, so it is applied at host side after guest start.
+ *
+ * @param [in]	cc		Pointer to container_config_t of target container.
+ * @return int
+ * @retval 0	Success to apply or not need to apply.
+ * @retval -1	Fail to apply to one or more interfaces.
+ */
+int lxcutil_netif_shaping_setup(container_config_t *cc)
+{
+	container_static_netif_elem_t *netelem = NULL;
+	int ret = -1, result = 0;
 
-err_ret:
+	dl_list_for_each(netelem, &cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list) {
+		if (netelem->type == STATICNETIF_VETH) {
+			netif_elem_veth_t *veth = (netif_elem_veth_t*)netelem->setting;
+
+			if ((veth->shaping == NULL) || (veth->peer_host == NULL)) {
+				continue;
+			}
+
+			ret = tcutil_setup_shaping(veth->peer_host, veth->shaping);
+			if (ret < 0) {
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"lxcutil: lxcutil_netif_shaping_setup tcutil_setup_shaping( %s ) return %d.\n", veth->peer_host, ret);
+				#endif
+				result = -1;
+			}
+		}
+	}
 
 	return result;
 }
@@ -426,9 +528,116 @@ int lxcutil_dynamic_networkif_add_to_guest(container_config_t *cc, container_dyn
 
 	return result;
 }
+/**
+ * Attach detached mount to guest mount namespace.
+ * This function is sub function for lxcutil_dynamic_mount_to_guest_detached.
+ * This function exec in child process side after fork.
+ *
+ * @param [in]	mntns_fd	Mount namespace fd of guest container.
+ * @param [in]	tree_fd		Detached mount fd.
+ * @param [in]	guest_path	Path for dynamic mount target.
+ * @return int
+ * @retval 0	Success to operations.
+ * @retval -1	Critical error.
+ */
+static int lxcutil_dynamic_mount_to_guest_child(int mntns_fd, int tree_fd, const char *guest_path)
+{
+	int ret = -1;
+
+	// Root and current directory move to guest root by setns.
+	ret = setns(mntns_fd, CLONE_NEWNS);
+	if (ret < 0) {
+		return -1;
+	}
+
+	ret = move_mount_syscall_wrapper(tree_fd, "", AT_FDCWD, guest_path, MOVE_MOUNT_F_EMPTY_PATH);
+	if (ret < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Dynamic bind mount from host to guest container by detached mount.
+ * This function clone host directory as detached mount and hand it to guest mount namespace directly.
+ * Mount namespace switch need to single thread process, so attach operation exec in child process.
+ *
+ * @param [in]	cc			Pointer to container_config_t.
+ * @param [in]	host_path	Path for dynamic mount source.
+ * @param [in]	guest_path	Path for dynamic mount target.
+ * @return int
+ * @retval 0	Success to operations.
+ * @retval -1	Mount error.
+ * @retval -2	Syscall error.
+ */
+static int lxcutil_dynamic_mount_to_guest_detached(container_config_t *cc, const char *host_path, const char *guest_path)
+{
+	int ret = -1;
+	int result = -1;
+	int tree_fd = -1, mntns_fd = -1;
+	pid_t target_pid = -1, child_pid = -1;
+	char buf[PATH_MAX];
+
+	target_pid = lxcutil_get_init_pid(cc);
+	if (target_pid <= 0) {
+		return -1;
+	}
+
+	ret = snprintf(buf, sizeof(buf), "/proc/%d/ns/mnt", target_pid);
+	if (!((size_t)ret < sizeof(buf))) {
+		return -1;
+	}
+
+	mntns_fd = open(buf, (O_RDONLY | O_CLOEXEC));
+	if (mntns_fd < 0) {
+		return -2;
+	}
+
+	tree_fd = open_tree_syscall_wrapper(AT_FDCWD, host_path, (OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC | AT_RECURSIVE));
+	if (tree_fd < 0) {
+		result = -2;
+		goto err_ret;
+	}
+
+	child_pid = fork();
+	if (child_pid < 0) {
+		result = -2;
+		goto err_ret;
+	}
+
+	if (child_pid == 0) {
+		// run on child process, must be exit.
+		ret = lxcutil_dynamic_mount_to_guest_child(mntns_fd, tree_fd, guest_path);
+		if (ret < 0) {
+			_exit(EXIT_FAILURE);
+		}
+
+		_exit(EXIT_SUCCESS);
+	}
+
+	ret = wait_child_pid(child_pid);
+	if (ret < 0) {
+		result = -1;
+		goto err_ret;
+	}
+
+	(void) close(tree_fd);
+	(void) close(mntns_fd);
+
+	return 0;
+
+err_ret:
+	if (tree_fd >= 0) {
+		(void) close(tree_fd);
+	}
+	(void) close(mntns_fd);
+
+	return result;
+}
 /**
  * Dynamic bind mount from host to guest container.
- * This function mount host directory to guest container using lxc mount interface.
+ * This function mount host directory to guest container.
+ * When new mount api is supported, detached mount is handed to guest mount namespace directly.  Otherwise using lxc mount interface.
  *
  * @param [in]	cc			Pointer to container_config_t.
  * @param [in]	host_path	Path for dynamic mount source.
@@ -446,6 +655,17 @@ int lxcutil_dynamic_mount_to_guest(container_config_t *cc, const char *host_path
 	(void) memset(&mnt, 0, sizeof(mnt));
 	mnt.version = LXC_MOUNT_API_V1;
 
+	if ((cc->runtime_stat.lxc != NULL) && (host_path != NULL) && (guest_path != NULL)
+		&& (mount_disk_is_detached_supported() == 1)) {
+		ret = lxcutil_dynamic_mount_to_guest_detached(cc, host_path, guest_path);
+		#ifdef _PRINTF_DEBUG_
+		fprintf(stdout, "lxcutil_dynamic_mount_to_guest: detached from %s to %s ret = %d\n", host_path, guest_path, ret);
+		#endif
+		if (ret == 0) {
+			return 0;
+		}
+		// Fallback to lxc mount interface.
+	}
 
 	if ((cc->runtime_stat.lxc != NULL) && (host_path != NULL) && (guest_path != NULL)) {
 		/*	int (*mount)(struct lxc_container *c, const char *source,
@@ -33,7 +33,10 @@ int lxcutil_container_shutdown(container_config_t *cc);
 int lxcutil_container_forcekill(container_config_t *cc);
 int lxcutil_release_instance(container_config_t *cc);
 pid_t lxcutil_get_init_pid(container_config_t *cc);
+int lxcutil_get_netns_fd(container_config_t *cc);
 
+int lxcutil_cgroup_device_attach(container_config_t *cc);
+int lxcutil_netif_shaping_setup(container_config_t *cc);
 int lxcutil_dynamic_device_operation(container_config_t *cc, lxcutil_dynamic_device_request_t *lddr);
 
 int lxcutil_dynamic_networkif_add_to_guest(container_config_t *cc, container_dynamic_netif_elem_t *cdne);
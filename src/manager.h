@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "list.h"
+#include "recovery-scheduler.h"
 
 //-----------------------------------------------------------------------------
 // Manager config ---------------------------------
@@ -93,6 +94,11 @@ typedef struct s_container_manager_bridge_config container_manager_bridge_config
  * @brief	.
  */
 #define MANAGER_WORKER_STATE_CANCELED	(3)
+/**
+ * @def	MANAGER_WORKER_STATE_RUNNING
+ * @brief	Recovery operation of this element is running.
+ */
+#define MANAGER_WORKER_STATE_RUNNING	(4)
 /**
  * @struct	s_container_manager_operation_mount_elem
  * @brief	The data structure for manager mount disk.  It's a list element for mount_list of s_container_manager_operation_mount.
@@ -112,6 +118,8 @@ struct s_container_manager_operation_mount_elem {
 	int is_dispatched;		/**< Already dispatched worker 0:no 1: yes.*/
 	int error_count;		/**< mount error count of this extra disk. That exclude busy error.*/
 	int state;				/**< State of this worker.*/
+	int failover_cache;		/**< Mounted disk of failover redundancy in previous mount. 0: not cached, 1: primary, 2: secondary. */
+	recovery_ticket_t ticket;	/**< Recovery scheduler ticket for this element. */
 };
 typedef struct s_container_manager_operation_mount_elem container_manager_operation_mount_elem_t;	/**< typedef for struct s_container_manager_operation_mound_elem. */
 
@@ -132,17 +140,51 @@ typedef struct s_container_manager_operation_mount container_manager_operation_m
 struct s_container_manager_operation_storage;
 typedef struct s_container_manager_operation_storage container_manager_operation_storage_t;	/**< typedef for struct s_container_manager_operation_storage. */
 
+/**
+ * @def	MANAGER_OPERATION_PARALLEL_DEFAULT
+ * @brief	Default number of concurrent manager mount and recovery operations.
+ */
+#define MANAGER_OPERATION_PARALLEL_DEFAULT	(2)
+/**
+ * @def	MANAGER_OPERATION_PARALLEL_MAX
+ * @brief	Maximum number of concurrent manager mount and recovery operations.
+ */
+#define MANAGER_OPERATION_PARALLEL_MAX		(8)
 /**
  * @struct	s_container_manager_operation
  * @brief	The data structure for manager operation.
  */
 struct s_container_manager_operation {
 	container_manager_operation_mount_t mount;		/**< Mount operation. */
+	int parallel;									/**< Number of concurrent mount and recovery operations. */
+	int recovery_ioweight;							/**< io.weight for recovery cgroup. */
+	int64_t recovery_iomax;							/**< Bandwidth limit (byte/sec) for recovery target disk. 0 is no limit. */
+	int recovery_budget;							/**< Time budget (sec) of last tier recovery (fsck full check, mkfs and clone). 0 is no limit. */
 	//--- internal control data
 	container_manager_operation_storage_t *storage;
 };
 typedef struct s_container_manager_operation container_manager_operation_t;	/**< typedef for struct s_container_manager_operation. */
 
+/**
+ * @def	MANAGER_UEVENT_SOURCE_LIBUDEV
+ * @brief	Dynamic device manager receive uevent using libudev and rebuild injection message from udev properties. It use at s_container_manager_dynamic_device.uevent_source.
+ */
+#define MANAGER_UEVENT_SOURCE_LIBUDEV	(0)
+/**
+ * @def	MANAGER_UEVENT_SOURCE_RAW
+ * @brief	Dynamic device manager receive uevent from kernel uevent netlink group directly and forward original payload. It use at s_container_manager_dynamic_device.uevent_source.
+ */
+#define MANAGER_UEVENT_SOURCE_RAW		(1)
+/**
+ * @struct	s_container_manager_dynamic_device
+ * @brief	The data structure for dynamic device manager options.
+ */
+struct s_container_manager_dynamic_device {
+	int uevent_source;		/**< uevent source mode. (libudev=MANAGER_UEVENT_SOURCE_LIBUDEV/raw=MANAGER_UEVENT_SOURCE_RAW) */
+	//--- internal control data
+};
+typedef struct s_container_manager_dynamic_device container_manager_dynamic_device_t;	/**< typedef for struct s_container_manager_dynamic_device. */
+
 struct s_container_config;
 typedef struct s_container_config container_config_t;
 
@@ -177,6 +219,7 @@ struct s_container_manager_config {
 	char *configdir;			/**< Guest container config directory */
 	struct dl_list bridgelist;	/**< Double link list for s_container_manager_bridge_config. */
 	container_manager_operation_t operation;	/**< The manager operations. */
+	container_manager_dynamic_device_t dynamicdevice;	/**< The dynamic device manager options. */
 	//--- internal control data
 	struct dl_list role_list;	/**< Double link list for s_container_manager_role_config. */
 };
@@ -17,6 +17,8 @@
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "list.h"
 
@@ -25,6 +27,38 @@
 
 #undef _PRINTF_DEBUG_
 
+/**
+ * @def	NETIFMONITOR_RECV_BUFFER_SIZE
+ * @brief	Default receive buffer size for RTNL netlink message. Larger message is received using allocated buffer.
+ */
+#define NETIFMONITOR_RECV_BUFFER_SIZE	(8192)
+/**
+ * @def	NETIFMONITOR_SOCKET_RCVBUF_SIZE
+ * @brief	Socket receive buffer size for RTNL netlink socket. Many link changes are happened at boot time.
+ */
+#define NETIFMONITOR_SOCKET_RCVBUF_SIZE	(1024*1024)
+/**
+ * @def	NETIFMONITOR_NETNS_MOVE_MAX
+ * @brief	Maximum number of in-flight netns move request. A batch is flushed when this limit is reached.
+ */
+#define NETIFMONITOR_NETNS_MOVE_MAX	(32)
+/**
+ * @def	NETIFMONITOR_BATCH_LIMIT
+ * @brief	Size limit of one netlink batch for netns move request.
+ */
+#define NETIFMONITOR_BATCH_LIMIT	(8192)
+
+/**
+ * @struct	s_netifmonitor_netns_move
+ * @brief	The data structure for in-flight netns move request.
+ */
+struct s_netifmonitor_netns_move {
+	unsigned int seq;			/**< Sequence number of request. 0 is unused entry. */
+	int ifindex;				/**< Target network interface index. */
+	char ifname[IFNAMSIZ+1];	/**< Target network interface name. */
+	int netns_fd;				/**< Duplicated fd of target network namespace. It's owned by this request until completion. */
+};
+
 /**
  * @struct	s_netifmonitor
  * @brief	Top level data for network interface monitor.
@@ -33,6 +67,17 @@ struct s_netifmonitor {
 	struct mnl_socket *nl;				/**< A memory object for libmnl. */
 	sd_event_source *ifmonitor_source;	/**< The sd event source for netlink socket controlled by libmnl. */
 	container_control_interface_t *cci;	/**< Reference to container manager control interface. */
+	int is_resync;						/**< Resync is running. 1: running, 0: not running.  Per link notification is suppressed in resync. */
+	//--- netns move request
+	sd_event *event;					/**< Instance of sd_event. (main loop) */
+	struct mnl_socket *nl_ctrl;			/**< A memory object for libmnl to send link operation request. */
+	sd_event_source *ctrl_source;		/**< The sd event source for acknowledgement of link operation request. */
+	sd_event_source *flush_source;		/**< The sd event source (defer) to flush queued request. */
+	unsigned int ctrl_seq;				/**< Last sequence number of link operation request. */
+	unsigned int ctrl_portid;			/**< Port id of nl_ctrl. */
+	struct mnl_nlmsg_batch *batch;		/**< Batch of queued link operation request. */
+	char batch_buf[NETIFMONITOR_BATCH_LIMIT * 2];	/**< Buffer for batch. libmnl require double size of limit. */
+	struct s_netifmonitor_netns_move move[NETIFMONITOR_NETNS_MOVE_MAX];	/**< In-flight netns move request. */
 };
 
 /**
@@ -178,8 +223,10 @@ static int data_cb(const struct nlmsghdr *nlh, void *data)
 
 		dl_list_add(&netif->nllist, &nfi_new->list);
 
-		// Update notification
-		(void)cci->netif_updated(cci);
+		// Update notification - only this link
+		if (nfm->is_resync == 0) {
+			(void)cci->netif_link_changed(cci, 1, ifindex, ifname);
+		}
 
 	} else if (nlh->nlmsg_type == RTM_DELLINK) {
 		network_interface_info_t *nfi = NULL, *nfi_n = NULL;
@@ -199,8 +246,10 @@ static int data_cb(const struct nlmsghdr *nlh, void *data)
 
 		(void) network_interface_info_free(nfi_new);
 
-		// Update notification
-		(void)cci->netif_updated(cci);
+		// Update notification - only this link
+		if (nfm->is_resync == 0) {
+			(void)cci->netif_link_changed(cci, 0, ifindex, ifname);
+		}
 
 	} else {
 		// No operation. need to free alloced memory
@@ -210,9 +259,137 @@ static int data_cb(const struct nlmsghdr *nlh, void *data)
 out:
 	return MNL_CB_OK;
 }
+static int netifmonitor_listing_existif(dynamic_device_manager_t *ddm);
+/**
+ * Get and clear pending error of netlink socket.
+ * Netlink socket overflow (ENOBUFS) is reported as EPOLLERR, it's cleared by this function.
+ *
+ * @param [in]	fd	File descriptor for netlink socket.
+ * @return int
+ * @retval	0	No pending error.
+ * @retval	>0	Pending error (errno).
+ * @retval	-1	Fail to get error.  Socket is broken.
+ */
+static int netifmonitor_socket_error(int fd)
+{
+	int error = 0;
+	socklen_t len = sizeof(error);
+	int ret = -1;
+
+	ret = getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+	if (ret < 0) {
+		return -1;
+	}
+
+	return error;
+}
+/**
+ * Receive one RTNL netlink message and dispatch it to data_cb.
+ * The receive buffer is sized by MSG_PEEK|MSG_TRUNC, large message is received by allocated buffer.
+ *
+ * @param [in]	ddm	Pointer to dynamic_device_manager_t.
+ * @param [in]	nl	The mnl_socket for RTNL netlink.
+ * @return int
+ * @retval	0	Success to receive one message.
+ * @retval	1	No more message (EAGAIN).
+ * @retval	-1	Receive error.
+ * @retval	-2	Socket buffer was overflowed (ENOBUFS), some messages were lost.
+ */
+static int netifmonitor_receive_one(dynamic_device_manager_t *ddm, struct mnl_socket *nl)
+{
+	char buf[NETIFMONITOR_RECV_BUFFER_SIZE];
+	char *pbuf = buf;
+	size_t bufsize = sizeof(buf);
+	ssize_t msglen = -1;
+	int fd = -1;
+	int ret = -1, result = 0;
+
+	fd = mnl_socket_get_fd(nl);
+
+	do {
+		msglen = recv(fd, NULL, 0, (MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT));
+	} while ((msglen < 0) && (errno == EINTR));
+
+	if (msglen < 0) {
+		if (errno == ENOBUFS) {
+			return -2;
+		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			return 1;
+		}
+		return -1;
+	}
+
+	if ((size_t)msglen > bufsize) {
+		pbuf = (char*)malloc((size_t)msglen);
+		if (pbuf == NULL) {
+			// Drop this message. It's same as overflow.
+			(void) recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+			return -2;
+		}
+		bufsize = (size_t)msglen;
+	}
+
+	ret = mnl_socket_recvfrom(nl, pbuf, bufsize);
+	if (ret > 0) {
+		(void) mnl_cb_run(pbuf, ret, 0, 0, data_cb, ddm);
+		result = 0;
+	} else if ((ret < 0) && (errno == ENOBUFS)) {
+		result = -2;
+	} else if ((ret < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+		result = 1;
+	} else {
+		result = -1;
+	}
+
+	if (pbuf != buf) {
+		(void) free(pbuf);
+	}
+
+	return result;
+}
+/**
+ * Resync network interface list after RTNL netlink socket overflow.
+ * The network interface list is re-constructed by fresh RTM_GETLINK dump and a single coalesced update is notified.
+ *
+ * @param [in]	ddm	Pointer to dynamic_device_manager_t.
+ * @return int
+ * @retval	0	Success to resync.
+ * @retval	-1	Fail to get network interface list.
+ */
+static int netifmonitor_resync(dynamic_device_manager_t *ddm)
+{
+	struct s_netifmonitor *nfm = NULL;
+	network_interface_info_t *nfi = NULL, *nfi_n = NULL;
+	int ret = -1;
+
+	nfm = (struct s_netifmonitor*)ddm->netifmon;
+
+	#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+	(void) fprintf(stderr,"[CM CRITICAL INFO] Network interface monitor was overflowed, resync.\n");
+	#endif
+
+	dl_list_for_each_safe(nfi, nfi_n, &ddm->netif.nllist, network_interface_info_t, list) {
+		dl_list_del(&nfi->list);
+		(void) network_interface_info_free(nfi);
+	}
+
+	nfm->is_resync = 1;
+	ret = netifmonitor_listing_existif(ddm);
+	nfm->is_resync = 0;
+
+	// Coalesced update notification - full rescan in container manager side.
+	(void) nfm->cci->netif_updated(nfm->cci);
+
+	if (ret < 0) {
+		return -1;
+	}
+
+	return 0;
+}
 /**
  * Event handler for libmnl RTNL netlink socket.
- * This function analyze received data using libmnl.
+ * This function drain all received data and analyze it using libmnl.
+ * When the socket was overflowed, network interface list is resynced.
  *
  * @param [in]	event		RTNL netlink event source object.
  * @param [in]	fd			File descriptor for RTNL netlink session.
@@ -224,8 +401,8 @@ out:
  */
 static int nml_event_handler(sd_event_source *event, int fd, uint32_t revents, void *userdata)
 {
-	char buf[8192];
 	int ret = 0;
+	int is_overflow = 0;
 	dynamic_device_manager_t *ddm = NULL;
 	struct s_netifmonitor *nfm = NULL;
 	struct mnl_socket *nl = NULL;
@@ -240,17 +417,43 @@ static int nml_event_handler(sd_event_source *event, int fd, uint32_t revents, v
 	nfm = (struct s_netifmonitor*)ddm->netifmon;
 	nl = nfm->nl;
 
-	if ((revents & (EPOLLHUP | EPOLLERR)) != 0) {
-		// Fail safe - disable udev event
+	if ((revents & EPOLLHUP) != 0) {
+		// Fail safe - disable netlink event
 		(void) sd_event_source_disable_unref(event);
-	} else if ((revents & EPOLLIN) != 0) {
-		// Receive
-		ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
-		if (ret > 0) {
-			(void) mnl_cb_run(buf, ret, 0, 0, data_cb, ddm);
+		nfm->ifmonitor_source = NULL;
+		return 0;
+	}
+
+	if ((revents & EPOLLERR) != 0) {
+		// Overflow is reported as socket error, clear it and recover by resync.
+		ret = netifmonitor_socket_error(fd);
+		if (ret == ENOBUFS) {
+			is_overflow = 1;
+		} else if (ret != 0) {
+			// Real socket failure - disable netlink event
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] Network interface monitor socket error (%d), monitor is disabled.\n", ret);
+			#endif
+			(void) sd_event_source_disable_unref(event);
+			nfm->ifmonitor_source = NULL;
+			return 0;
+		} else {
+			;	//nop
+		}
+	}
+
+	if (((revents & EPOLLIN) != 0) || (is_overflow == 1)) {
+		// Drain until EAGAIN.
+		do {
+			ret = netifmonitor_receive_one(ddm, nl);
+			if (ret == -2) {
+				is_overflow = 1;
+			}
+		} while ((ret == 0) || (ret == -2));
+
+		if (is_overflow == 1) {
+			(void) netifmonitor_resync(ddm);
 		}
-	} else {
-		;	//nop
 	}
 
 	#ifdef _PRINTF_DEBUG_
@@ -259,6 +462,374 @@ static int nml_event_handler(sd_event_source *event, int fd, uint32_t revents, v
 
 	return 0;
 }
+/**
+ * Release in-flight netns move request.  When request was fail, remove notification is sent to release ownership.
+ *
+ * @param [in]	nfm			Pointer to struct s_netifmonitor.
+ * @param [in]	index		Index of in-flight request.
+ * @param [in]	is_fail		Request was fail or not. 1: fail, 0: success.
+ * @return void
+ */
+static void netifmonitor_netns_move_complete(struct s_netifmonitor *nfm, int index, int is_fail)
+{
+	if (is_fail == 1) {
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"netifmonitor: fail to move %s(%d) to guest\n", nfm->move[index].ifname, nfm->move[index].ifindex);
+		#endif
+		// The interface is remaining in host. Release ownership, it will be re-assigned at next link event.
+		(void)nfm->cci->netif_link_changed(nfm->cci, 0, nfm->move[index].ifindex, nfm->move[index].ifname);
+	}
+
+	if (nfm->move[index].netns_fd >= 0) {
+		(void) close(nfm->move[index].netns_fd);
+	}
+
+	(void) memset(&nfm->move[index], 0, sizeof(nfm->move[index]));
+	nfm->move[index].netns_fd = -1;
+}
+/**
+ * Flush all queued netns move request as one netlink batch.
+ *
+ * @param [in]	nfm		Pointer to struct s_netifmonitor.
+ * @return int
+ * @retval	0	Success to send.
+ * @retval	-1	Fail to send. Queued requests are treated as failed.
+ */
+static int netifmonitor_netns_move_flush(struct s_netifmonitor *nfm)
+{
+	ssize_t ret = -1;
+	int result = 0;
+
+	if (nfm->flush_source != NULL) {
+		(void) sd_event_source_disable_unref(nfm->flush_source);
+		nfm->flush_source = NULL;
+	}
+
+	if (mnl_nlmsg_batch_is_empty(nfm->batch) == true) {
+		return 0;
+	}
+
+	ret = mnl_socket_sendto(nfm->nl_ctrl, mnl_nlmsg_batch_head(nfm->batch), mnl_nlmsg_batch_size(nfm->batch));
+	if (ret < 0) {
+		// All in-flight request that is not acknowledged yet in this batch are failed.
+		const struct nlmsghdr *nlh = (const struct nlmsghdr*)mnl_nlmsg_batch_head(nfm->batch);
+		int len = (int)mnl_nlmsg_batch_size(nfm->batch);
+
+		while (mnl_nlmsg_ok(nlh, len) == true) {
+			for (int i = 0; i < NETIFMONITOR_NETNS_MOVE_MAX; i++) {
+				if ((nfm->move[i].seq != 0u) && (nfm->move[i].seq == nlh->nlmsg_seq)) {
+					netifmonitor_netns_move_complete(nfm, i, 1);
+				}
+			}
+			nlh = mnl_nlmsg_next(nlh, &len);
+		}
+		result = -1;
+	}
+
+	mnl_nlmsg_batch_reset(nfm->batch);
+
+	return result;
+}
+/**
+ * Defer event handler to flush queued netns move request.
+ * This handler is dispatched after higher priority internal events, some requests are coalesced into one batch.
+ *
+ * @param [in]	es			sd event source.
+ * @param [in]	userdata	Pointer to struct s_netifmonitor.
+ * @return int
+ * @retval	0	Success to event handling.
+ */
+static int netifmonitor_netns_move_flush_handler(sd_event_source *es, void *userdata)
+{
+	struct s_netifmonitor *nfm = (struct s_netifmonitor*)userdata;
+
+	if (nfm == NULL) {
+		(void) sd_event_source_disable_unref(es);
+		return 0;
+	}
+
+	(void) netifmonitor_netns_move_flush(nfm);
+
+	return 0;
+}
+/**
+ * Event handler for acknowledgement of netns move request.
+ *
+ * @param [in]	event		Netlink event source object.
+ * @param [in]	fd			File descriptor for netlink session.
+ * @param [in]	revents		Active event (epoll).
+ * @param [in]	userdata	Pointer to struct s_netifmonitor.
+ * @return int
+ * @retval	0	Success to event handling.
+ */
+static int netifmonitor_netns_move_ack_handler(sd_event_source *event, int fd, uint32_t revents, void *userdata)
+{
+	char buf[NETIFMONITOR_RECV_BUFFER_SIZE];
+	struct s_netifmonitor *nfm = NULL;
+	const struct nlmsghdr *nlh = NULL;
+	int ret = -1;
+	int is_overflow = 0, is_broken = 0;
+
+	if (userdata == NULL) {
+		(void) sd_event_source_disable_unref(event);
+		return 0;
+	}
+
+	nfm = (struct s_netifmonitor*)userdata;
+
+	if ((revents & EPOLLHUP) != 0) {
+		(void) sd_event_source_disable_unref(event);
+		nfm->ctrl_source = NULL;
+		// No more acknowledgement, release all in-flight request.
+		is_overflow = 1;
+		is_broken = 1;
+	} else if ((revents & EPOLLERR) != 0) {
+		// Overflow is reported as socket error, clear it.
+		ret = netifmonitor_socket_error(fd);
+		if (ret == ENOBUFS) {
+			is_overflow = 1;
+		} else if (ret != 0) {
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] Network interface move socket error (%d).\n", ret);
+			#endif
+			(void) sd_event_source_disable_unref(event);
+			nfm->ctrl_source = NULL;
+			// No more acknowledgement, release all in-flight request.
+			is_overflow = 1;
+			is_broken = 1;
+		} else {
+			;	//nop
+		}
+	}
+
+	if (((revents & EPOLLIN) == 0) && (is_overflow == 0)) {
+		return 0;
+	}
+
+	while (is_broken == 0) {
+		ret = mnl_socket_recvfrom(nfm->nl_ctrl, buf, sizeof(buf));
+		if ((ret < 0) && (errno == ENOBUFS)) {
+			is_overflow = 1;
+			continue;
+		}
+		if (ret <= 0) {
+			break;
+		}
+
+		nlh = (const struct nlmsghdr*)buf;
+		while (mnl_nlmsg_ok(nlh, ret) == true) {
+			if (nlh->nlmsg_type == NLMSG_ERROR) {
+				const struct nlmsgerr *err = mnl_nlmsg_get_payload(nlh);
+
+				for (int i = 0; i < NETIFMONITOR_NETNS_MOVE_MAX; i++) {
+					if ((nfm->move[i].seq != 0u) && (nfm->move[i].seq == nlh->nlmsg_seq)) {
+						netifmonitor_netns_move_complete(nfm, i, ((err->error != 0) ? 1 : 0));
+						break;
+					}
+				}
+			}
+			nlh = mnl_nlmsg_next(nlh, &ret);
+		}
+	}
+
+	if (is_overflow == 1) {
+		// Acknowledgement of in-flight request may be lost.  Treat as failed, link state is resynced by remove notification.
+		for (int i = 0; i < NETIFMONITOR_NETNS_MOVE_MAX; i++) {
+			if (nfm->move[i].seq != 0u) {
+				netifmonitor_netns_move_complete(nfm, i, 1);
+			}
+		}
+	}
+
+	return 0;
+}
+/**
+ * Queue a request to move network interface to other network namespace.
+ * The request is sent as RTM_NEWLINK with IFLA_NET_NS_FD in a batch, it's flushed on event loop.
+ * Network interface name and link state are not changed, same as lxc attach_interface fallback.
+ * Acknowledgement is handled asynchronously, when it fail, remove notification is sent to container manager state machine.
+ * netns_fd is duplicated for the request, caller can close or re-open own fd before the request is flushed.
+ *
+ * @param [in]	ddm			Pointer to dynamic_device_manager_t.
+ * @param [in]	ifindex		Target network interface index in host.
+ * @param [in]	ifname		Target network interface name in host.
+ * @param [in]	netns_fd	A fd of target network namespace.
+ * @return int
+ * @retval	0	Success to queue request.
+ * @retval	-1	Can not queue request. Caller shall use other method.
+ * @retval	-2	Argument error.
+ */
+int netifmonitor_netns_move_queue(dynamic_device_manager_t *ddm, int ifindex, const char *ifname, int netns_fd)
+{
+	struct s_netifmonitor *nfm = NULL;
+	struct nlmsghdr *nlh = NULL;
+	struct ifinfomsg *ifm = NULL;
+	int index = -1;
+	int ret = -1;
+	int dup_fd = -1;
+
+	if ((ddm == NULL) || (ifname == NULL) || (ifindex <= 0) || (netns_fd < 0)) {
+		return -2;
+	}
+
+	nfm = (struct s_netifmonitor*)ddm->netifmon;
+	if ((nfm == NULL) || (nfm->nl_ctrl == NULL) || (nfm->ctrl_source == NULL)) {
+		return -1;
+	}
+
+	for (int i = 0; i < NETIFMONITOR_NETNS_MOVE_MAX; i++) {
+		if (nfm->move[i].seq == 0u) {
+			index = i;
+			break;
+		}
+	}
+	if (index < 0) {
+		// Too many in-flight requests.
+		return -1;
+	}
+
+	// The request is sent later, keep own reference of target network namespace.
+	dup_fd = fcntl(netns_fd, F_DUPFD_CLOEXEC, 0);
+	if (dup_fd < 0) {
+		return -1;
+	}
+
+	nfm->ctrl_seq++;
+	if (nfm->ctrl_seq == 0u) {
+		nfm->ctrl_seq = 1u;
+	}
+
+	nlh = mnl_nlmsg_put_header(mnl_nlmsg_batch_current(nfm->batch));
+	nlh->nlmsg_type	= RTM_NEWLINK;
+	nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+	nlh->nlmsg_seq = nfm->ctrl_seq;
+
+	ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(struct ifinfomsg));
+	ifm->ifi_family = AF_UNSPEC;
+	ifm->ifi_index = ifindex;
+
+	mnl_attr_put_u32(nlh, IFLA_NET_NS_FD, (uint32_t)dup_fd);
+
+	if (mnl_nlmsg_batch_next(nfm->batch) == false) {
+		// May not cause, batch limit is larger than NETIFMONITOR_NETNS_MOVE_MAX requests.
+		mnl_nlmsg_batch_reset(nfm->batch);
+		(void) close(dup_fd);
+		return -1;
+	}
+
+	nfm->move[index].seq = nfm->ctrl_seq;
+	nfm->move[index].netns_fd = dup_fd;
+	nfm->move[index].ifindex = ifindex;
+	(void) strncpy(nfm->move[index].ifname, ifname, sizeof(nfm->move[index].ifname) - 1u);
+
+	if (nfm->flush_source == NULL) {
+		ret = sd_event_add_defer(nfm->event, &nfm->flush_source, netifmonitor_netns_move_flush_handler, nfm);
+		if (ret < 0) {
+			// Can not defer, flush now.
+			nfm->flush_source = NULL;
+			(void) netifmonitor_netns_move_flush(nfm);
+		}
+	}
+
+	return 0;
+}
+/**
+ * Sub function for network if monitor.
+ * Setup for the netns move request session.  When this setup was fail, netns move is not available.
+ *
+ * @param [in]	nfm		Pointer to struct s_netifmonitor.
+ * @param [in]	event	Instance of sd_event. (main loop)
+ * @return int
+ * @retval	0	Success to setup.
+ * @retval	-1	Internal error.
+ */
+static int netifmonitor_netns_move_setup(struct s_netifmonitor *nfm, sd_event *event)
+{
+	struct mnl_socket *nl = NULL;
+	sd_event_source *ctrl_source = NULL;
+	int ret = -1;
+
+	nl = mnl_socket_open2(NETLINK_ROUTE, SOCK_CLOEXEC | SOCK_NONBLOCK);
+	if (nl == NULL) {
+		goto err_return;
+	}
+
+	ret = mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID);
+	if (ret < 0) {
+		goto err_return;
+	}
+
+	ret = sd_event_add_io(event, &ctrl_source, mnl_socket_get_fd(nl), EPOLLIN, netifmonitor_netns_move_ack_handler, nfm);
+	if (ret < 0) {
+		goto err_return;
+	}
+
+	nfm->batch = mnl_nlmsg_batch_start(nfm->batch_buf, NETIFMONITOR_BATCH_LIMIT);
+	if (nfm->batch == NULL) {
+		goto err_return;
+	}
+
+	nfm->event = event;
+	nfm->nl_ctrl = nl;
+	nfm->ctrl_source = ctrl_source;
+	nfm->ctrl_portid = mnl_socket_get_portid(nl);
+	nfm->ctrl_seq = 0;
+	for (int i = 0; i < NETIFMONITOR_NETNS_MOVE_MAX; i++) {
+		nfm->move[i].netns_fd = -1;
+	}
+
+	return 0;
+
+err_return:
+	if (ctrl_source != NULL) {
+		(void) sd_event_source_disable_unref(ctrl_source);
+	}
+
+	if (nl != NULL) {
+		(void) mnl_socket_close(nl);
+	}
+
+	return -1;
+}
+/**
+ * Sub function for network if monitor.
+ * Cleanup for the netns move request session.
+ *
+ * @param [in]	nfm		Pointer to struct s_netifmonitor.
+ * @return void
+ */
+static void netifmonitor_netns_move_cleanup(struct s_netifmonitor *nfm)
+{
+	for (int i = 0; i < NETIFMONITOR_NETNS_MOVE_MAX; i++) {
+		if (nfm->move[i].seq != 0u) {
+			if (nfm->move[i].netns_fd >= 0) {
+				(void) close(nfm->move[i].netns_fd);
+			}
+			(void) memset(&nfm->move[i], 0, sizeof(nfm->move[i]));
+			nfm->move[i].netns_fd = -1;
+		}
+	}
+
+	if (nfm->flush_source != NULL) {
+		(void) sd_event_source_disable_unref(nfm->flush_source);
+		nfm->flush_source = NULL;
+	}
+
+	if (nfm->batch != NULL) {
+		mnl_nlmsg_batch_stop(nfm->batch);
+		nfm->batch = NULL;
+	}
+
+	if (nfm->ctrl_source != NULL) {
+		(void) sd_event_source_disable_unref(nfm->ctrl_source);
+		nfm->ctrl_source = NULL;
+	}
+
+	if (nfm->nl_ctrl != NULL) {
+		(void) mnl_socket_close(nfm->nl_ctrl);
+		nfm->nl_ctrl = NULL;
+	}
+}
 /**
  * Sub function for network if monitor.
  * List up for the existing network if.
@@ -376,6 +947,16 @@ int netifmonitor_setup(dynamic_device_manager_t *ddm, container_control_interfac
 
 	fd = mnl_socket_get_fd(nl);
 
+	// Enlarge socket buffer to avoid overflow at many link changes. When it's fail, overflow is recovered by resync.
+	{
+		int rcvbuf = NETIFMONITOR_SOCKET_RCVBUF_SIZE;
+
+		ret = setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf));
+		if (ret < 0) {
+			(void) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+		}
+	}
+
 	ret = sd_event_add_io(event, &ifmonitor_source, fd, EPOLLIN, nml_event_handler, ddm);
 	if (ret < 0) {
 		goto err_return;
@@ -384,6 +965,9 @@ int netifmonitor_setup(dynamic_device_manager_t *ddm, container_control_interfac
 	netifmon->nl = nl;
 	netifmon->ifmonitor_source = ifmonitor_source;
 	netifmon->cci = cci;
+
+	// Native netns move is optional. When it's not available, network interface is moved by lxc.
+	(void) netifmonitor_netns_move_setup(netifmon, event);
 	dl_list_init(&ddm->netif.nllist);
 
 	ddm->netifmon = (netifmonitor_t*)netifmon;
@@ -397,6 +981,10 @@ int netifmonitor_setup(dynamic_device_manager_t *ddm, container_control_interfac
 	return 0;
 
 err_return:
+	if (netifmon != NULL) {
+		netifmonitor_netns_move_cleanup(netifmon);
+	}
+
 	if (nl != NULL) {
 		(void) mnl_socket_close(nl);
 	}
@@ -435,6 +1023,8 @@ int netifmonitor_cleanup(dynamic_device_manager_t *ddm)
 
 	netifmon = (struct s_netifmonitor*)ddm->netifmon;
 
+	netifmonitor_netns_move_cleanup(netifmon);
+
 	if (netifmon->ifmonitor_source != NULL) {
 		(void) sd_event_source_disable_unref(netifmon->ifmonitor_source);
 	}
@@ -487,3 +1077,398 @@ int network_interface_info_get(network_interface_manager_t **netif, dynamic_devi
 
 	return 0;
 }
+//-----------------------------------------------------------------------------
+/**
+ * @def	NETUTIL_LINK_BATCH_LIMIT
+ * @brief	Size limit of one netlink batch for link preparation.
+ */
+#define NETUTIL_LINK_BATCH_LIMIT	(16*1024)
+
+/**
+ * @struct	s_netutil_link_batch
+ * @brief	The data structure for multi message rtnetlink link transaction.
+ */
+struct s_netutil_link_batch {
+	struct mnl_nlmsg_batch *batch;					/**< libmnl batch object. */
+	char buf[NETUTIL_LINK_BATCH_LIMIT * 2];			/**< Buffer for batch. libmnl require double size of limit. */
+	int num;										/**< Number of messages in this batch. */
+	int error[NETUTIL_LINK_BATCH_MSG_MAX];			/**< Result of each message. 0 or negative errno. */
+};
+
+/**
+ * Create multi message rtnetlink link transaction.
+ *
+ * @param [out]	nlb	Double pointer to netutil_link_batch_t to store created object.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Memory allocation error.
+ * @retval	-2	Argument error.
+ */
+int netutil_link_batch_create(netutil_link_batch_t **nlb)
+{
+	netutil_link_batch_t *pnlb = NULL;
+
+	if (nlb == NULL) {
+		return -2;
+	}
+
+	pnlb = (netutil_link_batch_t*)malloc(sizeof(netutil_link_batch_t));
+	if (pnlb == NULL) {
+		return -1;
+	}
+	(void) memset(pnlb, 0, sizeof(netutil_link_batch_t));
+
+	pnlb->batch = mnl_nlmsg_batch_start(pnlb->buf, NETUTIL_LINK_BATCH_LIMIT);
+	if (pnlb->batch == NULL) {
+		(void) free(pnlb);
+		return -1;
+	}
+
+	(*nlb) = pnlb;
+
+	return 0;
+}
+/**
+ * Release multi message rtnetlink link transaction.
+ *
+ * @param [in]	nlb	Pointer to netutil_link_batch_t.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-2	Argument error.
+ */
+int netutil_link_batch_release(netutil_link_batch_t *nlb)
+{
+	if (nlb == NULL) {
+		return -2;
+	}
+
+	if (nlb->batch != NULL) {
+		mnl_nlmsg_batch_stop(nlb->batch);
+	}
+	(void) free(nlb);
+
+	return 0;
+}
+/**
+ * Start new RTM_NEWLINK/RTM_DELLINK message in link transaction.
+ *
+ * @param [in]	nlb		Pointer to netutil_link_batch_t.
+ * @param [in]	type	Message type.
+ * @param [in]	flags	Message flags. NLM_F_REQUEST and NLM_F_ACK are added automatically.
+ * @param [in]	ifname	Target interface name.
+ * @param [in]	is_up	Link up (=1) or not change (=0).
+ * @return struct nlmsghdr*
+ * @retval	!=NULL	Header of new message.
+ * @retval	NULL	Batch is full.
+ */
+static struct nlmsghdr *netutil_link_batch_put_header(netutil_link_batch_t *nlb, uint16_t type, uint16_t flags, const char *ifname, int is_up)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct ifinfomsg *ifm = NULL;
+
+	if (nlb->num >= NETUTIL_LINK_BATCH_MSG_MAX) {
+		return NULL;
+	}
+
+	// A link message is less than 512 bytes.
+	if ((mnl_nlmsg_batch_size(nlb->batch) + 512u) > NETUTIL_LINK_BATCH_LIMIT) {
+		return NULL;
+	}
+
+	nlh = mnl_nlmsg_put_header(mnl_nlmsg_batch_current(nlb->batch));
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = (NLM_F_REQUEST | NLM_F_ACK | flags);
+	nlh->nlmsg_seq = (unsigned int)nlb->num + 1u;
+
+	ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*ifm));
+	ifm->ifi_family = AF_UNSPEC;
+	if (is_up == 1) {
+		ifm->ifi_change = IFF_UP;
+		ifm->ifi_flags = IFF_UP;
+	}
+
+	mnl_attr_put_strz(nlh, IFLA_IFNAME, ifname);
+
+	return nlh;
+}
+/**
+ * Finish current message in link transaction.
+ *
+ * @param [in]	nlb		Pointer to netutil_link_batch_t.
+ * @return int
+ * @retval	>=0	Message id.
+ */
+static int netutil_link_batch_next(netutil_link_batch_t *nlb)
+{
+	int id = nlb->num;
+
+	(void) mnl_nlmsg_batch_next(nlb->batch);
+	nlb->num++;
+
+	return id;
+}
+/**
+ * Add bridge creation message to link transaction.  Existing bridge is not error.
+ *
+ * @param [in]	nlb		Pointer to netutil_link_batch_t.
+ * @param [in]	ifname	Bridge name.
+ * @return int
+ * @retval	>=0	Message id.
+ * @retval	-1	Batch is full.
+ * @retval	-2	Argument error.
+ */
+int netutil_link_batch_add_bridge(netutil_link_batch_t *nlb, const char *ifname)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct nlattr *linkinfo = NULL;
+
+	if ((nlb == NULL) || (ifname == NULL)) {
+		return -2;
+	}
+
+	nlh = netutil_link_batch_put_header(nlb, RTM_NEWLINK, NLM_F_CREATE, ifname, 0);
+	if (nlh == NULL) {
+		return -1;
+	}
+
+	linkinfo = mnl_attr_nest_start(nlh, IFLA_LINKINFO);
+	mnl_attr_put_strz(nlh, IFLA_INFO_KIND, "bridge");
+	mnl_attr_nest_end(nlh, linkinfo);
+
+	return netutil_link_batch_next(nlb);
+}
+/**
+ * Add virtual link pair (veth or vxcan) creation message to link transaction.
+ * The host side interface is linked up and attached to master device.
+ *
+ * @param [in]	nlb			Pointer to netutil_link_batch_t.
+ * @param [in]	kind		Link kind. "veth" or "vxcan".
+ * @param [in]	ifname		Host side interface name.
+ * @param [in]	peer_ifname	Guest side interface name.
+ * @param [in]	master		Interface index of master (bridge) device for host side interface.  0 is no master.
+ * @return int
+ * @retval	>=0	Message id.
+ * @retval	-1	Batch is full.
+ * @retval	-2	Argument error.
+ */
+static int netutil_link_batch_add_pair(netutil_link_batch_t *nlb, const char *kind, const char *ifname, const char *peer_ifname, unsigned int master)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct nlattr *linkinfo = NULL, *infodata = NULL, *peerinfo = NULL;
+	struct ifinfomsg *peer_ifm = NULL;
+
+	if ((nlb == NULL) || (ifname == NULL) || (peer_ifname == NULL)) {
+		return -2;
+	}
+
+	nlh = netutil_link_batch_put_header(nlb, RTM_NEWLINK, (NLM_F_CREATE | NLM_F_EXCL), ifname, 1);
+	if (nlh == NULL) {
+		return -1;
+	}
+
+	if (master != 0) {
+		mnl_attr_put_u32(nlh, IFLA_MASTER, master);
+	}
+
+	linkinfo = mnl_attr_nest_start(nlh, IFLA_LINKINFO);
+	mnl_attr_put_strz(nlh, IFLA_INFO_KIND, kind);
+	infodata = mnl_attr_nest_start(nlh, IFLA_INFO_DATA);
+	// VETH_INFO_PEER and VXCAN_INFO_PEER are same value (1).
+	peerinfo = mnl_attr_nest_start(nlh, 1);
+	peer_ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*peer_ifm));
+	peer_ifm->ifi_family = AF_UNSPEC;
+	mnl_attr_put_strz(nlh, IFLA_IFNAME, peer_ifname);
+	mnl_attr_nest_end(nlh, peerinfo);
+	mnl_attr_nest_end(nlh, infodata);
+	mnl_attr_nest_end(nlh, linkinfo);
+
+	return netutil_link_batch_next(nlb);
+}
+/**
+ * Add veth pair creation message to link transaction.
+ *
+ * @param [in]	nlb			Pointer to netutil_link_batch_t.
+ * @param [in]	ifname		Host side interface name.
+ * @param [in]	peer_ifname	Guest side interface name.
+ * @param [in]	master		Interface index of bridge for host side interface.  0 is no bridge.
+ * @return int
+ * @retval	>=0	Message id.
+ * @retval	-1	Batch is full.
+ * @retval	-2	Argument error.
+ */
+int netutil_link_batch_add_veth(netutil_link_batch_t *nlb, const char *ifname, const char *peer_ifname, unsigned int master)
+{
+	return netutil_link_batch_add_pair(nlb, "veth", ifname, peer_ifname, master);
+}
+/**
+ * Add vxcan pair creation message to link transaction.
+ *
+ * @param [in]	nlb			Pointer to netutil_link_batch_t.
+ * @param [in]	ifname		Host side interface name.
+ * @param [in]	peer_ifname	Guest side interface name.
+ * @return int
+ * @retval	>=0	Message id.
+ * @retval	-1	Batch is full.
+ * @retval	-2	Argument error.
+ */
+int netutil_link_batch_add_vxcan(netutil_link_batch_t *nlb, const char *ifname, const char *peer_ifname)
+{
+	return netutil_link_batch_add_pair(nlb, "vxcan", ifname, peer_ifname, 0);
+}
+/**
+ * Add link remove message to link transaction.
+ *
+ * @param [in]	nlb		Pointer to netutil_link_batch_t.
+ * @param [in]	ifname	Interface name.
+ * @return int
+ * @retval	>=0	Message id.
+ * @retval	-1	Batch is full.
+ * @retval	-2	Argument error.
+ */
+int netutil_link_batch_add_delete(netutil_link_batch_t *nlb, const char *ifname)
+{
+	struct nlmsghdr *nlh = NULL;
+
+	if ((nlb == NULL) || (ifname == NULL)) {
+		return -2;
+	}
+
+	nlh = netutil_link_batch_put_header(nlb, RTM_DELLINK, 0, ifname, 0);
+	if (nlh == NULL) {
+		return -1;
+	}
+
+	return netutil_link_batch_next(nlb);
+}
+/**
+ * Commit link transaction.
+ * All messages are sent by one sendto, the kernel process these without waiting per message round trip.
+ *
+ * @param [in]	nlb		Pointer to netutil_link_batch_t.
+ * @return int
+ * @retval	0	All messages are success.
+ * @retval	-1	Some messages are fail. Refer to netutil_link_batch_get_result.
+ * @retval	-2	Argument error.
+ * @retval	-3	Netlink socket error.
+ */
+int netutil_link_batch_commit(netutil_link_batch_t *nlb)
+{
+	struct mnl_socket *nl = NULL;
+	char buf[NETIFMONITOR_RECV_BUFFER_SIZE];
+	int ret = -1, result = 0;
+	int remain = 0;
+
+	if (nlb == NULL) {
+		return -2;
+	}
+
+	if (nlb->num == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < nlb->num; i++) {
+		nlb->error[i] = -EIO;	// Not acknowledged.
+	}
+
+	nl = mnl_socket_open2(NETLINK_ROUTE, SOCK_CLOEXEC);
+	if (nl == NULL) {
+		return -3;
+	}
+
+	if (mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID) < 0) {
+		result = -3;
+		goto do_return;
+	}
+
+	if (mnl_socket_sendto(nl, mnl_nlmsg_batch_head(nlb->batch), mnl_nlmsg_batch_size(nlb->batch)) < 0) {
+		result = -3;
+		goto do_return;
+	}
+
+	remain = nlb->num;
+	while (remain > 0) {
+		const struct nlmsghdr *nlh = NULL;
+
+		ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
+		if (ret < 0) {
+			result = -3;
+			goto do_return;
+		}
+
+		nlh = (const struct nlmsghdr*)buf;
+		while (mnl_nlmsg_ok(nlh, ret) == true) {
+			if ((nlh->nlmsg_type == NLMSG_ERROR) && (nlh->nlmsg_seq >= 1u) && (nlh->nlmsg_seq <= (unsigned int)nlb->num)) {
+				const struct nlmsgerr *err = mnl_nlmsg_get_payload(nlh);
+
+				nlb->error[nlh->nlmsg_seq - 1u] = err->error;
+				remain--;
+			}
+			nlh = mnl_nlmsg_next(nlh, &ret);
+		}
+	}
+
+	for (int i = 0; i < nlb->num; i++) {
+		if (nlb->error[i] != 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"netutil_link_batch_commit: message %d fail (%d)\n", i, nlb->error[i]);
+			#endif
+			result = -1;
+		}
+	}
+
+do_return:
+	(void) mnl_socket_close(nl);
+
+	return result;
+}
+/**
+ * Get result of one message in committed link transaction.
+ *
+ * @param [in]	nlb		Pointer to netutil_link_batch_t.
+ * @param [in]	id		Message id returned from netutil_link_batch_add_*.
+ * @return int
+ * @retval	0	Success.
+ * @retval	<0	Negative errno of fail reason.
+ */
+int netutil_link_batch_get_result(netutil_link_batch_t *nlb, int id)
+{
+	if ((nlb == NULL) || (id < 0) || (id >= nlb->num)) {
+		return -EINVAL;
+	}
+
+	return nlb->error[id];
+}
+/**
+ * Remove one network interface.  In case of virtual link pair, the peer is removed too.
+ *
+ * @param [in]	ifname	Interface name.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Fail to remove.
+ * @retval	-2	Argument error.
+ */
+int netutil_link_remove(const char *ifname)
+{
+	netutil_link_batch_t *nlb = NULL;
+	int ret = -1, result = 0;
+
+	if (ifname == NULL) {
+		return -2;
+	}
+
+	ret = netutil_link_batch_create(&nlb);
+	if (ret < 0) {
+		return -1;
+	}
+
+	(void) netutil_link_batch_add_delete(nlb, ifname);
+
+	ret = netutil_link_batch_commit(nlb);
+	if (ret < 0) {
+		result = -1;
+	}
+
+	(void) netutil_link_batch_release(nlb);
+
+	return result;
+}
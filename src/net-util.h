@@ -11,9 +11,29 @@
 #include <systemd/sd-event.h>
 #include "devicemng.h"
 
+/**
+ * @def	NETUTIL_LINK_BATCH_MSG_MAX
+ * @brief	Maximum number of messages in one link transaction.
+ */
+#define NETUTIL_LINK_BATCH_MSG_MAX	(64)
+
+struct s_netutil_link_batch;
+typedef struct s_netutil_link_batch netutil_link_batch_t;	/**< typedef for struct s_netutil_link_batch. */
+
 //-----------------------------------------------------------------------------
 int netifmonitor_setup(dynamic_device_manager_t *ddm, container_control_interface_t *cci, sd_event *event);
 int netifmonitor_cleanup(dynamic_device_manager_t *ddm);
+int netifmonitor_netns_move_queue(dynamic_device_manager_t *ddm, int ifindex, const char *ifname, int netns_fd);
+
+int netutil_link_batch_create(netutil_link_batch_t **nlb);
+int netutil_link_batch_release(netutil_link_batch_t *nlb);
+int netutil_link_batch_add_bridge(netutil_link_batch_t *nlb, const char *ifname);
+int netutil_link_batch_add_veth(netutil_link_batch_t *nlb, const char *ifname, const char *peer_ifname, unsigned int master);
+int netutil_link_batch_add_vxcan(netutil_link_batch_t *nlb, const char *ifname, const char *peer_ifname);
+int netutil_link_batch_add_delete(netutil_link_batch_t *nlb, const char *ifname);
+int netutil_link_batch_commit(netutil_link_batch_t *nlb);
+int netutil_link_batch_get_result(netutil_link_batch_t *nlb, int id);
+int netutil_link_remove(const char *ifname);
 
 //-----------------------------------------------------------------------------
 #endif //#ifndef NET_UTIL_H
@@ -0,0 +1,223 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	parallel-util.c
+ * @brief	This file include bounded parallel job execution utility functions.
+ */
+#include "parallel-util.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "cm-utils.h"
+
+#undef _PRINTF_DEBUG_
+
+/**
+ * @def	PARALLEL_UTIL_THREAD_MAX
+ * @brief	Maximum number of threads in one parallel execution.
+ */
+#define PARALLEL_UTIL_THREAD_MAX	(8)
+
+/**
+ * @def	PARALLEL_UTIL_JOB_PENDING
+ * @brief	Job state: not started.
+ */
+#define PARALLEL_UTIL_JOB_PENDING	(0)
+/**
+ * @def	PARALLEL_UTIL_JOB_RUNNING
+ * @brief	Job state: running.
+ */
+#define PARALLEL_UTIL_JOB_RUNNING	(1)
+/**
+ * @def	PARALLEL_UTIL_JOB_DONE
+ * @brief	Job state: done.
+ */
+#define PARALLEL_UTIL_JOB_DONE	(2)
+
+/**
+ * @struct	s_parallel_util_ctx
+ * @brief	The data structure for shared data between parallel execution threads.
+ */
+struct s_parallel_util_ctx {
+	pthread_mutex_t mutex;		/**< Mutex for job state. */
+	pthread_cond_t cond;		/**< Condition to notify job done. */
+	parallel_util_job_t *jobs;	/**< Array of jobs. */
+	int num;					/**< Number of jobs. */
+};
+
+/**
+ * Sub function for job selection.  Check the group of job is running or not.
+ * Shall call with locked mutex.
+ *
+ * @param [in]	ctx		Pointer to struct s_parallel_util_ctx.
+ * @param [in]	group	Group id.
+ * @return int
+ * @retval 1	Same group job is running.
+ * @retval 0	Same group job is not running.
+ */
+static int parallel_util_group_is_busy(struct s_parallel_util_ctx *ctx, int group)
+{
+	if (group < 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < ctx->num; i++) {
+		if ((ctx->jobs[i].state == PARALLEL_UTIL_JOB_RUNNING) && (ctx->jobs[i].group == group)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+/**
+ * Sub function for job selection.  Pick up runnable job.
+ * Shall call with locked mutex.
+ *
+ * @param [in]	ctx		Pointer to struct s_parallel_util_ctx.
+ * @param [out]	remain	Pointer to store number of not finished jobs.
+ * @return int
+ * @retval >=0	Index of runnable job.
+ * @retval -1	No runnable job.
+ */
+static int parallel_util_pick_job(struct s_parallel_util_ctx *ctx, int *remain)
+{
+	int picked = -1;
+
+	(*remain) = 0;
+
+	for (int i = 0; i < ctx->num; i++) {
+		if (ctx->jobs[i].state != PARALLEL_UTIL_JOB_DONE) {
+			(*remain) = (*remain) + 1;
+		}
+
+		if ((picked < 0) && (ctx->jobs[i].state == PARALLEL_UTIL_JOB_PENDING)
+			&& (parallel_util_group_is_busy(ctx, ctx->jobs[i].group) == 0)) {
+			picked = i;
+		}
+	}
+
+	return picked;
+}
+/**
+ * Thread entry point for parallel execution. The caller thread also run this function.
+ *
+ * @param [in]	args	Pointer to struct s_parallel_util_ctx.
+ * @return void*	Always NULL.
+ */
+static void* parallel_util_thread(void *args)
+{
+	struct s_parallel_util_ctx *ctx = (struct s_parallel_util_ctx*)args;
+	int remain = 0, index = -1;
+
+	(void) pthread_mutex_lock(&ctx->mutex);
+
+	for (;;) {
+		parallel_util_job_t *job = NULL;
+		int64_t start_time = 0;
+		int ret = -1;
+
+		index = parallel_util_pick_job(ctx, &remain);
+		if (index < 0) {
+			if (remain == 0) {
+				break;
+			}
+			// Wait to finish same group job.
+			(void) pthread_cond_wait(&ctx->cond, &ctx->mutex);
+			continue;
+		}
+
+		job = &ctx->jobs[index];
+		job->state = PARALLEL_UTIL_JOB_RUNNING;
+		(void) pthread_mutex_unlock(&ctx->mutex);
+
+		start_time = get_current_time_ms();
+		ret = job->func(job->arg);
+
+		(void) pthread_mutex_lock(&ctx->mutex);
+		job->result = ret;
+		job->elapsed_ms = get_current_time_ms() - start_time;
+		job->state = PARALLEL_UTIL_JOB_DONE;
+		(void) pthread_cond_broadcast(&ctx->cond);
+	}
+
+	(void) pthread_mutex_unlock(&ctx->mutex);
+
+	return NULL;
+}
+/**
+ * Run jobs in parallel by bounded number of threads and wait to finish all jobs.
+ * The caller thread is used as one of execution thread.  When fail to create thread,
+ * remaining jobs are executed by created threads, so all jobs are always executed.
+ *
+ * @param [in]	jobs		Array of parallel_util_job_t. result and elapsed_ms are set after return.
+ * @param [in]	num			Number of jobs.
+ * @param [in]	max_threads	Maximum number of parallel execution. Less than 1 is handled as 1.
+ * @return int
+ * @retval >=1	Number of used threads.
+ * @retval 0	No jobs.
+ * @retval -1	Argument error.
+ */
+int parallel_util_run(parallel_util_job_t *jobs, int num, int max_threads)
+{
+	struct s_parallel_util_ctx ctx;
+	pthread_t threads[PARALLEL_UTIL_THREAD_MAX];
+	int num_of_threads = 0, thread_limit = 0;
+
+	if ((jobs == NULL) || (num < 0)) {
+		return -1;
+	}
+
+	if (num == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < num; i++) {
+		if (jobs[i].func == NULL) {
+			return -1;
+		}
+		jobs[i].result = 0;
+		jobs[i].elapsed_ms = 0;
+		jobs[i].state = PARALLEL_UTIL_JOB_PENDING;
+	}
+
+	thread_limit = max_threads;
+	if (thread_limit > num) {
+		thread_limit = num;
+	}
+	if (thread_limit > PARALLEL_UTIL_THREAD_MAX) {
+		thread_limit = PARALLEL_UTIL_THREAD_MAX;
+	}
+
+	(void) memset(&ctx, 0, sizeof(ctx));
+	(void) pthread_mutex_init(&ctx.mutex, NULL);
+	(void) pthread_cond_init(&ctx.cond, NULL);
+	ctx.jobs = jobs;
+	ctx.num = num;
+
+	// Caller thread is one of execution thread.
+	for (int i = 0; i < (thread_limit - 1); i++) {
+		int ret = -1;
+
+		ret = pthread_create(&threads[num_of_threads], NULL, parallel_util_thread, (void*)&ctx);
+		if (ret != 0) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"parallel_util_run: pthread_create fail (%d).\n", ret);
+			#endif
+			break;
+		}
+		num_of_threads++;
+	}
+
+	(void) parallel_util_thread((void*)&ctx);
+
+	for (int i = 0; i < num_of_threads; i++) {
+		(void) pthread_join(threads[i], NULL);
+	}
+
+	(void) pthread_cond_destroy(&ctx.cond);
+	(void) pthread_mutex_destroy(&ctx.mutex);
+
+	return num_of_threads + 1;
+}
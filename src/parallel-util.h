@@ -0,0 +1,44 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	parallel-util.h
+ * @brief	The header for bounded parallel job execution utility.
+ */
+#ifndef PARALLEL_UTIL_H
+#define PARALLEL_UTIL_H
+//-----------------------------------------------------------------------------
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+/**
+ * @def	PARALLEL_UTIL_NO_GROUP
+ * @brief	Group id for the job that can run with any other job.
+ */
+#define PARALLEL_UTIL_NO_GROUP	(-1)
+
+/**
+ * @typedef	parallel_util_func_t
+ * @brief	Function pointer type for parallel job.
+ */
+typedef int (*parallel_util_func_t)(void *arg);
+
+/**
+ * @struct	s_parallel_util_job
+ * @brief	The data structure for one parallel job.
+ */
+struct s_parallel_util_job {
+	parallel_util_func_t func;	/**< Job function. */
+	void *arg;					/**< Argument for job function. */
+	int group;					/**< Jobs in same group (>=0) do not run at same time. PARALLEL_UTIL_NO_GROUP is no limitation. */
+	int result;					/**< Return value of job function. */
+	int64_t elapsed_ms;			/**< Execution time of job function (ms). */
+	//--- internal control data
+	int state;					/**< Job state. 0: pending, 1: running, 2: done. */
+};
+typedef struct s_parallel_util_job parallel_util_job_t;	/**< typedef for struct s_parallel_util_job. */
+
+//-----------------------------------------------------------------------------
+int parallel_util_run(parallel_util_job_t *jobs, int num, int max_threads);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef PARALLEL_UTIL_H
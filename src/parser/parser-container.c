@@ -21,6 +21,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <linux/can.h>
 #include "parser/parser-common.h"
 #include "parser/parser-container.h"
 
@@ -124,6 +126,9 @@ static int cmparser_parser_get_diskmountmode(const char *str)
  * @return int
  * @retval DISKREDUNDANCY_TYPE_FAILOVER	str is "failover" or other
  * @retval DISKREDUNDANCY_TYPE_AB	str is "ab"
+ * @retval DISKREDUNDANCY_TYPE_FSCK	str is "fsck"
+ * @retval DISKREDUNDANCY_TYPE_MKFS	str is "mkfs"
+ * @retval DISKREDUNDANCY_TYPE_CLONE	str is "clone"
  */
 static int cmparser_parser_get_diskmountfailop(const char *str)
 {
@@ -131,6 +136,7 @@ static int cmparser_parser_get_diskmountfailop(const char *str)
 	static const char ab[] = "ab";
 	static const char fsck[] = "fsck";
 	static const char mkfs[] = "mkfs";
+	static const char clone[] = "clone";
 	int ret = DISKREDUNDANCY_TYPE_FAILOVER;
 
 	if (strncmp(failover, str, sizeof(failover)) == 0) {
@@ -141,6 +147,8 @@ static int cmparser_parser_get_diskmountfailop(const char *str)
 		ret = DISKREDUNDANCY_TYPE_FSCK;
 	} else if (strncmp(mkfs, str, sizeof(mkfs)) == 0) {
 		ret = DISKREDUNDANCY_TYPE_MKFS;
+	} else if (strncmp(clone, str, sizeof(clone)) == 0) {
+		ret = DISKREDUNDANCY_TYPE_CLONE;
 	} else {
 		// unknow str, select FAILOVER.
 		ret = DISKREDUNDANCY_TYPE_FAILOVER;
@@ -148,6 +156,40 @@ static int cmparser_parser_get_diskmountfailop(const char *str)
 
 	return ret;
 }
+/**
+ * Sub function for the file system error policy parse.
+ * Shall not call from other than cmparser_parse_base.
+ *
+ * @param [in]	str		string of policy
+ * @return int
+ * @retval FSERROR_POLICY_NONE			str is "none" or other
+ * @retval FSERROR_POLICY_REMOUNT_RO	str is "remount-ro"
+ * @retval FSERROR_POLICY_FSCK			str is "fsck"
+ * @retval FSERROR_POLICY_RESTART		str is "restart"
+ */
+static int cmparser_parser_get_fserrorpolicy(const char *str)
+{
+	static const char none[] = "none";
+	static const char remount_ro[] = "remount-ro";
+	static const char fsck[] = "fsck";
+	static const char restart[] = "restart";
+	int ret = FSERROR_POLICY_NONE;
+
+	if (strncmp(none, str, sizeof(none)) == 0) {
+		ret = FSERROR_POLICY_NONE;
+	} else if (strncmp(remount_ro, str, sizeof(remount_ro)) == 0) {
+		ret = FSERROR_POLICY_REMOUNT_RO;
+	} else if (strncmp(fsck, str, sizeof(fsck)) == 0) {
+		ret = FSERROR_POLICY_FSCK;
+	} else if (strncmp(restart, str, sizeof(restart)) == 0) {
+		ret = FSERROR_POLICY_RESTART;
+	} else {
+		// unknow str, select NONE.
+		ret = FSERROR_POLICY_NONE;
+	}
+
+	return ret;
+}
 /**
  * Sub function for the rootfs config parser.
  *
@@ -162,7 +204,7 @@ static int cmparser_parser_get_diskmountfailop(const char *str)
 static int cmparser_parse_base_rootfs(container_baseconfig_t *bc, const cJSON *rootfs)
 {
 	int result = -1;
-	cJSON *path = NULL, *filesystem = NULL, *mode = NULL, *option= NULL, *blockdev = NULL, *hostpath = NULL;
+	cJSON *path = NULL, *filesystem = NULL, *mode = NULL, *option= NULL, *blockdev = NULL, *hostpath = NULL, *overlay = NULL;
 
 	path = cJSON_GetObjectItemCaseSensitive(rootfs, "path");
 	if (cJSON_IsString(path) && (path->valuestring != NULL)) {
@@ -212,6 +254,39 @@ static int cmparser_parse_base_rootfs(container_baseconfig_t *bc, const cJSON *r
 		bc->rootfs.option = NULL;
 	}
 
+	overlay = cJSON_GetObjectItemCaseSensitive(rootfs, "overlay");
+	if (cJSON_IsObject(overlay)) {
+		cJSON *size = NULL;
+		char buf[1024];
+		int ret = -1;
+
+		// Overlay mode stack volatile upper layer to read only rootfs.
+		if (bc->rootfs.mode != DISKMOUNT_TYPE_RO) {
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] cmparser: The rootfs overlay is available in ro mode only.\n");
+			#endif
+			result = -2;
+			goto err_ret;
+		}
+
+		size = cJSON_GetObjectItemCaseSensitive(overlay, "size");
+		if (cJSON_IsString(size) && (size->valuestring != NULL)) {
+			bc->rootfs.overlay_size = strdup(size->valuestring);
+		} else {
+			bc->rootfs.overlay_size = strdup(ROOTFS_OVERLAY_SIZE_DEFAULT);
+		}
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"cmparser: overlay size = %s\n", bc->rootfs.overlay_size);
+		#endif
+
+		ret = snprintf(buf, sizeof(buf), "%s-overlay", bc->rootfs.path);
+		if (!((size_t)ret < sizeof(buf)-1u)) {
+			result = -2;
+			goto err_ret;
+		}
+		bc->rootfs.overlay_path = strdup(buf);
+	}
+
 	blockdev = cJSON_GetObjectItemCaseSensitive(rootfs, "blockdev");
 	hostpath = cJSON_GetObjectItemCaseSensitive(rootfs, "hostpath");
 	if (cJSON_IsArray(blockdev)) {
@@ -290,6 +365,12 @@ err_ret:
 	(void) free(bc->rootfs.rootfs_dev[0]);
 	bc->rootfs.rootfs_dev[0] = NULL;
 
+	(void) free(bc->rootfs.overlay_path);
+	bc->rootfs.overlay_path = NULL;
+
+	(void) free(bc->rootfs.overlay_size);
+	bc->rootfs.overlay_size = NULL;
+
 	(void) free(bc->rootfs.option);
 	bc->rootfs.option = NULL;
 
@@ -319,10 +400,10 @@ static int cmparser_parse_base_extradisk(container_baseconfig_t *bc, const cJSON
 
 	cJSON_ArrayForEach(disk, extradisk) {
 		cJSON *from = NULL, *to = NULL,  *blockdev = NULL;
-		cJSON *filesystem = NULL, *mode = NULL, *option = NULL, *redundancy = NULL;
+		cJSON *filesystem = NULL, *mode = NULL, *option = NULL, *redundancy = NULL, *template_item = NULL;
 		container_baseconfig_extradisk_t *exdisk = NULL;
 		int mntmode = 0, mntredundancy = 0;
-		char *bdev[2], *fsstr = NULL, *optionstr = NULL;
+		char *bdev[2], *fsstr = NULL, *optionstr = NULL, *templatestr = NULL;
 		bdev[0] = NULL;
 		bdev[1] = NULL;
 
@@ -400,6 +481,24 @@ static int cmparser_parse_base_extradisk(container_baseconfig_t *bc, const cJSON
 			mntredundancy = DISKREDUNDANCY_TYPE_FAILOVER;
 		}
 
+		template_item = cJSON_GetObjectItemCaseSensitive(disk, "template");
+		if (cJSON_IsString(template_item) && (template_item->valuestring != NULL)) {
+			templatestr = template_item->valuestring;
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"cmparser: base-extradisk template = %s\n",templatestr);
+			#endif
+		} else {
+			templatestr = NULL;
+		}
+
+		if ((mntredundancy == DISKREDUNDANCY_TYPE_CLONE) && (templatestr == NULL)) {
+			// Clone needs template image, fallback to mkfs.
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			(void) fprintf(stderr,"[CM CRITICAL ERROR] cmparser: base-extradisk redundancy clone without template. use mkfs.\n");
+			#endif
+			mntredundancy = DISKREDUNDANCY_TYPE_MKFS;
+		}
+
 		blockdev = cJSON_GetObjectItemCaseSensitive(disk, "blockdev");
 		if (cJSON_IsArray(blockdev)) {
 			cJSON *dev = NULL;
@@ -450,6 +549,9 @@ static int cmparser_parse_base_extradisk(container_baseconfig_t *bc, const cJSON
 		if (optionstr != NULL) {
 			exdisk->option = strdup(optionstr);
 		}
+		if (templatestr != NULL) {
+			exdisk->template_image = strdup(templatestr);
+		}
 		exdisk->blockdev[0] = strdup(bdev[0]);
 		if (bdev[1] != NULL) {
 			exdisk->blockdev[1] = strdup(bdev[1]);
@@ -520,6 +622,7 @@ static int cmparser_parse_base(container_baseconfig_t *bc, const cJSON *base)
 {
 	cJSON *autoboot = NULL;
 	cJSON *bootpriority = NULL;
+	cJSON *fserror = NULL;
 	cJSON *rootfs = NULL;
 	cJSON *extradisk = NULL;
 	cJSON *extended = NULL;
@@ -564,6 +667,20 @@ static int cmparser_parse_base(container_baseconfig_t *bc, const cJSON *base)
 		#endif
 	}
 
+	// Get file system error policy
+	fserror = cJSON_GetObjectItemCaseSensitive(base, "fserror");
+	if (cJSON_IsString(fserror) && (fserror->valuestring != NULL)) {
+		bc->fserror_policy = cmparser_parser_get_fserrorpolicy(fserror->valuestring);
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"cmparser: base-fserror value = %d\n",bc->fserror_policy);
+		#endif
+	} else {
+		bc->fserror_policy = FSERROR_POLICY_NONE; // Default value is none
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"cmparser: base-fserror set default value = none\n");
+		#endif
+	}
+
 	// Get rootfs part
 	rootfs = cJSON_GetObjectItemCaseSensitive(base, "rootfs");
 	if (cJSON_IsObject(rootfs)) {
@@ -1740,22 +1857,230 @@ int cmparser_parse_device(container_deviceconfig_t *dc, const cJSON *dev)
  * @param [in]	str		string of netif type
  * @return int
  * @retval STATICNETIF_VETH	netif is veth
+ * @retval STATICNETIF_VXCAN	netif is vxcan
+ * @retval STATICNETIF_MACVLAN	netif is macvlan
+ * @retval STATICNETIF_IPVLAN	netif is ipvlan
  * @retval 0 NON
  */
 static int cmparser_parser_get_netiftype(const char *str)
 {
 	static const char veth[] = "veth";
 	static const char vxcan[] = "vxcan";
+	static const char macvlan[] = "macvlan";
+	static const char ipvlan[] = "ipvlan";
 	int ret = 0;
 
 	if (strncmp(veth, str, sizeof(veth)) == 0) {
 		ret = STATICNETIF_VETH;
 	} else if (strncmp(vxcan, str, sizeof(vxcan)) == 0) {
 		ret = STATICNETIF_VXCAN;
+	} else if (strncmp(macvlan, str, sizeof(macvlan)) == 0) {
+		ret = STATICNETIF_MACVLAN;
+	} else if (strncmp(ipvlan, str, sizeof(ipvlan)) == 0) {
+		ret = STATICNETIF_IPVLAN;
 	}
 
 	return ret;
 }
+/**
+ * Sub function for the rate or size value in traffic shaping.
+ * The rate accept bit, kbit, mbit and gbit suffix (no suffix is bit per sec) and converted to bytes per sec.
+ * The size accept b, k, kb, m and mb suffix (no suffix is bytes).
+ *
+ * @param [in]	item	Pointer to cJSON object of value.
+ * @param [in]	is_rate	Value is rate (=1) or size (=0).
+ * @param [out]	value	Pointer to buffer to store converted value.
+ * @return int
+ * @retval 0	Success to convert.
+ * @retval -1	Invalid value.
+ */
+static int cmparser_parse_static_netif_shaping_value(cJSON *item, int is_rate, uint64_t *value)
+{
+	struct s_shaping_unit {
+		const char *suffix;
+		uint64_t mul;
+	};
+	static const struct s_shaping_unit rate_unit[] = {
+		{"", 1ull}, {"bit", 1ull}, {"kbit", 1000ull}, {"mbit", 1000000ull}, {"gbit", 1000000000ull}, {NULL, 0}
+	}, size_unit[] = {
+		{"", 1ull}, {"b", 1ull}, {"k", 1024ull}, {"kb", 1024ull}, {"m", 1048576ull}, {"mb", 1048576ull}, {NULL, 0}
+	};
+	const struct s_shaping_unit *unit = NULL;
+	char *endptr = NULL;
+	unsigned long long ull = 0;
+	uint64_t mul = 0;
+
+	if (cJSON_IsNumber(item)) {
+		if (item->valuedouble < 0) {
+			return -1;
+		}
+		ull = (unsigned long long)item->valuedouble;
+		mul = 1ull;
+	} else if (cJSON_IsString(item) && (item->valuestring != NULL)) {
+		errno = 0;
+		ull = strtoull(item->valuestring, &endptr, 10);
+		if ((errno != 0) || (endptr == item->valuestring)) {
+			return -1;
+		}
+
+		unit = (is_rate == 1) ? rate_unit : size_unit;
+		for (int i = 0; unit[i].suffix != NULL; i++) {
+			if (strcmp(unit[i].suffix, endptr) == 0) {
+				mul = unit[i].mul;
+				break;
+			}
+		}
+		if (mul == 0) {
+			return -1;
+		}
+	} else {
+		return -1;
+	}
+
+	if ((ull != 0) && ((UINT64_MAX / ull) < mul)) {
+		return -1;
+	}
+
+	if (is_rate == 1) {
+		(*value) = (uint64_t)ull * mul / 8u;
+	} else {
+		(*value) = (uint64_t)ull * mul;
+	}
+
+	return 0;
+}
+/**
+ * Sub function for the traffic shaping setting of one direction.
+ * Shall not call from other than cmparser_parse_static_netif_shaping.
+ *
+ * @param [in]	param		Pointer to cJSON object of direction section.
+ * @param [in]	use_class	Accept class list (=1) or not (=0).
+ * @param [out]	dir			Pointer to netif_shaping_direction_t to store setting.
+ * @return int
+ * @retval 0	Success to parse.
+ * @retval -1	Json file parse error.
+ */
+static int cmparser_parse_static_netif_shaping_direction(cJSON *param, int use_class, netif_shaping_direction_t *dir)
+{
+	cJSON *rate = NULL, *burst = NULL, *classes = NULL, *cls = NULL;
+	uint64_t value = 0;
+	int i = 0;
+
+	rate = cJSON_GetObjectItemCaseSensitive(param, "rate");
+	if (cmparser_parse_static_netif_shaping_value(rate, 1, &dir->rate) < 0) {
+		//rate is mandatory
+		return -1;
+	}
+
+	burst = cJSON_GetObjectItemCaseSensitive(param, "burst");
+	if (burst != NULL) {
+		if ((cmparser_parse_static_netif_shaping_value(burst, 0, &value) < 0) || (value > UINT32_MAX)) {
+			return -1;
+		}
+		dir->burst = (uint32_t)value;
+	}
+
+	classes = cJSON_GetObjectItemCaseSensitive(param, "classes");
+	if (classes == NULL) {
+		return 0;
+	}
+
+	if ((use_class == 0) || (!cJSON_IsArray(classes)) || (cJSON_GetArraySize(classes) > NETIF_SHAPING_CLASS_MAX)) {
+		return -1;
+	}
+
+	cJSON_ArrayForEach(cls, classes) {
+		cJSON *crate = NULL, *ceil = NULL, *priority = NULL, *dscp = NULL;
+		netif_shaping_class_t *pcls = &dir->classes[i];
+
+		crate = cJSON_GetObjectItemCaseSensitive(cls, "rate");
+		if (cmparser_parse_static_netif_shaping_value(crate, 1, &pcls->rate) < 0) {
+			//rate is mandatory
+			return -1;
+		}
+
+		ceil = cJSON_GetObjectItemCaseSensitive(cls, "ceil");
+		if (ceil == NULL) {
+			pcls->ceil = dir->rate;
+		} else if (cmparser_parse_static_netif_shaping_value(ceil, 1, &pcls->ceil) < 0) {
+			return -1;
+		}
+
+		priority = cJSON_GetObjectItemCaseSensitive(cls, "priority");
+		if (cJSON_IsNumber(priority) && (priority->valueint >= 0) && (priority->valueint <= 7)) {
+			pcls->priority = (uint32_t)priority->valueint;
+		} else if (priority != NULL) {
+			return -1;
+		}
+
+		// No dscp is default class.
+		pcls->dscp = -1;
+		dscp = cJSON_GetObjectItemCaseSensitive(cls, "dscp");
+		if (cJSON_IsNumber(dscp) && (dscp->valueint >= 0) && (dscp->valueint <= 63)) {
+			pcls->dscp = dscp->valueint;
+		} else if (dscp != NULL) {
+			return -1;
+		}
+
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"cmparser: cmparser_parse_static_netif_shaping_direction: class %d rate = %lu, ceil = %lu, prio = %u, dscp = %d\n",
+						i, pcls->rate, pcls->ceil, pcls->priority, pcls->dscp);
+		#endif
+		i++;
+	}
+	dir->num_of_class = i;
+
+	return 0;
+}
+/**
+ * Sub function for the traffic shaping setting of guest network interface.
+ * Shall not call from other than cmparser_parse_static_netif_*_create.
+ *
+ * @param [in]	param		Pointer to cJSON object of shaping section.
+ * @param [out]	shaping		Double pointer to store allocated netif_shaping_t.
+ * @return int
+ * @retval 0	Success to parse.
+ * @retval -1	Json file parse error or memory allocation error.
+ */
+static int cmparser_parse_static_netif_shaping(cJSON *param, netif_shaping_t **shaping)
+{
+	cJSON *to_guest = NULL, *from_guest = NULL;
+	netif_shaping_t *pshaping = NULL;
+
+	if (!cJSON_IsObject(param)) {
+		return -1;
+	}
+
+	pshaping = (netif_shaping_t*)malloc(sizeof(netif_shaping_t));
+	if (pshaping == NULL) {
+		return -1;
+	}
+	(void) memset(pshaping, 0, sizeof(netif_shaping_t));
+
+	to_guest = cJSON_GetObjectItemCaseSensitive(param, "to_guest");
+	if (to_guest != NULL) {
+		if (cmparser_parse_static_netif_shaping_direction(to_guest, 1, &pshaping->to_guest) < 0) {
+			goto error_return;
+		}
+	}
+
+	from_guest = cJSON_GetObjectItemCaseSensitive(param, "from_guest");
+	if (from_guest != NULL) {
+		// Ingress policing is not support priority classes.
+		if (cmparser_parse_static_netif_shaping_direction(from_guest, 0, &pshaping->from_guest) < 0) {
+			goto error_return;
+		}
+	}
+
+	(*shaping) = pshaping;
+
+	return 0;
+
+error_return:
+	(void) free(pshaping);
+
+	return -1;
+}
 /**
  * Sub function for the static veth if configuration.
  * Shall not call from other than cmparser_parse_static_netif.
@@ -1768,9 +2093,10 @@ static int cmparser_parser_get_netiftype(const char *str)
 static void* cmparser_parse_static_netif_veth_create(cJSON *param)
 {
 	cJSON *name = NULL, *link = NULL, *flags = NULL, *hwaddr = NULL, *mode = NULL;
-	cJSON *address = NULL, *gateway = NULL;
+	cJSON *address = NULL, *gateway = NULL, *shaping = NULL;
 	char *pname = NULL, *plink = NULL, *pflags = NULL, *phwaddr = NULL, *pmode = NULL;
 	char *paddress = NULL, *pgateway = NULL;
+	netif_shaping_t *pshaping = NULL;
 	netif_elem_veth_t *pveth = NULL;
 	void *vp = NULL;
 
@@ -1821,6 +2147,21 @@ static void* cmparser_parse_static_netif_veth_create(cJSON *param)
 		pgateway = strdup(gateway->valuestring);
 	}
 
+	shaping = cJSON_GetObjectItemCaseSensitive(param, "shaping");
+	if (shaping != NULL) {
+		if (cmparser_parse_static_netif_shaping(shaping, &pshaping) < 0) {
+			(void) free(plink);
+			(void) free(pname);
+			(void) free(pflags);
+			(void) free(phwaddr);
+			(void) free(pmode);
+			(void) free(paddress);
+			(void) free(pgateway);
+			(void) free(pveth);
+			return NULL;
+		}
+	}
+
 	pveth->link = plink;
 	pveth->name = pname;
 	pveth->flags = pflags;
@@ -1828,6 +2169,7 @@ static void* cmparser_parse_static_netif_veth_create(cJSON *param)
 	pveth->mode = pmode;
 	pveth->address = paddress;
 	pveth->gateway = pgateway;
+	pveth->shaping = pshaping;
 
 	vp = (void*)pveth;
 
@@ -1857,10 +2199,358 @@ static int cmparser_parse_static_netif_veth_free(void *p)
 	(void) free(pveth->mode);
 	(void) free(pveth->address);
 	(void) free(pveth->gateway);
+	(void) free(pveth->shaping);
 	(void) free(pveth);
 
 	return 0;
 }
+/**
+ * Sub function for the static netif mode string.
+ * Shall not call from other than cmparser_parse_static_netif_*_create.
+ *
+ * @param [in]	param		Pointer to cJSON object of param section.
+ * @param [in]	key			Key name of mode item.
+ * @param [in]	list		NULL terminated list of acceptable mode string.
+ * @param [out]	mode		Double pointer to store duplicated mode string.  When the item is not set, NULL is stored.
+ * @return int
+ * @retval 0	Success to parse.
+ * @retval -1	Unsupported mode or memory allocation error.
+ */
+static int cmparser_parse_static_netif_mode(cJSON *param, const char *key, const char * const *list, char **mode)
+{
+	cJSON *item = NULL;
+
+	(*mode) = NULL;
+
+	item = cJSON_GetObjectItemCaseSensitive(param, key);
+	if (!(cJSON_IsString(item) && (item->valuestring != NULL))) {
+		return 0;
+	}
+
+	for (int i = 0; list[i] != NULL; i++) {
+		if (strcmp(list[i], item->valuestring) == 0) {
+			(*mode) = strdup(item->valuestring);
+			if ((*mode) == NULL) {
+				return -1;
+			}
+			return 0;
+		}
+	}
+
+	return -1;
+}
+/**
+ * Sub function for the static macvlan if configuration.
+ * Shall not call from other than cmparser_parse_static_netif.
+ *
+ * @param [in]	param		Pointer to cJSON object of top of macvlan param section.
+ * @return void*
+ * @retval !=NULL	Pointer to memory object for netif_elem_macvlan_t.
+ * @retval NULL		Json file parse error or memory allocation error.
+ */
+static void* cmparser_parse_static_netif_macvlan_create(cJSON *param)
+{
+	static const char * const modes[] = {"private", "vepa", "bridge", NULL};
+	cJSON *name = NULL, *link = NULL, *flags = NULL, *hwaddr = NULL;
+	cJSON *address = NULL, *gateway = NULL;
+	netif_elem_macvlan_t *pmacvlan = NULL;
+
+	pmacvlan = (netif_elem_macvlan_t*)malloc(sizeof(netif_elem_macvlan_t));
+	if (pmacvlan == NULL) {
+		return NULL;
+	}
+
+	(void) memset(pmacvlan, 0, sizeof(netif_elem_macvlan_t));
+
+	link = cJSON_GetObjectItemCaseSensitive(param, "link");
+	if (cJSON_IsString(link) && (link->valuestring != NULL)) {
+		pmacvlan->link = strdup(link->valuestring);
+	} else {
+		//link is mandatory
+		goto error_return;
+	}
+
+	if (cmparser_parse_static_netif_mode(param, "mode", modes, &pmacvlan->mode) < 0) {
+		goto error_return;
+	}
+
+	name = cJSON_GetObjectItemCaseSensitive(param, "name");
+	if (cJSON_IsString(name) && (name->valuestring != NULL)) {
+		pmacvlan->name = strdup(name->valuestring);
+	}
+
+	flags = cJSON_GetObjectItemCaseSensitive(param, "flags");
+	if (cJSON_IsString(flags) && (flags->valuestring != NULL)) {
+		pmacvlan->flags = strdup(flags->valuestring);
+	}
+
+	hwaddr = cJSON_GetObjectItemCaseSensitive(param, "hwaddr");
+	if (cJSON_IsString(hwaddr) && (hwaddr->valuestring != NULL)) {
+		pmacvlan->hwaddr = strdup(hwaddr->valuestring);
+	}
+
+	address = cJSON_GetObjectItemCaseSensitive(param, "address");
+	if (cJSON_IsString(address) && (address->valuestring != NULL)) {
+		pmacvlan->address = strdup(address->valuestring);
+	}
+
+	gateway = cJSON_GetObjectItemCaseSensitive(param, "gateway");
+	if (cJSON_IsString(gateway) && (gateway->valuestring != NULL)) {
+		pmacvlan->gateway = strdup(gateway->valuestring);
+	}
+
+	return (void*)pmacvlan;
+
+error_return:
+	(void) free(pmacvlan->link);
+	(void) free(pmacvlan->mode);
+	(void) free(pmacvlan);
+
+	return NULL;
+}
+/**
+ * Memory free function for the static macvlan if configuration.
+ *
+ * @param [in]	p	Pointer to memory object for netif_elem_macvlan_t.
+ * @return int
+ * @retval 0	Success to memory free.
+ * @retval -1	Misc error. (Reserve)
+ */
+static int cmparser_parse_static_netif_macvlan_free(void *p)
+{
+	netif_elem_macvlan_t *pmacvlan = NULL;
+
+	if (p == NULL) {
+		return 0;
+	}
+
+	pmacvlan = (netif_elem_macvlan_t*)p;
+	(void) free(pmacvlan->link);
+	(void) free(pmacvlan->name);
+	(void) free(pmacvlan->flags);
+	(void) free(pmacvlan->hwaddr);
+	(void) free(pmacvlan->mode);
+	(void) free(pmacvlan->address);
+	(void) free(pmacvlan->gateway);
+	(void) free(pmacvlan);
+
+	return 0;
+}
+/**
+ * Sub function for the static ipvlan if configuration.
+ * Shall not call from other than cmparser_parse_static_netif.
+ *
+ * @param [in]	param		Pointer to cJSON object of top of ipvlan param section.
+ * @return void*
+ * @retval !=NULL	Pointer to memory object for netif_elem_ipvlan_t.
+ * @retval NULL		Json file parse error or memory allocation error.
+ */
+static void* cmparser_parse_static_netif_ipvlan_create(cJSON *param)
+{
+	static const char * const modes[] = {"l2", "l3", "l3s", NULL};
+	static const char * const isolations[] = {"bridge", "private", "vepa", NULL};
+	cJSON *name = NULL, *link = NULL, *flags = NULL;
+	cJSON *address = NULL, *gateway = NULL;
+	netif_elem_ipvlan_t *pipvlan = NULL;
+
+	pipvlan = (netif_elem_ipvlan_t*)malloc(sizeof(netif_elem_ipvlan_t));
+	if (pipvlan == NULL) {
+		return NULL;
+	}
+
+	(void) memset(pipvlan, 0, sizeof(netif_elem_ipvlan_t));
+
+	link = cJSON_GetObjectItemCaseSensitive(param, "link");
+	if (cJSON_IsString(link) && (link->valuestring != NULL)) {
+		pipvlan->link = strdup(link->valuestring);
+	} else {
+		//link is mandatory
+		goto error_return;
+	}
+
+	if (cmparser_parse_static_netif_mode(param, "mode", modes, &pipvlan->mode) < 0) {
+		goto error_return;
+	}
+
+	if (cmparser_parse_static_netif_mode(param, "isolation", isolations, &pipvlan->isolation) < 0) {
+		goto error_return;
+	}
+
+	name = cJSON_GetObjectItemCaseSensitive(param, "name");
+	if (cJSON_IsString(name) && (name->valuestring != NULL)) {
+		pipvlan->name = strdup(name->valuestring);
+	}
+
+	flags = cJSON_GetObjectItemCaseSensitive(param, "flags");
+	if (cJSON_IsString(flags) && (flags->valuestring != NULL)) {
+		pipvlan->flags = strdup(flags->valuestring);
+	}
+
+	address = cJSON_GetObjectItemCaseSensitive(param, "address");
+	if (cJSON_IsString(address) && (address->valuestring != NULL)) {
+		pipvlan->address = strdup(address->valuestring);
+	}
+
+	gateway = cJSON_GetObjectItemCaseSensitive(param, "gateway");
+	if (cJSON_IsString(gateway) && (gateway->valuestring != NULL)) {
+		pipvlan->gateway = strdup(gateway->valuestring);
+	}
+
+	return (void*)pipvlan;
+
+error_return:
+	(void) free(pipvlan->link);
+	(void) free(pipvlan->mode);
+	(void) free(pipvlan->isolation);
+	(void) free(pipvlan);
+
+	return NULL;
+}
+/**
+ * Memory free function for the static ipvlan if configuration.
+ *
+ * @param [in]	p	Pointer to memory object for netif_elem_ipvlan_t.
+ * @return int
+ * @retval 0	Success to memory free.
+ * @retval -1	Misc error. (Reserve)
+ */
+static int cmparser_parse_static_netif_ipvlan_free(void *p)
+{
+	netif_elem_ipvlan_t *pipvlan = NULL;
+
+	if (p == NULL) {
+		return 0;
+	}
+
+	pipvlan = (netif_elem_ipvlan_t*)p;
+	(void) free(pipvlan->link);
+	(void) free(pipvlan->name);
+	(void) free(pipvlan->flags);
+	(void) free(pipvlan->mode);
+	(void) free(pipvlan->isolation);
+	(void) free(pipvlan->address);
+	(void) free(pipvlan->gateway);
+	(void) free(pipvlan);
+
+	return 0;
+}
+/**
+ * Sub function for the CAN ID value in vxcan filter.
+ * The value accept json number or string (decimal or hex with 0x prefix).
+ *
+ * @param [in]	item	Pointer to cJSON object of CAN ID value.
+ * @param [in]	max		Maximum valid value. (ex. CAN_EFF_MASK for CAN ID)
+ * @param [out]	value	Pointer to buffer to store converted value.
+ * @return int
+ * @retval 0	Success to convert.
+ * @retval -1	Invalid value.
+ */
+static int cmparser_parse_static_netif_vxcan_canid(cJSON *item, uint32_t max, uint32_t *value)
+{
+	if (cJSON_IsNumber(item)) {
+		// Check range before conversion, out of range conversion is undefined.
+		if ((item->valuedouble < 0) || (item->valuedouble > (double)max)
+			|| (item->valuedouble != (double)(uint32_t)item->valuedouble)) {
+			return -1;
+		}
+		(*value) = (uint32_t)item->valuedouble;
+	} else if (cJSON_IsString(item) && (item->valuestring != NULL)) {
+		char *endptr = NULL;
+		unsigned long ul = 0;
+
+		if (strchr(item->valuestring, '-') != NULL) {
+			// strtoul accept negative value with wrap around.
+			return -1;
+		}
+
+		errno = 0;
+		ul = strtoul(item->valuestring, &endptr, 0);
+		if ((errno != 0) || (endptr == item->valuestring) || (*endptr != '\0') || (ul > (unsigned long)max)) {
+			return -1;
+		}
+		(*value) = (uint32_t)ul;
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Sub function for the vxcan filter list.
+ * Shall not call from other than cmparser_parse_static_netif_vxcan_create.
+ *
+ * @param [in]	list	Pointer to cJSON array of filter list.
+ * @param [out]	filters	Double pointer to store allocated filter array.
+ * @param [out]	num		Pointer to store number of filters.
+ * @return int
+ * @retval 0	Success to parse.
+ * @retval -1	Json file parse error or memory allocation error.
+ */
+static int cmparser_parse_static_netif_vxcan_filter(cJSON *list, netif_vxcan_filter_t **filters, int *num)
+{
+	cJSON *filter = NULL;
+	netif_vxcan_filter_t *pfilters = NULL;
+	int array_size = 0, i = 0;
+
+	if (!cJSON_IsArray(list)) {
+		return -1;
+	}
+
+	array_size = cJSON_GetArraySize(list);
+	if (array_size <= 0) {
+		(*filters) = NULL;
+		(*num) = 0;
+		return 0;
+	}
+
+	pfilters = (netif_vxcan_filter_t*)malloc(sizeof(netif_vxcan_filter_t) * (size_t)array_size);
+	if (pfilters == NULL) {
+		return -1;
+	}
+	(void) memset(pfilters, 0, sizeof(netif_vxcan_filter_t) * (size_t)array_size);
+
+	cJSON_ArrayForEach(filter, list) {
+		cJSON *id = NULL, *mask = NULL, *rewrite = NULL;
+
+		id = cJSON_GetObjectItemCaseSensitive(filter, "id");
+		if (cmparser_parse_static_netif_vxcan_canid(id, CAN_EFF_MASK, &pfilters[i].can_id) < 0) {
+			//id is mandatory
+			goto error_return;
+		}
+
+		mask = cJSON_GetObjectItemCaseSensitive(filter, "mask");
+		if (mask == NULL) {
+			// Default is exact match for standard frame id.
+			pfilters[i].can_mask = 0x7ffu;
+		} else if (cmparser_parse_static_netif_vxcan_canid(mask, UINT32_MAX, &pfilters[i].can_mask) < 0) {
+			goto error_return;
+		}
+
+		rewrite = cJSON_GetObjectItemCaseSensitive(filter, "rewrite");
+		if (rewrite != NULL) {
+			if (cmparser_parse_static_netif_vxcan_canid(rewrite, CAN_EFF_MASK, &pfilters[i].rewrite_id) < 0) {
+				goto error_return;
+			}
+			pfilters[i].is_rewrite = 1;
+		}
+
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"cmparser: cmparser_parse_static_netif_vxcan_filter: id = %x, mask = %x, rewrite = %d:%x\n",
+						pfilters[i].can_id, pfilters[i].can_mask, pfilters[i].is_rewrite, pfilters[i].rewrite_id);
+		#endif
+		i++;
+	}
+
+	(*filters) = pfilters;
+	(*num) = i;
+
+	return 0;
+
+error_return:
+	(void) free(pfilters);
+
+	return -1;
+}
 /**
  * Sub function for the static vxcan if configuration.
  * Shall not call from other than cmparser_parse_static_netif.
@@ -1872,7 +2562,7 @@ static int cmparser_parse_static_netif_veth_free(void *p)
  */
 static void* cmparser_parse_static_netif_vxcan_create(cJSON *param)
 {
-	cJSON *name = NULL, *upstream = NULL;
+	cJSON *name = NULL, *upstream = NULL, *filter = NULL;
 	char *pname = NULL, *pupstream = NULL;
 	netif_elem_vxcan_t *pvxcan = NULL;
 	void *vp = NULL;
@@ -1900,6 +2590,25 @@ static void* cmparser_parse_static_netif_vxcan_create(cJSON *param)
 		goto error_return;
 	}
 
+	filter = cJSON_GetObjectItemCaseSensitive(param, "filter");
+	if (cJSON_IsObject(filter)) {
+		cJSON *rx = NULL, *tx = NULL;
+
+		rx = cJSON_GetObjectItemCaseSensitive(filter, "rx");
+		if (rx != NULL) {
+			if (cmparser_parse_static_netif_vxcan_filter(rx, &pvxcan->rx_filter, &pvxcan->num_of_rx_filter) < 0) {
+				goto error_return;
+			}
+		}
+
+		tx = cJSON_GetObjectItemCaseSensitive(filter, "tx");
+		if (tx != NULL) {
+			if (cmparser_parse_static_netif_vxcan_filter(tx, &pvxcan->tx_filter, &pvxcan->num_of_tx_filter) < 0) {
+				goto error_return;
+			}
+		}
+	}
+
 	#ifdef _PRINTF_DEBUG_
 	(void) fprintf(stdout,"cmparser: dcmparser_parse_static_netif_vxcan_create: name = %s, upstream = %s\n", pname, pupstream);
 	#endif
@@ -1911,6 +2620,8 @@ static void* cmparser_parse_static_netif_vxcan_create(cJSON *param)
 	return vp;
 
 error_return:
+	(void) free(pvxcan->rx_filter);
+	(void) free(pvxcan->tx_filter);
 	(void) free(pupstream);
 	(void) free(pname);
 	(void) free(pvxcan);
@@ -1934,6 +2645,8 @@ static int cmparser_parse_static_netif_vxcan_free(void *p)
 	}
 
 	pvxcan = (netif_elem_vxcan_t*)p;
+	(void) free(pvxcan->rx_filter);
+	(void) free(pvxcan->tx_filter);
 	(void) free(pvxcan->upstream);
 	(void) free(pvxcan->name);
 	(void) free(pvxcan);
@@ -1989,6 +2702,16 @@ static int cmparser_parse_static_netif(container_static_netif_t *snif, const cJS
 						if (vp == NULL) {
 							continue;
 						}
+					} else if (iftype == STATICNETIF_MACVLAN) {
+						vp = cmparser_parse_static_netif_macvlan_create(param);
+						if (vp == NULL) {
+							continue;
+						}
+					} else if (iftype == STATICNETIF_IPVLAN) {
+						vp = cmparser_parse_static_netif_ipvlan_create(param);
+						if (vp == NULL) {
+							continue;
+						}
 					} else {
 						continue;
 					}
@@ -2000,6 +2723,10 @@ static int cmparser_parse_static_netif(container_static_netif_t *snif, const cJS
 							(void) cmparser_parse_static_netif_veth_free(vp);
 						} else if (iftype == STATICNETIF_VXCAN) {
 							(void) cmparser_parse_static_netif_vxcan_free(vp);
+						} else if (iftype == STATICNETIF_MACVLAN) {
+							(void) cmparser_parse_static_netif_macvlan_free(vp);
+						} else if (iftype == STATICNETIF_IPVLAN) {
+							(void) cmparser_parse_static_netif_ipvlan_free(vp);
 						} else {
 							; //nop
 						}
@@ -2029,6 +2756,10 @@ err_ret:
 				(void) cmparser_parse_static_netif_veth_free((void *)selem->setting);
 			} else if (selem->type == STATICNETIF_VXCAN) {
 				(void) cmparser_parse_static_netif_vxcan_free((void *)selem->setting);
+			} else if (selem->type == STATICNETIF_MACVLAN) {
+				(void) cmparser_parse_static_netif_macvlan_free((void *)selem->setting);
+			} else if (selem->type == STATICNETIF_IPVLAN) {
+				(void) cmparser_parse_static_netif_ipvlan_free((void *)selem->setting);
 			} else {
 				; //nop
 			}
@@ -2424,6 +3155,10 @@ void cmparser_release_config(container_config_t *cc)
 				(void) cmparser_parse_static_netif_veth_free((void *)selem->setting);
 			} else if (selem->type == STATICNETIF_VXCAN) {
 				(void) cmparser_parse_static_netif_vxcan_free((void *)selem->setting);
+			} else if (selem->type == STATICNETIF_MACVLAN) {
+				(void) cmparser_parse_static_netif_macvlan_free((void *)selem->setting);
+			} else if (selem->type == STATICNETIF_IPVLAN) {
+				(void) cmparser_parse_static_netif_ipvlan_free((void *)selem->setting);
 			} else {
 				; //nop
 			}
@@ -2509,6 +3244,7 @@ void cmparser_release_config(container_config_t *cc)
 			dl_list_del(&exdisk->list);
 			(void) free(exdisk->blockdev[0]);
 			(void) free(exdisk->blockdev[1]);
+			(void) free(exdisk->template_image);
 			(void) free(exdisk->option);
 			(void) free(exdisk->filesystem);
 			(void) free(exdisk->to);
@@ -2518,6 +3254,8 @@ void cmparser_release_config(container_config_t *cc)
 
 		(void) free(cc->baseconfig.rootfs.rootfs_dev[0]);
 		(void) free(cc->baseconfig.rootfs.rootfs_dev[1]);
+		(void) free(cc->baseconfig.rootfs.overlay_path);
+		(void) free(cc->baseconfig.rootfs.overlay_size);
 		(void) free(cc->baseconfig.rootfs.option);
 		(void) free(cc->baseconfig.rootfs.filesystem);
 		(void) free(cc->baseconfig.rootfs.path);
@@ -111,6 +111,32 @@ static int cmparser_manager_parser_get_diskmountfailop(const char *str)
 
 	return ret;
 }
+/**
+ * Sub function for the uevent source parse.
+ * Shall not call from other than cmparser_manager_create_from_file.
+ *
+ * @param [in]	str		string of uevent source
+ * @return int
+ * @retval MANAGER_UEVENT_SOURCE_LIBUDEV	str is "libudev" or other
+ * @retval MANAGER_UEVENT_SOURCE_RAW		str is "raw"
+ */
+static int cmparser_manager_parser_get_ueventsource(const char *str)
+{
+	static const char libudev[] = "libudev";
+	static const char raw[] = "raw";
+	int ret = MANAGER_UEVENT_SOURCE_LIBUDEV;
+
+	if (strncmp(libudev, str, sizeof(libudev)) == 0) {
+		ret = MANAGER_UEVENT_SOURCE_LIBUDEV;
+	} else if (strncmp(raw, str, sizeof(raw)) == 0) {
+		ret = MANAGER_UEVENT_SOURCE_RAW;
+	} else {
+		// unknow str, select LIBUDEV.
+		ret = MANAGER_UEVENT_SOURCE_LIBUDEV;
+	}
+
+	return ret;
+}
 /**
  * Sub function for the operation mount config parser.
  *
@@ -321,6 +347,10 @@ int cmparser_manager_create_from_file(container_manager_config_t **cm, const cha
 	dl_list_init(&cmcfg->role_list);
 	dl_list_init(&cmcfg->bridgelist);
 	dl_list_init(&cmcfg->operation.mount.mount_list);
+	cmcfg->operation.parallel = MANAGER_OPERATION_PARALLEL_DEFAULT;
+	cmcfg->operation.recovery_ioweight = RECOVERY_SCHEDULER_IOWEIGHT_DEFAULT;
+	cmcfg->operation.recovery_iomax = 0;
+	cmcfg->operation.recovery_budget = 0;
 
 	// Get configdir
 	{
@@ -379,7 +409,59 @@ int cmparser_manager_create_from_file(container_manager_config_t **cm, const cha
 		const cJSON *operation = NULL;
 		operation = cJSON_GetObjectItemCaseSensitive(json, "operation");
 		if (cJSON_IsObject(operation)) {
-			cJSON *mount = NULL;
+			cJSON *mount = NULL, *parallel = NULL, *recovery = NULL;
+
+			parallel = cJSON_GetObjectItemCaseSensitive(operation, "parallel");
+			if (cJSON_IsNumber(parallel)) {
+				if ((parallel->valueint >= 1) && (parallel->valueint <= MANAGER_OPERATION_PARALLEL_MAX)) {
+					cmcfg->operation.parallel = parallel->valueint;
+				} else {
+					#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+					(void) fprintf(stderr,"[CM CRITICAL ERROR] cmparser_manager: operation parallel %d is out of range. use default.\n", parallel->valueint);
+					#endif
+				}
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"cmparser_manager: operation parallel = %d\n", cmcfg->operation.parallel);
+				#endif
+			}
+
+			recovery = cJSON_GetObjectItemCaseSensitive(operation, "recovery");
+			if (cJSON_IsObject(recovery)) {
+				cJSON *ioweight = NULL, *iomax = NULL, *budget = NULL;
+
+				ioweight = cJSON_GetObjectItemCaseSensitive(recovery, "ioweight");
+				if (cJSON_IsNumber(ioweight)) {
+					if ((ioweight->valueint >= 1) && (ioweight->valueint <= 10000)) {
+						cmcfg->operation.recovery_ioweight = ioweight->valueint;
+					} else {
+						#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+						(void) fprintf(stderr,"[CM CRITICAL ERROR] cmparser_manager: operation recovery ioweight %d is out of range. use default.\n", ioweight->valueint);
+						#endif
+					}
+				}
+
+				iomax = cJSON_GetObjectItemCaseSensitive(recovery, "iomax");
+				if (cJSON_IsNumber(iomax)) {
+					if (iomax->valuedouble >= 0) {
+						cmcfg->operation.recovery_iomax = (int64_t)iomax->valuedouble;
+					}
+				}
+
+				budget = cJSON_GetObjectItemCaseSensitive(recovery, "budget");
+				if (cJSON_IsNumber(budget)) {
+					if (budget->valueint >= 0) {
+						cmcfg->operation.recovery_budget = budget->valueint;
+					} else {
+						#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+						(void) fprintf(stderr,"[CM CRITICAL ERROR] cmparser_manager: operation recovery budget %d is out of range. use default.\n", budget->valueint);
+						#endif
+					}
+				}
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"cmparser_manager: operation recovery ioweight = %d, iomax = %lld, budget = %d\n"
+								, cmcfg->operation.recovery_ioweight, (long long)cmcfg->operation.recovery_iomax, cmcfg->operation.recovery_budget);
+				#endif
+			}
 
 			mount = cJSON_GetObjectItemCaseSensitive(operation, "mount");
 			if (cJSON_IsArray(mount)) {
@@ -394,6 +476,26 @@ int cmparser_manager_create_from_file(container_manager_config_t **cm, const cha
 		}
 	}
 
+	// Get dynamic device options
+	{
+		const cJSON *dynamicdevice = NULL;
+
+		cmcfg->dynamicdevice.uevent_source = MANAGER_UEVENT_SOURCE_LIBUDEV;
+
+		dynamicdevice = cJSON_GetObjectItemCaseSensitive(json, "dynamicdevice");
+		if (cJSON_IsObject(dynamicdevice)) {
+			cJSON *uevent = NULL;
+
+			uevent = cJSON_GetObjectItemCaseSensitive(dynamicdevice, "uevent");
+			if (cJSON_IsString(uevent) && (uevent->valuestring != NULL)) {
+				cmcfg->dynamicdevice.uevent_source = cmparser_manager_parser_get_ueventsource(uevent->valuestring);
+				#ifdef _PRINTF_DEBUG_
+				(void) fprintf(stdout,"cmcfg: dynamicdevice uevent = %s\n",uevent->valuestring);
+				#endif
+			}
+		}
+	}
+
 	cJSON_Delete(json);
 	cmparser_release_jsonstring(jsonstring);
 
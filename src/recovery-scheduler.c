@@ -0,0 +1,327 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	recovery-scheduler.c
+ * @brief	Global disk recovery scheduler.  Recovery (fsck/mkfs/erase) to same physical disk is serialized across all guests and manager operation.
+ */
+#undef _PRINTF_DEBUG_
+
+#include "recovery-scheduler.h"
+#include "block-util.h"
+#include "cgroup-utils.h"
+#include "cm-utils.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+/**
+ * @def	RECOVERY_SCHEDULER_WAITER_TIMEOUT
+ * @brief	Waiter that is not request in this time (ms) is ignored at priority evaluation.  Typically requester retry in every internal tick (50ms).
+ */
+#define RECOVERY_SCHEDULER_WAITER_TIMEOUT	(1000)
+
+static pthread_mutex_t g_recovery_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct dl_list g_recovery_list = { &g_recovery_list, &g_recovery_list };
+
+static const char g_cgroup_v2_subtree_control[] = "/sys/fs/cgroup/cgroup.subtree_control";
+static const char g_recovery_cgroup_path[] = "/sys/fs/cgroup/cm-recovery";
+static char g_recovery_cgroup_procs[PATH_MAX];
+static int g_recovery_cgroup_valid = 0;
+static int64_t g_recovery_iomax = 0;
+static int g_recovery_budget = 0;
+
+/**
+ * Sub function for write to cgroup control file.
+ *
+ * @param [in]	path	Path to control file.
+ * @param [in]	value	Value string to write.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Fail to write.
+ */
+static int recovery_scheduler_write_ctrl(const char *path, const char *value)
+{
+	int fd = -1;
+	ssize_t sret = -1;
+	size_t len = 0;
+
+	fd = open(path, (O_WRONLY | O_CLOEXEC));
+	if (fd < 0) {
+		return -1;
+	}
+
+	len = strlen(value);
+	sret = write(fd, value, len);
+	(void) close(fd);
+	if (sret != (ssize_t)len) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Setup recovery cgroup to throttle recovery I/O.
+ * The recovery cgroup is created in cgroup v2 root with low io.weight.  When iomax is set, io.max is set to recovery target disk.
+ * When this function fail, recovery is executed without throttle.
+ *
+ * @param [in]	ioweight	io.weight for recovery cgroup (1-10000).
+ * @param [in]	iomax		Read and write bandwidth limit (byte/sec) for recovery target disk. 0 is no limit.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Not support throttle.
+ */
+int recovery_scheduler_setup(int ioweight, int64_t iomax)
+{
+	char buf[64];
+	char path[PATH_MAX];
+	int ret = -1;
+
+	if (cgroup_util_get_cgroup_version() != 2) {
+		return -1;
+	}
+
+	// io controller is not enabled by default.  It may already be enabled.
+	(void) recovery_scheduler_write_ctrl(g_cgroup_v2_subtree_control, "+io");
+
+	ret = mkdir(g_recovery_cgroup_path, 0755);
+	if ((ret < 0) && (errno != EEXIST)) {
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Fail to create recovery cgroup %s.\n", g_recovery_cgroup_path);
+		#endif
+		return -1;
+	}
+
+	(void) snprintf(path, sizeof(path), "%s/io.weight", g_recovery_cgroup_path);
+	(void) snprintf(buf, sizeof(buf), "default %d", ioweight);
+	ret = recovery_scheduler_write_ctrl(path, buf);
+	if (ret < 0) {
+		#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+		(void) fprintf(stderr,"[CM CRITICAL ERROR] Fail to set io.weight to recovery cgroup.\n");
+		#endif
+		// Keep to use this cgroup for io.max.
+	}
+
+	(void) snprintf(g_recovery_cgroup_procs, sizeof(g_recovery_cgroup_procs), "%s/cgroup.procs", g_recovery_cgroup_path);
+	g_recovery_iomax = iomax;
+	g_recovery_cgroup_valid = 1;
+
+	#ifdef _PRINTF_DEBUG_
+	(void) fprintf(stdout,"recovery_scheduler_setup: io.weight = %d, io.max = %lld\n", ioweight, (long long)iomax);
+	#endif
+
+	return 0;
+}
+/**
+ * Sub function to set io.max of recovery cgroup for target disk.
+ *
+ * @param [in]	disk	Device number of physical disk.
+ * @return void
+ */
+static void recovery_scheduler_set_iomax(dev_t disk)
+{
+	char buf[128];
+	char path[PATH_MAX];
+
+	if ((g_recovery_cgroup_valid == 0) || (g_recovery_iomax <= 0)) {
+		return;
+	}
+
+	(void) snprintf(path, sizeof(path), "%s/io.max", g_recovery_cgroup_path);
+	(void) snprintf(buf, sizeof(buf), "%u:%u rbps=%lld wbps=%lld", major(disk), minor(disk)
+					, (long long)g_recovery_iomax, (long long)g_recovery_iomax);
+	(void) recovery_scheduler_write_ctrl(path, buf);
+}
+/**
+ * Try to acquire physical disk for recovery.
+ * When same physical disk is under recovery or higher priority request is waiting, requester shall retry later.
+ * Same priority requests are granted by request order.
+ *
+ * @param [in]	ticket		Pointer to recovery_ticket_t owned by requester.  It shall be RECOVERY_TICKET_IDLE at first request.
+ * @param [in]	devpath		Device node path for recovery target.
+ * @param [in]	priority	Priority of recovery. Small value is high priority.
+ * @return int
+ * @retval  1 Granted.  Requester must call recovery_scheduler_release after recovery.
+ * @retval  0 Not granted, retry later.
+ * @retval -1 Arg. error.
+ */
+int recovery_scheduler_try_acquire(recovery_ticket_t *ticket, const char *devpath, int priority)
+{
+	recovery_ticket_t *elem = NULL;
+	int64_t now = 0;
+	int is_blocked = 0;
+	int ret = -1;
+
+	if ((ticket == NULL) || (devpath == NULL)) {
+		return -1;
+	}
+
+	now = get_current_time_ms();
+
+	(void) pthread_mutex_lock(&g_recovery_mutex);
+
+	if (ticket->state == RECOVERY_TICKET_GRANTED) {
+		(void) pthread_mutex_unlock(&g_recovery_mutex);
+		return 1;
+	}
+
+	if (ticket->state == RECOVERY_TICKET_IDLE) {
+		ret = block_util_get_disk(devpath, &ticket->disk);
+		if (ret == 0) {
+			ticket->has_disk = 1;
+		} else {
+			// Not block device, can't detect contention.
+			ticket->has_disk = 0;
+		}
+		ticket->priority = priority;
+		ticket->state = RECOVERY_TICKET_WAIT;
+		dl_list_add_tail(&g_recovery_list, &ticket->list);
+	}
+	ticket->last_request = now;
+
+	if (ticket->has_disk == 1) {
+		int is_earlier = 1;
+
+		dl_list_for_each(elem, &g_recovery_list, recovery_ticket_t, list) {
+			if (elem == ticket) {
+				// Following elements are requested after this ticket.
+				is_earlier = 0;
+				continue;
+			}
+
+			if ((elem->has_disk == 0) || (elem->disk != ticket->disk)) {
+				continue;
+			}
+
+			if (elem->state == RECOVERY_TICKET_GRANTED) {
+				// Same physical disk is under recovery.
+				is_blocked = 1;
+				break;
+			}
+
+			if ((now - elem->last_request) > RECOVERY_SCHEDULER_WAITER_TIMEOUT) {
+				// Stale waiter.
+				continue;
+			}
+
+			if ((elem->priority < ticket->priority)
+				|| ((elem->priority == ticket->priority) && (is_earlier == 1))) {
+				// Higher priority or same priority and earlier request is waiting.
+				is_blocked = 1;
+				break;
+			}
+		}
+	}
+
+	if (is_blocked == 0) {
+		ticket->state = RECOVERY_TICKET_GRANTED;
+		if (ticket->has_disk == 1) {
+			recovery_scheduler_set_iomax(ticket->disk);
+		}
+		#ifdef _PRINTF_DEBUG_
+		(void) fprintf(stdout,"recovery_scheduler_try_acquire: granted %s (priority %d)\n", devpath, priority);
+		#endif
+	}
+
+	(void) pthread_mutex_unlock(&g_recovery_mutex);
+
+	if (is_blocked == 1) {
+		return 0;
+	}
+
+	return 1;
+}
+/**
+ * Release physical disk or cancel waiting.
+ * This function is thread safe, it can call from worker thread.
+ *
+ * @param [in]	ticket		Pointer to recovery_ticket_t.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Arg. error.
+ */
+int recovery_scheduler_release(recovery_ticket_t *ticket)
+{
+	if (ticket == NULL) {
+		return -1;
+	}
+
+	(void) pthread_mutex_lock(&g_recovery_mutex);
+
+	if (ticket->state != RECOVERY_TICKET_IDLE) {
+		dl_list_del(&ticket->list);
+		ticket->state = RECOVERY_TICKET_IDLE;
+	}
+
+	(void) pthread_mutex_unlock(&g_recovery_mutex);
+
+	return 0;
+}
+/**
+ * Get recovery cgroup path.
+ *
+ * @return const char*
+ * @retval	!=NULL	Path to recovery cgroup.
+ * @retval	NULL	Recovery cgroup is not available.
+ */
+const char *recovery_scheduler_get_cgroup(void)
+{
+	if (g_recovery_cgroup_valid == 0) {
+		return NULL;
+	}
+
+	return g_recovery_cgroup_path;
+}
+/**
+ * Set time budget of recovery job.
+ * This budget is applied to last tier of recovery (fsck full check, mkfs and clone).  It shall be set before any recovery job is run.
+ *
+ * @param [in]	budget	Time budget (sec).  0 is no limit.
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Arg. error.
+ */
+int recovery_scheduler_set_budget(int budget)
+{
+	if (budget < 0) {
+		return -1;
+	}
+
+	g_recovery_budget = budget;
+
+	return 0;
+}
+/**
+ * Get time budget of recovery job.
+ *
+ * @return int
+ * @retval	>0	Time budget (sec).
+ * @retval	0	No limit.
+ */
+int recovery_scheduler_get_budget(void)
+{
+	return g_recovery_budget;
+}
+/**
+ * Move calling process to recovery cgroup.
+ * This function is used in forked child process before exec recovery command.
+ *
+ * @return int
+ * @retval  0 Success.
+ * @retval -1 Recovery cgroup is not available or fail to move.
+ */
+int recovery_scheduler_attach_self(void)
+{
+	if (g_recovery_cgroup_valid == 0) {
+		return -1;
+	}
+
+	// "0" is calling process.
+	return recovery_scheduler_write_ctrl(g_recovery_cgroup_procs, "0");
+}
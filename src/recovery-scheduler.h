@@ -0,0 +1,55 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	recovery-scheduler.h
+ * @brief	The header for global disk recovery scheduler.
+ */
+#ifndef RECOVERY_SCHEDULER_H
+#define RECOVERY_SCHEDULER_H
+//-----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "list.h"
+
+//-----------------------------------------------------------------------------
+/**
+ * @def	RECOVERY_SCHEDULER_PRIORITY_MANAGER
+ * @brief	Recovery priority for manager operation.  Guest recovery use own bootpriority (1 is highest).
+ */
+#define RECOVERY_SCHEDULER_PRIORITY_MANAGER	(0)
+/**
+ * @def	RECOVERY_SCHEDULER_IOWEIGHT_DEFAULT
+ * @brief	Default io.weight for recovery cgroup.  cgroup default is 100.
+ */
+#define RECOVERY_SCHEDULER_IOWEIGHT_DEFAULT	(10)
+
+#define RECOVERY_TICKET_IDLE	(0)	/**< Ticket is not used. */
+#define RECOVERY_TICKET_WAIT	(1)	/**< Ticket is waiting for disk. */
+#define RECOVERY_TICKET_GRANTED	(2)	/**< Ticket is granted to use disk. */
+
+/**
+ * @struct	s_recovery_ticket
+ * @brief	The data structure for one recovery request.  It's owned by requester and linked to scheduler while waiting or granted.
+ */
+struct s_recovery_ticket {
+	struct dl_list list;	/**< Double link list header. */
+	dev_t disk;				/**< Device number of physical disk. */
+	int has_disk;			/**< Physical disk lookup result. 1: disk is valid, 0: not block device (no serialization). */
+	int priority;			/**< Priority of recovery. Small value is high priority. */
+	int state;				/**< Ticket state. RECOVERY_TICKET_XXX. */
+	int64_t last_request;	/**< Last request time (ms). Waiter that is not request in timeout is ignored. */
+};
+typedef struct s_recovery_ticket recovery_ticket_t;	/**< typedef for struct s_recovery_ticket. */
+
+//-----------------------------------------------------------------------------
+int recovery_scheduler_setup(int ioweight, int64_t iomax);
+int recovery_scheduler_try_acquire(recovery_ticket_t *ticket, const char *devpath, int priority);
+int recovery_scheduler_release(recovery_ticket_t *ticket);
+const char *recovery_scheduler_get_cgroup(void);
+int recovery_scheduler_set_budget(int budget);
+int recovery_scheduler_get_budget(void);
+int recovery_scheduler_attach_self(void);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef RECOVERY_SCHEDULER_H
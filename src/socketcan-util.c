@@ -15,6 +15,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
 #include <errno.h>
 
 #include <stdio.h>
@@ -25,34 +26,264 @@
 #undef _PRINTF_DEBUG_
 
 /**
- * Function for create VXCAN interface pair.
+ * @def	SOCKETCANUTIL_BATCH_LIMIT
+ * @brief	Size limit of one netlink batch for socketcan utility.
+ */
+#define SOCKETCANUTIL_BATCH_LIMIT	(8192)
+/**
+ * @def	SOCKETCANUTIL_BATCH_MSG_MAX
+ * @brief	Maximum number of messages in one netlink batch for socketcan utility.
+ */
+#define SOCKETCANUTIL_BATCH_MSG_MAX	(8)
+/**
+ * @def	SOCKETCANUTIL_ACK_TIMEOUT_MS
+ * @brief	Receive timeout of acknowledgement in rtnetlink session for socketcan utility (ms).  Session is used in main loop, shall not block long time.
+ */
+#define SOCKETCANUTIL_ACK_TIMEOUT_MS	(500)
+
+/**
+ * @struct	s_socketcanutil_batch
+ * @brief	The data structure for multi message netlink transaction.
+ */
+struct s_socketcanutil_batch {
+	struct mnl_nlmsg_batch *batch;					/**< libmnl batch object. */
+	char buf[SOCKETCANUTIL_BATCH_LIMIT * 2];		/**< Buffer for batch. libmnl require double size of limit. */
+	unsigned int first_seq;							/**< Sequence number of first message in this batch. */
+	int num;										/**< Number of messages in this batch. */
+	int error[SOCKETCANUTIL_BATCH_MSG_MAX];			/**< Result of each message. 0 or negative errno. */
+};
+typedef struct s_socketcanutil_batch socketcanutil_batch_t;	/**< typedef for struct s_socketcanutil_batch. */
+
+/**
+ * @var		g_socketcanutil_nl
+ * @brief	Persistent rtnetlink session for socketcan utility. It's shared with libsocketcangw.
+ */
+static struct mnl_socket *g_socketcanutil_nl = NULL;
+/**
+ * @var		g_socketcanutil_seq
+ * @brief	Last sequence number of rtnetlink session for socketcan utility.  It's shared with libsocketcangw to avoid sequence number conflict.
+ */
+static unsigned int g_socketcanutil_seq = 115200;
+
+/**
+ * Get persistent rtnetlink session.  The session is opened at first call.
+ *
+ * @return struct mnl_socket*
+ * @retval	!=NULL	rtnetlink session.
+ * @retval	NULL	Fail to open session.
+ */
+static struct mnl_socket *socketcanutil_session_get(void)
+{
+	struct mnl_socket *nl = NULL;
+	struct timeval tv;
+
+	if (g_socketcanutil_nl != NULL) {
+		return g_socketcanutil_nl;
+	}
+
+	nl = mnl_socket_open2(NETLINK_ROUTE, SOCK_CLOEXEC);
+	if (nl == NULL) {
+		return NULL;
+	}
+
+	if (mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID) < 0) {
+		(void) mnl_socket_close(nl);
+		return NULL;
+	}
+
+	// Lost acknowledgement shall not block main loop, bound the wait time.
+	(void) memset(&tv, 0, sizeof(tv));
+	tv.tv_sec = SOCKETCANUTIL_ACK_TIMEOUT_MS / 1000;
+	tv.tv_usec = (SOCKETCANUTIL_ACK_TIMEOUT_MS % 1000) * 1000;
+	if (setsockopt(mnl_socket_get_fd(nl), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
+		(void) mnl_socket_close(nl);
+		return NULL;
+	}
+
+	g_socketcanutil_nl = nl;
+
+	// CAN gateway request use same session and same sequence number allocator.
+	(void) cangw_attach_session(mnl_socket_get_fd(nl), &g_socketcanutil_seq);
+
+	return g_socketcanutil_nl;
+}
+/**
+ * Close persistent rtnetlink session.
+ * Shall call at end of process.
  *
- * @param [in]	ifname	Pointer to ifname.
- * @param [in]	peer_ifname	Pointer to peer ifname.
  * @return int
- * @retval	0	Success to create VXCAN interface pair.
- * @retval	-1	Fail to create VXCAN interface pair.
- * @retval	-2	Argument error.
+ * @retval	0	Success.
  */
-int socketcanutil_create_vxcan_peer(const char *ifname, const char *peer_ifname)
+int socketcanutil_session_close(void)
+{
+	if (g_socketcanutil_nl != NULL) {
+		(void) cangw_attach_session(-1, NULL);
+		(void) mnl_socket_close(g_socketcanutil_nl);
+		g_socketcanutil_nl = NULL;
+	}
+
+	return 0;
+}
+/**
+ * Initialize multi message netlink transaction.
+ *
+ * @param [in]	scb	Pointer to socketcanutil_batch_t.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Fail to initialize.
+ */
+static int socketcanutil_batch_init(socketcanutil_batch_t *scb)
+{
+	(void) memset(scb->error, 0, sizeof(scb->error));
+	scb->num = 0;
+	// Reserve sequence numbers for whole batch, CAN gateway requests between init and commit use other numbers.
+	scb->first_seq = g_socketcanutil_seq + 1u;
+	g_socketcanutil_seq = g_socketcanutil_seq + (unsigned int)SOCKETCANUTIL_BATCH_MSG_MAX;
+
+	scb->batch = mnl_nlmsg_batch_start(scb->buf, SOCKETCANUTIL_BATCH_LIMIT);
+	if (scb->batch == NULL) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Start new message in multi message netlink transaction.
+ *
+ * @param [in]	scb		Pointer to socketcanutil_batch_t.
+ * @param [in]	type	Message type.
+ * @param [in]	flags	Message flags. NLM_F_REQUEST and NLM_F_ACK are added automatically.
+ * @return struct nlmsghdr*
+ * @retval	!=NULL	Header of new message.
+ * @retval	NULL	Batch is full.
+ */
+static struct nlmsghdr *socketcanutil_batch_put_header(socketcanutil_batch_t *scb, uint16_t type, uint16_t flags)
+{
+	struct nlmsghdr *nlh = NULL;
+
+	if (scb->num >= SOCKETCANUTIL_BATCH_MSG_MAX) {
+		return NULL;
+	}
+
+	nlh = mnl_nlmsg_put_header(mnl_nlmsg_batch_current(scb->batch));
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = (NLM_F_REQUEST | NLM_F_ACK | flags);
+	nlh->nlmsg_seq = scb->first_seq + (unsigned int)scb->num;
+
+	return nlh;
+}
+/**
+ * Finish current message in multi message netlink transaction.
+ *
+ * @param [in]	scb		Pointer to socketcanutil_batch_t.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int socketcanutil_batch_next(socketcanutil_batch_t *scb)
+{
+	if (mnl_nlmsg_batch_next(scb->batch) == false) {
+		return -1;
+	}
+
+	scb->num++;
+
+	return 0;
+}
+/**
+ * Commit multi message netlink transaction.
+ * All messages are sent by one sendto and acknowledgement is tracked by sequence number.
+ * When acknowledgement is not received in SOCKETCANUTIL_ACK_TIMEOUT_MS, it's treated as session error.
+ *
+ * @param [in]	scb		Pointer to socketcanutil_batch_t.
+ * @return int
+ * @retval	0	All messages are success.
+ * @retval	-1	Some messages are fail. Refer to scb->error.
+ * @retval	-2	Session error.
+ */
+static int socketcanutil_batch_commit(socketcanutil_batch_t *scb)
 {
 	struct mnl_socket *nl = NULL;
 	char buf[8192];
+	int ret = -1, result = 0;
+	int remain = 0;
+
+	nl = socketcanutil_session_get();
+	if (nl == NULL) {
+		result = -2;
+		goto do_return;
+	}
+
+	for (int i = 0; i < scb->num; i++) {
+		scb->error[i] = -EIO;	// Not acknowledged.
+	}
+	if (mnl_socket_sendto(nl, mnl_nlmsg_batch_head(scb->batch), mnl_nlmsg_batch_size(scb->batch)) < 0) {
+		result = -2;
+		goto do_return;
+	}
+
+	remain = scb->num;
+	while (remain > 0) {
+		const struct nlmsghdr *nlh = NULL;
+
+		ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
+		if (ret < 0) {
+			#ifdef CM_CRITICAL_ERROR_OUT_STDERROR
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+				(void) fprintf(stderr, "[CM CRITICAL ERROR] socketcanutil: acknowledgement timeout, %d of %d messages are not acknowledged.\n", remain, scb->num);
+			}
+			#endif
+			result = -2;
+			goto do_return;
+		}
+
+		nlh = (const struct nlmsghdr*)buf;
+		while (mnl_nlmsg_ok(nlh, ret) == true) {
+			// Skip stale acknowledgement from previous transaction.
+			if ((nlh->nlmsg_type == NLMSG_ERROR) && (nlh->nlmsg_seq >= scb->first_seq)
+				&& (nlh->nlmsg_seq < (scb->first_seq + (unsigned int)scb->num))) {
+				const struct nlmsgerr *err = mnl_nlmsg_get_payload(nlh);
+
+				scb->error[nlh->nlmsg_seq - scb->first_seq] = err->error;
+				remain--;
+			}
+			nlh = mnl_nlmsg_next(nlh, &ret);
+		}
+	}
+
+	for (int i = 0; i < scb->num; i++) {
+		if (scb->error[i] != 0) {
+			result = -1;
+		}
+	}
+
+do_return:
+	mnl_nlmsg_batch_stop(scb->batch);
+	scb->batch = NULL;
+
+	return result;
+}
+/**
+ * Put VXCAN interface pair creation message to transaction.
+ *
+ * @param [in]	scb			Pointer to socketcanutil_batch_t.
+ * @param [in]	ifname		Pointer to ifname.
+ * @param [in]	peer_ifname	Pointer to peer ifname.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int socketcanutil_put_create_vxcan_peer(socketcanutil_batch_t *scb, const char *ifname, const char *peer_ifname)
+{
 	struct nlmsghdr *nlh = NULL;
 	struct ifinfomsg *ifm = NULL;
 	struct nlattr *linkinfo = NULL;
-	int ret = 0, result = 0;
-	unsigned int portid = 0, vxcan_seq = 115200;
 
-	if ((ifname == NULL) || (peer_ifname == NULL)) {
-		result = -2;
-		goto do_return;
+	nlh = socketcanutil_batch_put_header(scb, RTM_NEWLINK, (NLM_F_EXCL | NLM_F_CREATE));
+	if (nlh == NULL) {
+		return -1;
 	}
 
-	nlh = mnl_nlmsg_put_header(buf);
-	nlh->nlmsg_type	= RTM_NEWLINK;
-	nlh->nlmsg_flags = (NLM_F_REQUEST | NLM_F_ACK | NLM_F_EXCL | NLM_F_CREATE);
-	nlh->nlmsg_seq = vxcan_seq;
 	ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*ifm));
 	ifm->ifi_family = AF_UNSPEC;
 	ifm->ifi_change = 0;
@@ -81,118 +312,178 @@ int socketcanutil_create_vxcan_peer(const char *ifname, const char *peer_ifname)
 	}
 	mnl_attr_nest_end(nlh, linkinfo);
 
-	nl = mnl_socket_open(NETLINK_ROUTE);
-	if (nl == NULL) {
-		result = -1;
-		goto do_return;
-	}
+	return socketcanutil_batch_next(scb);
+}
+/**
+ * Put link up message to transaction. Target interface is selected by name, it can use to just created interface in same transaction.
+ *
+ * @param [in]	scb		Pointer to socketcanutil_batch_t.
+ * @param [in]	ifname	Pointer to ifname.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int socketcanutil_put_up_can_if(socketcanutil_batch_t *scb, const char *ifname)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct ifinfomsg *ifm = NULL;
 
-	if (mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID) < 0) {
-		result = -1;
-		goto do_return;
+	nlh = socketcanutil_batch_put_header(scb, RTM_NEWLINK, 0);
+	if (nlh == NULL) {
+		return -1;
 	}
-	portid = mnl_socket_get_portid(nl);
 
-	if (mnl_socket_sendto(nl, nlh, nlh->nlmsg_len) < 0) {
-		result = -1;
-		goto do_return;
-	}
+	ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*ifm));
+	ifm->ifi_family = AF_UNSPEC;
+	ifm->ifi_index = 0;
+	ifm->ifi_change = IFF_UP;
+	ifm->ifi_flags = IFF_UP;
 
-	ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
-	if (ret == -1) {
-		result = -1;
-		goto do_return;
-	}
+	mnl_attr_put_str(nlh, IFLA_IFNAME, ifname);
 
-	ret = mnl_cb_run(buf, ret, vxcan_seq, portid, NULL, NULL);
-	if (ret == -1){
-		result = -1;
-		goto do_return;
-	}
+	return socketcanutil_batch_next(scb);
+}
+/**
+ * Put link remove message to transaction. Target interface is selected by name.
+ *
+ * @param [in]	scb		Pointer to socketcanutil_batch_t.
+ * @param [in]	ifname	Pointer to ifname.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int socketcanutil_put_remove_vxcan_peer(socketcanutil_batch_t *scb, const char *ifname)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct ifinfomsg *ifm = NULL;
 
-do_return:
-	if (nl != NULL) {
-		mnl_socket_close(nl);
+	nlh = socketcanutil_batch_put_header(scb, RTM_DELLINK, 0);
+	if (nlh == NULL) {
+		return -1;
 	}
 
-	return result;
+	ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*ifm));
+	ifm->ifi_family = AF_UNSPEC;
+	ifm->ifi_index = 0;
+	ifm->ifi_change = 0;
+	ifm->ifi_flags = 0;
+
+	mnl_attr_put_str(nlh, IFLA_IFNAME, ifname);
+
+	return socketcanutil_batch_next(scb);
 }
 /**
- * Function for remove VXCAN interface pair.
+ * Function for create VXCAN interface pair.
  *
  * @param [in]	ifname	Pointer to ifname.
+ * @param [in]	peer_ifname	Pointer to peer ifname.
  * @return int
- * @retval	0	Success to remove vxcan interface.
- * @retval	-1	Fail to remove VXCAN interface pair.
+ * @retval	0	Success to create VXCAN interface pair.
+ * @retval	-1	Fail to create VXCAN interface pair.
  * @retval	-2	Argument error.
- * @retval	-3	No interface.
  */
-int socketcanutil_up_can_if(const char *ifname)
+int socketcanutil_create_vxcan_peer(const char *ifname, const char *peer_ifname)
 {
-	struct mnl_socket *nl = NULL;
-	char buf[8192];
-	struct nlmsghdr *nlh = NULL;
-	struct ifinfomsg *ifm = NULL;
-	int ret = 0, result = 0;
-	unsigned int portid = 0, vxcan_seq = 115202, vxcan_if_index = 0;
+	socketcanutil_batch_t scb;
+	int ret = -1;
 
-	if (ifname == NULL) {
-		result = -2;
-		goto do_return;
+	if ((ifname == NULL) || (peer_ifname == NULL)) {
+		return -2;
 	}
 
-	vxcan_if_index = if_nametoindex(ifname);
-	if (vxcan_if_index == 0) {
-		// No interface
-		result = -3;
-		goto do_return;
+	ret = socketcanutil_batch_init(&scb);
+	if (ret < 0) {
+		return -1;
 	}
 
-	nlh = mnl_nlmsg_put_header(buf);
-	nlh->nlmsg_type = RTM_NEWLINK;
-	nlh->nlmsg_flags = (NLM_F_REQUEST | NLM_F_ACK);
-	nlh->nlmsg_seq = vxcan_seq;
-	ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*ifm));
-	ifm->ifi_family = AF_UNSPEC;
-	ifm->ifi_index = vxcan_if_index;
-	ifm->ifi_change = 0;
-	ifm->ifi_flags = IFF_UP;
+	(void) socketcanutil_put_create_vxcan_peer(&scb, ifname, peer_ifname);
 
-	nl = mnl_socket_open(NETLINK_ROUTE);
-	if (nl == NULL) {
-		result = -1;
-		goto do_return;
+	ret = socketcanutil_batch_commit(&scb);
+	if (ret < 0) {
+		return -1;
 	}
 
-	if (mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID) < 0) {
-		result = -1;
-		goto do_return;
+	return 0;
+}
+/**
+ * Function for create VXCAN interface pair and link up for host side interface.
+ * These operations are done in one netlink transaction.
+ *
+ * @param [in]	ifname	Pointer to ifname. (host side)
+ * @param [in]	peer_ifname	Pointer to peer ifname. (guest side)
+ * @return int
+ * @retval	0	Success to create VXCAN interface pair.
+ * @retval	-1	Fail to create VXCAN interface pair.
+ * @retval	-2	Argument error.
+ * @retval	-3	Created VXCAN interface pair, but fail to link up.
+ */
+int socketcanutil_setup_vxcan_peer(const char *ifname, const char *peer_ifname)
+{
+	socketcanutil_batch_t scb;
+	int ret = -1;
+
+	if ((ifname == NULL) || (peer_ifname == NULL)) {
+		return -2;
 	}
-	portid = mnl_socket_get_portid(nl);
 
-	if (mnl_socket_sendto(nl, nlh, nlh->nlmsg_len) < 0) {
-		result = -1;
-		goto do_return;
+	ret = socketcanutil_batch_init(&scb);
+	if (ret < 0) {
+		return -1;
 	}
 
-	ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
+	(void) socketcanutil_put_create_vxcan_peer(&scb, ifname, peer_ifname);
+	(void) socketcanutil_put_up_can_if(&scb, ifname);
+
+	ret = socketcanutil_batch_commit(&scb);
 	if (ret == -1) {
-		result = -1;
-		goto do_return;
+		if (scb.error[0] != 0) {
+			return -1;
+		}
+		return -3;
+	} else if (ret < 0) {
+		return -1;
 	}
 
-	ret = mnl_cb_run(buf, ret, vxcan_seq, portid, NULL, NULL);
-	if (ret == -1){
-		result = -1;
-		goto do_return;
+	return 0;
+}
+/**
+ * Function for link up CAN interface.
+ *
+ * @param [in]	ifname	Pointer to ifname.
+ * @return int
+ * @retval	0	Success to link up.
+ * @retval	-1	Fail to link up.
+ * @retval	-2	Argument error.
+ * @retval	-3	No interface.
+ */
+int socketcanutil_up_can_if(const char *ifname)
+{
+	socketcanutil_batch_t scb;
+	int ret = -1;
+
+	if (ifname == NULL) {
+		return -2;
 	}
 
-do_return:
-	if (nl != NULL) {
-		mnl_socket_close(nl);
+	ret = socketcanutil_batch_init(&scb);
+	if (ret < 0) {
+		return -1;
 	}
 
-	return result;
+	(void) socketcanutil_put_up_can_if(&scb, ifname);
+
+	ret = socketcanutil_batch_commit(&scb);
+	if (ret == -1) {
+		if (scb.error[0] == -ENODEV) {
+			// No interface
+			return -3;
+		}
+		return -1;
+	} else if (ret < 0) {
+		return -1;
+	}
+
+	return 0;
 }
 /**
  * Function for remove VXCAN interface pair.
@@ -206,73 +497,93 @@ do_return:
  */
 int socketcanutil_remove_vxcan_peer(const char *ifname)
 {
-	struct mnl_socket *nl = NULL;
-	char buf[8192];
-	struct nlmsghdr *nlh = NULL;
-	struct ifinfomsg *ifm = NULL;
-	int ret = 0, result = 0;
-	unsigned int portid = 0, vxcan_seq = 115201, vxcan_if_index = 0;
+	socketcanutil_batch_t scb;
+	int ret = -1;
 
 	if (ifname == NULL) {
-		result = -2;
-		goto do_return;
+		return -2;
 	}
 
-	vxcan_if_index = if_nametoindex(ifname);
-	if (vxcan_if_index == 0) {
-		// No interface
-		result = -3;
-		goto do_return;
+	ret = socketcanutil_batch_init(&scb);
+	if (ret < 0) {
+		return -1;
 	}
 
-	nlh = mnl_nlmsg_put_header(buf);
-	nlh->nlmsg_type = RTM_DELLINK;
-	nlh->nlmsg_flags = (NLM_F_REQUEST | NLM_F_ACK);
-	nlh->nlmsg_seq = vxcan_seq;
-	ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*ifm));
-	ifm->ifi_family = AF_UNSPEC;
-	ifm->ifi_index = vxcan_if_index;
-	ifm->ifi_change = 0;
-	ifm->ifi_flags = 0;
+	(void) socketcanutil_put_remove_vxcan_peer(&scb, ifname);
 
-	nl = mnl_socket_open(NETLINK_ROUTE);
-	if (nl == NULL) {
-		result = -1;
-		goto do_return;
+	ret = socketcanutil_batch_commit(&scb);
+	if (ret == -1) {
+		if (scb.error[0] == -ENODEV) {
+			// No interface
+			return -3;
+		}
+		return -1;
+	} else if (ret < 0) {
+		return -1;
 	}
 
-	if (mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID) < 0) {
-		result = -1;
-		goto do_return;
-	}
-	portid = mnl_socket_get_portid(nl);
+	return 0;
+}
+/**
+ * Function for configure CAN gateway from upstream interface to VXCAN interface.
+ * The request is sent using persistent rtnetlink session.
+ *
+ * @param [in]	src_ifname	Pointer to source ifname.
+ * @param [in]	dest_ifname	Pointer to destination ifname.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Argument error.
+ * @retval	-2	No interface.
+ */
+int socketcanutil_configure_gateway(const char *src_ifname, const char *dest_ifname)
+{
+	int ret = -1;
+	socketcan_gw_rule_t gw_rule;
 
-	if (mnl_socket_sendto(nl, nlh, nlh->nlmsg_len) < 0) {
-		result = -1;
-		goto do_return;
+	if ((src_ifname == NULL) || (dest_ifname == NULL)) {
+		return -1;
 	}
 
-	ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
-	if (ret == -1) {
-		result = -1;
-		goto do_return;
-	}
+	memset(&gw_rule, 0, sizeof(gw_rule));
 
-	ret = mnl_cb_run(buf, ret, vxcan_seq, portid, NULL, NULL);
-	if (ret == -1){
-		result = -1;
-		goto do_return;
+	gw_rule.src_ifindex = if_nametoindex(src_ifname);
+	gw_rule.dst_ifindex = if_nametoindex(dest_ifname);
+
+	if ((gw_rule.src_ifindex == 0) || (gw_rule.dst_ifindex == 0)) {
+		return -2;
 	}
 
-do_return:
-	if (nl != NULL) {
-		mnl_socket_close(nl);
+	// Open shared session before gateway request.
+	(void) socketcanutil_session_get();
+
+	gw_rule.options |= SOCKETCAN_GW_RULE_FILTER;
+	gw_rule.filter.can_id = 0x000;
+	gw_rule.filter.can_mask = 0x000;
+
+	ret = cangw_add_rule(&gw_rule);
+	if (ret < 0) {
+		; //nop
 	}
 
-	return result;
+	return 0;
 }
-
-int socketcanutil_configure_gateway(const char *src_ifname, const char *dest_ifname)
+/**
+ * Function for add CAN gateway rule with CAN ID filter.
+ * The request is sent using persistent rtnetlink session.
+ *
+ * @param [in]	src_ifname	Pointer to source ifname.
+ * @param [in]	dest_ifname	Pointer to destination ifname.
+ * @param [in]	can_id		CAN ID for filter.
+ * @param [in]	can_mask	CAN ID mask for filter.
+ * @param [in]	is_rewrite	Rewrite CAN ID of passed frame (=1) or not (=0).
+ * @param [in]	rewrite_id	New CAN ID to rewrite.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Argument error.
+ * @retval	-2	No interface.
+ * @retval	-3	Fail to add rule.
+ */
+int socketcanutil_add_gateway_rule(const char *src_ifname, const char *dest_ifname, uint32_t can_id, uint32_t can_mask, int is_rewrite, uint32_t rewrite_id)
 {
 	int ret = -1;
 	socketcan_gw_rule_t gw_rule;
@@ -290,14 +601,73 @@ int socketcanutil_configure_gateway(const char *src_ifname, const char *dest_ifn
 		return -2;
 	}
 
+	(void) socketcanutil_session_get();
+
 	gw_rule.options |= SOCKETCAN_GW_RULE_FILTER;
-	gw_rule.filter.can_id = 0x000;
-	gw_rule.filter.can_mask = 0x000;
+	gw_rule.filter.can_id = (canid_t)can_id;
+	gw_rule.filter.can_mask = (canid_t)can_mask;
+
+	if (is_rewrite == 1) {
+		gw_rule.options |= SOCKETCAN_GW_RULE_MOD_ID;
+		gw_rule.mod_id = (canid_t)rewrite_id;
+	}
 
 	ret = cangw_add_rule(&gw_rule);
 	if (ret < 0) {
-		; //nop
+		return -3;
+	}
+
+	return 0;
+}
+/**
+ * Function for get CAN gateway statistics of VXCAN host side interface.
+ * The rules to host side interface are counted as rx, the rules from host side interface are counted as tx.
+ *
+ * @param [in]	host_ifname	Pointer to host side vxcan ifname.
+ * @param [out]	stat		Pointer to socketcanutil_gw_stat_t to store statistics.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Argument error.
+ * @retval	-2	No interface.
+ * @retval	-3	Fail to get rules.
+ */
+int socketcanutil_get_gateway_stat(const char *host_ifname, socketcanutil_gw_stat_t *stat)
+{
+	int ret = -1;
+	unsigned int ifindex = 0;
+	socketcan_gw_rules_t *gw_rules = NULL;
+
+	if ((host_ifname == NULL) || (stat == NULL)) {
+		return -1;
 	}
 
+	(void) memset(stat, 0, sizeof(socketcanutil_gw_stat_t));
+
+	ifindex = if_nametoindex(host_ifname);
+	if (ifindex == 0) {
+		return -2;
+	}
+
+	ret = cangw_get_rules(&gw_rules);
+	if (ret < 0) {
+		return -3;
+	}
+
+	for (size_t i = 0; i < gw_rules->rule_num; i++) {
+		socketcan_gw_rule_t *rule = gw_rules->rules[i];
+
+		if (rule->dst_ifindex == ifindex) {
+			stat->rx_handled += rule->handled;
+			stat->rx_dropped += rule->dropped;
+		} else if (rule->src_ifindex == ifindex) {
+			stat->tx_handled += rule->handled;
+			stat->tx_dropped += rule->dropped;
+		} else {
+			; //nop
+		}
+	}
+
+	(void) cangw_release_rules(gw_rules);
+
 	return 0;
-}
\ No newline at end of file
+}
@@ -9,10 +9,27 @@
 //-----------------------------------------------------------------------------
 #include <stdint.h>
 
+//-----------------------------------------------------------------------------
+/**
+ * @struct	s_socketcanutil_gw_stat
+ * @brief	The data structure for CAN gateway statistics of one vxcan interface.
+ */
+struct s_socketcanutil_gw_stat {
+	uint64_t rx_handled;	/**< Handled frames to guest. */
+	uint64_t rx_dropped;	/**< Dropped frames to guest. */
+	uint64_t tx_handled;	/**< Handled frames from guest. */
+	uint64_t tx_dropped;	/**< Dropped frames from guest. */
+};
+typedef struct s_socketcanutil_gw_stat socketcanutil_gw_stat_t;	/**< typedef for struct s_socketcanutil_gw_stat. */
+
 //-----------------------------------------------------------------------------
 int socketcanutil_create_vxcan_peer(const char *ifname, const char *peer_ifname);
+int socketcanutil_setup_vxcan_peer(const char *ifname, const char *peer_ifname);
 int socketcanutil_up_can_if(const char *ifname);
 int socketcanutil_remove_vxcan_peer(const char *ifname);
 int socketcanutil_configure_gateway(const char *src_ifname, const char *dest_ifname);
+int socketcanutil_add_gateway_rule(const char *src_ifname, const char *dest_ifname, uint32_t can_id, uint32_t can_mask, int is_rewrite, uint32_t rewrite_id);
+int socketcanutil_get_gateway_stat(const char *host_ifname, socketcanutil_gw_stat_t *stat);
+int socketcanutil_session_close(void);
 //-----------------------------------------------------------------------------
 #endif //#ifndef SOCKETCAN_UTIL_H
@@ -0,0 +1,874 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	tc-util.c
+ * @brief	This file include traffic control utility functions using libnml for guest network interface shaping.
+ */
+#include "tc-util.h"
+
+#include <stdlib.h>
+#include <net/if.h>
+#include <libmnl/libmnl.h>
+#include <linux/rtnetlink.h>
+#include <linux/pkt_sched.h>
+#include <linux/pkt_cls.h>
+#include <linux/gen_stats.h>
+#include <linux/if_ether.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#undef _PRINTF_DEBUG_
+
+/**
+ * @def	TCUTIL_BATCH_LIMIT
+ * @brief	Size limit of one netlink batch for traffic control setup.
+ */
+#define TCUTIL_BATCH_LIMIT	(32*1024)
+/**
+ * @def	TCUTIL_BATCH_MSG_MAX
+ * @brief	Maximum number of messages in one netlink batch for traffic control setup.
+ */
+#define TCUTIL_BATCH_MSG_MAX	(64)
+/**
+ * @def	TCUTIL_HTB_HANDLE
+ * @brief	Handle of root htb qdisc. (1:0)
+ */
+#define TCUTIL_HTB_HANDLE	(0x00010000u)
+/**
+ * @def	TCUTIL_HTB_ROOT_CLASS
+ * @brief	Class id of htb root class. (1:1)
+ */
+#define TCUTIL_HTB_ROOT_CLASS	(0x00010001u)
+/**
+ * @def	TCUTIL_HTB_DEFAULT_MINOR
+ * @brief	Minor id of default leaf class when no default class in config. (1:2)
+ */
+#define TCUTIL_HTB_DEFAULT_MINOR	(0x2u)
+/**
+ * @def	TCUTIL_HTB_LEAF_MINOR_BASE
+ * @brief	Minor id of first leaf class from config. (1:10)
+ */
+#define TCUTIL_HTB_LEAF_MINOR_BASE	(0x10u)
+/**
+ * @def	TCUTIL_HTB_DEFAULT_RATE_DIV
+ * @brief	Divider of total rate for minimum guaranteed rate of implicit default class. (1/100 of total rate)
+ */
+#define TCUTIL_HTB_DEFAULT_RATE_DIV	(100u)
+/**
+ * @def	TCUTIL_HTB_DEFAULT_RATE_MIN
+ * @brief	Minimum guaranteed rate of implicit default class (bytes per sec). (8kbit)
+ */
+#define TCUTIL_HTB_DEFAULT_RATE_MIN	(1000u)
+/**
+ * @def	TCUTIL_POLICE_MTU
+ * @brief	MTU for ingress policing. veth deliver GSO packet, shall allow 64k packet.
+ */
+#define TCUTIL_POLICE_MTU	(65535u)
+/**
+ * @def	TCUTIL_PSCHED_NS_PER_TICK
+ * @brief	Nano sec per packet scheduler tick. Ref. PSCHED_TICKS2NS in kernel.
+ */
+#define TCUTIL_PSCHED_NS_PER_TICK	(64u)
+/**
+ * @def	TCUTIL_DEFAULT_BURST_MIN
+ * @brief	Minimum burst size in case of automatic burst.
+ */
+#define TCUTIL_DEFAULT_BURST_MIN	(1600u)
+
+/**
+ * @struct	s_tcutil_batch
+ * @brief	The data structure for multi message traffic control transaction.
+ */
+struct s_tcutil_batch {
+	struct mnl_nlmsg_batch *batch;				/**< libmnl batch object. */
+	char buf[TCUTIL_BATCH_LIMIT * 2];			/**< Buffer for batch. libmnl require double size of limit. */
+	int num;									/**< Number of messages in this batch. */
+	int is_optional[TCUTIL_BATCH_MSG_MAX];		/**< Fail of this message is not error (=1). */
+	int error[TCUTIL_BATCH_MSG_MAX];			/**< Result of each message. 0 or negative errno. */
+};
+typedef struct s_tcutil_batch tcutil_batch_t;	/**< typedef for struct s_tcutil_batch. */
+
+/**
+ * @struct	s_tcutil_stat_ctx
+ * @brief	The data structure for statistics dump callback.
+ */
+struct s_tcutil_stat_ctx {
+	int ifindex;			/**< Target interface index. */
+	tcutil_stat_t *stats;	/**< Array to store statistics. */
+	int max;				/**< Size of stats. */
+	int num;				/**< Number of stored statistics. */
+};
+
+/**
+ * Calculate transmit time in packet scheduler tick.
+ *
+ * @param [in]	rate	Rate (bytes per sec).
+ * @param [in]	size	Size (bytes).
+ * @return uint32_t	Transmit time (tick).
+ */
+static uint32_t tcutil_xmittime(uint64_t rate, uint32_t size)
+{
+	uint64_t tick = 0;
+
+	if (rate == 0) {
+		return 0;
+	}
+
+	tick = ((uint64_t)size * 1000000000ull) / rate / TCUTIL_PSCHED_NS_PER_TICK;
+	if (tick > UINT32_MAX) {
+		tick = UINT32_MAX;
+	}
+
+	return (uint32_t)tick;
+}
+/**
+ * Get burst size.  In case of automatic, use 4ms of rate.
+ *
+ * @param [in]	rate	Rate (bytes per sec).
+ * @param [in]	burst	Burst size in config (bytes).  0 is automatic.
+ * @return uint32_t	Burst size (bytes).
+ */
+static uint32_t tcutil_burst(uint64_t rate, uint32_t burst)
+{
+	uint64_t auto_burst = 0;
+
+	if (burst != 0) {
+		return burst;
+	}
+
+	auto_burst = rate / 250u;
+	if (auto_burst < TCUTIL_DEFAULT_BURST_MIN) {
+		auto_burst = TCUTIL_DEFAULT_BURST_MIN;
+	} else if (auto_burst > UINT32_MAX) {
+		auto_burst = UINT32_MAX;
+	}
+
+	return (uint32_t)auto_burst;
+}
+/**
+ * Set rate to tc_ratespec. The rate over 32bit is set by 64bit attribute.
+ *
+ * @param [out]	r		Pointer to tc_ratespec.
+ * @param [in]	rate	Rate (bytes per sec).
+ */
+static void tcutil_fill_ratespec(struct tc_ratespec *r, uint64_t rate)
+{
+	(void) memset(r, 0, sizeof(struct tc_ratespec));
+
+	if (rate >= UINT32_MAX) {
+		r->rate = UINT32_MAX;
+	} else {
+		r->rate = (uint32_t)rate;
+	}
+	r->linklayer = TC_LINKLAYER_ETHERNET;
+}
+/**
+ * Initialize multi message traffic control transaction.
+ *
+ * @param [out]	tb	Pointer to tcutil_batch_t.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Fail to initialize.
+ */
+static int tcutil_batch_init(tcutil_batch_t *tb)
+{
+	(void) memset(tb->is_optional, 0, sizeof(tb->is_optional));
+	(void) memset(tb->error, 0, sizeof(tb->error));
+	tb->num = 0;
+
+	tb->batch = mnl_nlmsg_batch_start(tb->buf, TCUTIL_BATCH_LIMIT);
+	if (tb->batch == NULL) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Start new message in traffic control transaction.
+ *
+ * @param [in]	tb			Pointer to tcutil_batch_t.
+ * @param [in]	type		Message type.
+ * @param [in]	flags		Message flags. NLM_F_REQUEST and NLM_F_ACK are added automatically.
+ * @param [in]	ifindex		Target interface index.
+ * @param [in]	handle		tcm_handle.
+ * @param [in]	parent		tcm_parent.
+ * @param [in]	info		tcm_info.
+ * @param [in]	is_optional	Fail of this message is not error (=1).
+ * @return struct nlmsghdr*
+ * @retval	!=NULL	Header of new message.
+ * @retval	NULL	Batch is full.
+ */
+static struct nlmsghdr *tcutil_batch_put_header(tcutil_batch_t *tb, uint16_t type, uint16_t flags, int ifindex
+												, uint32_t handle, uint32_t parent, uint32_t info, int is_optional)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct tcmsg *tcm = NULL;
+
+	if (tb->num >= TCUTIL_BATCH_MSG_MAX) {
+		return NULL;
+	}
+
+	// A message is less than 2k bytes. (Rate table is 1k bytes)
+	if ((mnl_nlmsg_batch_size(tb->batch) + 2048u) > TCUTIL_BATCH_LIMIT) {
+		return NULL;
+	}
+
+	nlh = mnl_nlmsg_put_header(mnl_nlmsg_batch_current(tb->batch));
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = (NLM_F_REQUEST | NLM_F_ACK | flags);
+	nlh->nlmsg_seq = (unsigned int)tb->num + 1u;
+
+	tcm = mnl_nlmsg_put_extra_header(nlh, sizeof(*tcm));
+	tcm->tcm_family = AF_UNSPEC;
+	tcm->tcm_ifindex = ifindex;
+	tcm->tcm_handle = handle;
+	tcm->tcm_parent = parent;
+	tcm->tcm_info = info;
+
+	tb->is_optional[tb->num] = is_optional;
+
+	return nlh;
+}
+/**
+ * Finish current message in traffic control transaction.
+ *
+ * @param [in]	tb	Pointer to tcutil_batch_t.
+ * @return int
+ * @retval	0	Success.
+ */
+static int tcutil_batch_next(tcutil_batch_t *tb)
+{
+	(void) mnl_nlmsg_batch_next(tb->batch);
+	tb->num++;
+
+	return 0;
+}
+/**
+ * Commit traffic control transaction.
+ * All messages are sent by one sendto and acknowledgement is tracked by sequence number.
+ *
+ * @param [in]	tb	Pointer to tcutil_batch_t.
+ * @return int
+ * @retval	0	All required messages are success.
+ * @retval	-1	Some required messages are fail.
+ * @retval	-2	Netlink socket error.
+ */
+static int tcutil_batch_commit(tcutil_batch_t *tb)
+{
+	struct mnl_socket *nl = NULL;
+	char buf[8192];
+	int ret = -1, result = 0;
+	int remain = 0;
+
+	for (int i = 0; i < tb->num; i++) {
+		tb->error[i] = -EIO;	// Not acknowledged.
+	}
+
+	nl = mnl_socket_open2(NETLINK_ROUTE, SOCK_CLOEXEC);
+	if (nl == NULL) {
+		result = -2;
+		goto do_return;
+	}
+
+	if (mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID) < 0) {
+		result = -2;
+		goto do_return;
+	}
+
+	if (mnl_socket_sendto(nl, mnl_nlmsg_batch_head(tb->batch), mnl_nlmsg_batch_size(tb->batch)) < 0) {
+		result = -2;
+		goto do_return;
+	}
+
+	remain = tb->num;
+	while (remain > 0) {
+		const struct nlmsghdr *nlh = NULL;
+
+		ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
+		if (ret < 0) {
+			result = -2;
+			goto do_return;
+		}
+
+		nlh = (const struct nlmsghdr*)buf;
+		while (mnl_nlmsg_ok(nlh, ret) == true) {
+			if ((nlh->nlmsg_type == NLMSG_ERROR) && (nlh->nlmsg_seq >= 1u) && (nlh->nlmsg_seq <= (unsigned int)tb->num)) {
+				const struct nlmsgerr *err = mnl_nlmsg_get_payload(nlh);
+
+				tb->error[nlh->nlmsg_seq - 1u] = err->error;
+				remain--;
+			}
+			nlh = mnl_nlmsg_next(nlh, &ret);
+		}
+	}
+
+	for (int i = 0; i < tb->num; i++) {
+		if ((tb->error[i] != 0) && (tb->is_optional[i] == 0)) {
+			#ifdef _PRINTF_DEBUG_
+			(void) fprintf(stdout,"tcutil_batch_commit: message %d fail (%d)\n", i, tb->error[i]);
+			#endif
+			result = -1;
+		}
+	}
+
+do_return:
+	if (nl != NULL) {
+		(void) mnl_socket_close(nl);
+	}
+	mnl_nlmsg_batch_stop(tb->batch);
+	tb->batch = NULL;
+
+	return result;
+}
+/**
+ * Put htb class creation message and fq_codel leaf qdisc creation message to transaction.
+ *
+ * @param [in]	tb			Pointer to tcutil_batch_t.
+ * @param [in]	ifindex		Target interface index.
+ * @param [in]	classid		Class id.
+ * @param [in]	parent		Parent class id.
+ * @param [in]	rate		Guaranteed rate (bytes per sec).
+ * @param [in]	ceil		Maximum rate (bytes per sec).
+ * @param [in]	burst		Burst size (bytes).
+ * @param [in]	prio		Priority.
+ * @param [in]	is_leaf		Create fq_codel leaf qdisc (=1) or not (=0).
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int tcutil_put_htb_class(tcutil_batch_t *tb, int ifindex, uint32_t classid, uint32_t parent
+								, uint64_t rate, uint64_t ceil, uint32_t burst, uint32_t prio, int is_leaf)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct nlattr *opts = NULL;
+	struct tc_htb_opt opt;
+
+	if (ceil < rate) {
+		ceil = rate;
+	}
+
+	nlh = tcutil_batch_put_header(tb, RTM_NEWTCLASS, (NLM_F_CREATE | NLM_F_EXCL), ifindex, classid, parent, 0, 0);
+	if (nlh == NULL) {
+		return -1;
+	}
+
+	(void) memset(&opt, 0, sizeof(opt));
+	tcutil_fill_ratespec(&opt.rate, rate);
+	tcutil_fill_ratespec(&opt.ceil, ceil);
+	opt.buffer = tcutil_xmittime(rate, tcutil_burst(rate, burst));
+	opt.cbuffer = tcutil_xmittime(ceil, tcutil_burst(ceil, burst));
+	opt.prio = prio;
+
+	mnl_attr_put_strz(nlh, TCA_KIND, "htb");
+	opts = mnl_attr_nest_start(nlh, TCA_OPTIONS);
+	mnl_attr_put(nlh, TCA_HTB_PARMS, sizeof(opt), &opt);
+	if (rate >= UINT32_MAX) {
+		mnl_attr_put_u64(nlh, TCA_HTB_RATE64, rate);
+	}
+	if (ceil >= UINT32_MAX) {
+		mnl_attr_put_u64(nlh, TCA_HTB_CEIL64, ceil);
+	}
+	mnl_attr_nest_end(nlh, opts);
+	(void) tcutil_batch_next(tb);
+
+	if (is_leaf == 1) {
+		// fq_codel keeps latency of each flow low inside class.
+		nlh = tcutil_batch_put_header(tb, RTM_NEWQDISC, (NLM_F_CREATE | NLM_F_EXCL), ifindex
+										, TC_H_MAKE(TC_H_MIN(classid) << 16, 0), classid, 0, 0);
+		if (nlh == NULL) {
+			return -1;
+		}
+		mnl_attr_put_strz(nlh, TCA_KIND, "fq_codel");
+		(void) tcutil_batch_next(tb);
+	}
+
+	return 0;
+}
+/**
+ * Put DSCP classification filter creation message to transaction.
+ *
+ * @param [in]	tb			Pointer to tcutil_batch_t.
+ * @param [in]	ifindex		Target interface index.
+ * @param [in]	classid		Class id to classify.
+ * @param [in]	dscp		IPv4 DSCP value.
+ * @param [in]	pref		Filter preference.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int tcutil_put_dscp_filter(tcutil_batch_t *tb, int ifindex, uint32_t classid, int dscp, uint32_t pref)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct nlattr *opts = NULL;
+	struct {
+		struct tc_u32_sel sel;
+		struct tc_u32_key key;
+	} sel;
+
+	nlh = tcutil_batch_put_header(tb, RTM_NEWTFILTER, (NLM_F_CREATE | NLM_F_EXCL), ifindex
+									, 0, TCUTIL_HTB_HANDLE, TC_H_MAKE(pref << 16, htons(ETH_P_IP)), 0);
+	if (nlh == NULL) {
+		return -1;
+	}
+
+	(void) memset(&sel, 0, sizeof(sel));
+	sel.sel.flags = TC_U32_TERMINAL;
+	sel.sel.nkeys = 1;
+	// DSCP is upper 6 bits of second byte in IPv4 header.
+	sel.key.mask = htonl(0x00fc0000u);
+	sel.key.val = htonl(((uint32_t)dscp & 0x3fu) << 18);
+	sel.key.off = 0;
+
+	mnl_attr_put_strz(nlh, TCA_KIND, "u32");
+	opts = mnl_attr_nest_start(nlh, TCA_OPTIONS);
+	mnl_attr_put_u32(nlh, TCA_U32_CLASSID, classid);
+	mnl_attr_put(nlh, TCA_U32_SEL, sizeof(sel), &sel);
+	mnl_attr_nest_end(nlh, opts);
+
+	return tcutil_batch_next(tb);
+}
+/**
+ * Put traffic shaping messages for to_guest direction (host side peer egress) to transaction.
+ *
+ * @param [in]	tb			Pointer to tcutil_batch_t.
+ * @param [in]	ifindex		Target interface index.
+ * @param [in]	dir			Pointer to netif_shaping_direction_t.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int tcutil_put_to_guest(tcutil_batch_t *tb, int ifindex, const netif_shaping_direction_t *dir)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct nlattr *opts = NULL;
+	struct tc_htb_glob glob;
+	uint32_t default_minor = TCUTIL_HTB_DEFAULT_MINOR;
+	int ret = -1;
+
+	for (int i = 0; i < dir->num_of_class; i++) {
+		if (dir->classes[i].dscp < 0) {
+			default_minor = TCUTIL_HTB_LEAF_MINOR_BASE + (uint32_t)i;
+			break;
+		}
+	}
+
+	nlh = tcutil_batch_put_header(tb, RTM_NEWQDISC, (NLM_F_CREATE | NLM_F_EXCL), ifindex, TCUTIL_HTB_HANDLE, TC_H_ROOT, 0, 0);
+	if (nlh == NULL) {
+		return -1;
+	}
+
+	(void) memset(&glob, 0, sizeof(glob));
+	glob.version = 3;
+	glob.rate2quantum = 10;
+	glob.defcls = default_minor;
+
+	mnl_attr_put_strz(nlh, TCA_KIND, "htb");
+	opts = mnl_attr_nest_start(nlh, TCA_OPTIONS);
+	mnl_attr_put(nlh, TCA_HTB_INIT, sizeof(glob), &glob);
+	mnl_attr_nest_end(nlh, opts);
+	(void) tcutil_batch_next(tb);
+
+	ret = tcutil_put_htb_class(tb, ifindex, TCUTIL_HTB_ROOT_CLASS, TCUTIL_HTB_HANDLE, dir->rate, dir->rate, dir->burst, 0, 0);
+	if (ret < 0) {
+		return -1;
+	}
+
+	if (default_minor == TCUTIL_HTB_DEFAULT_MINOR) {
+		// No default class in config, unclassified traffic use lowest priority.
+		// Guaranteed rate is remainder of configured classes. Over it, unclassified traffic shall borrow after configured classes.
+		uint64_t class_rate = 0, default_rate = 0, default_rate_min = 0;
+
+		for (int i = 0; i < dir->num_of_class; i++) {
+			class_rate += dir->classes[i].rate;
+		}
+
+		default_rate_min = dir->rate / TCUTIL_HTB_DEFAULT_RATE_DIV;
+		if (default_rate_min < TCUTIL_HTB_DEFAULT_RATE_MIN) {
+			default_rate_min = TCUTIL_HTB_DEFAULT_RATE_MIN;
+		}
+
+		if (dir->rate > class_rate) {
+			default_rate = dir->rate - class_rate;
+		}
+		if (default_rate < default_rate_min) {
+			default_rate = default_rate_min;
+		}
+
+		ret = tcutil_put_htb_class(tb, ifindex, TC_H_MAKE(TCUTIL_HTB_HANDLE, TCUTIL_HTB_DEFAULT_MINOR), TCUTIL_HTB_ROOT_CLASS
+									, default_rate, dir->rate, dir->burst, 7, 1);
+		if (ret < 0) {
+			return -1;
+		}
+	}
+
+	for (int i = 0; i < dir->num_of_class; i++) {
+		const netif_shaping_class_t *cls = &dir->classes[i];
+		uint32_t classid = TC_H_MAKE(TCUTIL_HTB_HANDLE, TCUTIL_HTB_LEAF_MINOR_BASE + (uint32_t)i);
+		uint64_t ceil = cls->ceil;
+
+		if (ceil == 0) {
+			ceil = dir->rate;
+		}
+
+		ret = tcutil_put_htb_class(tb, ifindex, classid, TCUTIL_HTB_ROOT_CLASS, cls->rate, ceil, dir->burst, cls->priority, 1);
+		if (ret < 0) {
+			return -1;
+		}
+
+		if (cls->dscp >= 0) {
+			ret = tcutil_put_dscp_filter(tb, ifindex, classid, cls->dscp, (uint32_t)i + 1u);
+			if (ret < 0) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+/**
+ * Put traffic policing messages for from_guest direction (host side peer ingress) to transaction.
+ *
+ * @param [in]	tb			Pointer to tcutil_batch_t.
+ * @param [in]	ifindex		Target interface index.
+ * @param [in]	dir			Pointer to netif_shaping_direction_t.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Batch is full.
+ */
+static int tcutil_put_from_guest(tcutil_batch_t *tb, int ifindex, const netif_shaping_direction_t *dir)
+{
+	struct nlmsghdr *nlh = NULL;
+	struct nlattr *opts = NULL, *acts = NULL, *act = NULL, *actopts = NULL;
+	struct tc_police police;
+	uint32_t rtab[256];
+	uint32_t cell_log = 0;
+
+	nlh = tcutil_batch_put_header(tb, RTM_NEWQDISC, (NLM_F_CREATE | NLM_F_EXCL), ifindex
+									, TC_H_MAKE(TC_H_INGRESS, 0), TC_H_INGRESS, 0, 0);
+	if (nlh == NULL) {
+		return -1;
+	}
+	mnl_attr_put_strz(nlh, TCA_KIND, "ingress");
+	(void) tcutil_batch_next(tb);
+
+	// Rate table, same as tc_calc_rtable in iproute2. Kernel require it for police action.
+	while ((TCUTIL_POLICE_MTU >> cell_log) > 255u) {
+		cell_log++;
+	}
+	for (uint32_t i = 0; i < 256u; i++) {
+		rtab[i] = tcutil_xmittime(dir->rate, (i + 1u) << cell_log);
+	}
+
+	(void) memset(&police, 0, sizeof(police));
+	police.action = TC_ACT_SHOT;
+	police.mtu = TCUTIL_POLICE_MTU;
+	police.burst = tcutil_xmittime(dir->rate, tcutil_burst(dir->rate, dir->burst));
+	tcutil_fill_ratespec(&police.rate, dir->rate);
+	police.rate.cell_log = (unsigned char)cell_log;
+	police.rate.cell_align = -1;
+
+	nlh = tcutil_batch_put_header(tb, RTM_NEWTFILTER, (NLM_F_CREATE | NLM_F_EXCL), ifindex
+									, 0, TC_H_MAKE(TC_H_INGRESS, 0), TC_H_MAKE(1u << 16, htons(ETH_P_ALL)), 0);
+	if (nlh == NULL) {
+		return -1;
+	}
+
+	mnl_attr_put_strz(nlh, TCA_KIND, "matchall");
+	opts = mnl_attr_nest_start(nlh, TCA_OPTIONS);
+	acts = mnl_attr_nest_start(nlh, TCA_MATCHALL_ACT);
+	act = mnl_attr_nest_start(nlh, 1);
+	mnl_attr_put_strz(nlh, TCA_ACT_KIND, "police");
+	actopts = mnl_attr_nest_start(nlh, TCA_ACT_OPTIONS);
+	mnl_attr_put(nlh, TCA_POLICE_TBF, sizeof(police), &police);
+	mnl_attr_put(nlh, TCA_POLICE_RATE, sizeof(rtab), rtab);
+	if (dir->rate >= UINT32_MAX) {
+		mnl_attr_put_u64(nlh, TCA_POLICE_RATE64, dir->rate);
+	}
+	mnl_attr_nest_end(nlh, actopts);
+	mnl_attr_nest_end(nlh, act);
+	mnl_attr_nest_end(nlh, acts);
+	mnl_attr_nest_end(nlh, opts);
+
+	return tcutil_batch_next(tb);
+}
+/**
+ * Setup traffic shaping to host side peer of guest network interface.
+ * Existing root and ingress qdisc are replaced.  All operations are sent by one rtnetlink transaction.
+ *
+ * @param [in]	ifname		Host side interface name.
+ * @param [in]	shaping		Pointer to netif_shaping_t.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Fail to setup shaping.
+ * @retval	-2	Argument error.
+ * @retval	-3	No interface.
+ */
+int tcutil_setup_shaping(const char *ifname, const netif_shaping_t *shaping)
+{
+	tcutil_batch_t *tb = NULL;
+	int ifindex = 0;
+	int ret = -1, result = 0;
+
+	if ((ifname == NULL) || (shaping == NULL)) {
+		return -2;
+	}
+
+	ifindex = (int)if_nametoindex(ifname);
+	if (ifindex == 0) {
+		return -3;
+	}
+
+	tb = (tcutil_batch_t*)malloc(sizeof(tcutil_batch_t));
+	if (tb == NULL) {
+		return -1;
+	}
+
+	ret = tcutil_batch_init(tb);
+	if (ret < 0) {
+		result = -1;
+		goto do_return;
+	}
+
+	// Remove existing qdisc. No qdisc is not error.
+	(void) tcutil_batch_put_header(tb, RTM_DELQDISC, 0, ifindex, 0, TC_H_ROOT, 0, 1);
+	(void) tcutil_batch_next(tb);
+	(void) tcutil_batch_put_header(tb, RTM_DELQDISC, 0, ifindex, TC_H_MAKE(TC_H_INGRESS, 0), TC_H_INGRESS, 0, 1);
+	(void) tcutil_batch_next(tb);
+
+	if (shaping->to_guest.rate > 0) {
+		ret = tcutil_put_to_guest(tb, ifindex, &shaping->to_guest);
+		if (ret < 0) {
+			result = -1;
+		}
+	}
+
+	if ((result == 0) && (shaping->from_guest.rate > 0)) {
+		ret = tcutil_put_from_guest(tb, ifindex, &shaping->from_guest);
+		if (ret < 0) {
+			result = -1;
+		}
+	}
+
+	if (result == 0) {
+		ret = tcutil_batch_commit(tb);
+		if (ret < 0) {
+			result = -1;
+		}
+	} else {
+		mnl_nlmsg_batch_stop(tb->batch);
+	}
+
+do_return:
+	(void) free(tb);
+
+	return result;
+}
+/**
+ * Sub function for statistics dump. Parse TCA_STATS2 attribute.
+ *
+ * @param [in]	stats2	Pointer to TCA_STATS2 attribute.
+ * @param [out]	stat	Pointer to tcutil_stat_t to store.
+ */
+static void tcutil_parse_stats2(const struct nlattr *stats2, tcutil_stat_t *stat)
+{
+	const struct nlattr *attr = NULL;
+
+	mnl_attr_for_each_nested(attr, stats2) {
+		uint16_t type = mnl_attr_get_type(attr);
+
+		if (type == TCA_STATS_BASIC) {
+			struct gnet_stats_basic basic;
+
+			(void) memset(&basic, 0, sizeof(basic));
+			(void) memcpy(&basic, mnl_attr_get_payload(attr)
+						, (mnl_attr_get_payload_len(attr) < sizeof(basic)) ? mnl_attr_get_payload_len(attr) : sizeof(basic));
+			stat->bytes = basic.bytes;
+			stat->packets = basic.packets;
+		} else if (type == TCA_STATS_QUEUE) {
+			struct gnet_stats_queue queue;
+
+			(void) memset(&queue, 0, sizeof(queue));
+			(void) memcpy(&queue, mnl_attr_get_payload(attr)
+						, (mnl_attr_get_payload_len(attr) < sizeof(queue)) ? mnl_attr_get_payload_len(attr) : sizeof(queue));
+			stat->drops = queue.drops;
+		} else {
+			; //nop
+		}
+	}
+}
+/**
+ * Callback for class and qdisc dump.
+ *
+ * @param [in]	nlh		Pointer to netlink message.
+ * @param [in]	data	Pointer to struct s_tcutil_stat_ctx.
+ * @return int
+ * @retval	MNL_CB_OK	Continue.
+ */
+static int tcutil_stats_cb(const struct nlmsghdr *nlh, void *data)
+{
+	struct s_tcutil_stat_ctx *ctx = (struct s_tcutil_stat_ctx*)data;
+	const struct tcmsg *tcm = mnl_nlmsg_get_payload(nlh);
+	const struct nlattr *attr = NULL;
+	tcutil_stat_t *stat = NULL;
+
+	if (tcm->tcm_ifindex != ctx->ifindex) {
+		return MNL_CB_OK;
+	}
+
+	if (nlh->nlmsg_type == RTM_NEWQDISC) {
+		if (tcm->tcm_parent != TC_H_INGRESS) {
+			// fq_codel leaf qdisc drops packets by AQM inside class, add them to parent class.  Classes are dumped before qdiscs.
+			for (int i = 0; i < ctx->num; i++) {
+				if ((ctx->stats[i].classid != TCUTIL_STAT_FROM_GUEST) && (ctx->stats[i].classid == tcm->tcm_parent)) {
+					tcutil_stat_t leaf;
+
+					(void) memset(&leaf, 0, sizeof(leaf));
+					mnl_attr_for_each(attr, nlh, sizeof(*tcm)) {
+						if (mnl_attr_get_type(attr) == TCA_STATS2) {
+							tcutil_parse_stats2(attr, &leaf);
+						}
+					}
+					ctx->stats[i].drops = ctx->stats[i].drops + leaf.drops;
+					break;
+				}
+			}
+			return MNL_CB_OK;
+		}
+	} else if (nlh->nlmsg_type != RTM_NEWTCLASS) {
+		return MNL_CB_OK;
+	}
+
+	if (ctx->num >= ctx->max) {
+		return MNL_CB_OK;
+	}
+
+	stat = &ctx->stats[ctx->num];
+	(void) memset(stat, 0, sizeof(tcutil_stat_t));
+	if (nlh->nlmsg_type == RTM_NEWQDISC) {
+		stat->classid = TCUTIL_STAT_FROM_GUEST;
+	} else {
+		stat->classid = tcm->tcm_handle;
+	}
+
+	mnl_attr_for_each(attr, nlh, sizeof(*tcm)) {
+		if (mnl_attr_get_type(attr) == TCA_STATS2) {
+			tcutil_parse_stats2(attr, stat);
+		}
+	}
+
+	ctx->num++;
+
+	return MNL_CB_OK;
+}
+/**
+ * Sub function for statistics. Dump classes or qdiscs.
+ *
+ * @param [in]	nl		Pointer to mnl socket.
+ * @param [in]	type	RTM_GETTCLASS or RTM_GETQDISC.
+ * @param [in]	ctx		Pointer to struct s_tcutil_stat_ctx.
+ * @param [in]	seq		Sequence number.
+ * @return int
+ * @retval	0	Success.
+ * @retval	-1	Fail to dump.
+ */
+static int tcutil_stats_dump(struct mnl_socket *nl, uint16_t type, struct s_tcutil_stat_ctx *ctx, unsigned int seq)
+{
+	char buf[8192];
+	struct nlmsghdr *nlh = NULL;
+	struct tcmsg *tcm = NULL;
+	unsigned int portid = 0;
+	int ret = -1;
+
+	nlh = mnl_nlmsg_put_header(buf);
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = (NLM_F_REQUEST | NLM_F_DUMP);
+	nlh->nlmsg_seq = seq;
+	tcm = mnl_nlmsg_put_extra_header(nlh, sizeof(*tcm));
+	tcm->tcm_family = AF_UNSPEC;
+	tcm->tcm_ifindex = ctx->ifindex;
+
+	if (mnl_socket_sendto(nl, nlh, nlh->nlmsg_len) < 0) {
+		return -1;
+	}
+
+	portid = mnl_socket_get_portid(nl);
+	do {
+		ret = mnl_socket_recvfrom(nl, buf, sizeof(buf));
+		if (ret <= 0) {
+			return -1;
+		}
+		ret = mnl_cb_run(buf, ret, seq, portid, tcutil_stats_cb, ctx);
+	} while (ret > MNL_CB_STOP);
+
+	if (ret < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+/**
+ * Get traffic shaping statistics of host side peer.
+ * Each htb class and ingress policing (classid is TCUTIL_STAT_FROM_GUEST) are stored.
+ * Drops of htb class include drops of fq_codel leaf qdisc in the class.
+ *
+ * @param [in]	ifname	Host side interface name.
+ * @param [out]	stats	Array of tcutil_stat_t to store statistics.
+ * @param [in]	max		Size of stats.
+ * @return int
+ * @retval	>=0	Number of stored statistics.
+ * @retval	-1	Fail to get statistics.
+ * @retval	-2	Argument error.
+ * @retval	-3	No interface.
+ */
+int tcutil_get_stats(const char *ifname, tcutil_stat_t *stats, int max)
+{
+	struct mnl_socket *nl = NULL;
+	struct s_tcutil_stat_ctx ctx;
+	int ret = -1, result = 0;
+
+	if ((ifname == NULL) || (stats == NULL) || (max <= 0)) {
+		return -2;
+	}
+
+	(void) memset(&ctx, 0, sizeof(ctx));
+	ctx.ifindex = (int)if_nametoindex(ifname);
+	if (ctx.ifindex == 0) {
+		return -3;
+	}
+	ctx.stats = stats;
+	ctx.max = max;
+
+	nl = mnl_socket_open2(NETLINK_ROUTE, SOCK_CLOEXEC);
+	if (nl == NULL) {
+		return -1;
+	}
+
+	if (mnl_socket_bind(nl, 0, MNL_SOCKET_AUTOPID) < 0) {
+		result = -1;
+		goto do_return;
+	}
+
+	ret = tcutil_stats_dump(nl, RTM_GETTCLASS, &ctx, 1);
+	if (ret < 0) {
+		result = -1;
+		goto do_return;
+	}
+
+	ret = tcutil_stats_dump(nl, RTM_GETQDISC, &ctx, 2);
+	if (ret < 0) {
+		result = -1;
+		goto do_return;
+	}
+
+	result = ctx.num;
+
+do_return:
+	(void) mnl_socket_close(nl);
+
+	return result;
+}
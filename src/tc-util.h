@@ -0,0 +1,37 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	tc-util.h
+ * @brief	The header for traffic control utility.
+ */
+#ifndef TC_UTIL_H
+#define TC_UTIL_H
+//-----------------------------------------------------------------------------
+#include <stdint.h>
+#include "container.h"
+
+//-----------------------------------------------------------------------------
+/**
+ * @def	TCUTIL_STAT_FROM_GUEST
+ * @brief	Class id of statistics for from_guest direction (ingress policing).
+ */
+#define TCUTIL_STAT_FROM_GUEST	(0xffff0000u)
+
+/**
+ * @struct	s_tcutil_stat
+ * @brief	The data structure for statistics of one traffic class.
+ */
+struct s_tcutil_stat {
+	uint32_t classid;	/**< tc class id. TCUTIL_STAT_FROM_GUEST is ingress policing. */
+	uint64_t bytes;		/**< Passed bytes. */
+	uint64_t packets;	/**< Passed packets. */
+	uint64_t drops;		/**< Dropped packets. */
+};
+typedef struct s_tcutil_stat tcutil_stat_t;	/**< typedef for struct s_tcutil_stat. */
+
+//-----------------------------------------------------------------------------
+int tcutil_setup_shaping(const char *ifname, const netif_shaping_t *shaping);
+int tcutil_get_stats(const char *ifname, tcutil_stat_t *stats, int max);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef TC_UTIL_H
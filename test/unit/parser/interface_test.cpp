@@ -12,6 +12,7 @@
 extern "C" {
 #include "../../../src/parser/parser-common.c"
 #include "../../../src/parser/parser-container.c"
+#include "../../../src/parser/parser-manager.c"
 }
 // Test Terget files ---------------------------------------
 using namespace ::testing;
@@ -208,6 +209,276 @@ TEST_F(parser_test, cmparser_create_from_file__base02_rootfs)
 	cmparser_release_config(cc);
 }
 //--------------------------------------------------------------------------------------------------------
+TEST_F(parser_test, cmparser_create_from_file__base03_extradisk_clone)
+{
+	int ret = -1;
+	container_config_t *cc = NULL;
+	container_baseconfig_extradisk_t *exdisk = NULL;
+
+	// clone with template
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-base/03/test-base-03-0.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+
+	exdisk = dl_list_first(&cc->baseconfig.extradisk_list, container_baseconfig_extradisk_t, list);
+	ASSERT_NE(NULL, exdisk);
+	ASSERT_EQ(DISKREDUNDANCY_TYPE_CLONE, exdisk->redundancy);
+	ASSERT_STREQ("/usr/share/container/nv-template.img", exdisk->template_image);
+
+	cmparser_release_config(cc);
+	cc = NULL;
+
+	// clone without template, fallback to mkfs
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-base/03/test-base-03-1.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+
+	exdisk = dl_list_first(&cc->baseconfig.extradisk_list, container_baseconfig_extradisk_t, list);
+	ASSERT_NE(NULL, exdisk);
+	ASSERT_EQ(DISKREDUNDANCY_TYPE_MKFS, exdisk->redundancy);
+	ASSERT_EQ(NULL, exdisk->template_image);
+
+	cmparser_release_config(cc);
+}
+//--------------------------------------------------------------------------------------------------------
+TEST_F(parser_test, cmparser_create_from_file__base04_rootfs_overlay)
+{
+	int ret = -1;
+	container_config_t *cc = NULL;
+
+	// overlay with size
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-base/04/test-base-04-0.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+	ASSERT_STREQ("64M", cc->baseconfig.rootfs.overlay_size);
+	ASSERT_STREQ("/opt/container/guests/agl-cluster/rootfs-overlay", cc->baseconfig.rootfs.overlay_path);
+
+	cmparser_release_config(cc);
+	cc = NULL;
+
+	// overlay without size, use default
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-base/04/test-base-04-1.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+	ASSERT_STREQ(ROOTFS_OVERLAY_SIZE_DEFAULT, cc->baseconfig.rootfs.overlay_size);
+
+	cmparser_release_config(cc);
+	cc = NULL;
+
+	// overlay with rw rootfs, the rootfs setting is rejected
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-base/04/test-base-04-2.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+	ASSERT_EQ(NULL, cc->baseconfig.rootfs.overlay_size);
+	ASSERT_EQ(NULL, cc->baseconfig.rootfs.overlay_path);
+	ASSERT_EQ(NULL, cc->baseconfig.rootfs.path);
+
+	cmparser_release_config(cc);
+}
+//--------------------------------------------------------------------------------------------------------
+TEST_F(parser_test, cmparser_create_from_file__base05_fserror)
+{
+	static const int expect[] = {FSERROR_POLICY_REMOUNT_RO, FSERROR_POLICY_FSCK, FSERROR_POLICY_RESTART, FSERROR_POLICY_NONE};
+	static const char * const files[] = {
+		"test/unit/data/test-base/05/test-base-05-0.json",
+		"test/unit/data/test-base/05/test-base-05-1.json",
+		"test/unit/data/test-base/05/test-base-05-2.json",
+		"test/unit/data/test-base/05/test-base-05-3.json",
+	};
+	int ret = -1;
+	container_config_t *cc = NULL;
+
+	for (int i = 0; i < 4; i++) {
+		ret = cmparser_create_from_file(&cc, files[i]);
+		ASSERT_EQ(0, ret);
+		ASSERT_NE(NULL, cc);
+		ASSERT_EQ(expect[i], cc->baseconfig.fserror_policy);
+
+		cmparser_release_config(cc);
+		cc = NULL;
+	}
+}
+//--------------------------------------------------------------------------------------------------------
+TEST_F(parser_test, cmparser_create_from_file__netif00_veth_shaping)
+{
+	int ret = -1;
+	container_config_t *cc = NULL;
+	container_static_netif_elem_t *elem = NULL;
+	netif_elem_veth_t *veth = NULL;
+	netif_shaping_t *shaping = NULL;
+
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-netif/00/test-netif-00-0.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+
+	elem = dl_list_first(&cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list);
+	ASSERT_NE(NULL, elem);
+	ASSERT_EQ(STATICNETIF_VETH, elem->type);
+	veth = (netif_elem_veth_t*)elem->setting;
+	ASSERT_STREQ("lxcbr0", veth->link);
+	shaping = veth->shaping;
+	ASSERT_NE(NULL, shaping);
+
+	// rate is stored in bytes/sec
+	ASSERT_EQ(2500000u, shaping->to_guest.rate);
+	ASSERT_EQ(32768u, shaping->to_guest.burst);
+	ASSERT_EQ(2, shaping->to_guest.num_of_class);
+	ASSERT_EQ(1250000u, shaping->to_guest.classes[0].rate);
+	ASSERT_EQ(2500000u, shaping->to_guest.classes[0].ceil);
+	ASSERT_EQ(0u, shaping->to_guest.classes[0].priority);
+	ASSERT_EQ(46, shaping->to_guest.classes[0].dscp);
+	ASSERT_EQ(625000u, shaping->to_guest.classes[1].rate);
+	ASSERT_EQ(2500000u, shaping->to_guest.classes[1].ceil);
+	ASSERT_EQ(-1, shaping->to_guest.classes[1].dscp);
+	ASSERT_EQ(1250000u, shaping->from_guest.rate);
+	ASSERT_EQ(0, shaping->from_guest.num_of_class);
+
+	cmparser_release_config(cc);
+	cc = NULL;
+
+	// dscp out of range, the interface is dropped
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-netif/00/test-netif-00-1.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+	ASSERT_NE(0, dl_list_empty(&cc->netifconfig.static_netif.static_netiflist));
+
+	cmparser_release_config(cc);
+	cc = NULL;
+
+	// classes in from_guest direction, the interface is dropped
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-netif/00/test-netif-00-2.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+	ASSERT_NE(0, dl_list_empty(&cc->netifconfig.static_netif.static_netiflist));
+
+	cmparser_release_config(cc);
+}
+//--------------------------------------------------------------------------------------------------------
+TEST_F(parser_test, cmparser_create_from_file__netif01_macvlan_ipvlan)
+{
+	int ret = -1;
+	container_config_t *cc = NULL;
+	container_static_netif_elem_t *elem = NULL;
+	netif_elem_macvlan_t *macvlan = NULL;
+	netif_elem_ipvlan_t *ipvlan = NULL;
+
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-netif/01/test-netif-01-0.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+
+	elem = dl_list_first(&cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list);
+	ASSERT_NE(NULL, elem);
+	ASSERT_EQ(STATICNETIF_MACVLAN, elem->type);
+	macvlan = (netif_elem_macvlan_t*)elem->setting;
+	ASSERT_STREQ("eth1", macvlan->name);
+	ASSERT_STREQ("eth0", macvlan->link);
+	ASSERT_STREQ("up", macvlan->flags);
+	ASSERT_STREQ("02:00:00:00:00:01", macvlan->hwaddr);
+	ASSERT_STREQ("bridge", macvlan->mode);
+	ASSERT_STREQ("192.168.10.2/24", macvlan->address);
+	ASSERT_STREQ("192.168.10.1", macvlan->gateway);
+
+	elem = dl_list_last(&cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list);
+	ASSERT_NE(NULL, elem);
+	ASSERT_EQ(STATICNETIF_IPVLAN, elem->type);
+	ipvlan = (netif_elem_ipvlan_t*)elem->setting;
+	ASSERT_STREQ("eth2", ipvlan->name);
+	ASSERT_STREQ("eth0", ipvlan->link);
+	ASSERT_STREQ("l3s", ipvlan->mode);
+	ASSERT_STREQ("private", ipvlan->isolation);
+	ASSERT_STREQ("192.168.20.2/24", ipvlan->address);
+	ASSERT_EQ(NULL, ipvlan->gateway);
+
+	cmparser_release_config(cc);
+	cc = NULL;
+
+	// unsupported macvlan mode and ipvlan without link, both interfaces are dropped
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-netif/01/test-netif-01-1.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+	ASSERT_NE(0, dl_list_empty(&cc->netifconfig.static_netif.static_netiflist));
+
+	cmparser_release_config(cc);
+}
+//--------------------------------------------------------------------------------------------------------
+TEST_F(parser_test, cmparser_create_from_file__netif02_vxcan_filter)
+{
+	int ret = -1;
+	container_config_t *cc = NULL;
+	container_static_netif_elem_t *elem = NULL;
+	netif_elem_vxcan_t *vxcan = NULL;
+
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-netif/02/test-netif-02-0.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+
+	elem = dl_list_first(&cc->netifconfig.static_netif.static_netiflist, container_static_netif_elem_t, list);
+	ASSERT_NE(NULL, elem);
+	ASSERT_EQ(STATICNETIF_VXCAN, elem->type);
+	vxcan = (netif_elem_vxcan_t*)elem->setting;
+	ASSERT_STREQ("vxcan0", vxcan->name);
+	ASSERT_STREQ("can0", vxcan->upstream);
+
+	ASSERT_EQ(3, vxcan->num_of_rx_filter);
+	ASSERT_EQ(0x100u, vxcan->rx_filter[0].can_id);
+	ASSERT_EQ(0x700u, vxcan->rx_filter[0].can_mask);
+	ASSERT_EQ(0, vxcan->rx_filter[0].is_rewrite);
+	ASSERT_EQ(0x200u, vxcan->rx_filter[1].can_id);
+	ASSERT_EQ(0x7ffu, vxcan->rx_filter[1].can_mask);
+	ASSERT_EQ(1, vxcan->rx_filter[1].is_rewrite);
+	ASSERT_EQ(0x280u, vxcan->rx_filter[1].rewrite_id);
+	ASSERT_EQ(0x1fffffffu, vxcan->rx_filter[2].can_id);
+	ASSERT_EQ(0xffffffffu, vxcan->rx_filter[2].can_mask);
+
+	ASSERT_EQ(1, vxcan->num_of_tx_filter);
+	ASSERT_EQ(0x123u, vxcan->tx_filter[0].can_id);
+
+	cmparser_release_config(cc);
+	cc = NULL;
+
+	// out of range id, mask and rewrite, all interfaces are dropped
+	ret = cmparser_create_from_file(&cc, "test/unit/data/test-netif/02/test-netif-02-1.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cc);
+	ASSERT_NE(0, dl_list_empty(&cc->netifconfig.static_netif.static_netiflist));
+
+	cmparser_release_config(cc);
+}
+//--------------------------------------------------------------------------------------------------------
+TEST_F(parser_test, cmparser_manager_create_from_file__manager00_recovery_uevent)
+{
+	int ret = -1;
+	container_manager_config_t *cm = NULL;
+
+	ret = cmparser_manager_create_from_file(&cm, "test/unit/data/test-manager/00/test-manager-00-0.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cm);
+	ASSERT_EQ(2, cm->operation.recovery_budget);
+	ASSERT_EQ(MANAGER_UEVENT_SOURCE_RAW, cm->dynamicdevice.uevent_source);
+
+	cmparser_manager_release_config(cm);
+	cm = NULL;
+
+	// negative budget use default
+	ret = cmparser_manager_create_from_file(&cm, "test/unit/data/test-manager/00/test-manager-00-1.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cm);
+	ASSERT_EQ(0, cm->operation.recovery_budget);
+	ASSERT_EQ(MANAGER_UEVENT_SOURCE_LIBUDEV, cm->dynamicdevice.uevent_source);
+
+	cmparser_manager_release_config(cm);
+	cm = NULL;
+
+	// no budget and unknown uevent source use default
+	ret = cmparser_manager_create_from_file(&cm, "test/unit/data/test-manager/00/test-manager-00-2.json");
+	ASSERT_EQ(0, ret);
+	ASSERT_NE(NULL, cm);
+	ASSERT_EQ(0, cm->operation.recovery_budget);
+	ASSERT_EQ(MANAGER_UEVENT_SOURCE_LIBUDEV, cm->dynamicdevice.uevent_source);
+
+	cmparser_manager_release_config(cm);
+}
+//--------------------------------------------------------------------------------------------------------
 #if 0
 TEST_F(parser_test, cmparser_create_from_file__argerr)
 {